@@ -0,0 +1,213 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// a unit test made using the Catch framework in catch.hpp / tests.cpp.
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "catch.hpp"
+#include "testUtils.h"
+#include "MLDSPAdditive.h"
+#include "MLDSPGens.h"
+
+using namespace ml;
+using namespace testUtils;
+
+namespace
+{
+// a partial or mode computed in double precision, with the same ramps as the banks.
+struct Partial
+{
+  double freq{0}, amp{0}, radius{1};
+  std::complex<double> z{1., 0.};
+};
+
+// run one vector of a partial with new target frequency and amplitude, adding its
+// output to y. The partial is a mode driven by x if x is not null.
+void runPartial(Partial& p, double freq, double amp, std::vector<double>& y,
+                const float* x = nullptr)
+{
+  const double df = (freq - p.freq) / kFloatsPerDSPVector;
+  const double da = (amp - p.amp) / kFloatsPerDSPVector;
+  for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+  {
+    const double f = p.freq + (n + 1) * df;
+    const double a = p.amp + (n + 1) * da;
+    const auto pole = std::polar(p.radius, kTwoPi * f);
+    if (x)
+    {
+      p.z = pole * p.z + (double)x[n];
+      y[n] += a * p.z.imag();
+    }
+    else
+    {
+      y[n] += a * p.z.imag();
+      p.z *= pole;
+    }
+  }
+  p.freq = freq;
+  p.amp = amp;
+}
+}  // namespace
+
+TEST_CASE("madronalib/core/dsp_additive", "[dsp_additive]")
+{
+  SECTION("sines")
+  {
+    // partials with steady, gliding, fading and too-high frequencies.
+    constexpr int kPartials{6};
+    SineBank<kPartials> bank;
+    std::vector<Partial> ref(kPartials);
+    const float freqs[kPartials]{0.01f, 0.1234f, 0.3f, 0.002f, 0.45f, 0.6f};
+    const float amps[kPartials]{1.f, 0.5f, 0.25f, 0.5f, 0.1f, 1.f};
+    for (int i = 0; i < kPartials; ++i)
+    {
+      bank.setPartial(i, freqs[i], amps[i]);
+      ref[i].freq = freqs[i];
+    }
+    bank.clear();
+    bank.setPhase(3, 0.25f);
+    ref[3].z = std::polar(1., kTwoPi * 0.25);
+
+    float maxError{0};
+    for (int v = 0; v < 100; ++v)
+    {
+      float target[kPartials];
+      float amp[kPartials];
+      for (int i = 0; i < kPartials; ++i)
+      {
+        target[i] = freqs[i];
+        amp[i] = amps[i];
+      }
+      // partial 1 glides up and partial 4 glides above half the sample rate.
+      if (v >= 20) target[1] = 0.1234f + 0.001f * std::min(v - 20, 30);
+      if (v >= 40) target[4] = 0.55f;
+      // partial 2 is silent for a while.
+      if (v >= 30 && v < 60) amp[2] = 0.f;
+
+      std::vector<double> y(kFloatsPerDSPVector);
+      for (int i = 0; i < kPartials; ++i)
+      {
+        bank.setPartial(i, target[i], amp[i]);
+        runPartial(ref[i], target[i], (std::fabs(target[i]) < 0.5f) ? amp[i] : 0., y);
+      }
+      auto out = bank();
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        maxError = std::max(maxError, (float)std::fabs(out[n] - y[n]));
+      }
+    }
+    // the rotations in float drift slowly from the ideal phases.
+    REQUIRE(maxError < 3e-4f);
+  }
+
+  SECTION("silence")
+  {
+    // a silent bank outputs zeroes. A partial that was silent fades back in
+    // with the phase it would have had.
+    SineBank<9> bank;
+    REQUIRE(max(abs(bank())) < 1e-6f);
+
+    SineBank<1> a, b;
+    a.setPartial(0, 0.05f, 1.f);
+    b.setPartial(0, 0.05f, 1.f);
+    a.clear();
+    b.clear();
+    for (int v = 0; v < 10; ++v)
+    {
+      a.setAmplitude(0, (v < 3 || v > 6) ? 1.f : 0.f);
+      b.setAmplitude(0, (v < 3 || v > 6) ? 1.f : 1e-4f);
+      auto ya = a();
+      auto yb = b();
+      if (v > 7)
+      {
+        REQUIRE(max(abs(ya - yb)) < 1e-5f);
+      }
+    }
+  }
+
+  SECTION("modes")
+  {
+    // the impulse response of each mode is a * r^n * sin(2 pi f n).
+    constexpr int kModes{5};
+    ModalBank<kModes> bank;
+    const float freqs[kModes]{0.01f, 0.05f, 0.1f, 0.2f, 0.4f};
+    const float decays[kModes]{100.f, 1000.f, 3000.f, 500.f, 50.f};
+    const float amps[kModes]{1.f, 0.5f, 0.25f, 0.125f, 1.f};
+    for (int i = 0; i < kModes; ++i)
+    {
+      bank.setMode(i, freqs[i], decays[i], amps[i]);
+    }
+    bank.clear();
+
+    float maxError{0};
+    DSPVector impulse;
+    impulse[0] = 1.f;
+    for (int v = 0; v < 20; ++v)
+    {
+      auto y = bank(v ? DSPVector() : impulse);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        const int t = v * kFloatsPerDSPVector + n;
+        double ideal{0};
+        for (int i = 0; i < kModes; ++i)
+        {
+          const double r = std::exp(std::log(0.001) / decays[i]);
+          ideal += amps[i] * std::pow(r, t) * std::sin(kTwoPi * freqs[i] * t);
+        }
+        maxError = std::max(maxError, (float)std::fabs(y[n] - ideal));
+      }
+    }
+    REQUIRE(maxError < 1e-4f);
+
+    // the modes have all decayed below kSilence after 2 * 3000 samples.
+    for (int v = 0; v < 80; ++v)
+    {
+      bank(DSPVector());
+    }
+    REQUIRE(max(abs(bank(DSPVector()))) < 1e-6f);
+  }
+
+  SECTION("driven modes")
+  {
+    // modes driven by noise, with gliding frequencies and amplitudes.
+    constexpr int kModes{7};
+    ModalBank<kModes> bank;
+    std::vector<Partial> ref(kModes);
+    for (int i = 0; i < kModes; ++i)
+    {
+      const float f = 0.013f * (i + 1);
+      bank.setMode(i, f, 200.f * (i + 1), 1.f / (i + 1));
+      ref[i].freq = f;
+      ref[i].amp = 1.f / (i + 1);
+      ref[i].radius = std::exp(std::log(0.001) / (200. * (i + 1)));
+      ref[i].z = 0.;
+    }
+    bank.clear();
+
+    NoiseGen noise;
+    float maxError{0};
+    for (int v = 0; v < 50; ++v)
+    {
+      const DSPVector x = noise() * 0.1f;
+      std::vector<double> y(kFloatsPerDSPVector);
+      for (int i = 0; i < kModes; ++i)
+      {
+        const double f = 0.013 * (i + 1) * (1. + 0.01 * std::sin(v * 0.2));
+        const double a = (1. + 0.5 * std::sin(v * 0.3 + i)) / (i + 1);
+        bank.setFrequency(i, (float)f);
+        bank.setAmplitude(i, (float)a);
+        runPartial(ref[i], (float)f, (float)a, y, x.getConstBuffer());
+      }
+      auto out = bank(x);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        maxError = std::max(maxError, (float)std::fabs(out[n] - y[n]));
+      }
+    }
+    REQUIRE(maxError < 1e-4f);
+  }
+}
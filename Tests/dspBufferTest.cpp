@@ -205,6 +205,16 @@ TEST_CASE("madronalib/core/dspbuffer/vectors", "[dspbuffer][vectors]")
   }
 
   REQUIRE(inputVec == outputVec);
+
+  // vectors of other lengths can be written and read back in different sizes.
+  DSPVectorArrayN<2, 16> shortVec{columnIndex<2, 16>()};
+  DSPVectorN<32> longVec;
+  for (int i = 0; i < 8; ++i)
+  {
+    buf.write(shortVec);
+    buf.read(longVec);
+  }
+  REQUIRE(longVec == DSPVectorN<32>(shortVec.getConstBuffer()));
 }
 
 TEST_CASE("madronalib/core/dspbuffer/peek", "[dspbuffer][peek]")
@@ -239,6 +249,218 @@ TEST_CASE("madronalib/core/dspbuffer/peek", "[dspbuffer][peek]")
   REQUIRE(floatVec[19] == 128);
 }
 
+TEST_CASE("madronalib/core/dspbuffer/regions", "[dspbuffer][regions]")
+{
+  DSPBuffer buf;
+  buf.resize(256);
+
+  // move to near end
+  buf.commitWrite(250);
+  buf.consume(250);
+  REQUIRE(buf.getReadAvailable() == 0);
+
+  // reserve space across the end, as two regions, and write a ramp in place.
+  auto writeRegions = buf.reserveWrite(20);
+  REQUIRE(writeRegions.size1 == 6);
+  REQUIRE(writeRegions.size2 == 14);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    float *p = (i < writeRegions.size1) ? writeRegions.p1 + i : writeRegions.p2 + i - 6;
+    *p = (float)i;
+  }
+  REQUIRE(buf.getReadAvailable() == 0);
+  buf.commitWrite(20);
+  REQUIRE(buf.getReadAvailable() == 20);
+
+  // peek at the same regions without moving the read index.
+  auto readRegions = buf.peekRead(20);
+  REQUIRE(readRegions.p1 == writeRegions.p1);
+  REQUIRE(readRegions.p2 == writeRegions.p2);
+  REQUIRE(buf.getReadAvailable() == 20);
+  REQUIRE(readRegions.p2[13] == 19.f);
+
+  // consume part, then read the rest with a copy.
+  buf.consume(10);
+  std::vector<float> rest(10);
+  REQUIRE(buf.read(rest.data(), 10) == 10);
+  REQUIRE(rest[0] == 10.f);
+  REQUIRE(rest[9] == 19.f);
+
+  // consume never releases more samples than are available.
+  buf.commitWrite(5);
+  buf.consume(10);
+  REQUIRE(buf.getReadAvailable() == 0);
+  REQUIRE(buf.getWriteAvailable() == 256);
+
+  // the regions are empty if there are not enough samples or space.
+  REQUIRE(buf.peekRead(1).p1 == nullptr);
+  REQUIRE(buf.peekRead(1).size1 == 0);
+  REQUIRE(buf.reserveWrite(257).p1 == nullptr);
+}
+
+TEST_CASE("madronalib/core/dspbuffer/mirrored", "[dspbuffer][mirrored]")
+{
+  DSPBuffer buf;
+  buf.resize(256, DSPBuffer::kMirroredStorage);
+  if (!buf.isMirrored())
+  {
+    // without mirrored storage, the buffer falls back to a std::vector.
+    REQUIRE(buf.getWriteAvailable() == 256);
+    return;
+  }
+
+  // a mirrored buffer is at least one page long.
+  const size_t size = buf.getWriteAvailable();
+  REQUIRE(size >= 256);
+  REQUIRE(size * sizeof(float) >= MirroredMemory::getPageSize());
+
+  // write to near end
+  std::vector<float> nines(size, 9.f);
+  buf.write(nines.data(), size - 10);
+  buf.read(nines.data(), size - 10);
+
+  // writes and reads across the end are contiguous.
+  DSPVector v1(columnIndex());
+  buf.write(v1);
+  auto readRegions = buf.peekRead(kFloatsPerDSPVector);
+  REQUIRE(readRegions.size1 == kFloatsPerDSPVector);
+  REQUIRE(readRegions.p2 == nullptr);
+  REQUIRE(DSPVector(readRegions.p1) == v1);
+  buf.consume(kFloatsPerDSPVector);
+  REQUIRE(buf.getReadAvailable() == 0);
+
+  // write in place across the end.
+  buf.resize(256, DSPBuffer::kMirroredStorage);
+  buf.write(nines.data(), size - 10);
+  buf.discard(size - 10);
+  auto writeRegions = buf.reserveWrite(20);
+  REQUIRE(writeRegions.size1 == 20);
+  REQUIRE(writeRegions.p2 == nullptr);
+  std::copy(v1.getConstBuffer(), v1.getConstBuffer() + 20, writeRegions.p1);
+  buf.commitWrite(20);
+  REQUIRE(buf.getReadAvailable() == 20);
+  std::vector<float> readBack(20);
+  buf.read(readBack.data(), 20);
+  REQUIRE(std::equal(readBack.begin(), readBack.end(), v1.getConstBuffer()));
+
+  // not more than the available samples or space can be peeked or reserved.
+  REQUIRE(buf.peekRead(1).p1 == nullptr);
+  REQUIRE(buf.reserveWrite(size + 1).p1 == nullptr);
+
+  // copies are mirrored too.
+  buf.write(v1);
+  DSPBuffer copy(buf);
+  REQUIRE(copy.isMirrored());
+}
+
+TEST_CASE("madronalib/core/dspbuffer/mirrored/in_place", "[dspbuffer][mirrored]")
+{
+  // write and read chunks of an odd size that often wrap. Copying through
+  // vector storage, copying through mirrored storage, and writing and reading
+  // mirrored storage in place should all return the same samples.
+  constexpr size_t kChunk{61};
+  constexpr int kChunks{40};
+  DSPBuffer vectorBuf, mirroredBuf, inPlaceBuf;
+  vectorBuf.resize(1024);
+  mirroredBuf.resize(1024, DSPBuffer::kMirroredStorage);
+  inPlaceBuf.resize(1024, DSPBuffer::kMirroredStorage);
+
+  std::vector<float> src(kChunk);
+  std::vector<float> vectorOut, mirroredOut, inPlaceOut;
+  std::vector<float> dest(kChunk);
+  for (int i = 0; i < kChunks; ++i)
+  {
+    for (size_t j = 0; j < kChunk; ++j)
+    {
+      src[j] = static_cast<float>(i * kChunk + j);
+    }
+
+    vectorBuf.write(src.data(), kChunk);
+    vectorBuf.read(dest.data(), kChunk);
+    vectorOut.insert(vectorOut.end(), dest.begin(), dest.end());
+
+    mirroredBuf.write(src.data(), kChunk);
+    mirroredBuf.read(dest.data(), kChunk);
+    mirroredOut.insert(mirroredOut.end(), dest.begin(), dest.end());
+
+    // with vector storage, if mirroring is not available here, the regions may
+    // be split in two.
+    auto writeRegions = inPlaceBuf.reserveWrite(kChunk);
+    REQUIRE(writeRegions.p1 != nullptr);
+    std::copy(src.begin(), src.begin() + writeRegions.size1, writeRegions.p1);
+    std::copy(src.begin() + writeRegions.size1, src.end(), writeRegions.p2);
+    inPlaceBuf.commitWrite(kChunk);
+    auto readRegions = inPlaceBuf.peekRead(kChunk);
+    REQUIRE(readRegions.p1 != nullptr);
+    inPlaceOut.insert(inPlaceOut.end(), readRegions.p1, readRegions.p1 + readRegions.size1);
+    inPlaceOut.insert(inPlaceOut.end(), readRegions.p2, readRegions.p2 + readRegions.size2);
+    inPlaceBuf.consume(kChunk);
+  }
+
+  REQUIRE(vectorOut.size() == kChunk * kChunks);
+  REQUIRE(vectorOut[kChunk * kChunks - 1] == kChunk * kChunks - 1);
+  REQUIRE(mirroredOut == vectorOut);
+  REQUIRE(inPlaceOut == vectorOut);
+}
+
+TEST_CASE("madronalib/core/dspbuffer/mirrored/time", "[dspbuffer][mirrored][time]")
+{
+  // write and read chunks of an odd size that often wrap, with vector and
+  // mirrored storage, by copying with write() and read() and in place with
+  // reserveWrite() / commitWrite() and peekRead() / consume().
+  constexpr size_t kChunk{61};
+  constexpr int kChunks{16};
+  DSPBuffer vectorBuf, mirroredBuf;
+  vectorBuf.resize(1024);
+  mirroredBuf.resize(1024, DSPBuffer::kMirroredStorage);
+  std::vector<float> src(kChunk, 1.f), dest(kChunk);
+
+  auto copyFn = [&](DSPBuffer& buf)
+  {
+    return [&, pBuf = &buf]()
+    {
+      for (int i = 0; i < kChunks; ++i)
+      {
+        pBuf->write(src.data(), kChunk);
+        pBuf->read(dest.data(), kChunk);
+      }
+      return dest[0];
+    };
+  };
+  auto inPlaceFn = [&](DSPBuffer& buf)
+  {
+    return [&, pBuf = &buf]()
+    {
+      float sum{0};
+      for (int i = 0; i < kChunks; ++i)
+      {
+        auto w = pBuf->reserveWrite(kChunk);
+        std::copy(src.begin(), src.begin() + w.size1, w.p1);
+        std::copy(src.begin() + w.size1, src.end(), w.p2);
+        pBuf->commitWrite(kChunk);
+        auto r = pBuf->peekRead(kChunk);
+        sum += r.size2 ? r.p2[r.size2 - 1] : r.p1[r.size1 - 1];
+        pBuf->consume(kChunk);
+      }
+      return sum;
+    };
+  };
+
+  using namespace testUtils;
+  TimedResult<float> vectorCopyTime = timeIterations<float>(copyFn(vectorBuf));
+  TimedResult<float> vectorInPlaceTime = timeIterations<float>(inPlaceFn(vectorBuf));
+  TimedResult<float> mirroredCopyTime = timeIterations<float>(copyFn(mirroredBuf));
+  TimedResult<float> mirroredInPlaceTime = timeIterations<float>(inPlaceFn(mirroredBuf));
+
+  /*
+  std::cout << "DSPBuffer nanoseconds per " << kChunks << " chunks:\n";
+  std::cout << "vector storage, copy: " << vectorCopyTime.ns
+            << ", in place: " << vectorInPlaceTime.ns << "\n";
+  std::cout << "mirrored storage, copy: " << mirroredCopyTime.ns
+            << ", in place: " << mirroredInPlaceTime.ns << "\n";
+  */
+}
+
 TEST_CASE("madronalib/core/dspbuffer/vector", "[dspbuffer][peek]")
 {
 
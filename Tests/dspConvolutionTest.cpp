@@ -0,0 +1,148 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// a unit test made using the Catch framework in catch.hpp / tests.cpp.
+
+#include <vector>
+
+#include "catch.hpp"
+#include "testUtils.h"
+#include "MLDSPConvolution.h"
+#include "MLDSPGens.h"
+
+using namespace ml;
+using namespace testUtils;
+
+namespace
+{
+// a direct form FIR filter, for comparison.
+class DirectFIR
+{
+ public:
+  explicit DirectFIR(const std::vector<float>& ir)
+      : mIR(ir.rbegin(), ir.rend()), mHistory(ir.size() + kFloatsPerDSPVector)
+  {
+  }
+
+  DSPVector operator()(const DSPVector x)
+  {
+    const size_t taps = mIR.size();
+    std::copy(mHistory.begin() + kFloatsPerDSPVector, mHistory.end(), mHistory.begin());
+    std::copy_n(x.getConstBuffer(), kFloatsPerDSPVector, mHistory.end() - kFloatsPerDSPVector);
+    DSPVector y;
+    for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+    {
+      // the history starts taps - 1 samples before x[0].
+      const float* px = mHistory.data() + n + 1;
+      float sum{0};
+      for (size_t m = 0; m < taps; ++m)
+      {
+        sum += mIR[m] * px[m];
+      }
+      y[n] = sum;
+    }
+    return y;
+  }
+
+ private:
+  std::vector<float> mIR;
+  std::vector<float> mHistory;
+};
+
+// the largest difference between the outputs of a and b for noise input.
+template <typename A, typename B>
+float maxDifference(A& a, B& b, int vectors)
+{
+  NoiseGen noise;
+  float maxDiff{0};
+  for (int i = 0; i < vectors; ++i)
+  {
+    DSPVector x = noise();
+    maxDiff = std::max(maxDiff, max(abs(a(x) - b(x))));
+  }
+  return maxDiff;
+}
+
+std::vector<float> makeImpulseResponse(size_t length)
+{
+  // decaying noise.
+  NoiseGen noise;
+  std::vector<float> ir(length);
+  for (size_t n = 0; n < length; ++n)
+  {
+    ir[n] = noise.getSample() * expf(-4.f * n / length) * 0.1f;
+  }
+  return ir;
+}
+}  // namespace
+
+TEST_CASE("madronalib/core/dsp_convolution", "[dsp_convolution]")
+{
+  ConvolutionReverb<256>::prepare();
+
+  SECTION("head only")
+  {
+    auto ir = makeImpulseResponse(300);
+    ConvolutionReverb<256> reverb;
+    reverb.setImpulseResponse(ir.data(), ir.size(), false);
+    DirectFIR fir(ir);
+    REQUIRE(maxDifference(reverb, fir, 32) < 1e-5f);
+  }
+
+  SECTION("tail")
+  {
+    // the tail partitions start at 256 samples. 2000 samples needs 7 of them.
+    auto ir = makeImpulseResponse(2000);
+    ConvolutionReverb<256> reverb;
+    reverb.setImpulseResponse(ir.data(), ir.size());
+    DirectFIR fir(ir);
+    REQUIRE(maxDifference(reverb, fir, 128) < 1e-5f);
+  }
+
+  SECTION("impulse")
+  {
+    // an impulse at the input should output the impulse response immediately.
+    auto ir = makeImpulseResponse(1000);
+    ConvolutionReverb<256> reverb;
+    reverb.setImpulseResponse(ir.data(), ir.size());
+    std::vector<float> y;
+    DSPVector x;
+    x[0] = 1.f;
+    for (int i = 0; i < 20; ++i)
+    {
+      DSPVector vy = reverb(x);
+      y.insert(y.end(), vy.getConstBuffer(), vy.getConstBuffer() + kFloatsPerDSPVector);
+      x = DSPVector();
+    }
+    float maxDiff{0};
+    for (size_t n = 0; n < y.size(); ++n)
+    {
+      maxDiff = std::max(maxDiff, fabsf(y[n] - (n < ir.size() ? ir[n] : 0.f)));
+    }
+    REQUIRE(maxDiff < 1e-5f);
+  }
+
+  SECTION("time")
+  {
+    // compare the partitioned convolution with a direct form FIR over the same
+    // 4096-sample impulse response.
+    ConvolutionReverb<>::prepare();
+    auto ir = makeImpulseResponse(4096);
+    ConvolutionReverb<> reverb;
+    reverb.setImpulseResponse(ir.data(), ir.size());
+    DirectFIR fir(ir);
+
+    NoiseGen noise;
+    DSPVector x = noise();
+    std::function<DSPVector(void)> reverbFn = [&]() { return reverb(x); };
+    std::function<DSPVector(void)> firFn = [&]() { return fir(x); };
+    TimedResult<DSPVector> reverbTime = timeIterations<DSPVector>(reverbFn);
+    TimedResult<DSPVector> firTime = timeIterations<DSPVector>(firFn);
+
+    /*
+    std::cout << "4096 taps, nanoseconds per vector: direct FIR: " << firTime.ns
+              << ", ConvolutionReverb: " << reverbTime.ns << "\n";
+    */
+  }
+}
@@ -0,0 +1,175 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// a unit test made using the Catch framework in catch.hpp / tests.cpp.
+
+#include <cmath>
+#include <vector>
+
+#include "catch.hpp"
+#include "testUtils.h"
+#include "MLDSPFFT.h"
+#include "MLDSPFunctional.h"
+#include "MLDSPGens.h"
+
+using namespace ml;
+
+TEST_CASE("madronalib/core/dsp_fft", "[dsp_fft]")
+{
+  constexpr size_t kSize{128};
+  constexpr size_t kBins{kSize / 2};
+  FFT<kSize>::prepare();
+
+  NoiseGen noise;
+  DSPVectorN<kSize> x = noise.operator()<kSize>();
+
+  SECTION("forward")
+  {
+    // compare with a direct DFT in double precision. This also checks the sign
+    // convention: X[k] = sum x[n] e^(-2 pi i k n / N).
+    auto spectrum = FFT<kSize>::forward(x);
+    float maxDiff{0};
+    for (size_t k = 0; k <= kBins; ++k)
+    {
+      double re{0}, im{0};
+      for (size_t n = 0; n < kSize; ++n)
+      {
+        double phase = -2. * kPi * double(k * n % kSize) / kSize;
+        re += x[n] * std::cos(phase);
+        im += x[n] * std::sin(phase);
+      }
+      if (k == 0)
+      {
+        maxDiff = std::max(maxDiff, fabsf(spectrum.constRow(0)[0] - float(re)));
+      }
+      else if (k == kBins)
+      {
+        maxDiff = std::max(maxDiff, fabsf(spectrum.constRow(1)[0] - float(re)));
+      }
+      else
+      {
+        maxDiff = std::max(maxDiff, fabsf(spectrum.constRow(0)[k] - float(re)));
+        maxDiff = std::max(maxDiff, fabsf(spectrum.constRow(1)[k] - float(im)));
+      }
+    }
+    REQUIRE(maxDiff < 1e-4f);
+  }
+
+  SECTION("inverse")
+  {
+    auto y = FFT<kSize>::inverse(FFT<kSize>::forward(x));
+    REQUIRE(max(abs(y - x)) < 1e-6f);
+  }
+
+  SECTION("convolution")
+  {
+    // multiplying spectra should make the circular convolution of the signals.
+    DSPVectorN<kSize> h = noise.operator()<kSize>();
+    auto y = FFT<kSize>::inverse(multiplySpectra(FFT<kSize>::forward(x), FFT<kSize>::forward(h)));
+
+    float maxDiff{0};
+    for (size_t n = 0; n < kSize; ++n)
+    {
+      double sum{0};
+      for (size_t m = 0; m < kSize; ++m)
+      {
+        sum += double(x[m]) * h[(n + kSize - m) % kSize];
+      }
+      maxDiff = std::max(maxDiff, fabsf(y[n] - float(sum)));
+    }
+    REQUIRE(maxDiff < 1e-4f);
+
+    // multiplyAddSpectra(a, b, c) == multiplySpectra(a, b) + c.
+    auto fx = FFT<kSize>::forward(x);
+    auto fh = FFT<kSize>::forward(h);
+    auto sum = multiplyAddSpectra(fx, fh, fx);
+    auto expected = multiplySpectra(fx, fh) + fx;
+    REQUIRE(max(abs(sum.constRow(0) - expected.constRow(0))) < 1e-4f);
+    REQUIRE(max(abs(sum.constRow(1) - expected.constRow(1))) < 1e-4f);
+  }
+
+  SECTION("magnitudes")
+  {
+    // a cosine at bin 4 with amplitude 1 has a magnitude of kSize / 2 in that bin.
+    DSPVectorN<kSize> c;
+    for (size_t n = 0; n < kSize; ++n)
+    {
+      c[n] = std::cos(kTwoPi * 4 * n / kSize);
+    }
+    auto m = magnitudes(FFT<kSize>::forward(c));
+    REQUIRE(fabsf(m[4] - kSize / 2) < 1e-3f);
+    REQUIRE(m[5] < 1e-3f);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_fft/overlap_add", "[dsp_fft][overlap_add]")
+{
+  // with a process function that returns its input, or transforms and inverse
+  // transforms it, the output should be the input delayed by the latency. The
+  // windows only sum to 1 once the first frames have overlapped, so skip those.
+  constexpr int kVectors{16};
+  NoiseGen noise;
+  std::vector<DSPVectorArray<2> > inputs;
+  for (int i = 0; i < kVectors; ++i)
+  {
+    DSPVectorArray<2> x;
+    x.row(0) = noise();
+    x.row(1) = noise();
+    inputs.push_back(x);
+  }
+
+  auto testReconstruction = [&](auto& ola, auto fn)
+  {
+    const int latency = ola.getLatency();
+    std::vector<float> x, y;
+    for (int i = 0; i < kVectors; ++i)
+    {
+      auto vy = ola(fn, inputs[i]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        x.push_back(inputs[i].constRow(1)[n]);
+        y.push_back(vy.constRow(0)[n]);
+      }
+    }
+    float maxDiff{0};
+    for (size_t n = latency + 512; n < y.size(); ++n)
+    {
+      maxDiff = std::max(maxDiff, fabsf(y[n] - x[n - latency]));
+    }
+    return maxDiff;
+  };
+
+  // return input row 1, to check that the rows are kept apart.
+  auto secondRow = [](const DSPVectorArrayN<2, 256>& frame)
+  {
+    DSPVectorArrayN<1, 256> y = frame.constRow(1);
+    return y;
+  };
+
+  SECTION("long hop")
+  {
+    OverlapAddFunction<256, 4, 2, 1> ola;
+    REQUIRE(ola.getLatency() == 256 - kFloatsPerDSPVector);
+    REQUIRE(testReconstruction(ola, secondRow) < 1e-5f);
+  }
+
+  SECTION("short hop")
+  {
+    OverlapAddFunction<256, 8, 2, 1> ola(dspwindows::hamming);
+    REQUIRE(ola.getLatency() == 256 - 32);
+    REQUIRE(testReconstruction(ola, secondRow) < 1e-5f);
+  }
+
+  SECTION("spectral")
+  {
+    FFT<256>::prepare();
+    OverlapAddFunction<256, 4, 2, 1> ola;
+    auto spectralIdentity = [](const DSPVectorArrayN<2, 256>& frame)
+    {
+      DSPVectorArrayN<1, 256> y = FFT<256>::inverse(FFT<256>::forward(frame.constRow(1)));
+      return y;
+    };
+    REQUIRE(testReconstruction(ola, spectralIdentity) < 1e-5f);
+  }
+}
@@ -7,6 +7,8 @@
 #include "catch.hpp"
 #include "testUtils.h"
 #include "MLDSPFilters.h"
+#include "MLDSPGens.h"
+#include "MLDSPFunctional.h"
 #include "MLDSPSample.h"
 
 using namespace ml;
@@ -59,3 +61,787 @@ TEST_CASE("madronalib/core/dsp_filters", "[dsp_filters]")
     DSPVector sineOut = downer.read();
   }
 }
+
+TEST_CASE("madronalib/core/dsp_filters/modulated", "[dsp_filters][modulated]")
+{
+  const DSPVector omegas{rangeOpen(0.001f, 0.45f)};
+  const DSPVector ks{rangeOpen(0.1f, 2.f)};
+  const DSPVector gains{rangeOpen(0.25f, 4.f)};
+  auto maxDiff = [](const DSPVector& a, const DSPVector& b) { return max(abs(a - b)); };
+
+  SECTION("coefficients")
+  {
+    // coefficients made for every sample should match the scalar versions.
+    const float kCoeffsTolerance{1e-5f};
+    float lopassDiff{0}, bellDiff{0}, loShelfDiff{0}, hiShelfDiff{0};
+    auto lopassVec = Lopass::makeCoeffsVec(omegas, ks);
+    auto bellVec = Bell::makeCoeffsVec(omegas, ks, gains);
+    auto loShelfVec = LoShelf::makeCoeffsVec(omegas, ks, gains);
+    auto hiShelfVec = HiShelf::makeCoeffsVec(omegas, ks, gains);
+    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    {
+      auto lopass = Lopass::makeCoeffs(omegas[n], ks[n]);
+      for (int i = 0; i < Lopass::nCoeffs; ++i)
+      {
+        lopassDiff = std::max(lopassDiff, fabsf(lopass[i] - lopassVec.constRow(i)[n]));
+      }
+
+      auto bell = Bell::makeCoeffs(omegas[n], ks[n], gains[n]);
+      std::array<float, 4> bellArray{bell.a1, bell.a2, bell.a3, bell.m1};
+      for (int i = 0; i < bellArray.size(); ++i)
+      {
+        bellDiff = std::max(bellDiff, fabsf(bellArray[i] - bellVec.constRow(i)[n]));
+      }
+
+      auto loShelf = LoShelf::makeCoeffs({omegas[n], ks[n], gains[n]});
+      for (int i = 0; i < loShelf.size(); ++i)
+      {
+        loShelfDiff = std::max(loShelfDiff, fabsf(loShelf[i] - loShelfVec.constRow(i)[n]));
+      }
+
+      auto hiShelf = HiShelf::makeCoeffs({omegas[n], ks[n], gains[n]});
+      for (int i = 0; i < hiShelf.size(); ++i)
+      {
+        hiShelfDiff = std::max(hiShelfDiff, fabsf(hiShelf[i] - hiShelfVec.constRow(i)[n]));
+      }
+    }
+    REQUIRE(lopassDiff < kCoeffsTolerance);
+    REQUIRE(bellDiff < kCoeffsTolerance);
+    REQUIRE(loShelfDiff < kCoeffsTolerance);
+    REQUIRE(hiShelfDiff < kCoeffsTolerance);
+  }
+
+  SECTION("constant parameters")
+  {
+    // modulated filters given constant parameters should match the filters with fixed
+    // coefficients.
+    const float kOutputTolerance{1e-4f};
+    const float omega{0.05f}, k{0.5f}, gain{2.f};
+    const DSPVector vOmega(omega), vk(k), vGain(gain);
+
+    Lopass lopass1, lopass2;
+    Hipass hipass1, hipass2;
+    Bandpass bandpass1, bandpass2;
+    Bell bell1, bell2;
+    LoShelf loShelf1, loShelf2;
+    HiShelf hiShelf1, hiShelf2;
+    lopass1.coeffs = Lopass::makeCoeffs(omega, k);
+    hipass1.coeffs = Hipass::makeCoeffs(omega, k);
+    bandpass1.coeffs = Bandpass::makeCoeffs(omega, k);
+    bell1.coeffs = Bell::makeCoeffs(omega, k, gain);
+    loShelf1.coeffs = LoShelf::makeCoeffs({omega, k, gain});
+    hiShelf1.coeffs = HiShelf::makeCoeffs({omega, k, gain});
+
+    NoiseGen noise;
+    std::array<float, 6> diffs{};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVector x = noise();
+      diffs[0] = std::max(diffs[0], maxDiff(lopass1(x), lopass2(x, vOmega, vk)));
+      diffs[1] = std::max(diffs[1], maxDiff(hipass1(x), hipass2(x, vOmega, vk)));
+      diffs[2] = std::max(diffs[2], maxDiff(bandpass1(x), bandpass2(x, vOmega, vk)));
+      diffs[3] = std::max(diffs[3], maxDiff(bell1(x), bell2(x, vOmega, vk, vGain)));
+      diffs[4] = std::max(diffs[4], maxDiff(loShelf1(x), loShelf2(x, vOmega, vk, vGain)));
+      diffs[5] = std::max(diffs[5], maxDiff(hiShelf1(x), hiShelf2(x, vOmega, vk, vGain)));
+    }
+    for (float d : diffs)
+    {
+      REQUIRE(d < kOutputTolerance);
+    }
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/banks", "[dsp_filters][banks]")
+{
+  // six rows, to test a partial group of rows.
+  constexpr size_t kRows{6};
+  const float kTolerance{1e-5f};
+  NoiseGen noise;
+  auto maxRowDiff = [](const DSPVectorArray<kRows>& a, const DSPVectorArray<kRows>& b) {
+    float d{0};
+    for (int j = 0; j < kRows; ++j)
+    {
+      d = std::max(d, max(abs(a.constRow(j) - b.constRow(j))));
+    }
+    return d;
+  };
+
+  SECTION("one pole")
+  {
+    Bank<OnePole, kRows> scalarBank;
+    OnePoleBank<kRows> simdBank;
+    for (int j = 0; j < kRows; ++j)
+    {
+      auto c = OnePole::makeCoeffs(0.01f * (j + 1));
+      scalarBank[j].coeffs = c;
+      simdBank.setCoeffs(j, c);
+    }
+    float d{0};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVectorArray<kRows> x = map([&](DSPVector) { return noise(); }, DSPVectorArray<kRows>());
+      d = std::max(d, maxRowDiff(scalarBank(x), simdBank(x)));
+    }
+    REQUIRE(d < kTolerance);
+  }
+
+  SECTION("svf")
+  {
+    // each row gets a different filter type and frequency.
+    Lopass lopass[2];
+    Bandpass bandpass[2];
+    Hipass hipass[2];
+    SVFBank<kRows> simdBank;
+    for (int j = 0; j < 2; ++j)
+    {
+      float omega = 0.02f * (j + 1);
+      float k = 0.3f + j;
+      lopass[j].coeffs = Lopass::makeCoeffs(omega, k);
+      bandpass[j].coeffs = Bandpass::makeCoeffs(omega, k);
+      hipass[j].coeffs = Hipass::makeCoeffs(omega, k);
+      simdBank.setCoeffs(j * 3, SVFBank<kRows>::lopassCoeffs(omega, k));
+      simdBank.setCoeffs(j * 3 + 1, SVFBank<kRows>::bandpassCoeffs(omega, k));
+      simdBank.setCoeffs(j * 3 + 2, SVFBank<kRows>::hipassCoeffs(omega, k));
+    }
+    float d{0};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVectorArray<kRows> x = map([&](DSPVector) { return noise(); }, DSPVectorArray<kRows>());
+      DSPVectorArray<kRows> y{kUninitialized};
+      for (int j = 0; j < 2; ++j)
+      {
+        y.row(j * 3) = lopass[j](x.constRow(j * 3));
+        y.row(j * 3 + 1) = bandpass[j](x.constRow(j * 3 + 1));
+        y.row(j * 3 + 2) = hipass[j](x.constRow(j * 3 + 2));
+      }
+      d = std::max(d, maxRowDiff(y, simdBank(x)));
+    }
+    REQUIRE(d < kTolerance);
+  }
+
+  SECTION("biquad")
+  {
+    // compare with a scalar transposed direct form II filter.
+    BiquadBank<kRows> simdBank;
+    std::array<BiquadBank<kRows>::Coeffs, kRows> coeffs;
+    std::array<float, kRows> s1{}, s2{};
+    for (int j = 0; j < kRows; ++j)
+    {
+      float omega = 0.02f * (j + 1);
+      coeffs[j] = (j & 1) ? BiquadBank<kRows>::hipassCoeffs(omega, 0.7f)
+                          : BiquadBank<kRows>::lopassCoeffs(omega, 0.7f);
+      simdBank.setCoeffs(j, coeffs[j]);
+    }
+    float d{0};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVectorArray<kRows> x = map([&](DSPVector) { return noise(); }, DSPVectorArray<kRows>());
+      DSPVectorArray<kRows> y{kUninitialized};
+      for (int j = 0; j < kRows; ++j)
+      {
+        auto c = coeffs[j];
+        for (int n = 0; n < kFloatsPerDSPVector; ++n)
+        {
+          float x0 = x.constRow(j)[n];
+          float y0 = c.b0 * x0 + s1[j];
+          s1[j] = c.b1 * x0 - c.a1 * y0 + s2[j];
+          s2[j] = c.b2 * x0 - c.a2 * y0;
+          y.row(j)[n] = y0;
+        }
+      }
+      d = std::max(d, maxRowDiff(y, simdBank(x)));
+    }
+    REQUIRE(d < kTolerance);
+
+    // a lowpass should settle to unity gain at DC.
+    BiquadBank<kRows> lopassBank;
+    lopassBank.setCoeffs(BiquadBank<kRows>::lopassCoeffs(0.05f, 0.7f));
+    DSPVectorArray<kRows> ones(1.f), y;
+    for (int i = 0; i < 16; ++i)
+    {
+      y = lopassBank(ones);
+    }
+    REQUIRE(fabsf(y.constRow(kRows - 1)[kFloatsPerDSPVector - 1] - 1.f) < kTolerance);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/parallel", "[dsp_filters][parallel]")
+{
+  // processParallel() computes the same filters as operator() four samples at a time, so the
+  // outputs differ by rounding only. The differences are measured relative to the peak output,
+  // over 32 vectors of noise. The largest is about 2e-6. The Integrator's difference grows
+  // slowly with its output, to about 1.2e-5 after 200 vectors.
+  const float kTolerance{2e-5f};
+  auto relativeDiff = [](auto& filter1, auto& filter2) {
+    NoiseGen noise;
+    float diff{0}, peak{0};
+    for (int i = 0; i < 32; ++i)
+    {
+      DSPVector x = noise();
+      DSPVector y1 = filter1(x);
+      DSPVector y2 = filter2.processParallel(x);
+      diff = std::max(diff, max(abs(y1 - y2)));
+      peak = std::max(peak, max(abs(y1)));
+    }
+    return diff / peak;
+  };
+
+  SECTION("first order")
+  {
+    OnePole onePole1, onePole2;
+    onePole1.coeffs = onePole2.coeffs = OnePole::makeCoeffs(0.01f);
+    REQUIRE(relativeDiff(onePole1, onePole2) < kTolerance);
+
+    DCBlocker dcBlocker1, dcBlocker2;
+    dcBlocker1.coeffs = dcBlocker2.coeffs = DCBlocker::makeCoeffs(0.045f);
+    REQUIRE(relativeDiff(dcBlocker1, dcBlocker2) < kTolerance);
+
+    Integrator integrator1, integrator2;
+    integrator1.mLeak = integrator2.mLeak = 0.001f;
+    REQUIRE(relativeDiff(integrator1, integrator2) < kTolerance);
+  }
+
+  SECTION("second order")
+  {
+    // include a low, resonant lowpass, which is the most sensitive to rounding.
+    Lopass lopass1, lopass2, lopassLow1, lopassLow2;
+    lopass1.coeffs = lopass2.coeffs = Lopass::makeCoeffs(0.05f, 0.5f);
+    lopassLow1.coeffs = lopassLow2.coeffs = Lopass::makeCoeffs(0.002f, 0.1f);
+    REQUIRE(relativeDiff(lopass1, lopass2) < kTolerance);
+    REQUIRE(relativeDiff(lopassLow1, lopassLow2) < kTolerance);
+
+    Hipass hipass1, hipass2;
+    hipass1.coeffs = hipass2.coeffs = Hipass::makeCoeffs(0.05f, 0.5f);
+    REQUIRE(relativeDiff(hipass1, hipass2) < kTolerance);
+
+    Bandpass bandpass1, bandpass2;
+    bandpass1.coeffs = bandpass2.coeffs = Bandpass::makeCoeffs(0.05f, 0.5f);
+    REQUIRE(relativeDiff(bandpass1, bandpass2) < kTolerance);
+
+    LoShelf loShelf1, loShelf2;
+    loShelf1.coeffs = loShelf2.coeffs = LoShelf::makeCoeffs({0.05f, 0.5f, 2.f});
+    REQUIRE(relativeDiff(loShelf1, loShelf2) < kTolerance);
+
+    HiShelf hiShelf1, hiShelf2;
+    hiShelf1.coeffs = hiShelf2.coeffs = HiShelf::makeCoeffs({0.05f, 0.5f, 2.f});
+    REQUIRE(relativeDiff(hiShelf1, hiShelf2) < kTolerance);
+
+    Bell bell1, bell2;
+    bell1.coeffs = bell2.coeffs = Bell::makeCoeffs(0.05f, 0.5f, 2.f);
+    REQUIRE(relativeDiff(bell1, bell2) < kTolerance);
+  }
+
+  SECTION("other lengths")
+  {
+    // the state carries over correctly between vectors of any length.
+    Lopass lopass1, lopass2;
+    lopass1.coeffs = lopass2.coeffs = Lopass::makeCoeffs(0.05f, 0.5f);
+    NoiseGen noise;
+    float diff{0};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVectorN<16> x = noise.operator()<16>();
+      diff = std::max(diff, max(abs(lopass1(x) - lopass2.processParallel(x))));
+    }
+    REQUIRE(diff < kTolerance);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/oversampling", "[dsp_filters][oversampling]")
+{
+  constexpr size_t kRows{6};
+  const float kTolerance{1e-5f};
+  NoiseGen noise;
+  auto makeNoise = [&]() {
+    DSPVectorArray<kRows> x;
+    for (int j = 0; j < kRows; ++j)
+    {
+      x.row(j) = noise();
+    }
+    return x;
+  };
+
+  SECTION("half band bank")
+  {
+    // each row of the bank should match a HalfBandFilter.
+    HalfBandBank<kRows> upBank, downBank;
+    std::array<HalfBandFilter, kRows> ups, downs;
+    float diff{0};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVectorArray<kRows> x = makeNoise();
+      DSPVectorArray<kRows> y1, y2;
+      upBank.upsample(x, y1, y2);
+      DSPVectorArray<kRows> z = downBank.downsample(y1, y2);
+      for (int j = 0; j < kRows; ++j)
+      {
+        DSPVector u1 = ups[j].upsampleFirstHalf(x.constRow(j));
+        DSPVector u2 = ups[j].upsampleSecondHalf(x.constRow(j));
+        DSPVector d = downs[j].downsample(u1, u2);
+        diff = std::max(diff, max(abs(u1 - y1.constRow(j))));
+        diff = std::max(diff, max(abs(u2 - y2.constRow(j))));
+        diff = std::max(diff, max(abs(d - z.constRow(j))));
+      }
+    }
+    REQUIRE(diff < kTolerance);
+  }
+
+  SECTION("2x")
+  {
+    // at 2x, should match Upsample2xFunction.
+    OversampleFunction<2, 1> over;
+    Upsample2xFunction<1> up2;
+    auto square = [](const DSPVectorArray<1>& x) { return x * x; };
+    float diff{0};
+    for (int i = 0; i < 8; ++i)
+    {
+      DSPVectorArray<1> x(noise());
+      diff = std::max(diff, max(abs(over(square, x) - up2(square, x))));
+    }
+    REQUIRE(diff < kTolerance);
+  }
+
+  SECTION("group delay")
+  {
+    // a low frequency sine through each factor should come out delayed by the group delay.
+    auto testFactor = [&](auto& over) {
+      const float omega = 0.002f;
+      const float delay = over.getGroupDelay();
+      auto identity = [](const DSPVectorArray<kRows>& x) { return x; };
+      float diff{0};
+      for (int i = 0; i < 16; ++i)
+      {
+        DSPVectorArray<kRows> x, expected;
+        for (int n = 0; n < kFloatsPerDSPVector; ++n)
+        {
+          float t = i * kFloatsPerDSPVector + n;
+          for (int j = 0; j < kRows; ++j)
+          {
+            x.row(j)[n] = sinf(kTwoPi * omega * t);
+            expected.row(j)[n] = sinf(kTwoPi * omega * (t - delay));
+          }
+        }
+        DSPVectorArray<kRows> y = over(identity, x);
+        if (i >= 4)
+        {
+          diff = std::max(diff, max(abs(y.constRow(kRows - 1) - expected.constRow(kRows - 1))));
+        }
+      }
+      return diff;
+    };
+
+    OversampleFunction<2, kRows> over2;
+    OversampleFunction<4, kRows> over4;
+    OversampleFunction<8, kRows> over8;
+    OversampleFunction<16, kRows> over16;
+    REQUIRE(testFactor(over2) < 1e-3f);
+    REQUIRE(testFactor(over4) < 1e-3f);
+    REQUIRE(testFactor(over8) < 1e-3f);
+    REQUIRE(testFactor(over16) < 1e-3f);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/fdn", "[dsp_filters][fdn]")
+{
+  constexpr int kSize{8};
+  const std::array<float, kSize> delays{{301, 353, 397, 449, 503, 557, 601, 661}};
+  const std::array<float, kSize> gains{{0.9f, 0.9f, 0.9f, 0.9f, 0.9f, 0.9f, 0.9f, 0.9f}};
+
+  auto setup = [&](auto& fdn)
+  {
+    fdn.setMaxDelayInSamples(1024.f);
+    fdn.setDelaysInSamples(delays);
+    fdn.setFeedbackGains(gains);
+  };
+
+  // run an impulse through the network and return the outputs.
+  auto impulseResponse = [](auto& fdn, int vectors)
+  {
+    std::vector<DSPVectorArray<2> > y;
+    DSPVector x;
+    x[0] = 1.f;
+    for (int i = 0; i < vectors; ++i)
+    {
+      y.push_back(fdn(x));
+      x = DSPVector();
+    }
+    return y;
+  };
+
+  auto maxDifference = [](const std::vector<DSPVectorArray<2> >& a,
+                          const std::vector<DSPVectorArray<2> >& b)
+  {
+    float diff{0};
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      diff = std::max(diff, max(abs(a[i].constRow(0) - b[i].constRow(0))));
+      diff = std::max(diff, max(abs(a[i].constRow(1) - b[i].constRow(1))));
+    }
+    return diff;
+  };
+
+  SECTION("timing")
+  {
+    // the impulse should first reach output 0 after the shortest delay.
+    FeedbackDelayNetwork<kSize> fdn;
+    setup(fdn);
+    auto y = impulseResponse(fdn, 8);
+    int first{-1};
+    for (int t = 0; t < 8 * kFloatsPerDSPVector && first < 0; ++t)
+    {
+      if (y[t / kFloatsPerDSPVector].constRow(0)[t % kFloatsPerDSPVector] != 0.f) first = t;
+    }
+    REQUIRE(first == 301);
+  }
+
+  SECTION("matrices")
+  {
+    // an arbitrary matrix with the same values should give the same outputs as
+    // the built-in Householder and Hadamard matrices.
+    std::array<std::array<float, kSize>, kSize> householder, hadamard;
+    for (int i = 0; i < kSize; ++i)
+    {
+      for (int j = 0; j < kSize; ++j)
+      {
+        householder[i][j] = (i == j ? 1.f : 0.f) - 2.f / kSize;
+
+        // the sign is negative where i & j has an odd number of bits set.
+        int bits{0};
+        for (int k = i & j; k; k >>= 1)
+        {
+          bits += k & 1;
+        }
+        hadamard[i][j] = ((bits & 1) ? -1.f : 1.f) / sqrtf(kSize);
+      }
+    }
+
+    FeedbackDelayNetwork<kSize> a, b;
+    setup(a);
+    setup(b);
+    b.setMatrix(householder);
+    REQUIRE(maxDifference(impulseResponse(a, 64), impulseResponse(b, 64)) < 1e-5f);
+
+    FeedbackDelayNetwork<kSize> c, d;
+    setup(c);
+    setup(d);
+    c.setHadamardMatrix();
+    d.setMatrix(hadamard);
+    REQUIRE(maxDifference(impulseResponse(c, 64), impulseResponse(d, 64)) < 1e-5f);
+  }
+
+  SECTION("modulated")
+  {
+    // with modulated delay times, the output should stay bounded, and the
+    // impulse should first arrive near the shortest delay.
+    FeedbackDelayNetwork<kSize, 2, PitchbendableDelay> fdn;
+    fdn.setMaxDelayInSamples(1024.f);
+    fdn.setFeedbackGains(gains);
+    fdn.setFilterCutoffs({{0.2f, 0.2f, 0.2f, 0.2f, 0.2f, 0.2f, 0.2f, 0.2f}});
+
+    SineGen lfo;
+    DSPVector x;
+    x[0] = 1.f;
+    float maxOut{0};
+    int first{-1};
+    for (int i = 0; i < 400; ++i)
+    {
+      DSPVector mod = lfo(DSPVector(2.f / 48000.f)) * DSPVector(4.f);
+      DSPVectorArray<kSize> times;
+      for (int n = 0; n < kSize; ++n)
+      {
+        times.row(n) = mod + DSPVector(delays[n]);
+      }
+      auto y = fdn(x, times);
+      x = DSPVector();
+      for (int n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        if (first < 0 && fabsf(y.constRow(0)[n]) > 1e-3f) first = i * kFloatsPerDSPVector + n;
+      }
+      maxOut = std::max(maxOut, max(abs(y.constRow(0))));
+    }
+    REQUIRE(first >= 296);
+    REQUIRE(first <= 306);
+    REQUIRE(maxOut < 2.f);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/modulated_delay", "[dsp_filters][modulated_delay]")
+{
+  // run a delay with input and delay time functions of the time in samples,
+  // and return the largest difference from expected(t) after the delay has
+  // filled.
+  auto maxError = [](auto& delay, auto input, auto delayTime, auto expected)
+  {
+    float maxDiff{0};
+    for (int i = 0; i < 64; ++i)
+    {
+      DSPVector x, d, e;
+      for (int n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        float t = i * kFloatsPerDSPVector + n;
+        x[n] = input(t);
+        d[n] = delayTime(t);
+        e[n] = expected(t);
+      }
+      DSPVector y = delay(x, d);
+      if (i >= 4) maxDiff = std::max(maxDiff, max(abs(y - e)));
+    }
+    return maxDiff;
+  };
+
+  auto testAll = [&](auto input, auto delayTime, auto expected)
+  {
+    ModulatedDelay<kLinearInterpolation> linear(200.f);
+    ModulatedDelay<kHermiteInterpolation> hermite(200.f);
+    ModulatedDelay<kLagrangeInterpolation> lagrange(200.f);
+    return std::array<float, 3>{{maxError(linear, input, delayTime, expected),
+                                 maxError(hermite, input, delayTime, expected),
+                                 maxError(lagrange, input, delayTime, expected)}};
+  };
+
+  SECTION("integer")
+  {
+    // with whole-sample delays, every interpolation should return input samples.
+    auto input = [](float t) { return sinf(t * 0.37f) + cosf(t * 0.011f); };
+    auto delayTime = [](float t) { return 1.f + float(int(t * 0.7f) % 150); };
+    auto expected = [&](float t) { return input(t - delayTime(t)); };
+    for (float e : testAll(input, delayTime, expected))
+    {
+      REQUIRE(e < 1e-6f);
+    }
+  }
+
+  SECTION("ramp")
+  {
+    // all the interpolations are exact for a ramp, even with varying delays.
+    auto input = [](float t) { return t * (1.f / 64.f); };
+    auto delayTime = [](float t) { return 100.f + 90.f * sinf(t * 0.003f); };
+    auto expected = [&](float t) { return (t - delayTime(t)) * (1.f / 64.f); };
+    for (float e : testAll(input, delayTime, expected))
+    {
+      REQUIRE(e < 1e-3f);
+    }
+  }
+
+  SECTION("sine")
+  {
+    // a vibrato: the cubic interpolations should be much more accurate than linear.
+    auto input = [](float t) { return sinf(kTwoPi * 0.02f * t); };
+    auto delayTime = [](float t) { return 50.f + 20.f * sinf(kTwoPi * 0.0005f * t); };
+    auto expected = [&](float t) { return input(t - delayTime(t)); };
+    auto e = testAll(input, delayTime, expected);
+    REQUIRE(e[0] < 5e-3f);
+    REQUIRE(e[1] < 2e-4f);
+    REQUIRE(e[2] < 2e-4f);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/shared_delays", "[dsp_filters][shared_delays]")
+{
+  constexpr int kVectors{40};
+  NoiseGen noise;
+  std::vector<DSPVector> inputs;
+  for (int i = 0; i < kVectors; ++i)
+  {
+    inputs.push_back(noise());
+  }
+
+  // slowly changing delay times for row j.
+  auto modulatedTimes = [](int rows, int i)
+  {
+    std::vector<DSPVector> times;
+    for (int j = 0; j < rows; ++j)
+    {
+      DSPVector d;
+      for (int n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        float t = i * kFloatsPerDSPVector + n;
+        d[n] = 20.f + 30.f * j + 10.f * sinf(0.001f * (j + 1) * t);
+      }
+      times.push_back(d);
+    }
+    return times;
+  };
+
+  SECTION("multi tap")
+  {
+    // constant taps should match IntegerDelay and ModulatedDelay.
+    MultiTapDelay<3, kLinearInterpolation> taps(200.f);
+    taps.setDelaysInSamples({{0.f, 100.f, 50.5f}});
+    IntegerDelay integer(100);
+    ModulatedDelay<kLinearInterpolation> fractional(200.f);
+    float maxDiff{0};
+    for (int i = 0; i < kVectors; ++i)
+    {
+      auto y = taps(inputs[i]);
+      maxDiff = std::max(maxDiff, max(abs(y.constRow(0) - inputs[i])));
+      maxDiff = std::max(maxDiff, max(abs(y.constRow(1) - integer(inputs[i]))));
+      maxDiff = std::max(maxDiff, max(abs(y.constRow(2) - fractional(inputs[i], 50.5f))));
+    }
+    REQUIRE(maxDiff < 1e-6f);
+
+    // modulated taps should match ModulatedDelay.
+    MultiTapDelay<2> modulatedTaps(200.f);
+    std::array<ModulatedDelay<>, 2> delays;
+    delays[0].setMaxDelayInSamples(200.f);
+    delays[1].setMaxDelayInSamples(200.f);
+    maxDiff = 0;
+    for (int i = 0; i < kVectors; ++i)
+    {
+      auto times = modulatedTimes(2, i);
+      DSPVectorArray<2> vTimes;
+      vTimes.row(0) = times[0];
+      vTimes.row(1) = times[1];
+      auto y = modulatedTaps(inputs[i], vTimes);
+      maxDiff = std::max(maxDiff, max(abs(y.constRow(0) - delays[0](inputs[i], times[0]))));
+      maxDiff = std::max(maxDiff, max(abs(y.constRow(1) - delays[1](inputs[i], times[1]))));
+    }
+    REQUIRE(maxDiff < 1e-6f);
+  }
+
+  SECTION("shared memory")
+  {
+    // delays in one block should work the same as delays with their own memory.
+    constexpr int kDelays{4};
+    MultiTapDelay<2> taps, ownTaps(300.f);
+    std::array<ModulatedDelay<>, kDelays> delays, ownDelays;
+    DelayMemory memory;
+    memory.resize(MultiTapDelay<2>::getMemorySize(300.f) +
+                  kDelays * ModulatedDelay<>::getMemorySize(100.f));
+    REQUIRE(memory.assign(taps, 300.f));
+    for (int j = 0; j < kDelays; ++j)
+    {
+      REQUIRE(memory.assign(delays[j], 100.f));
+      ownDelays[j].setMaxDelayInSamples(100.f);
+    }
+    REQUIRE(!memory.assign(ownTaps, 300.f));
+
+    const std::array<float, 2> tapTimes{{300.f, 7.f}};
+    const std::array<float, kDelays> delayTimes{{1.f, 10.f, 50.5f, 100.f}};
+    taps.setDelaysInSamples(tapTimes);
+    ownTaps.setDelaysInSamples(tapTimes);
+
+    float maxDiff{0};
+    for (int i = 0; i < kVectors; ++i)
+    {
+      auto a = taps(inputs[i]);
+      auto b = ownTaps(inputs[i]);
+      for (int j = 0; j < 2; ++j)
+      {
+        maxDiff = std::max(maxDiff, max(abs(a.constRow(j) - b.constRow(j))));
+      }
+      for (int j = 0; j < kDelays; ++j)
+      {
+        const DSPVector x = inputs[(i + j) % kVectors];
+        auto c = delays[j](x, delayTimes[j]);
+        auto d = ownDelays[j](x, delayTimes[j]);
+        maxDiff = std::max(maxDiff, max(abs(c - d)));
+      }
+    }
+    REQUIRE(maxDiff < 1e-6f);
+  }
+
+  SECTION("shared allpass memory")
+  {
+    // allpasses and integer delays in one block should work the same as ones
+    // with their own memory, and so should copies of them.
+    Allpass<PitchbendableDelay> allpass, ownAllpass;
+    IntegerDelay integer, ownInteger(150);
+    DelayMemory memory;
+    memory.resize(Allpass<PitchbendableDelay>::getMemorySize(300.f) +
+                  IntegerDelay::getMemorySize(150.f));
+    REQUIRE(memory.assign(allpass, 300.f));
+    REQUIRE(memory.assign(integer, 150.f));
+    REQUIRE(!memory.assign(ownInteger, 150.f));
+    ownAllpass.setMaxDelayInSamples(300.f);
+    allpass.mGain = ownAllpass.mGain = 0.6f;
+    integer.setDelayInSamples(150);
+    IntegerDelay ownIntegerCopy(ownInteger);
+
+    float maxDiff{0};
+    for (int i = 0; i < kVectors; ++i)
+    {
+      const DSPVector vTime = modulatedTimes(6, i)[5] + DSPVector(kFloatsPerDSPVector);
+      auto a = allpass(inputs[i], vTime);
+      auto b = ownAllpass(inputs[i], vTime);
+      maxDiff = std::max(maxDiff, max(abs(a - b)));
+      auto c = integer(inputs[i]);
+      maxDiff = std::max(maxDiff, max(abs(c - ownInteger(inputs[i]))));
+      maxDiff = std::max(maxDiff, max(abs(c - ownIntegerCopy(inputs[i]))));
+    }
+    REQUIRE(maxDiff < 1e-6f);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_filters/adsr_bank", "[dsp_filters][adsr_bank]")
+{
+  constexpr int kRows{6};
+  constexpr float kSr{48000.f};
+
+  // gates of different lengths and amps, with some retriggers during release.
+  auto makeGates = [](int i)
+  {
+    DSPVectorArray<kRows> x;
+    for (int j = 0; j < kRows; ++j)
+    {
+      for (int n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        int t = i * kFloatsPerDSPVector + n;
+        int period = 1500 + 700 * j;
+        bool on = (t % period) < period / (j + 2);
+        x.row(j)[n] = on ? 0.5f + 0.1f * j : 0.f;
+      }
+    }
+    return x;
+  };
+
+  ADSRBank<kRows> bank;
+  std::array<ADSR, kRows> envelopes;
+  for (int j = 0; j < kRows; ++j)
+  {
+    auto c = ADSR::calcCoeffs(0.001f * (j + 1), 0.01f, 0.1f * j, 0.005f * (j + 1), kSr);
+    bank.setCoeffs(j, c);
+    envelopes[j].coeffs = c;
+  }
+
+  SECTION("scalar")
+  {
+    // the bank should compute the same envelopes as ADSR.
+    float maxDiff{0};
+    for (int i = 0; i < 400; ++i)
+    {
+      auto x = makeGates(i);
+      auto y = bank(x);
+      for (int j = 0; j < kRows; ++j)
+      {
+        maxDiff = std::max(maxDiff, max(abs(y.constRow(j) - envelopes[j](x.constRow(j)))));
+      }
+    }
+    REQUIRE(maxDiff < 1e-6f);
+  }
+
+  SECTION("gate and amp")
+  {
+    // separate gate and amp inputs should work like the combined signal.
+    ADSRBank<kRows> bank2;
+    for (int j = 0; j < kRows; ++j)
+    {
+      bank2.setCoeffs(j, ADSR::calcCoeffs(0.001f * (j + 1), 0.01f, 0.1f * j, 0.005f * (j + 1), kSr));
+    }
+    float maxDiff{0};
+    for (int i = 0; i < 100; ++i)
+    {
+      auto x = makeGates(i);
+      auto gate = select(DSPVectorArray<kRows>(1.f), DSPVectorArray<kRows>(0.f),
+                         greaterThan(x, DSPVectorArray<kRows>(0.f)));
+      auto amp = x + DSPVectorArray<kRows>(1.f) - gate;
+      auto y = bank(x);
+      auto y2 = bank2(gate, amp);
+      for (int j = 0; j < kRows; ++j)
+      {
+        maxDiff = std::max(maxDiff, max(abs(y.constRow(j) - y2.constRow(j))));
+      }
+    }
+    REQUIRE(maxDiff < 1e-6f);
+  }
+}
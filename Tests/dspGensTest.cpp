@@ -4,6 +4,8 @@
 
 // a unit test made using the Catch framework in catch.hpp / tests.cpp.
 
+#include <cstring>
+
 #include "catch.hpp"
 #include "testUtils.h"
 #include "MLDSPGens.h"
@@ -45,3 +47,291 @@ TEST_CASE("madronalib/core/dsp_gens", "[dsp_gens]")
 
   
 }
+
+namespace
+{
+// the scalar phase accumulation of PhasorGen and OneShotGen, for comparison.
+template <size_t LEN>
+DSPVectorN<LEN> scalarPhasor(uint32_t& omega32, const DSPVectorN<LEN> cyclesPerSample)
+{
+  DSPVectorIntN<LEN> steps = roundFloatToInt(cyclesPerSample * PhasorGen::stepsPerCycle);
+  DSPVectorIntN<LEN> omega32V{kUninitialized};
+  for (size_t n = 0; n < LEN; ++n)
+  {
+    omega32 += steps[n];
+    omega32V[n] = omega32;
+  }
+  return unsignedIntToFloat(omega32V) * PhasorGen::cyclesPerStep;
+}
+
+DSPVector scalarOneShot(uint32_t& omega32, uint32_t& gate, const DSPVector cyclesPerSample)
+{
+  DSPVectorInt steps = roundFloatToInt(cyclesPerSample * OneShotGen::stepsPerCycle);
+  DSPVectorInt omega32V{kUninitialized};
+  for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+  {
+    const uint32_t prev = omega32;
+    omega32 += steps[n] * gate;
+    if (omega32 < prev)
+    {
+      gate = 0;
+      omega32 = 0;
+    }
+    omega32V[n] = omega32;
+  }
+  return unsignedIntToFloat(omega32V) * OneShotGen::cyclesPerStep;
+}
+
+template <size_t ROWS, size_t LEN>
+bool bitsEqual(const DSPVectorArrayN<ROWS, LEN>& a, const DSPVectorArrayN<ROWS, LEN>& b)
+{
+  return !std::memcmp(a.getConstBuffer(), b.getConstBuffer(), ROWS * LEN * sizeof(float));
+}
+}  // namespace
+
+TEST_CASE("madronalib/core/dsp_gens/phasor", "[dsp_gens][phasor]")
+{
+  NoiseGen noise;
+
+  SECTION("phasor")
+  {
+    // frequencies from -0.6 to 0.6 cycles per sample, and tiny ones.
+    PhasorGen p64, p16;
+    uint32_t omega64{0}, omega16{0};
+    bool equal{true};
+    for (int i = 0; i < 100; ++i)
+    {
+      DSPVector freq = noise() * ((i & 1) ? 0.6f : 1e-4f);
+      equal &= bitsEqual(p64(freq), scalarPhasor(omega64, freq));
+      DSPVectorN<16> freq16 = noise.operator()<16>() * 0.3f;
+      equal &= bitsEqual(p16(freq16), scalarPhasor(omega16, freq16));
+    }
+    REQUIRE(equal);
+  }
+
+  SECTION("one shot")
+  {
+    // ramps that end at every position within a vector.
+    OneShotGen g;
+    uint32_t omega{0}, gate{0};
+    bool equal{true};
+    for (int i = 0; i < 200; ++i)
+    {
+      if (i % 3 == 0)
+      {
+        g.trigger();
+        omega = 0;
+        gate = 1;
+      }
+      DSPVector freq = DSPVector(0.007f + 0.0001f * i) + noise() * 0.002f;
+      equal &= bitsEqual(g(freq), scalarOneShot(omega, gate, freq));
+    }
+    REQUIRE(equal);
+  }
+
+  SECTION("bank")
+  {
+    constexpr size_t kRows{6};
+    PhasorGenBank<kRows> bank;
+    std::vector<PhasorGen> gens(kRows);
+    bank.clear(2, 12345);
+    gens[2].clear(12345);
+    bool equal{true};
+    for (int i = 0; i < 100; ++i)
+    {
+      DSPVectorArray<kRows> freqs = map([&](DSPVector) { return noise() * 0.6f; },
+                                        DSPVectorArray<kRows>());
+      DSPVectorArray<kRows> y = bank(freqs);
+      for (size_t j = 0; j < kRows; ++j)
+      {
+        equal &= bitsEqual(y.constRow(j), gens[j](freqs.constRow(j)));
+      }
+    }
+    REQUIRE(equal);
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_gens/noise_bank", "[dsp_gens][noise_bank]")
+{
+  constexpr size_t kRows{6};
+  constexpr int kVectors{256};
+
+  // collect the samples of each row over kVectors vectors.
+  auto collect = [&](auto fn)
+  {
+    std::vector<std::vector<float> > rows(kRows);
+    for (int i = 0; i < kVectors; ++i)
+    {
+      DSPVectorArray<kRows> y = fn();
+      for (size_t j = 0; j < kRows; ++j)
+      {
+        rows[j].insert(rows[j].end(), y.constRow(j).getConstBuffer(),
+                       y.constRow(j).getConstBuffer() + kFloatsPerDSPVector);
+      }
+    }
+    return rows;
+  };
+
+  auto mean = [](const std::vector<float>& x)
+  {
+    double sum{0};
+    for (float f : x) sum += f;
+    return sum / x.size();
+  };
+
+  auto moment = [&](const std::vector<float>& x, int k)
+  {
+    double m = mean(x), sum{0};
+    for (float f : x) sum += std::pow(f - m, k);
+    return sum / x.size();
+  };
+
+  SECTION("white")
+  {
+    // each row should match a NoiseGen with the same seed.
+    NoiseBank<kRows> bank;
+    std::array<NoiseGen, kRows> gens;
+    for (size_t j = 0; j < kRows; ++j)
+    {
+      bank.setSeed(j, 1000 + j);
+      gens[j].setSeed(1000 + j);
+    }
+    float maxDiff{0};
+    for (int i = 0; i < 4; ++i)
+    {
+      auto y = bank.white();
+      for (size_t j = 0; j < kRows; ++j)
+      {
+        maxDiff = std::max(maxDiff, max(abs(y.constRow(j) - gens[j]())));
+      }
+    }
+    REQUIRE(maxDiff < 1e-6f);
+
+    // rows with seeds made by setSeeds() should be uncorrelated, and repeat
+    // after reset().
+    bank.setSeeds(1);
+    auto rows = collect([&]() { return bank.white(); });
+    for (size_t j = 1; j < kRows; ++j)
+    {
+      double sum{0};
+      for (size_t n = 0; n < rows[0].size(); ++n) sum += rows[0][n] * rows[j][n];
+      REQUIRE(fabs(sum / rows[0].size()) < 0.02);
+    }
+    bank.reset();
+    REQUIRE(bank.white().constRow(3)[0] == rows[3][0]);
+  }
+
+  SECTION("pink")
+  {
+    // pink noise has equal power in each octave. Compare the power in two
+    // octaves, made by differences of one pole lowpass filters.
+    NoiseBank<kRows> bank;
+    auto rows = collect([&]() { return bank.pink(); });
+    auto octavePower = [](const std::vector<float>& x, float lo)
+    {
+      float a = expf(-kTwoPi * lo), b = expf(-kTwoPi * lo * 2.f);
+      float y1{0}, y2{0};
+      double sum{0};
+      for (float f : x)
+      {
+        y1 = f + a * (y1 - f);
+        y2 = f + b * (y2 - f);
+        sum += (y2 - y1) * (y2 - y1);
+      }
+      return sum / x.size();
+    };
+    for (size_t j = 0; j < kRows; ++j)
+    {
+      double ratio = octavePower(rows[j], 0.005f) / octavePower(rows[j], 0.08f);
+      REQUIRE(ratio > 0.7);
+      REQUIRE(ratio < 1.4);
+    }
+  }
+
+  SECTION("gaussian")
+  {
+    NoiseBank<kRows> bank;
+    auto rows = collect([&]() { return bank.gaussian(); });
+    for (size_t j = 0; j < kRows; ++j)
+    {
+      REQUIRE(fabs(mean(rows[j])) < 0.03);
+      REQUIRE(fabs(moment(rows[j], 2) - 1.) < 0.05);
+      REQUIRE(fabs(moment(rows[j], 4) / 3. - 1.) < 0.1);
+    }
+  }
+}
+
+TEST_CASE("madronalib/core/dsp_gens/smoothers", "[dsp_gens][smoothers]")
+{
+  SECTION("glides")
+  {
+    // a bank should glide like LinearGlides with the same inputs.
+    constexpr size_t kParams{7};
+    ParameterSmootherBank<kParams> bank;
+    std::array<LinearGlide, kParams> glides;
+    for (size_t i = 0; i < kParams; ++i)
+    {
+      const float t = 64.f * (i + 1) + 10.f;
+      bank.setGlideTimeInSamples(i, t);
+      glides[i].setGlideTimeInSamples(t);
+    }
+
+    std::array<float, kParams> targets{};
+    DSPVectorArray<kParams> y;
+    float maxError{0};
+    for (int v = 0; v < 100; ++v)
+    {
+      for (size_t i = 0; i < kParams; ++i)
+      {
+        // change targets at different times, sometimes during a glide.
+        if ((v * 7 + i * 3) % (5 + i * 4) == 0)
+        {
+          targets[i] = std::sin(v * 0.37f + i);
+          if (i == 3)
+          {
+            bank.setValue(i, targets[i]);
+            glides[i].setValue(targets[i]);
+          }
+          else
+          {
+            bank.setTarget(i, targets[i]);
+          }
+        }
+      }
+      bank.process(y);
+      for (size_t i = 0; i < kParams; ++i)
+      {
+        maxError = std::max(maxError, max(abs(y.row(i) - glides[i](targets[i]))));
+      }
+    }
+    REQUIRE(maxError < 1e-5f);
+    REQUIRE(bank.getTarget(2) == targets[2]);
+  }
+
+  SECTION("idle")
+  {
+    // once all the glides are done, no rows are written.
+    ParameterSmootherBank<5> bank;
+    DSPVectorDynamic y(5);
+    bank.setGlideTimeInSamples(256);
+    bank.setTarget(4, 2.f);
+    for (int v = 0; v < 5; ++v)
+    {
+      REQUIRE(!bank.isIdle());
+      bank.process(y);
+    }
+    REQUIRE(bank.isIdle());
+    REQUIRE(bank.getValue(4) == 2.f);
+    REQUIRE(max(abs(y[4] - DSPVector(2.f))) < 1e-6f);
+    REQUIRE(max(abs(y[0])) < 1e-6f);
+
+    y[4] = DSPVector(3.f);
+    bank.process(y);
+    REQUIRE(y[4][0] == 3.f);
+
+    bank.setValue(0, 1.f);
+    bank.process(y);
+    REQUIRE(y[0][kFloatsPerDSPVector - 1] == 1.f);
+    REQUIRE(y[4][0] == 3.f);
+  }
+}
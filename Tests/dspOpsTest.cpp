@@ -4,9 +4,13 @@
 
 // a unit test made using the Catch framework in catch.hpp / tests.cpp.
 
+#include <limits>
+#include <new>
+
 #include "catch.hpp"
 #include "testUtils.h"
 #include "MLDSPOps.h"
+#include "MLDSPExpressions.h"
 #include "MLDSPFunctional.h"
 #include "MLDSPUtils.h"
 #include "MLDSPRouting.h"
@@ -15,6 +19,27 @@
 using namespace ml;
 using namespace testUtils;
 
+namespace
+{
+// construct the result of make() in memory filled with NaNs, and return true
+// if each element i of it equals f(i). The result is returned by value, so
+// the op that makes it writes straight into the memory, and any element it
+// skips is left a NaN.
+template <size_t ROWS, typename MAKE, typename F>
+bool writesAllElements(MAKE make, F f)
+{
+  alignas(DSPVectorArray<ROWS>) unsigned char storage[sizeof(DSPVectorArray<ROWS>)];
+  std::fill_n(reinterpret_cast<float*>(storage), sizeof(storage) / sizeof(float),
+              std::numeric_limits<float>::quiet_NaN());
+  const DSPVectorArray<ROWS>* pv = new (storage) DSPVectorArray<ROWS>(make());
+  for (size_t i = 0; i < ROWS * kFloatsPerDSPVector; ++i)
+  {
+    if (!((*pv)[i] == f(i))) return false;
+  }
+  return true;
+}
+}  // namespace
+
 TEST_CASE("madronalib/core/dsp_ops", "[dsp_ops]")
 {
   DSPVector a(rangeClosed(-kPi, kPi));
@@ -145,6 +170,320 @@ TEST_CASE("madronalib/core/dsp_ops", "[dsp_ops]")
     }
   }
 
+  SECTION("SIMD kernels")
+  {
+    // every kernel table the CPU supports should match the base kernels.
+    // wider kernels use FMA, so allow for small rounding differences.
+    constexpr int kRows = 4;
+    constexpr size_t n = kFloatsPerDSPVector * kRows;
+    DSPVectorArray<kRows> x1{repeatRows<kRows>(rangeClosed(-kPi, kPi)) * (rowIndex<kRows>() + 1)};
+    DSPVectorArray<kRows> x2{abs(x1) + 0.5f};
+    DSPVectorArray<kRows> x3{repeatRows<kRows>(rangeClosed(0.f, 1.f))};
+    DSPVectorArray<kRows> mask{select(DSPVectorArray<kRows>(-1.f), DSPVectorArray<kRows>(0.f),
+                                      greaterThan(x1, DSPVectorArray<kRows>(0.f)))};
+
+    const SIMDKernels& base = getSIMDKernels(kSIMDLevelBase);
+    // std::cout << "SIMD kernels selected: " << getSIMDKernels().name << "\n";
+
+    for (int level = kSIMDLevelBase; level < kNumSIMDLevels; ++level)
+    {
+      const SIMDKernels& k = getSIMDKernels(static_cast<SIMDLevel>(level));
+      DSPVectorArray<kRows> yBase, yWide;
+
+      // true if the base and wide results differ by no more than eps.
+      auto matches = [&](float eps) {
+        for (size_t i = 0; i < n; ++i)
+        {
+          if (fabsf(yBase[i] - yWide[i]) > eps) return false;
+        }
+        return true;
+      };
+      auto test1 = [&](SIMDKernel1 fb, SIMDKernel1 fw, const DSPVectorArray<kRows>& x,
+                       float eps) {
+        fb(x.getConstBuffer(), yBase.getBuffer(), n);
+        fw(x.getConstBuffer(), yWide.getBuffer(), n);
+        return matches(eps);
+      };
+      auto test2 = [&](SIMDKernel2 fb, SIMDKernel2 fw) {
+        fb(x1.getConstBuffer(), x2.getConstBuffer(), yBase.getBuffer(), n);
+        fw(x1.getConstBuffer(), x2.getConstBuffer(), yWide.getBuffer(), n);
+        return matches(0.f);
+      };
+      auto test3 = [&](SIMDKernel3 fb, SIMDKernel3 fw, const DSPVectorArray<kRows>& x,
+                       float eps) {
+        fb(x1.getConstBuffer(), x2.getConstBuffer(), x.getConstBuffer(), yBase.getBuffer(), n);
+        fw(x1.getConstBuffer(), x2.getConstBuffer(), x.getConstBuffer(), yWide.getBuffer(), n);
+        return matches(eps);
+      };
+
+      REQUIRE(test1(base.sqrt, k.sqrt, x2, 0.f));
+      REQUIRE(test1(base.abs, k.abs, x1, 0.f));
+      REQUIRE(test1(base.sin, k.sin, x1, 1e-6f));
+      REQUIRE(test1(base.cos, k.cos, x1, 1e-6f));
+      REQUIRE(test1(base.log, k.log, x2, 1e-6f));
+
+      // exp is compared over a smaller range, its output gets large.
+      REQUIRE(test1(base.exp, k.exp, x3, 1e-6f));
+
+      REQUIRE(test2(base.add, k.add));
+      REQUIRE(test2(base.subtract, k.subtract));
+      REQUIRE(test2(base.multiply, k.multiply));
+      REQUIRE(test2(base.divide, k.divide));
+      REQUIRE(test2(base.min, k.min));
+      REQUIRE(test2(base.max, k.max));
+
+      REQUIRE(test3(base.lerp, k.lerp, x3, 1e-5f));
+      REQUIRE(test3(base.clamp, k.clamp, x3, 0.f));
+      REQUIRE(test3(base.select, k.select, mask, 0.f));
+      REQUIRE(test3(base.multiplyAdd, k.multiplyAdd, x3, 1e-4f));
+      REQUIRE(test3(base.multiplySubtract, k.multiplySubtract, x3, 1e-4f));
+    }
+
+    // the ops should give the same results as the kernels they use.
+    DSPVectorArray<kRows> yk;
+    getSIMDKernels().sin(x1.getConstBuffer(), yk.getBuffer(), n);
+    REQUIRE(sin(x1) == yk);
+    REQUIRE(select(x1, x2, greaterThan(x1, x2)) == max(x1, x2));
+
+    // an op on an array large enough to use the kernels can differ from the
+    // same op on a single DSPVector, which uses the inline loops, by rounding
+    // only. The differences allowed here are the ones documented in
+    // MLDSPMathDispatch.h.
+    DSPVector r1{x1.constRow(0)}, r2{x2.constRow(0)}, r3{x3.constRow(0)};
+    auto maxDiff = [](const DSPVector& a, const DSPVector& b) { return max(abs(a - b)); };
+    REQUIRE(maxDiff(sin(x1).constRow(0), sin(r1)) <= 1e-6f);
+    REQUIRE(maxDiff(cos(x1).constRow(0), cos(r1)) <= 1e-6f);
+    REQUIRE(maxDiff(log(x2).constRow(0), log(r2)) <= 1e-6f);
+    REQUIRE(maxDiff(exp(x3).constRow(0), exp(r3)) <= 1e-6f);
+    REQUIRE(maxDiff(lerp(x1, x2, x3).constRow(0), lerp(r1, r2, r3)) <= 1e-5f);
+    REQUIRE(maxDiff(multiplyAdd(x1, x2, x3).constRow(0), multiplyAdd(r1, r2, r3)) <= 1e-4f);
+    REQUIRE((x1 * x2 + x3).constRow(0) == r1 * r2 + r3);
+    REQUIRE(sqrt(x2).constRow(0) == sqrt(r2));
+  }
+
+  SECTION("uninitialized construction")
+  {
+    // ops and row functions write every element of their outputs, so they
+    // can skip zero-filling them.
+    DSPVectorArray<4> x{columnIndex<4>()};
+    DSPVectorArray<4> y{kUninitialized};
+    y = x * 2.f;
+    REQUIRE(y == x + x);
+    REQUIRE(zeroPadRows<6>(x).constRow(5) == DSPVector(0.f));
+    REQUIRE(concatRows(separateRows<0, 2>(x), separateRows<2, 4>(x)) == x);
+
+    // each op that skips zero-filling should still write every element.
+    DSPVectorArray<4> w{rowIndex<4>() - 1.5f};
+    const float* px = x.getConstBuffer();
+    const float* pw = w.getConstBuffer();
+    bool allWritten{true};
+    allWritten &= writesAllElements<4>([&]() { return x + w; },
+                                       [&](size_t i) { return px[i] + pw[i]; });
+    allWritten &= writesAllElements<4>([&]() { return x * w; },
+                                       [&](size_t i) { return px[i] * pw[i]; });
+    allWritten &= writesAllElements<4>([&]() { return abs(w); },
+                                       [&](size_t i) { return std::fabs(pw[i]); });
+    allWritten &= writesAllElements<4>([&]() { return max(x, w); },
+                                       [&](size_t i) { return std::max(px[i], pw[i]); });
+    allWritten &= writesAllElements<4>([&]() { return select(x, w, greaterThan(x, w)); },
+                                       [&](size_t i) { return std::max(px[i], pw[i]); });
+    allWritten &= writesAllElements<4>([&]() { return lerp(x, w, 0.5f); },
+                                       [&](size_t i) { return px[i] + 0.5f * (pw[i] - px[i]); });
+    allWritten &= writesAllElements<4>(
+        [&]() { return intToFloat(roundFloatToInt(x * 4.f) + roundFloatToInt(w * 2.f)); },
+        [&](size_t i) { return px[i] * 4.f + pw[i] * 2.f; });
+    allWritten &= writesAllElements<4>(
+        [&]() { return repeatRows<4>(x.constRow(1)); },
+        [&](size_t i) { return px[kFloatsPerDSPVector + i % kFloatsPerDSPVector]; });
+    allWritten &= writesAllElements<4>(
+        [&]() { return concatRows(separateRows<0, 2>(x), separateRows<2, 4>(w)); },
+        [&](size_t i) { return (i < 2 * kFloatsPerDSPVector) ? px[i] : pw[i]; });
+    allWritten &= writesAllElements<4>(
+        [&]() { return map([](DSPVector v) { return v * 3.f; }, x); },
+        [&](size_t i) { return px[i] * 3.f; });
+    REQUIRE(allWritten);
+
+    // time filling each row of an array after constructing it zeroed and
+    // uninitialized.
+    std::function<DSPVectorArray<4>(void)> zeroedFn = [&]() {
+      DSPVectorArray<4> y;
+      for (int j = 0; j < 4; ++j) y.row(j) = x.constRow(j) * w.constRow(3 - j);
+      return y;
+    };
+    std::function<DSPVectorArray<4>(void)> uninitializedFn = [&]() {
+      DSPVectorArray<4> y{kUninitialized};
+      for (int j = 0; j < 4; ++j) y.row(j) = x.constRow(j) * w.constRow(3 - j);
+      return y;
+    };
+    REQUIRE(zeroedFn() == uninitializedFn());
+    TimedResult<DSPVectorArray<4> > zeroedTime = timeIterations<DSPVectorArray<4> >(zeroedFn);
+    TimedResult<DSPVectorArray<4> > uninitializedTime =
+        timeIterations<DSPVectorArray<4> >(uninitializedFn);
+    /*
+    std::cout << "nanoseconds per DSPVectorArray<4>, zeroed: " << zeroedTime.ns
+              << ", uninitialized: " << uninitializedTime.ns << "\n";
+     */
+  }
+
+  SECTION("lazy expressions")
+  {
+    // a lazy expression should give the same results as the eager ops.
+    DSPVectorArray<2> va{columnIndex<2>()};
+    DSPVectorArray<2> vb{rowIndex<2>() + 1.f};
+    DSPVectorArray<2> vc{sin(va)};
+    DSPVectorArray<2> vd{2.f};
+    DSPVectorArray<2> ve{va * 0.25f};
+
+    DSPVectorArray<2> eager = va * vb + vc * vd - ve;
+    DSPVectorArray<2> lazyResult = lazy(va) * vb + vc * vd - ve;
+    REQUIRE(lazyResult == eager);
+
+    // mixing with floats and functions
+    DSPVectorArray<2> eager2 = max(lerp(va, vb, 0.5f) * 2.f, vc);
+    DSPVectorArray<2> lazy2 = max(lerp(lazy(va), vb, 0.5f) * 2.f, vc);
+    REQUIRE(lazy2 == eager2);
+
+    DSPVectorArray<2> eager3 = clamp(sqrt(abs(vc)) - exp(vb - va), DSPVectorArray<2>(-0.5f),
+                                          DSPVectorArray<2>(0.5f));
+    DSPVectorArray<2> lazy3 = clamp(sqrt(abs(lazy(vc))) - exp(lazy(vb) - va), -0.5f, 0.5f);
+    REQUIRE(lazy3 == eager3);
+
+    // comparisons make int expressions that can be used with select.
+    DSPVectorArrayInt<2> eagerMask = greaterThan(va, vb);
+    DSPVectorArrayInt<2> lazyMask = greaterThan(lazy(va), vb);
+    REQUIRE(lazyMask == eagerMask);
+    DSPVectorArray<2> lazySelect = select(lazy(va), vb, greaterThan(lazy(va), vb));
+    REQUIRE(lazySelect == max(va, vb));
+
+    // int expressions
+    DSPVectorArrayInt<2> ia = roundFloatToInt(va);
+    DSPVectorArrayInt<2> ib = roundFloatToInt(vb);
+    DSPVectorArrayInt<2> lazyInt = lazy(ia) + ib - ia;
+    REQUIRE(lazyInt == ib);
+
+    // float is the only scalar operand
+    static_assert(kMakesDSPExpression<decltype(lazy(va)), float>);
+    static_assert(!kMakesDSPExpression<decltype(lazy(va)), double>);
+    static_assert(!kMakesDSPExpression<decltype(lazy(ia)), int>);
+
+    // assigning an expression to one of its operands
+    DSPVectorArray<2> vf = va;
+    vf = lazy(vf) * vb + vf;
+    REQUIRE(vf == va * vb + va);
+
+    // evaluate to the inferred type
+    auto ev = eval(lazy(va) * 3.f);
+    REQUIRE(ev == va * 3.f);
+    REQUIRE(DSPVectorArray<2>(-lazy(va)) == 0.f - va);
+
+    // single rows
+    DSPVector ta{va.constRow(0)}, tb{vb.constRow(0)}, tc{vc.constRow(0)}, td{vd.constRow(0)},
+        te{ve.constRow(0)};
+    REQUIRE(DSPVector(lazy(ta) * tb + tc * td - te) == ta * tb + tc * td - te);
+  }
+
+  SECTION("fused multiply-add")
+  {
+    DSPVectorArray<2> va{columnIndex<2>() * 0.1f + 0.3f};
+    DSPVectorArray<2> vb{rowIndex<2>() * 1.7f - 0.9f};
+    DSPVectorArray<2> vc{sin(va)};
+
+    // fused results can differ from separate ones only by rounding.
+    auto near = [](const DSPVectorArray<2>& x, const DSPVectorArray<2>& y) {
+      return max(abs(x.constRow(0) - y.constRow(0))) < 1e-5f &&
+             max(abs(x.constRow(1) - y.constRow(1))) < 1e-5f;
+    };
+    REQUIRE(near(multiplyAdd(va, vb, vc), va * vb + vc));
+    REQUIRE(near(multiplySubtract(va, vb, vc), va * vb - vc));
+    REQUIRE(near(multiplyAdd(va, 3.f, vc), va * 3.f + vc));
+    REQUIRE(near(multiplySubtract(va, 3.f, vc), va * 3.f - vc));
+    REQUIRE(near(multiplyAdd(va, 3.f, 0.5f), va * 3.f + 0.5f));
+    REQUIRE(near(multiplySubtract(va, 3.f, 0.5f), va * 3.f - 0.5f));
+    REQUIRE(near(multiplyAdd(lazy(va), vb, vc), va * vb + vc));
+    REQUIRE(multiplyAdd(1.5f, 2.f, 0.25f) == 3.25f);
+
+    // with a single rounding, a * b - round(a * b) recovers the rounding
+    // error of the product exactly. The AVX kernels round once, but ops on
+    // arrays this small use the inline SSE2 loops, so call the kernel.
+    if (getSIMDKernels().level >= kSIMDLevelAVX2)
+    {
+      DSPVectorArray<2> product = va * vb;
+      DSPVectorArray<2> err;
+      getSIMDKernels().multiplySubtract(va.getConstBuffer(), vb.getConstBuffer(),
+                                        product.getConstBuffer(), err.getBuffer(),
+                                        kFloatsPerDSPVector * 2);
+      bool exact = true;
+      for (size_t i = 0; i < kFloatsPerDSPVector * 2; ++i)
+      {
+        double exactErr = double(va[i]) * double(vb[i]) - double(product[i]);
+        if (err[i] != float(exactErr)) exact = false;
+      }
+      REQUIRE(exact);
+    }
+  }
+
+  SECTION("vector lengths")
+  {
+    // ops on shorter and longer rows give the same results as on DSPVectors.
+    DSPVectorArray<2> va{columnIndex<2>() * 0.01f};
+    DSPVectorArray<2> vb{rowIndex<2>() + 0.5f};
+    DSPVectorArray<2> eager = sin(va) * vb + lerp(va, vb, 0.25f);
+
+    DSPVectorArrayN<8, 16> va16(va.getConstBuffer()), vb16(vb.getConstBuffer());
+    DSPVectorArrayN<8, 16> y16 = sin(va16) * vb16 + lerp(va16, vb16, 0.25f);
+    REQUIRE(DSPVectorArray<2>(y16.getConstBuffer()) == eager);
+
+    DSPVectorN<128> va128(va.getConstBuffer()), vb128(vb.getConstBuffer());
+    DSPVectorN<128> y128 = lazy(va128) * vb128 + lerp(va128, vb128, 0.25f);
+    DSPVectorArray<2> y64 = lazy(va) * vb + lerp(va, vb, 0.25f);
+    REQUIRE(DSPVectorArray<2>(y128.getConstBuffer()) == y64);
+    REQUIRE(sum(DSPVectorN<256>(1.f)) == 256.f);
+    REQUIRE(columnIndex<1, 32>()[31] == 31.f);
+
+    // generators and filters keep their state across rows of any length.
+    PhasorGen p64, p16;
+    OnePole f64, f16;
+    f64.coeffs = f16.coeffs = OnePole::makeCoeffs(0.01f);
+    DSPVectorN<16> freq16(0.0123f);
+    for (int i = 0; i < 4; ++i)
+    {
+      DSPVector y64 = f64(p64(DSPVector(0.0123f)));
+      DSPVectorArrayN<4, 16> y16;
+      for (int j = 0; j < 4; ++j)
+      {
+        y16.row(j) = f16(p16(freq16));
+      }
+      REQUIRE(DSPVector(y16.getConstBuffer()) == y64);
+    }
+
+    // a SineGen makes the same samples at any row length. Shorter rows give
+    // lower latency, at a higher cost per sample.
+    SineGen s16, s64, s256;
+    std::function<DSPVectorN<256>(void)> fn16 = [&]() {
+      DSPVectorArrayN<16, 16> y{kUninitialized};
+      for (int j = 0; j < 16; ++j) y.row(j) = s16(DSPVectorN<16>(0.01f));
+      return DSPVectorN<256>(y.getConstBuffer());
+    };
+    std::function<DSPVectorN<256>(void)> fn64 = [&]() {
+      DSPVectorArray<4> y{kUninitialized};
+      for (int j = 0; j < 4; ++j) y.row(j) = s64(DSPVector(0.01f));
+      return DSPVectorN<256>(y.getConstBuffer());
+    };
+    std::function<DSPVectorN<256>(void)> fn256 = [&]() { return s256(DSPVectorN<256>(0.01f)); };
+    DSPVectorN<256> sines16 = fn16(), sines64 = fn64(), sines256 = fn256();
+    REQUIRE(sines16 == sines64);
+    REQUIRE(sines64 == sines256);
+
+    // time making the same number of samples at each length.
+    TimedResult<DSPVectorN<256> > time16 = timeIterations<DSPVectorN<256> >(fn16);
+    TimedResult<DSPVectorN<256> > time64 = timeIterations<DSPVectorN<256> >(fn64);
+    TimedResult<DSPVectorN<256> > time256 = timeIterations<DSPVectorN<256> >(fn256);
+    /*
+    std::cout << "nanoseconds per 256 samples of SineGen, rows of 16: " << time16.ns
+              << ", 64: " << time64.ns << ", 256: " << time256.ns << "\n";
+     */
+  }
+
   SECTION("lerp")
   {
     // lerp with constant mix value
@@ -217,7 +556,31 @@ TEST_CASE("madronalib/core/dsp_ops", "[dsp_ops]")
     auto n = shiftRows(k, 2);
     // TODO actual tests
   }
-  
+
+  SECTION("row references")
+  {
+    // writes through row() must be seen by copies of the whole array, and
+    // writes to the whole array must be seen through constRow().
+    DSPVectorArray<6> state;
+    DSPVectorArray<6> copies;
+    for (int i = 0; i < 2; ++i)
+    {
+      for (int j = 0; j < 6; ++j)
+      {
+        state.row(j) = state.constRow(j) + DSPVector(j + 1.f);
+      }
+      copies = state;
+      state = copies * 2.f;
+    }
+    bool rowsOK{true};
+    for (int j = 0; j < 6; ++j)
+    {
+      rowsOK &= (copies.constRow(j) == DSPVector(3.f * (j + 1.f)));
+      rowsOK &= (state.constRow(j) == DSPVector(6.f * (j + 1.f)));
+    }
+    REQUIRE(rowsOK);
+  }
+
   SECTION("combining")
   {
     DSPVectorArray<2> a{repeatRows<2>(columnIndex())};
@@ -270,6 +633,122 @@ TEST_CASE("madronalib/core/dsp_ops", "[dsp_ops]")
     REQUIRE(demuxInput3 == demuxThenMux);
   }
   
+  SECTION("mix matrix")
+  {
+    constexpr size_t kIn{5}, kOut{3};
+    MixMatrix<kIn, kOut> matrix;
+    DSPVectorArray<kIn> x = map([](DSPVector, int i) { return columnIndex() * 0.01f + i; },
+                                DSPVectorArray<kIn>());
+
+    // the mix of one vector, with each gain ramping from g0 to g1.
+    auto expected = [&](const std::array<std::array<float, kIn>, kOut>& g0,
+                        const std::array<std::array<float, kIn>, kOut>& g1)
+    {
+      DSPVectorArray<kOut> y;
+      for (size_t j = 0; j < kOut; ++j)
+      {
+        for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+        {
+          double sum{0};
+          for (size_t i = 0; i < kIn; ++i)
+          {
+            const double t = (n + 1.) / kFloatsPerDSPVector;
+            sum += x.constRow(i)[n] * (g0[j][i] + t * (g1[j][i] - g0[j][i]));
+          }
+          y.row(j)[n] = (float)sum;
+        }
+      }
+      return y;
+    };
+    auto maxAbs = [](const DSPVectorArray<kOut>& y)
+    {
+      float m{0};
+      for (size_t j = 0; j < kOut; ++j)
+      {
+        m = std::max(m, max(abs(y.constRow(j))));
+      }
+      return m;
+    };
+
+    // a sparse matrix of gains, ramping from zero.
+    std::array<std::array<float, kIn>, kOut> zero{}, gains{};
+    gains[0] = {1.f, 0.f, 0.5f, 0.f, 0.f};
+    gains[1] = {0.f, 0.f, 0.f, 0.f, 0.f};
+    gains[2] = {0.25f, -1.f, 0.f, 2.f, 0.125f};
+    matrix.setGains(gains);
+    REQUIRE(matrix.isConnected(0, 2));
+    REQUIRE(!matrix.isConnected(0, 1));
+    REQUIRE(!matrix.isConnected(1, 0));
+    REQUIRE(maxAbs(matrix(x) - expected(zero, gains)) < 1e-5f);
+
+    // steady gains.
+    REQUIRE(maxAbs(matrix(x) - expected(gains, gains)) < 1e-5f);
+    REQUIRE(max(abs(matrix(x).constRow(1))) < 1e-6f);
+
+    // change one gain with a ramp, and one immediately.
+    auto newGains = gains;
+    newGains[0][1] = 3.f;
+    matrix.setGain<0, 1>(3.f);
+    newGains[2][3] = 0.f;
+    matrix.setGainNow(2, 3, 0.f);
+    auto startGains = gains;
+    startGains[2][3] = 0.f;
+    REQUIRE(matrix.getGain(0, 1) == 3.f);
+    REQUIRE(maxAbs(matrix(x) - expected(startGains, newGains)) < 1e-5f);
+    REQUIRE(maxAbs(matrix(x) - expected(newGains, newGains)) < 1e-5f);
+
+    matrix.clear();
+    REQUIRE(maxAbs(matrix(x)) < 1e-6f);
+  }
+
+  SECTION("large mix matrix")
+  {
+    // a 32 x 32 modulation matrix with a quarter of its entries connected, and one
+    // entry changing every other vector, should match a loop over the whole matrix
+    // once each ramp is done.
+    constexpr size_t kSize{32};
+    MixMatrix<kSize, kSize> matrix;
+    std::array<std::array<float, kSize>, kSize> gains{};
+    for (size_t j = 0; j < kSize; ++j)
+    {
+      for (size_t i = 0; i < kSize; ++i)
+      {
+        gains[j][i] = ((i + j) % 4) ? 0.f : 1.f / (i + 1);
+      }
+    }
+    matrix.setGains(gains);
+    DSPVectorArray<kSize> x = map([](DSPVector, int i) { return columnIndex() + i; },
+                                  DSPVectorArray<kSize>());
+
+    auto loop = [&]()
+    {
+      DSPVectorArray<kSize> y;
+      for (size_t j = 0; j < kSize; ++j)
+      {
+        for (size_t i = 0; i < kSize; ++i)
+        {
+          y.row(j) += x.constRow(i) * gains[j][i];
+        }
+      }
+      return y;
+    };
+
+    float maxDiff{0};
+    for (int v = 0; v < 8; ++v)
+    {
+      // ramp for one vector, then compare.
+      gains[3][5] = (v & 1) * 0.5f;
+      matrix.setGain(3, 5, gains[3][5]);
+      matrix(x);
+      const DSPVectorArray<kSize> d = matrix(x) - loop();
+      for (size_t j = 0; j < kSize; ++j)
+      {
+        maxDiff = std::max(maxDiff, max(abs(d.constRow(j))));
+      }
+    }
+    REQUIRE(maxDiff < 1e-4f);
+  }
+
   SECTION("bank")
   {
     constexpr size_t n = 5;
@@ -0,0 +1,204 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// a unit test made using the Catch framework in catch.hpp / tests.cpp.
+
+#include <cmath>
+#include <vector>
+
+#include "catch.hpp"
+#include "testUtils.h"
+#include "MLDSPResample.h"
+#include "MLSignalProcessBuffer.h"
+
+using namespace ml;
+
+namespace
+{
+// Resample a sine wave of the given frequency in blocks of varying size and
+// return the largest difference from the ideal sine at the output rate, after
+// the filter has settled.
+float sineError(double inputRate, double outputRate, double freq)
+{
+  Resampler r;
+  r.setRates(inputRate, outputRate);
+
+  constexpr size_t kInputFrames{8192};
+  std::vector<float> x(kInputFrames);
+  for (size_t n = 0; n < kInputFrames; ++n)
+  {
+    x[n] = (float)std::sin(2. * kPi * freq * n / inputRate);
+  }
+
+  std::vector<float> y;
+  std::vector<float> block(r.getMaxOutputFrames(kInputFrames));
+  size_t start{0}, blockSize{1};
+  while (start < kInputFrames)
+  {
+    const size_t n = std::min(blockSize, kInputFrames - start);
+    const size_t made = r.process(x.data() + start, n, block.data());
+    y.insert(y.end(), block.begin(), block.begin() + made);
+    start += n;
+    blockSize = (blockSize * 7 + 3) % 500 + 1;
+  }
+
+  // all the outputs whose times are more than the latency before the end of
+  // the input should have been made.
+  const double outputsPerInput = outputRate / inputRate;
+  const size_t expected =
+      (size_t)((kInputFrames - Resampler::getLatencyInInputSamples()) * outputsPerInput);
+  REQUIRE(y.size() >= expected);
+
+  float maxError{0};
+  for (size_t k = 256; k < y.size(); ++k)
+  {
+    const float ideal = (float)std::sin(2. * kPi * freq * k / outputRate);
+    maxError = std::max(maxError, std::fabs(y[k] - ideal));
+  }
+  return maxError;
+}
+
+// Send a note on at the given frame of the given block through a
+// SignalProcessBuffer running at internalRate, and return the external frame
+// where the gate output first goes high.
+void writeGate(AudioContext* ctx, void*)
+{
+  ctx->outputs[0] = ctx->getInputVoice(0).outputs.constRow(kGate);
+}
+
+int gateOnsetFrame(double externalRate, double internalRate, int eventBlock, int eventTime)
+{
+  constexpr int kBlockSize{100};
+  AudioContext ctx(0, 1, (int)internalRate);
+  ctx.setInputPolyphony(1);
+  SignalProcessBuffer buf(0, 1, kBlockSize);
+  buf.setSampleRates(externalRate, internalRate);
+
+  std::vector<float> out(kBlockSize);
+  float* outputs[1]{out.data()};
+  for (int b = 0; b < 20; ++b)
+  {
+    if (b == eventBlock)
+    {
+      Event e;
+      e.type = kNoteOn;
+      e.channel = 1;
+      e.sourceIdx = 60;
+      e.time = eventTime;
+      e.value1 = 60;
+      e.value2 = 1.f;
+      ctx.addInputEvent(e);
+    }
+    buf.process(nullptr, outputs, kBlockSize, &ctx, writeGate, nullptr);
+    for (int i = 0; i < kBlockSize; ++i)
+    {
+      if (out[i] > 0.5f) return b * kBlockSize + i;
+    }
+  }
+  return -1;
+}
+}  // namespace
+
+TEST_CASE("madronalib/core/dsp_resample", "[dsp_resample]")
+{
+  SECTION("rational")
+  {
+    // the errors measured on x86-64 were at most 4.1e-5, and about 1e-6 for the
+    // 2:1 ratios.
+    REQUIRE(sineError(44100., 48000., 1000.) < 5e-5f);
+    REQUIRE(sineError(48000., 44100., 5000.) < 5e-5f);
+    REQUIRE(sineError(96000., 48000., 3000.) < 5e-6f);
+    REQUIRE(sineError(48000., 96000., 3000.) < 5e-6f);
+  }
+
+  SECTION("irrational")
+  {
+    REQUIRE(sineError(44100., 48000. * std::sqrt(1.001), 1000.) < 5e-5f);
+    REQUIRE(sineError(48000., 44100.5, 5000.) < 5e-5f);
+  }
+
+  SECTION("stopband")
+  {
+    // a sine above the output Nyquist frequency should be removed. The largest
+    // output measured was 4.3e-5.
+    Resampler r;
+    r.setRates(96000., 44100.);
+    std::vector<float> x(8192), y(r.getMaxOutputFrames(x.size()));
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+      x[n] = (float)std::sin(2. * kPi * 30000. * n / 96000.);
+    }
+    const size_t made = r.process(x.data(), x.size(), y.data());
+    float maxOut{0};
+    for (size_t k = 64; k < made; ++k)
+    {
+      maxOut = std::max(maxOut, std::fabs(y[k]));
+    }
+    REQUIRE(maxOut < 5e-5f);
+  }
+
+  SECTION("sample")
+  {
+    // resample a stereo Sample and check the length and timing of an impulse.
+    Sample src;
+    src.sampleRate = 44100;
+    resize(src, 44100, 2);
+    std::fill(src.sampleData.begin(), src.sampleData.end(), 0.f);
+    src[2 * 4410] = 1.f;
+    src[2 * 4410 + 1] = -1.f;
+
+    Sample dest;
+    REQUIRE(resample(src, dest, 48000));
+    REQUIRE(getFrames(dest) == 48000);
+    REQUIRE(dest.channels == 2);
+    REQUIRE(dest.sampleRate == 48000);
+
+    // the impulse at 0.1s should peak at 0.1s in the output.
+    size_t peak{0};
+    for (size_t i = 0; i < getFrames(dest); ++i)
+    {
+      if (dest[i * 2] > dest[peak * 2]) peak = i;
+    }
+    REQUIRE(peak == 4800);
+    REQUIRE(dest[peak * 2 + 1] == -dest[peak * 2]);
+  }
+
+  SECTION("events")
+  {
+    // event times are in external frames. Without resampling, moving an event
+    // later in its block should move its effect later by the same number of
+    // output frames.
+    int t0 = gateOnsetFrame(48000., 48000., 3, 0);
+    int t1 = gateOnsetFrame(48000., 48000., 3, 70);
+    REQUIRE(t0 >= 0);
+    REQUIRE(std::abs(t1 - t0 - 70) <= 1);
+
+    // when resampling, each block starts partway into an internal vector that
+    // has already run, so an event at the start of a block may have to wait
+    // for the next vector. The wait is at most one vector plus the latency of
+    // the output resampler, which makes the vectors run that much further ahead.
+    // Otherwise the delay from the event to its effect should be the same in
+    // every block.
+    for (double internalRate : {96000., 44100.})
+    {
+      std::vector<int> delays;
+      for (int b = 3; b < 10; ++b)
+      {
+        for (int t = 0; t < 100; t += 9)
+        {
+          delays.push_back(gateOnsetFrame(48000., internalRate, b, t) - (b * 100 + t));
+        }
+      }
+      const int minDelay = *std::min_element(delays.begin(), delays.end());
+      const int maxDelay = *std::max_element(delays.begin(), delays.end());
+      const int maxWait = kFloatsPerDSPVector + Resampler::getLatencyInInputSamples();
+      REQUIRE(maxDelay - minDelay <= maxWait * 48000. / internalRate + 1);
+      for (int b = 0; b < 7; ++b)
+      {
+        auto first = delays.begin() + b * 12;
+        REQUIRE(*std::min_element(first, first + 12) - minDelay <= 1);
+      }
+    }
+  }
+}
@@ -0,0 +1,248 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// a unit test made using the Catch framework in catch.hpp / tests.cpp.
+
+#include <cmath>
+#include <vector>
+
+#include "catch.hpp"
+#include "testUtils.h"
+#include "MLDSPWavetable.h"
+
+using namespace ml;
+using namespace testUtils;
+
+namespace
+{
+constexpr size_t kFrameSize{Wavetable::kFrameSize};
+
+// one cycle of a sine of the given amplitude.
+std::vector<float> makeSine(float amplitude = 1.f)
+{
+  std::vector<float> x(kFrameSize);
+  for (size_t n = 0; n < kFrameSize; ++n)
+  {
+    x[n] = amplitude * (float)std::sin(kTwoPi * n / kFrameSize);
+  }
+  return x;
+}
+
+// one cycle of a naive falling sawtooth, with all the harmonics.
+std::vector<float> makeSaw()
+{
+  std::vector<float> x(kFrameSize);
+  for (size_t n = 0; n < kFrameSize; ++n)
+  {
+    x[n] = 1.f - 2.f * n / kFrameSize;
+  }
+  return x;
+}
+}  // namespace
+
+TEST_CASE("madronalib/core/dsp_wavetable", "[dsp_wavetable]")
+{
+  FFT<kFrameSize>::prepare();
+
+  SECTION("levels")
+  {
+    REQUIRE(Wavetable::getLevel(0.f) == 0);
+    REQUIRE(Wavetable::getLevel(1.f / kFrameSize) == 0);
+    REQUIRE(Wavetable::getLevel(-1.01f / kFrameSize) == 1);
+    REQUIRE(Wavetable::getLevel(4.f / kFrameSize) == 2);
+    REQUIRE(Wavetable::getLevel(0.49f) == Wavetable::kLevels - 1);
+
+    // the highest level of a sawtooth keeps only its fundamental, and level 0
+    // keeps everything but the Nyquist bin, at twice the sample rate.
+    auto saw = makeSaw();
+    Wavetable table(saw.data(), 1);
+    constexpr int kTop{Wavetable::kLevels - 1};
+    const size_t topSize = Wavetable::getLevelSize(kTop);
+    const float* pTop = table.getLevelData(0, kTop);
+    const float* pBottom = table.getLevelData(0, 0);
+
+    // the DC and fundamental of the sawtooth, by direct DFT.
+    double dc{0}, re{0}, im{0};
+    for (size_t n = 0; n < kFrameSize; ++n)
+    {
+      dc += saw[n] / kFrameSize;
+      re += saw[n] * std::cos(kTwoPi * n / kFrameSize) * 2. / kFrameSize;
+      im += saw[n] * std::sin(kTwoPi * n / kFrameSize) * 2. / kFrameSize;
+    }
+
+    float topError{0}, bottomError{0};
+    for (size_t n = 0; n < topSize; ++n)
+    {
+      const double phase = kTwoPi * n / topSize;
+      const float fundamental = (float)(dc + re * std::cos(phase) + im * std::sin(phase));
+      topError = std::max(topError, std::fabs(pTop[n] - fundamental));
+    }
+    for (size_t n = 1; n < kFrameSize; ++n)
+    {
+      const float nyquist = (n & 1) ? -1.f / kFrameSize : 1.f / kFrameSize;
+      bottomError = std::max(bottomError, std::fabs(pBottom[n * 2] - (saw[n] - nyquist)));
+    }
+    REQUIRE(topError < 1e-5f);
+    REQUIRE(bottomError < 1e-4f);
+
+    // the guards continue the cycle.
+    REQUIRE(pTop[-1] == pTop[topSize - 1]);
+    REQUIRE(pTop[topSize] == pTop[0]);
+    REQUIRE(pTop[topSize + 2] == pTop[2]);
+  }
+
+  SECTION("phase")
+  {
+    // a sine table should play a sine at the phase of a PhasorGen.
+    auto sine = makeSine();
+    Wavetable table(sine.data(), 1);
+    WavetableBank<3> bank;
+    bank.setWavetable(&table);
+    PhasorGen phasors[3];
+    DSPVectorArray<3> freqs;
+    freqs.row(0) = DSPVector(110.f / 48000.f);
+    freqs.row(1) = DSPVector(0.05f);
+    freqs.row(2) = columnIndex() * (0.002f / kFloatsPerDSPVector) + 0.01f;
+
+    float maxError{0};
+    for (int i = 0; i < 20; ++i)
+    {
+      auto y = bank(freqs);
+      for (int j = 0; j < 3; ++j)
+      {
+        const DSPVector phase = phasors[j](freqs.constRow(j));
+        for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+        {
+          const float ideal = (float)std::sin(kTwoPi * phase[n]);
+          maxError = std::max(maxError, std::fabs(y.constRow(j)[n] - ideal));
+        }
+      }
+    }
+    REQUIRE(maxError < 1e-5f);
+  }
+
+  SECTION("aliasing")
+  {
+    // play a sawtooth at exactly the frequencies of FFT bins, and measure the
+    // power in the bins that are not harmonics.
+    constexpr size_t kSize{2048};
+    FFT<kSize>::prepare();
+    auto saw = makeSaw();
+    Wavetable table(saw.data(), 1);
+    WavetableBank<4> bank;
+    bank.setWavetable(&table);
+    const size_t fundamentals[4]{7, 60, 205, 450};
+    DSPVectorArray<4> freqs;
+    for (int j = 0; j < 4; ++j)
+    {
+      freqs.row(j) = DSPVector((float)fundamentals[j] / kSize);
+    }
+    std::vector<DSPVectorN<kSize> > y(4);
+    for (size_t n = 0; n < kSize; n += kFloatsPerDSPVector)
+    {
+      auto v = bank(freqs);
+      for (int j = 0; j < 4; ++j)
+      {
+        std::copy_n(v.constRow(j).getConstBuffer(), kFloatsPerDSPVector, y[j].getBuffer() + n);
+      }
+    }
+
+    for (int j = 0; j < 4; ++j)
+    {
+      auto m = magnitudes(FFT<kSize>::forward(y[j]));
+      float harmonicPower{0}, otherPower{0};
+      for (size_t k = 1; k < kSize / 2; ++k)
+      {
+        const float p = m[k] * m[k];
+        ((k % fundamentals[j]) ? otherPower : harmonicPower) += p;
+      }
+      REQUIRE(otherPower < harmonicPower * 1e-5f);
+    }
+  }
+
+  SECTION("morph")
+  {
+    // three frames: a sine, silence and a sine of twice the amplitude.
+    std::vector<float> frames = makeSine();
+    frames.resize(kFrameSize * 2, 0.f);
+    auto loud = makeSine(2.f);
+    frames.insert(frames.end(), loud.begin(), loud.end());
+    Wavetable table(frames.data(), 3);
+    REQUIRE(table.getFrames() == 3);
+
+    WavetableBank<5> bank;
+    bank.setWavetable(&table);
+    DSPVectorArray<5> freqs(1.f / 64.f);
+    DSPVectorArray<5> positions;
+    positions.row(0) = DSPVector(0.f);
+    positions.row(1) = DSPVector(0.25f);
+    positions.row(2) = DSPVector(0.5f);
+    positions.row(3) = DSPVector(1.f);
+    positions.row(4) = DSPVector(2.f);
+    auto y = bank(freqs, positions);
+
+    const float peak = max(y.constRow(0));
+    REQUIRE(peak > 0.99f);
+    REQUIRE(max(abs(y.constRow(1) - y.constRow(0) * 0.5f)) < 1e-5f);
+    REQUIRE(max(abs(y.constRow(2))) < 1e-6f);
+    REQUIRE(max(abs(y.constRow(3) - y.constRow(0) * 2.f)) < 1e-5f);
+    REQUIRE(max(abs(y.constRow(4) - y.constRow(3))) < 1e-6f);
+
+    // without positions, frame 0 is played.
+    bank.clear();
+    auto y0 = bank(freqs);
+    REQUIRE(max(abs(y0.constRow(4) - y.constRow(0))) < 1e-6f);
+  }
+
+  SECTION("scalar")
+  {
+    // compare 64 voices with PhasorGens and a scalar cubic interpolation from
+    // the same mipmap level.
+    constexpr int kVoices{64};
+    auto saw = makeSaw();
+    Wavetable table(saw.data(), 1);
+    WavetableBank<kVoices> bank;
+    bank.setWavetable(&table);
+    DSPVectorArray<kVoices> freqs = map(
+        [](DSPVector, int j) { return DSPVector(0.001f + 0.0003f * j); }, DSPVectorArray<kVoices>());
+
+    std::vector<PhasorGen> phasors(kVoices);
+    auto gensFn = [&]()
+    {
+      DSPVectorArray<kVoices> y{kUninitialized};
+      for (int j = 0; j < kVoices; ++j)
+      {
+        const DSPVector freq = freqs.constRow(j);
+        const int level = Wavetable::getLevel(max(freq));
+        const float* p = table.getLevelData(0, level);
+        const float size = (float)Wavetable::getLevelSize(level);
+        const DSPVector phase = phasors[j](freq) * size;
+        for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+        {
+          const int i = (int)phase[n];
+          const float t = phase[n] - i;
+          const float a = p[i - 1], b = p[i], c = p[i + 1], d = p[i + 2];
+          const float c1 = a + 2.f * c - 0.5f * (5.f * b + d);
+          const float c2 = 1.5f * (b - c) + 0.5f * (d - a);
+          y.row(j)[n] = ((c2 * t + c1) * t + 0.5f * (c - a)) * t + b;
+        }
+      }
+      return y;
+    };
+    auto bankFn = [&]() { return bank(freqs); };
+
+    // from the same phases, the bank and the scalar loop should agree to within
+    // the rounding of the phase to a table position.
+    float maxDiff{0};
+    for (int i = 0; i < 16; ++i)
+    {
+      const DSPVectorArray<kVoices> d = gensFn() - bankFn();
+      for (int j = 0; j < kVoices; ++j)
+      {
+        maxDiff = std::max(maxDiff, max(abs(d.constRow(j))));
+      }
+    }
+    REQUIRE(maxDiff < 1e-4f);
+  }
+}
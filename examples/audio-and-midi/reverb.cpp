@@ -20,15 +20,19 @@ Projection unityToDecay(projections::unityToLogParam({kDecayLo, kDecayHi}));
 
 struct AaltoverbState
 {
-  // parameter smoothers
-  LinearGlide mSmoothFeedback;
-  LinearGlide mSmoothDelay;
+  // parameter smoothers and their output signals
+  enum { kFeedback, kDelay, kNumParams };
+  ParameterSmootherBank< kNumParams > mSmoothers;
+  DSPVectorArray< kNumParams > mvSmoothed;
 
   // reverb machinery
   Allpass< PitchbendableDelay > mAp1, mAp2, mAp3, mAp4;
   Allpass< PitchbendableDelay > mAp5, mAp6, mAp7, mAp8, mAp9, mAp10;
   PitchbendableDelay mDelayL, mDelayR;
 
+  // one block of memory for all of the delays above
+  DelayMemory mDelayMemory;
+
   // feedback storage
   DSPVector mvFeedbackL, mvFeedbackR;
 };
@@ -36,8 +40,7 @@ struct AaltoverbState
 void initializeReverb(AaltoverbState& r)
 {
   // set fixed parameters for reverb
-  r.mSmoothFeedback.setGlideTimeInSamples(0.1f*kSampleRate);
-  r.mSmoothDelay.setGlideTimeInSamples(0.1f*kSampleRate);
+  r.mSmoothers.setGlideTimeInSamples(0.1f*kSampleRate);
 
   // set allpass filter coefficients
   r.mAp1.mGain = 0.75f;
@@ -48,19 +51,26 @@ void initializeReverb(AaltoverbState& r)
   r.mAp7.mGain = r.mAp8.mGain = 0.6f;
   r.mAp9.mGain = r.mAp10.mGain = 0.5f;
 
-  // allocate delay memory
-  r.mAp1.setMaxDelayInSamples(500.f);
-  r.mAp2.setMaxDelayInSamples(500.f);
-  r.mAp3.setMaxDelayInSamples(1000.f);
-  r.mAp4.setMaxDelayInSamples(1000.f);
-  r.mAp5.setMaxDelayInSamples(2600.f);
-  r.mAp6.setMaxDelayInSamples(2600.f);
-  r.mAp7.setMaxDelayInSamples(8000.f);
-  r.mAp8.setMaxDelayInSamples(8000.f);
-  r.mAp9.setMaxDelayInSamples(10000.f);
-  r.mAp10.setMaxDelayInSamples(10000.f);
-  r.mDelayL.setMaxDelayInSamples(3500.f);
-  r.mDelayR.setMaxDelayInSamples(3500.f);
+  // allocate one block of delay memory and assign it to the delays
+  using AllpassType = Allpass< PitchbendableDelay >;
+  const std::array< std::pair< AllpassType*, float >, 10 > allpasses{{
+    {&r.mAp1, 500.f}, {&r.mAp2, 500.f}, {&r.mAp3, 1000.f}, {&r.mAp4, 1000.f},
+    {&r.mAp5, 2600.f}, {&r.mAp6, 2600.f}, {&r.mAp7, 8000.f}, {&r.mAp8, 8000.f},
+    {&r.mAp9, 10000.f}, {&r.mAp10, 10000.f}}};
+  constexpr float kMaxDelay = 3500.f;
+
+  size_t memorySize = 2*PitchbendableDelay::getMemorySize(kMaxDelay);
+  for(auto& ap : allpasses)
+  {
+    memorySize += AllpassType::getMemorySize(ap.second);
+  }
+  r.mDelayMemory.resize(memorySize);
+  for(auto& ap : allpasses)
+  {
+    r.mDelayMemory.assign(*ap.first, ap.second);
+  }
+  r.mDelayMemory.assign(r.mDelayL, kMaxDelay);
+  r.mDelayMemory.assign(r.mDelayR, kMaxDelay);
 }
 
 // processVector() does all of the audio processing, in DSPVector-sized chunks.
@@ -82,8 +92,11 @@ void processVector(AudioContext* ctx, void *stateData)
   float feedback = (decayU < 1.0f) ? powf(RT60const, 1.0f/decayIterations) : 1.0f;
 
   // generate smoothed delay time and feedback gain vectors
-  DSPVector vSmoothDelay = r->mSmoothDelay(sizeU*2.0f);
-  DSPVector vSmoothFeedback = r->mSmoothFeedback(feedback);
+  r->mSmoothers.setTarget(AaltoverbState::kDelay, sizeU*2.0f);
+  r->mSmoothers.setTarget(AaltoverbState::kFeedback, feedback);
+  r->mSmoothers.process(r->mvSmoothed);
+  const DSPVector& vSmoothDelay = r->mvSmoothed.constRow(AaltoverbState::kDelay);
+  const DSPVector& vSmoothFeedback = r->mvSmoothed.constRow(AaltoverbState::kFeedback);
 
   // get the minimum possible delay in samples, which is the length of a DSPVector.
   DSPVector vMin(kFloatsPerDSPVector);
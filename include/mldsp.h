@@ -5,8 +5,14 @@
 #pragma once
 
 #include "MLDSPOps.h"
+#include "MLDSPExpressions.h"
 #include "MLDSPFilters.h"
+#include "MLDSPFFT.h"
+#include "MLDSPConvolution.h"
+#include "MLDSPResample.h"
 #include "MLDSPGens.h"
+#include "MLDSPWavetable.h"
+#include "MLDSPAdditive.h"
 #include "MLDSPBuffer.h"
 #include "MLDSPFunctional.h"
 #include "MLDSPUtils.h"
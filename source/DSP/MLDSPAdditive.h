@@ -0,0 +1,457 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// Banks of sine oscillators and resonant modes, for additive and modal synthesis.
+//
+// SineBank<N> sums N sine partials into one DSPVector, and ModalBank<N> sums the
+// outputs of N decaying resonant modes driven by one input. Each partial or mode
+// is a complex number advanced by a complex multiply every sample: a rotation
+// for a sine, and a rotation with a decay for a mode. The partials are kept in
+// structure-of-arrays form, so that each SIMD operation advances
+// kFloatsPerSIMDVector of them by one sample.
+//
+// Frequencies are in cycles per sample. Frequencies and amplitudes are set as
+// targets, which are reached at the end of the next DSPVector. Amplitudes ramp
+// linearly. Frequencies ramp linearly too, by multiplying each rotation by a
+// small fixed rotation every sample. Each group of partials whose amplitudes are
+// all below kSilence for the whole vector is skipped.
+
+#pragma once
+
+#include "MLDSPFilters.h"
+
+namespace ml
+{
+namespace additiveUtils
+{
+// amplitudes below this, -100 dB, are not heard.
+constexpr float kSilence{1e-5f};
+
+// set c and s to the cosine and sine of a phase in cycles.
+inline void cosSin(SIMDVectorFloat cycles, SIMDVectorFloat& c, SIMDVectorFloat& s)
+{
+  const SIMDVectorFloat wrapped = vecSub(cycles, vecIntToFloat(vecFloatToIntRound(cycles)));
+  vecSinCos(vecMul(wrapped, vecSet1(kTwoPi)), &s, &c);
+}
+
+// the state of one group of partials while a vector is rendered: the partials
+// re + i*im, their rotations per sample c + i*s and their amplitudes. If GLIDE is
+// true, the rotations are rotated by dc + i*ds every sample.
+template <bool GLIDE>
+struct PartialGroup
+{
+  SIMDVectorFloat re, im, c, s, dc, ds, amp, da;
+
+  // set up the ramps over one vector, from amplitude a0 to a1 and from frequency
+  // f0 to f1. The first sample is advanced by f0 + df and scaled by a0 + da.
+  inline void setRamps(SIMDVectorFloat a0, SIMDVectorFloat a1, SIMDVectorFloat f0,
+                       SIMDVectorFloat f1)
+  {
+    const SIMDVectorFloat rampScale = vecSet1(1.f / kFloatsPerDSPVector);
+    da = vecMul(vecSub(a1, a0), rampScale);
+    amp = vecAdd(a0, da);
+    if (GLIDE)
+    {
+      cosSin(vecMul(vecSub(f1, f0), rampScale), dc, ds);
+      rampFrequency();
+    }
+  }
+
+  // advance the partials by one sample.
+  inline void rotate()
+  {
+    const SIMDVectorFloat re1 = vecFNMA(im, s, vecMul(re, c));
+    im = vecFMA(re, s, vecMul(im, c));
+    re = re1;
+  }
+
+  inline void rampFrequency()
+  {
+    const SIMDVectorFloat c1 = vecFNMA(s, ds, vecMul(c, dc));
+    s = vecFMA(c, ds, vecMul(s, dc));
+    c = c1;
+  }
+
+  inline void ramp()
+  {
+    amp = vecAdd(amp, da);
+    if (GLIDE)
+    {
+      rampFrequency();
+    }
+  }
+};
+
+// return the sum of the lanes of sums[n] for each time n.
+inline DSPVector sumLanes(SIMDVectorFloat* sums)
+{
+  static_assert(kFloatsPerSIMDVector == 4, "sumLanes: SIMD vectors must have 4 floats");
+  DSPVector y{kUninitialized};
+  float* py = y.getBuffer();
+  for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+  {
+    vecTranspose4(sums[n], sums[n + 1], sums[n + 2], sums[n + 3]);
+    vecStore(py + n, vecAdd(vecAdd(sums[n], sums[n + 1]), vecAdd(sums[n + 2], sums[n + 3])));
+  }
+  return y;
+}
+}  // namespace additiveUtils
+
+// SineBank: N sine partials summed into one output.
+//
+// A partial at or above half the sample rate is faded out over the vector, like
+// a partial whose amplitude is set to 0. Skipped partials keep their phases, so
+// that a partial fading back in is still in phase with the others.
+
+template <size_t N>
+class SineBank
+{
+  static constexpr size_t kGroups{BankLanes<N>::kSize / kFloatsPerSIMDVector};
+
+  BankLanes<N> _freq, _freqTarget, _amp, _ampTarget;
+  BankLanes<N> _cosW, _sinW, _re, _im;
+
+ public:
+  static constexpr float kSilence{additiveUtils::kSilence};
+
+  SineBank() { clear(); }
+
+  // set the target frequency of partial i, in cycles per sample.
+  void setFrequency(size_t i, float f) { _freqTarget[i] = f; }
+
+  // set the target amplitude of partial i.
+  void setAmplitude(size_t i, float a) { _ampTarget[i] = a; }
+
+  void setPartial(size_t i, float f, float a)
+  {
+    setFrequency(i, f);
+    setAmplitude(i, a);
+  }
+
+  // set the phase of partial i in cycles. A partial with phase 0 starts at 0
+  // and rises.
+  void setPhase(size_t i, float phase)
+  {
+    _re[i] = std::cos(kTwoPi * phase);
+    _im[i] = std::sin(kTwoPi * phase);
+  }
+
+  // set all the phases to 0 and the amplitudes to 0, so that the partials fade
+  // in to their targets over the next vector. The frequencies jump to their
+  // targets.
+  void clear()
+  {
+    _re.fill(1.f);
+    _im.fill(0.f);
+    _amp.fill(0.f);
+    _freq = _freqTarget;
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      SIMDVectorFloat c, s;
+      additiveUtils::cosSin(_freq.load(g), c, s);
+      _cosW.store(g, c);
+      _sinW.store(g, s);
+    }
+  }
+
+  DSPVector operator()()
+  {
+    SIMDVectorFloat sums[kFloatsPerDSPVector];
+    for (auto& s : sums)
+    {
+      s = vecZeros();
+    }
+
+    // sort the audible groups into steady and gliding ones, and advance the
+    // phases of the silent ones over the vector with one rotation.
+    size_t steady[kGroups];
+    size_t gliding[kGroups];
+    size_t steadyCount{0}, glidingCount{0};
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      const SIMDVectorFloat f0 = _freq.load(g);
+      const SIMDVectorFloat f1 = _freqTarget.load(g);
+      const bool glide = vecAnyTrue(vecNotEqual(f0, f1));
+      const SIMDVectorFloat loudest = vecMax(vecAbs(_amp.load(g)), vecAbs(targetAmp(g)));
+      if (vecAnyTrue(vecGreaterThanOrEqual(loudest, vecSet1(kSilence))))
+      {
+        (glide ? gliding[glidingCount++] : steady[steadyCount++]) = g;
+      }
+      else
+      {
+        additiveUtils::PartialGroup<false> p;
+        p.re = _re.load(g);
+        p.im = _im.load(g);
+        additiveUtils::cosSin(vecAdd(vecMul(f0, vecSet1(31.5f)), vecMul(f1, vecSet1(32.5f))),
+                              p.c, p.s);
+        p.rotate();
+        update(g, glide, p);
+      }
+    }
+
+    renderGroups<false>(sums, steady, steadyCount);
+    renderGroups<true>(sums, gliding, glidingCount);
+    return additiveUtils::sumLanes(sums);
+  }
+
+ private:
+  // the target amplitudes of group g, with partials at or above half the sample
+  // rate silenced.
+  inline SIMDVectorFloat targetAmp(size_t g) const
+  {
+    return vecAnd(_ampTarget.load(g), vecLessThan(vecAbs(_freqTarget.load(g)), vecSet1(0.5f)));
+  }
+
+  template <bool GLIDE>
+  inline additiveUtils::PartialGroup<GLIDE> loadGroup(size_t g) const
+  {
+    additiveUtils::PartialGroup<GLIDE> p;
+    p.re = _re.load(g);
+    p.im = _im.load(g);
+    p.c = _cosW.load(g);
+    p.s = _sinW.load(g);
+    p.setRamps(_amp.load(g), targetAmp(g), _freq.load(g), _freqTarget.load(g));
+    return p;
+  }
+
+  // store the state of group g at the end of a vector.
+  template <bool GLIDE>
+  inline void update(size_t g, bool glide, const additiveUtils::PartialGroup<GLIDE>& p)
+  {
+    // keep the magnitudes at 1 with a Newton's method step.
+    const SIMDVectorFloat mag2 = vecFMA(p.re, p.re, vecMul(p.im, p.im));
+    const SIMDVectorFloat k = vecFNMA(vecSet1(0.5f), mag2, vecSet1(1.5f));
+    _re.store(g, vecMul(p.re, k));
+    _im.store(g, vecMul(p.im, k));
+    _amp.store(g, targetAmp(g));
+    if (glide)
+    {
+      SIMDVectorFloat c, s;
+      const SIMDVectorFloat f1 = _freqTarget.load(g);
+      additiveUtils::cosSin(f1, c, s);
+      _cosW.store(g, c);
+      _sinW.store(g, s);
+      _freq.store(g, f1);
+    }
+  }
+
+  // add the outputs of the given groups to sums over one vector. Two groups are
+  // advanced at once where possible, so that their chains of dependent
+  // multiplies can overlap.
+  template <bool GLIDE>
+  inline void renderGroups(SIMDVectorFloat* sums, const size_t* groups, size_t count)
+  {
+    auto step = [](additiveUtils::PartialGroup<GLIDE>& p) {
+      const SIMDVectorFloat y = vecMul(p.amp, p.im);
+      p.rotate();
+      p.ramp();
+      return y;
+    };
+
+    size_t i{0};
+    for (; i + 1 < count; i += 2)
+    {
+      auto a = loadGroup<GLIDE>(groups[i]);
+      auto b = loadGroup<GLIDE>(groups[i + 1]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        sums[n] = vecAdd(sums[n], vecAdd(step(a), step(b)));
+      }
+      update(groups[i], GLIDE, a);
+      update(groups[i + 1], GLIDE, b);
+    }
+    if (i < count)
+    {
+      auto a = loadGroup<GLIDE>(groups[i]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        sums[n] = vecAdd(sums[n], step(a));
+      }
+      update(groups[i], GLIDE, a);
+    }
+  }
+};
+
+// ModalBank: N resonant modes driven by one input, with their outputs summed.
+//
+// The impulse response of mode i is a * r^n * sin(2 pi f n), where f and a are
+// the frequency and amplitude of the mode and r is its decay per sample. A mode
+// can ring for any time, so the decay is set by the time in samples the mode
+// takes to fall by 60 dB. Unlike the frequency and amplitude, the decay changes
+// at the start of the next vector without a ramp: the output stays continuous.
+//
+// Groups of modes are skipped when their amplitudes are all silent, or when the
+// input is silent and their outputs have all decayed below kSilence. The states
+// of skipped modes are cleared, so a mode with amplitude 0 is off, and will not
+// ring when its amplitude is raised until it is excited again.
+
+template <size_t N>
+class ModalBank
+{
+  static constexpr size_t kGroups{BankLanes<N>::kSize / kFloatsPerSIMDVector};
+
+  BankLanes<N> _freq, _freqTarget, _amp, _ampTarget, _radius;
+  BankLanes<N> _cosW, _sinW, _re, _im;
+
+ public:
+  static constexpr float kSilence{additiveUtils::kSilence};
+
+  ModalBank() { clear(); }
+
+  // set the target frequency of mode i, in cycles per sample.
+  void setFrequency(size_t i, float f) { _freqTarget[i] = f; }
+
+  // set the target amplitude of mode i.
+  void setAmplitude(size_t i, float a) { _ampTarget[i] = a; }
+
+  // set the time mode i takes to decay by 60 dB, in samples.
+  void setDecay(size_t i, float t60)
+  {
+    _radius[i] = (t60 > 0.f) ? std::exp(std::log(0.001f) / t60) : 0.f;
+  }
+
+  void setMode(size_t i, float f, float t60, float a)
+  {
+    setFrequency(i, f);
+    setDecay(i, t60);
+    setAmplitude(i, a);
+  }
+
+  // silence all the modes. The frequencies and amplitudes jump to their targets.
+  void clear()
+  {
+    _re.fill(0.f);
+    _im.fill(0.f);
+    _amp = _ampTarget;
+    _freq = _freqTarget;
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      SIMDVectorFloat c, s;
+      additiveUtils::cosSin(_freq.load(g), c, s);
+      _cosW.store(g, c);
+      _sinW.store(g, s);
+    }
+  }
+
+  DSPVector operator()(const DSPVector& x)
+  {
+    SIMDVectorFloat sums[kFloatsPerDSPVector];
+    SIMDVectorFloat inputs[kFloatsPerDSPVector];
+    bool inputSilent{true};
+    for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+    {
+      sums[n] = vecZeros();
+      inputs[n] = vecSet1(x[n]);
+      inputSilent &= (x[n] == 0.f);
+    }
+
+    // sort the audible groups into steady and gliding ones, and clear the
+    // silent ones.
+    const SIMDVectorFloat silence = vecSet1(kSilence);
+    size_t steady[kGroups];
+    size_t gliding[kGroups];
+    size_t steadyCount{0}, glidingCount{0};
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      const bool glide = vecAnyTrue(vecNotEqual(_freq.load(g), _freqTarget.load(g)));
+      const SIMDVectorFloat loudest = vecMax(vecAbs(_amp.load(g)), vecAbs(_ampTarget.load(g)));
+      bool audible = vecAnyTrue(vecGreaterThanOrEqual(loudest, silence));
+      if (audible && inputSilent)
+      {
+        const SIMDVectorFloat re = _re.load(g);
+        const SIMDVectorFloat im = _im.load(g);
+        const SIMDVectorFloat level =
+            vecMul(vecFMA(re, re, vecMul(im, im)), vecMul(loudest, loudest));
+        audible = vecAnyTrue(vecGreaterThanOrEqual(level, vecMul(silence, silence)));
+      }
+
+      if (audible)
+      {
+        (glide ? gliding[glidingCount++] : steady[steadyCount++]) = g;
+      }
+      else
+      {
+        additiveUtils::PartialGroup<false> p;
+        p.re = p.im = vecZeros();
+        update(g, glide, p);
+      }
+    }
+
+    renderGroups<false>(sums, inputs, steady, steadyCount);
+    renderGroups<true>(sums, inputs, gliding, glidingCount);
+    return additiveUtils::sumLanes(sums);
+  }
+
+ private:
+  // load group g, with its rotations scaled by the decay to make the poles.
+  template <bool GLIDE>
+  inline additiveUtils::PartialGroup<GLIDE> loadGroup(size_t g) const
+  {
+    additiveUtils::PartialGroup<GLIDE> p;
+    const SIMDVectorFloat r = _radius.load(g);
+    p.re = _re.load(g);
+    p.im = _im.load(g);
+    p.c = vecMul(r, _cosW.load(g));
+    p.s = vecMul(r, _sinW.load(g));
+    p.setRamps(_amp.load(g), _ampTarget.load(g), _freq.load(g), _freqTarget.load(g));
+    return p;
+  }
+
+  // store the state of group g at the end of a vector.
+  template <bool GLIDE>
+  inline void update(size_t g, bool glide, const additiveUtils::PartialGroup<GLIDE>& p)
+  {
+    _re.store(g, p.re);
+    _im.store(g, p.im);
+    _amp.store(g, _ampTarget.load(g));
+    if (glide)
+    {
+      SIMDVectorFloat c, s;
+      const SIMDVectorFloat f1 = _freqTarget.load(g);
+      additiveUtils::cosSin(f1, c, s);
+      _cosW.store(g, c);
+      _sinW.store(g, s);
+      _freq.store(g, f1);
+    }
+  }
+
+  // add the outputs of the given groups to sums over one vector, two groups at
+  // once where possible.
+  template <bool GLIDE>
+  inline void renderGroups(SIMDVectorFloat* sums, const SIMDVectorFloat* inputs,
+                           const size_t* groups, size_t count)
+  {
+    auto step = [](additiveUtils::PartialGroup<GLIDE>& p, SIMDVectorFloat x) {
+      p.rotate();
+      p.re = vecAdd(p.re, x);
+      const SIMDVectorFloat y = vecMul(p.amp, p.im);
+      p.ramp();
+      return y;
+    };
+
+    size_t i{0};
+    for (; i + 1 < count; i += 2)
+    {
+      auto a = loadGroup<GLIDE>(groups[i]);
+      auto b = loadGroup<GLIDE>(groups[i + 1]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        sums[n] = vecAdd(sums[n], vecAdd(step(a, inputs[n]), step(b, inputs[n])));
+      }
+      update(groups[i], GLIDE, a);
+      update(groups[i + 1], GLIDE, b);
+    }
+    if (i < count)
+    {
+      auto a = loadGroup<GLIDE>(groups[i]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; ++n)
+      {
+        sums[n] = vecAdd(sums[n], step(a, inputs[n]));
+      }
+      update(groups[i], GLIDE, a);
+    }
+  }
+};
+
+}  // namespace ml
@@ -6,6 +6,17 @@
 // audio. Some nice implementation details are borrowed from Portaudio's
 // pa_ringbuffer by Phil Burk and others. C++11 atomics are used to implement
 // the lockfree algorithm.
+//
+// By default the samples are stored in a std::vector, and reads and writes
+// that cross the end of the storage are split into two regions. On Linux, a
+// buffer can instead be made with mirrored storage: the same memory pages are
+// mapped twice, back to back, so that any region of the buffer is contiguous.
+// Reads and writes are then never split.
+//
+// Samples can also be read and written in place, without copying: peekRead()
+// and reserveWrite() return the DataRegions of the buffer to read from or
+// write to, which are released with consume() and commitWrite(). With vector
+// storage there may be two regions. With mirrored storage there is only one.
 
 #pragma once
 
@@ -13,14 +24,120 @@
 #include <atomic>
 #include <vector>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "MLDSPOps.h"
 
 namespace ml
 {
+// MirroredMemory maps a number of bytes of shared memory twice, back to back,
+// so that the bytes past the end of the first mapping are the start of the
+// memory again. The size must be a whole number of pages. Where mirrored
+// memory is not supported, allocate() returns false.
+class MirroredMemory
+{
+ public:
+  MirroredMemory() = default;
+  ~MirroredMemory() { release(); }
+  MirroredMemory(const MirroredMemory &) = delete;
+  MirroredMemory &operator=(const MirroredMemory &) = delete;
+
+  static size_t getPageSize()
+  {
+#if defined(__linux__)
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    return pageSize > 0 ? static_cast<size_t>(pageSize) : 0;
+#else
+    return 0;
+#endif
+  }
+
+  bool allocate(size_t bytes)
+  {
+    release();
+#if defined(__linux__)
+    const size_t pageSize = getPageSize();
+    if (!bytes || !pageSize || (bytes % pageSize)) return false;
+
+    const int fd = memfd_create("DSPBuffer", MFD_CLOEXEC);
+    if (fd < 0) return false;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+    {
+      close(fd);
+      return false;
+    }
+
+    // reserve address space for both copies, then map the memory into each half.
+    void *pBase = mmap(nullptr, bytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pBase == MAP_FAILED)
+    {
+      close(fd);
+      return false;
+    }
+    char *p = static_cast<char *>(pBase);
+    const int prot = PROT_READ | PROT_WRITE;
+    const bool mapped = (mmap(p, bytes, prot, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) &&
+                        (mmap(p + bytes, bytes, prot, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED);
+
+    // the mappings keep the memory alive after the file is closed.
+    close(fd);
+    if (!mapped)
+    {
+      munmap(pBase, bytes * 2);
+      return false;
+    }
+    pData_ = static_cast<float *>(pBase);
+    bytes_ = bytes;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void release()
+  {
+#if defined(__linux__)
+    if (pData_)
+    {
+      munmap(pData_, bytes_ * 2);
+    }
+#endif
+    pData_ = nullptr;
+    bytes_ = 0;
+  }
+
+  float *data() const { return pData_; }
+
+ private:
+  float *pData_{nullptr};
+  size_t bytes_{0};
+};
+
 class DSPBuffer
 {
+ public:
+  enum Storage
+  {
+    kVectorStorage,
+    kMirroredStorage
+  };
+
+  // a region of the buffer that may wrap around its end, as one or two parts.
+  // If the region is contiguous, p2 is nullptr and size2 is 0.
+  struct DataRegions
+  {
+    float *p1;
+    size_t size1;
+    float *p2;
+    size_t size2;
+  };
+
  private:
   std::vector<float> data_;
+  MirroredMemory mirror_;
   float *dataBuffer_{nullptr};
   size_t size_{0};
   size_t dataMask_{0};
@@ -28,13 +145,6 @@ class DSPBuffer
 
   std::atomic<size_t> writeIndex_{0};
   std::atomic<size_t> readIndex_{0};
-  struct DataRegions
-  {
-    float *p1;
-    size_t size1;
-    float *p2;
-    size_t size2;
-  };
 
   inline void addSamples(const float *pSrcStart, const float *pSrcEnd, float *pDest)
   {
@@ -57,7 +167,7 @@ class DSPBuffer
   inline DataRegions getDataRegions(size_t currentIdx, size_t elems) const
   {
     size_t startIdx = currentIdx & dataMask_;
-    if (startIdx + elems > size_)
+    if ((startIdx + elems > size_) && !isMirrored())
     {
       size_t firstHalf = size_ - startIdx;
       size_t secondHalf = elems - firstHalf;
@@ -77,17 +187,25 @@ class DSPBuffer
   {
     size_ = b.size_;
 
-    try
+    if (b.isMirrored() && mirror_.allocate(size_ * sizeof(float)))
     {
-      data_ = b.data_;
+      dataBuffer_ = mirror_.data();
     }
-    catch (const std::bad_alloc &)
+    else
     {
-      size_ = dataMask_ = distanceMask_ = 0;
-      return;
+      try
+      {
+        data_.resize(size_);
+      }
+      catch (const std::bad_alloc &)
+      {
+        size_ = dataMask_ = distanceMask_ = 0;
+        return;
+      }
+      dataBuffer_ = data_.data();
     }
 
-    dataBuffer_ = data_.data();
+    std::copy(b.dataBuffer_, b.dataBuffer_ + size_, dataBuffer_);
     dataMask_ = size_ - 1;
     distanceMask_ = size_ * 2 - 1;
   }
@@ -100,25 +218,43 @@ class DSPBuffer
   }
 
   // resize the buffer, allocating 2^n samples sufficient to contain the
-  // requested length.
-  size_t resize(int sizeInSamples)
+  // requested length. With kMirroredStorage, the buffer is mirrored if the
+  // platform supports it, and is then at least one memory page long. Otherwise
+  // a std::vector of the requested size is used.
+  size_t resize(int sizeInSamples, Storage storage = kVectorStorage)
   {
     readIndex_ = writeIndex_ = 0;
 
     int sizeBits = (int)ml::bitsToContain(sizeInSamples);
     size_ = std::max((1 << sizeBits), (int)kFloatsPerDSPVector);
 
-    try
+    mirror_.release();
+    dataBuffer_ = nullptr;
+    if (storage == kMirroredStorage)
     {
-      data_.resize(size_);
+      const size_t mirroredSize = std::max(size_, MirroredMemory::getPageSize() / sizeof(float));
+      if (mirror_.allocate(mirroredSize * sizeof(float)))
+      {
+        std::vector<float>().swap(data_);
+        dataBuffer_ = mirror_.data();
+        size_ = mirroredSize;
+      }
     }
-    catch (const std::bad_alloc &)
+
+    if (!dataBuffer_)
     {
-      size_ = dataMask_ = distanceMask_ = 0;
-      return 0;
+      try
+      {
+        data_.resize(size_);
+      }
+      catch (const std::bad_alloc &)
+      {
+        size_ = dataMask_ = distanceMask_ = 0;
+        return 0;
+      }
+      dataBuffer_ = data_.data();
     }
 
-    dataBuffer_ = data_.data();
     dataMask_ = size_ - 1;
 
     // The distance mask idea is based on code from PortAudio's ringbuffer by
@@ -132,6 +268,10 @@ class DSPBuffer
     return size_;
   }
 
+  // return true if the buffer has mirrored storage, so that every region is
+  // contiguous.
+  bool isMirrored() const { return mirror_.data() != nullptr; }
+
   // return the number of samples available for reading.
   size_t getReadAvailable() const
   {
@@ -167,11 +307,12 @@ class DSPBuffer
     }
   }
 
-  // write a single DSPVectorArray to the buffer, advancing the write index.
-  template <size_t VECTORS>
-  void write(const DSPVectorArray<VECTORS> &srcVec)
+  // write a single DSPVectorArray of any row length to the buffer, advancing
+  // the write index.
+  template <size_t VECTORS, size_t LEN>
+  void write(const DSPVectorArrayN<VECTORS, LEN> &srcVec)
   {
-    constexpr int samples = kFloatsPerDSPVector * VECTORS;
+    constexpr int samples = LEN * VECTORS;
 
     bool full = (getWriteAvailable() < samples);
 
@@ -222,11 +363,12 @@ class DSPBuffer
     return samples;
   }
 
-  // read a single DSPVectorArray from the buffer, advancing the read index.
-  template <size_t VECTORS>
-  void read(DSPVectorArray<VECTORS> &destVec)
+  // read a single DSPVectorArray of any row length from the buffer, advancing
+  // the read index.
+  template <size_t VECTORS, size_t LEN>
+  void read(DSPVectorArrayN<VECTORS, LEN> &destVec)
   {
-    constexpr int samples = kFloatsPerDSPVector * VECTORS;
+    constexpr int samples = LEN * VECTORS;
     if (getReadAvailable() < samples) return;
 
     const auto currentReadIndex = readIndex_.load(std::memory_order_acquire);
@@ -251,7 +393,7 @@ class DSPBuffer
   // read a single DSPVector from the buffer, advancing the read index.
   DSPVector read()
   {
-    DSPVector destVec;
+    DSPVector destVec{kUninitialized};
     constexpr int samples = kFloatsPerDSPVector;
     if (getReadAvailable() < samples) return DSPVector{};
 
@@ -275,7 +417,39 @@ class DSPBuffer
     return destVec;
   }
 
-  // discard n samples by advancing the read index.
+  // return the regions holding the next n samples to be read, which can be
+  // read in place until they are released with consume(). If fewer samples are
+  // available, the regions are empty.
+  DataRegions peekRead(size_t samples) const
+  {
+    if (getReadAvailable() < samples) return DataRegions{nullptr, 0, nullptr, 0};
+    const auto currentReadIndex = readIndex_.load(std::memory_order_acquire);
+    return getDataRegions(currentReadIndex, samples);
+  }
+
+  // release n samples that were read in place after peekRead(), by advancing
+  // the read index. No more samples are released than are available.
+  void consume(size_t samples) { discard(samples); }
+
+  // return the regions of free space for the next n samples to be written in
+  // place, then made readable with commitWrite(). If there is not enough free
+  // space, the regions are empty.
+  DataRegions reserveWrite(size_t samples)
+  {
+    if (getWriteAvailable() < samples) return DataRegions{nullptr, 0, nullptr, 0};
+    const auto currentWriteIndex = writeIndex_.load(std::memory_order_acquire);
+    return getDataRegions(currentWriteIndex, samples);
+  }
+
+  // make n samples written in place readable by advancing the write index.
+  void commitWrite(size_t samples)
+  {
+    samples = std::min(samples, getWriteAvailable());
+    const auto currentWriteIndex = writeIndex_.load(std::memory_order_acquire);
+    writeIndex_.store(advanceDistanceIndex(currentWriteIndex, samples), std::memory_order_release);
+  }
+
+  // discard n samples without reading them, by advancing the read index.
   void discard(size_t samples)
   {
     size_t available = getReadAvailable();
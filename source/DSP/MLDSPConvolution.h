@@ -0,0 +1,198 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// Convolution with long impulse responses, computed in the frequency domain.
+//
+// PartitionedConvolution<BLOCK> splits an impulse response into partitions of
+// BLOCK samples and uses the uniformly partitioned overlap-save method. The
+// spectrum of each block of input is kept in a frequency-domain delay line, and
+// each block of output is the inverse transform of the sum of the delayed input
+// spectra times the partition spectra.
+//
+// ConvolutionReverb uses one-DSPVector partitions for the start of the impulse
+// response, so its output is not delayed, and optionally longer partitions for
+// the rest, which need much less computation per sample.
+
+#pragma once
+
+#include <vector>
+
+#include "MLDSPFFT.h"
+
+namespace ml
+{
+template <size_t BLOCK>
+class PartitionedConvolution
+{
+  static constexpr size_t kFFTSize = BLOCK * 2;
+  using Spectrum = DSPSpectrum<kFFTSize>;
+
+ public:
+  // set the impulse response to the length samples starting at pIR. This
+  // allocates memory, so it should not be called from the audio thread.
+  void setImpulseResponse(const float* pIR, size_t length)
+  {
+    FFT<kFFTSize>::prepare();
+    const size_t partitions = (length + BLOCK - 1) / BLOCK;
+    mPartitions.resize(partitions);
+    mDelayLine.resize(partitions);
+    for (size_t p = 0; p < partitions; ++p)
+    {
+      // each partition is zero-padded to the FFT size.
+      DSPVectorN<kFFTSize> h;
+      const size_t start = p * BLOCK;
+      std::copy_n(pIR + start, std::min(BLOCK, length - start), h.getBuffer());
+      mPartitions[p] = FFT<kFFTSize>::forward(h);
+    }
+    clear();
+  }
+
+  void clear()
+  {
+    std::fill(mDelayLine.begin(), mDelayLine.end(), Spectrum());
+    mInputWindow = DSPVectorN<kFFTSize>();
+    mSum = Spectrum();
+    mNewest = 0;
+    mNextPartition = 1;
+  }
+
+  size_t getPartitions() const { return mPartitions.size(); }
+
+  // Add up to count of the products for partitions 1 and up to the output
+  // spectrum. These only need earlier blocks of input, so their work can be
+  // spread over the time before the next block of input is complete.
+  void accumulate(size_t count)
+  {
+    const size_t partitions = mPartitions.size();
+    const size_t end = std::min(partitions, mNextPartition + count);
+    for (; mNextPartition < end; ++mNextPartition)
+    {
+      // the input spectrum from mNextPartition blocks ago.
+      const size_t d = (mNewest + partitions + 1 - mNextPartition) % partitions;
+      mSum = multiplyAddSpectra(mDelayLine[d], mPartitions[mNextPartition], mSum);
+    }
+  }
+
+  // convolve one block of input and return one block of output.
+  DSPVectorN<BLOCK> operator()(const DSPVectorN<BLOCK>& x)
+  {
+    const size_t partitions = mPartitions.size();
+    if (!partitions) return DSPVectorN<BLOCK>();
+    accumulate(partitions);
+
+    // the input window holds the previous block and this one.
+    float* pw = mInputWindow.getBuffer();
+    std::copy_n(pw + BLOCK, BLOCK, pw);
+    std::copy_n(x.getConstBuffer(), BLOCK, pw + BLOCK);
+
+    mNewest = (mNewest + 1) % partitions;
+    mDelayLine[mNewest] = FFT<kFFTSize>::forward(mInputWindow);
+    auto y = FFT<kFFTSize>::inverse(multiplyAddSpectra(mDelayLine[mNewest], mPartitions[0], mSum));
+    mSum = Spectrum();
+    mNextPartition = 1;
+
+    // the first half of the output is wrapped around by the circular
+    // convolution, so only the second half is returned.
+    return DSPVectorN<BLOCK>(y.getConstBuffer() + BLOCK);
+  }
+
+ private:
+  std::vector<Spectrum> mPartitions;
+  std::vector<Spectrum> mDelayLine;
+  DSPVectorN<kFFTSize> mInputWindow;
+  Spectrum mSum;
+  size_t mNewest{0};
+  size_t mNextPartition{1};
+};
+
+// ConvolutionReverb convolves its input with an impulse response of any length.
+// The output of each call includes the input of the same call, so there is no
+// latency beyond the one DSPVector of buffering that all processing here has.
+//
+// The first TAIL_BLOCK samples of the impulse response use partitions of one
+// DSPVector. If the tail is used, the rest uses partitions of TAIL_BLOCK
+// samples. The tail's output for each block is due one block after its input,
+// so the products for its earlier partitions are spread over the calls in
+// between, and only the newest partition and the FFTs are done when a block of
+// input is complete.
+//
+// Nothing is allocated after setImpulseResponse(), as long as prepare() has been
+// called on the processing thread.
+
+template <size_t TAIL_BLOCK = 1024>
+class ConvolutionReverb
+{
+  static_assert(TAIL_BLOCK > kFloatsPerDSPVector,
+                "ConvolutionReverb: the tail block must be longer than a DSPVector.");
+  static constexpr size_t kVectorsPerTailBlock = TAIL_BLOCK / kFloatsPerDSPVector;
+
+ public:
+  // make the FFT plans on the calling thread. Call this on the thread that will
+  // process audio, before processing.
+  static void prepare()
+  {
+    FFT<kFloatsPerDSPVector * 2>::prepare();
+    FFT<TAIL_BLOCK * 2>::prepare();
+  }
+
+  // set the impulse response to the length samples starting at pIR. If useTail
+  // is false, the whole response uses one-DSPVector partitions. This allocates
+  // memory, so it should not be called from the audio thread.
+  void setImpulseResponse(const float* pIR, size_t length, bool useTail = true)
+  {
+    mUseTail = useTail && (length > TAIL_BLOCK);
+    const size_t headLength = mUseTail ? TAIL_BLOCK : length;
+    mHead.setImpulseResponse(pIR, headLength);
+    mTail.setImpulseResponse(pIR + headLength, mUseTail ? length - headLength : 0);
+
+    // products per call to finish the tail's earlier partitions within each block.
+    const size_t earlierPartitions = mTail.getPartitions() ? mTail.getPartitions() - 1 : 0;
+    mTailProductsPerVector =
+        (earlierPartitions + kVectorsPerTailBlock - 2) / (kVectorsPerTailBlock - 1);
+    clear();
+  }
+
+  void clear()
+  {
+    mHead.clear();
+    mTail.clear();
+    mTailInput = DSPVectorN<TAIL_BLOCK>();
+    mTailOutput = DSPVectorN<TAIL_BLOCK>();
+    mTailPosition = 0;
+  }
+
+  DSPVector operator()(const DSPVector x)
+  {
+    DSPVector y = mHead(x);
+    if (mUseTail)
+    {
+      // the tail output for this vector comes from the previous tail block.
+      const size_t offset = mTailPosition * kFloatsPerDSPVector;
+      y += DSPVector(mTailOutput.getConstBuffer() + offset);
+      std::copy_n(x.getConstBuffer(), kFloatsPerDSPVector, mTailInput.getBuffer() + offset);
+
+      if (++mTailPosition == kVectorsPerTailBlock)
+      {
+        mTailOutput = mTail(mTailInput);
+        mTailPosition = 0;
+      }
+      else
+      {
+        mTail.accumulate(mTailProductsPerVector);
+      }
+    }
+    return y;
+  }
+
+ private:
+  PartitionedConvolution<kFloatsPerDSPVector> mHead;
+  PartitionedConvolution<TAIL_BLOCK> mTail;
+  DSPVectorN<TAIL_BLOCK> mTailInput;
+  DSPVectorN<TAIL_BLOCK> mTailOutput;
+  size_t mTailPosition{0};
+  size_t mTailProductsPerVector{0};
+  bool mUseTail{false};
+};
+
+}  // namespace ml
@@ -0,0 +1,443 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// Lazy expressions on DSPVectorArrays.
+//
+// Each op in MLDSPOps.h makes a complete DSPVectorArray for its result. So an
+// expression like a*b + c*d - e makes four passes over memory and stores three
+// temporaries. With the ops here, wrapping any operand with lazy() builds a
+// tree of the whole expression at compile time instead. The tree is evaluated
+// in a single SIMD loop when it is assigned to a DSPVectorArray or
+// DSPVectorArrayInt, or passed to eval():
+//
+//   DSPVector y = lazy(a)*b + c*d - e;
+//
+// Without lazy(), the usual eager ops are used. Lazy and eager values mix
+// freely: any DSPVectorArray, DSPVectorArrayInt or float combined with a lazy
+// expression becomes part of the expression.
+//
+// Expressions refer to their operands and do not copy them, so they must be
+// evaluated before the end of the statement that makes them. Don't store them
+// with auto.
+//
+// Because each element is computed from the elements of its operands at the
+// same index, assigning an expression to one of its own operands is safe.
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "MLDSPOps.h"
+
+namespace ml
+{
+// ----------------------------------------------------------------
+// expression leaves. Each has a number of rows and a row length, where 0 means
+// it can be used with any size, and returns its value at SIMD vector index n.
+
+template <size_t ROWS, size_t LEN>
+struct ExprLeaf
+{
+  static constexpr size_t kRows = ROWS;
+  static constexpr size_t kLen = LEN;
+  const float* px;
+  inline SIMDVectorFloat operator()(int n) const { return vecLoad(px + n * kFloatsPerSIMDVector); }
+};
+
+template <size_t ROWS, size_t LEN>
+struct ExprLeafInt
+{
+  static constexpr size_t kRows = ROWS;
+  static constexpr size_t kLen = LEN;
+  const float* px;
+  inline SIMDVectorInt operator()(int n) const
+  {
+    return VecF2I(vecLoad(px + n * kIntsPerSIMDVector));
+  }
+};
+
+struct ExprScalar
+{
+  static constexpr size_t kRows = 0;
+  static constexpr size_t kLen = 0;
+  SIMDVectorFloat k;
+  inline SIMDVectorFloat operator()(int) const { return k; }
+};
+
+// ----------------------------------------------------------------
+// DSPExpression: applies the function object F to the values of its
+// arguments, which are leaves or other DSPExpressions.
+
+template <class... Args>
+constexpr size_t exprRows()
+{
+  size_t r = 0;
+  ((r = Args::kRows ? Args::kRows : r), ...);
+  return r;
+}
+
+template <class... Args>
+constexpr size_t exprLen()
+{
+  size_t r = 0;
+  ((r = Args::kLen ? Args::kLen : r), ...);
+  return r;
+}
+
+template <class... Args>
+constexpr bool exprSizesMatch()
+{
+  constexpr size_t r = exprRows<Args...>();
+  constexpr size_t l = exprLen<Args...>();
+  return (((Args::kRows == 0 || Args::kRows == r) && (Args::kLen == 0 || Args::kLen == l)) && ...);
+}
+
+// distinguishes float from int32 expression values, for use in decltype.
+std::false_type exprIsInt(SIMDVectorFloat);
+std::true_type exprIsInt(SIMDVectorInt);
+
+template <class F, class... Args>
+class DSPExpression
+{
+  static_assert(exprSizesMatch<Args...>(), "DSPExpression: operand sizes don't match!");
+
+  std::tuple<Args...> args_;
+
+  template <size_t... I>
+  inline auto apply(int n, std::index_sequence<I...>) const
+  {
+    return F::apply(std::get<I>(args_)(n)...);
+  }
+
+ public:
+  static constexpr size_t kRows = exprRows<Args...>();
+  static constexpr size_t kLen = exprLen<Args...>();
+
+  explicit DSPExpression(Args... args) : args_(args...) {}
+
+  // return the value of the expression at SIMD vector index n.
+  inline auto operator()(int n) const { return apply(n, std::index_sequence_for<Args...>{}); }
+
+  // evaluate the expression into ROWS rows of LEN floats or int32s at py, in
+  // one pass.
+  template <size_t ROWS, size_t LEN, bool INT_RESULT>
+  inline void evaluate(float* py) const
+  {
+    static_assert((kRows == ROWS) || (kRows == 0), "DSPExpression: size doesn't match result!");
+    static_assert((kLen == LEN) || (kLen == 0), "DSPExpression: length doesn't match result!");
+    static_assert(decltype(exprIsInt((*this)(0)))::value == INT_RESULT,
+                  "DSPExpression: type doesn't match result!");
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)
+    {
+      if constexpr (INT_RESULT)
+      {
+        vecStore(py, VecI2F((*this)(n)));
+      }
+      else
+      {
+        vecStore(py, (*this)(n));
+      }
+      py += kFloatsPerSIMDVector;
+    }
+  }
+};
+
+template <class T>
+struct IsDSPExpression : std::false_type
+{
+};
+
+template <class F, class... Args>
+struct IsDSPExpression<DSPExpression<F, Args...> > : std::true_type
+{
+};
+
+// ----------------------------------------------------------------
+// converting operands to expression arguments
+
+template <class F, class... Args>
+inline DSPExpression<F, Args...> toExprArg(const DSPExpression<F, Args...>& e)
+{
+  return e;
+}
+
+template <size_t ROWS, size_t LEN>
+inline ExprLeaf<ROWS, LEN> toExprArg(const DSPVectorArrayN<ROWS, LEN>& x)
+{
+  return ExprLeaf<ROWS, LEN>{x.getConstBuffer()};
+}
+
+template <size_t ROWS, size_t LEN>
+inline ExprLeafInt<ROWS, LEN> toExprArg(const DSPVectorArrayIntN<ROWS, LEN>& x)
+{
+  return ExprLeafInt<ROWS, LEN>{x.getConstBuffer()};
+}
+
+inline ExprScalar toExprArg(float k) { return ExprScalar{vecSet1(k)}; }
+
+template <class T>
+using ExprArgType = decltype(toExprArg(std::declval<const T&>()));
+
+// operands that can be part of an expression. The only scalar operand is
+// float, because ExprScalar holds a float SIMD vector: other arithmetic types
+// would be converted to float silently, and can't be combined with int32
+// expressions at all.
+template <class T>
+struct IsExprOperand : std::is_same<T, float>
+{
+};
+
+template <class F, class... Args>
+struct IsExprOperand<DSPExpression<F, Args...> > : std::true_type
+{
+};
+
+template <size_t ROWS, size_t LEN>
+struct IsExprOperand<DSPVectorArrayN<ROWS, LEN> > : std::true_type
+{
+};
+
+template <size_t ROWS, size_t LEN>
+struct IsExprOperand<DSPVectorArrayIntN<ROWS, LEN> > : std::true_type
+{
+};
+
+// true if the operands can be combined into an expression, and at least one of
+// them is already an expression. Otherwise the eager ops are used.
+template <class... Ts>
+constexpr bool kMakesDSPExpression =
+    (IsDSPExpression<Ts>::value || ...) && (IsExprOperand<Ts>::value && ...);
+
+template <class F, class... Ts>
+inline DSPExpression<F, ExprArgType<Ts>...> makeDSPExpression(const Ts&... xs)
+{
+  return DSPExpression<F, ExprArgType<Ts>...>(toExprArg(xs)...);
+}
+
+// ----------------------------------------------------------------
+// lazy(): start an expression.
+
+struct ExprIdentity
+{
+  static inline SIMDVectorFloat apply(SIMDVectorFloat x) { return x; }
+  static inline SIMDVectorInt apply(SIMDVectorInt x) { return x; }
+};
+
+template <size_t ROWS, size_t LEN>
+inline DSPExpression<ExprIdentity, ExprLeaf<ROWS, LEN> > lazy(const DSPVectorArrayN<ROWS, LEN>& x)
+{
+  return makeDSPExpression<ExprIdentity>(x);
+}
+
+template <size_t ROWS, size_t LEN>
+inline DSPExpression<ExprIdentity, ExprLeafInt<ROWS, LEN> > lazy(
+    const DSPVectorArrayIntN<ROWS, LEN>& x)
+{
+  return makeDSPExpression<ExprIdentity>(x);
+}
+
+// an expression must not outlive its operands, so don't make one from a temporary.
+template <size_t ROWS, size_t LEN>
+void lazy(const DSPVectorArrayN<ROWS, LEN>&& x) = delete;
+template <size_t ROWS, size_t LEN>
+void lazy(const DSPVectorArrayIntN<ROWS, LEN>&& x) = delete;
+
+// eval(): evaluate an expression to a DSPVectorArray or DSPVectorArrayInt
+// explicitly. This is only needed where the result type can't be inferred.
+template <class F, class... Args>
+inline auto eval(const DSPExpression<F, Args...>& e)
+{
+  constexpr size_t kRows = DSPExpression<F, Args...>::kRows;
+  constexpr size_t kLen = DSPExpression<F, Args...>::kLen;
+  if constexpr (decltype(exprIsInt(e(0)))::value)
+  {
+    return DSPVectorArrayIntN<kRows, kLen>(e);
+  }
+  else
+  {
+    return DSPVectorArrayN<kRows, kLen>(e);
+  }
+}
+
+// ----------------------------------------------------------------
+// function objects for expressions
+
+#define DEFINE_EXPR_FN1(fnName, opComputation)                                         \
+  struct fnName                                                                        \
+  {                                                                                    \
+    static inline SIMDVectorFloat apply(SIMDVectorFloat x) { return (opComputation); } \
+  };
+
+#define DEFINE_EXPR_FN2(fnName, opComputation)                                  \
+  struct fnName                                                                 \
+  {                                                                             \
+    static inline SIMDVectorFloat apply(SIMDVectorFloat x1, SIMDVectorFloat x2) \
+    {                                                                           \
+      return (opComputation);                                                   \
+    }                                                                           \
+  };
+
+#define DEFINE_EXPR_FN2_FF2I(fnName, opComputation)                           \
+  struct fnName                                                               \
+  {                                                                           \
+    static inline SIMDVectorInt apply(SIMDVectorFloat x1, SIMDVectorFloat x2) \
+    {                                                                         \
+      return VecF2I(opComputation);                                           \
+    }                                                                         \
+  };
+
+#define DEFINE_EXPR_FN3(fnName, opComputation)                                  \
+  struct fnName                                                                 \
+  {                                                                             \
+    static inline SIMDVectorFloat apply(SIMDVectorFloat x1, SIMDVectorFloat x2, \
+                                        SIMDVectorFloat x3)                     \
+    {                                                                           \
+      return (opComputation);                                                   \
+    }                                                                           \
+  };
+
+// + and - work on float and int32 expressions.
+struct ExprAdd
+{
+  static inline SIMDVectorFloat apply(SIMDVectorFloat x1, SIMDVectorFloat x2)
+  {
+    return vecAdd(x1, x2);
+  }
+  static inline SIMDVectorInt apply(SIMDVectorInt x1, SIMDVectorInt x2)
+  {
+    return vecAddInt(x1, x2);
+  }
+};
+
+struct ExprSubtract
+{
+  static inline SIMDVectorFloat apply(SIMDVectorFloat x1, SIMDVectorFloat x2)
+  {
+    return vecSub(x1, x2);
+  }
+  static inline SIMDVectorInt apply(SIMDVectorInt x1, SIMDVectorInt x2)
+  {
+    return vecSubInt(x1, x2);
+  }
+};
+
+DEFINE_EXPR_FN2(ExprMultiply, vecMul(x1, x2));
+DEFINE_EXPR_FN2(ExprDivide, vecDiv(x1, x2));
+DEFINE_EXPR_FN1(ExprNegate, vecSub(vecZeros(), x));
+
+DEFINE_EXPR_FN1(ExprSqrt, vecSqrt(x));
+DEFINE_EXPR_FN1(ExprAbs, vecAbs(x));
+DEFINE_EXPR_FN1(ExprSin, vecSin(x));
+DEFINE_EXPR_FN1(ExprCos, vecCos(x));
+DEFINE_EXPR_FN1(ExprLog, vecLog(x));
+DEFINE_EXPR_FN1(ExprExp, vecExp(x));
+DEFINE_EXPR_FN1(ExprSinApprox, vecSinApprox(x));
+DEFINE_EXPR_FN1(ExprCosApprox, vecCosApprox(x));
+DEFINE_EXPR_FN1(ExprLogApprox, vecLogApprox(x));
+DEFINE_EXPR_FN1(ExprExpApprox, vecExpApprox(x));
+
+DEFINE_EXPR_FN2(ExprMin, vecMin(x1, x2));
+DEFINE_EXPR_FN2(ExprMax, vecMax(x1, x2));
+
+DEFINE_EXPR_FN2_FF2I(ExprEqual, vecEqual(x1, x2));
+DEFINE_EXPR_FN2_FF2I(ExprNotEqual, vecNotEqual(x1, x2));
+DEFINE_EXPR_FN2_FF2I(ExprGreaterThan, vecGreaterThan(x1, x2));
+DEFINE_EXPR_FN2_FF2I(ExprGreaterThanOrEqual, vecGreaterThanOrEqual(x1, x2));
+DEFINE_EXPR_FN2_FF2I(ExprLessThan, vecLessThan(x1, x2));
+DEFINE_EXPR_FN2_FF2I(ExprLessThanOrEqual, vecLessThanOrEqual(x1, x2));
+
+DEFINE_EXPR_FN3(ExprLerp, vecFMA(x3, vecSub(x2, x1), x1));
+DEFINE_EXPR_FN3(ExprClamp, vecClamp(x1, x2, x3));
+DEFINE_EXPR_FN3(ExprMultiplyAdd, vecFMA(x1, x2, x3));
+DEFINE_EXPR_FN3(ExprMultiplySubtract, vecFMS(x1, x2, x3));
+
+struct ExprSelect
+{
+  static inline SIMDVectorFloat apply(SIMDVectorFloat x1, SIMDVectorFloat x2, SIMDVectorInt x3)
+  {
+    return vecSelect(x1, x2, x3);
+  }
+  static inline SIMDVectorInt apply(SIMDVectorInt x1, SIMDVectorInt x2, SIMDVectorInt x3)
+  {
+    return vecSelect(x1, x2, x3);
+  }
+};
+
+// ----------------------------------------------------------------
+// operators and functions making expressions.
+//
+// The generic templates here only participate when at least one argument is
+// a DSPExpression. The overloads taking the same DSPExpression type for all
+// arguments are there to be more specialized than the scalar templates for
+// min(), max(), clamp() and lerp() in MLDSPScalarMath.h.
+
+#define DEFINE_EXPR_OP1(opName, fnName)                   \
+  template <class F, class... Args>                       \
+  inline auto opName(const DSPExpression<F, Args...>& x1) \
+  {                                                       \
+    return makeDSPExpression<fnName>(x1);                 \
+  }
+
+#define DEFINE_EXPR_OP2(opName, fnName)                                                        \
+  template <class T1, class T2, class = std::enable_if_t<kMakesDSPExpression<T1, T2> > >       \
+  inline auto opName(const T1& x1, const T2& x2)                                               \
+  {                                                                                            \
+    return makeDSPExpression<fnName>(x1, x2);                                                  \
+  }                                                                                            \
+  template <class F, class... Args>                                                            \
+  inline auto opName(const DSPExpression<F, Args...>& x1, const DSPExpression<F, Args...>& x2) \
+  {                                                                                            \
+    return makeDSPExpression<fnName>(x1, x2);                                                  \
+  }
+
+#define DEFINE_EXPR_OP3(opName, fnName)                                                        \
+  template <class T1, class T2, class T3,                                                      \
+            class = std::enable_if_t<kMakesDSPExpression<T1, T2, T3> > >                       \
+  inline auto opName(const T1& x1, const T2& x2, const T3& x3)                                 \
+  {                                                                                            \
+    return makeDSPExpression<fnName>(x1, x2, x3);                                              \
+  }                                                                                            \
+  template <class F, class... Args>                                                            \
+  inline auto opName(const DSPExpression<F, Args...>& x1, const DSPExpression<F, Args...>& x2, \
+                     const DSPExpression<F, Args...>& x3)                                      \
+  {                                                                                            \
+    return makeDSPExpression<fnName>(x1, x2, x3);                                              \
+  }
+
+DEFINE_EXPR_OP2(operator+, ExprAdd);
+DEFINE_EXPR_OP2(operator-, ExprSubtract);
+DEFINE_EXPR_OP2(operator*, ExprMultiply);
+DEFINE_EXPR_OP2(operator/, ExprDivide);
+DEFINE_EXPR_OP1(operator-, ExprNegate);
+
+DEFINE_EXPR_OP1(sqrt, ExprSqrt);
+DEFINE_EXPR_OP1(abs, ExprAbs);
+DEFINE_EXPR_OP1(sin, ExprSin);
+DEFINE_EXPR_OP1(cos, ExprCos);
+DEFINE_EXPR_OP1(log, ExprLog);
+DEFINE_EXPR_OP1(exp, ExprExp);
+DEFINE_EXPR_OP1(sinApprox, ExprSinApprox);
+DEFINE_EXPR_OP1(cosApprox, ExprCosApprox);
+DEFINE_EXPR_OP1(logApprox, ExprLogApprox);
+DEFINE_EXPR_OP1(expApprox, ExprExpApprox);
+
+DEFINE_EXPR_OP2(min, ExprMin);
+DEFINE_EXPR_OP2(max, ExprMax);
+
+DEFINE_EXPR_OP2(equal, ExprEqual);
+DEFINE_EXPR_OP2(notEqual, ExprNotEqual);
+DEFINE_EXPR_OP2(greaterThan, ExprGreaterThan);
+DEFINE_EXPR_OP2(greaterThanOrEqual, ExprGreaterThanOrEqual);
+DEFINE_EXPR_OP2(lessThan, ExprLessThan);
+DEFINE_EXPR_OP2(lessThanOrEqual, ExprLessThanOrEqual);
+
+DEFINE_EXPR_OP3(lerp, ExprLerp);                          // x = lerp(a, b, mix)
+DEFINE_EXPR_OP3(clamp, ExprClamp);                        // clamp(x, minBound, maxBound)
+DEFINE_EXPR_OP3(multiplyAdd, ExprMultiplyAdd);            // a * b + c
+DEFINE_EXPR_OP3(multiplySubtract, ExprMultiplySubtract);  // a * b - c
+DEFINE_EXPR_OP3(select, ExprSelect);  // bitwise select(resultIfTrue, resultIfFalse, conditionMask)
+
+}  // namespace ml
@@ -0,0 +1,173 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// Real FFTs of power-of-two sizes, using FFTRealFixLen from external/ffft.
+//
+// A real signal of SIZE samples is a DSPVectorN<SIZE>. Its spectrum is a
+// DSPSpectrum<SIZE>, which is a DSPVectorArrayN<2, SIZE / 2> in packed form:
+// row 0 holds the real parts of bins 0 to SIZE / 2 - 1 and row 1 holds their
+// imaginary parts. Bins 0 (DC) and SIZE / 2 (Nyquist) have no imaginary part, so
+// the real part of the Nyquist bin is kept in row 1 at index 0. Keeping real and
+// imaginary parts in separate rows lets the spectral operations below work on four
+// bins per SIMD operation.
+
+#pragma once
+
+#include "MLDSPOps.h"
+#include "ffft/FFTRealFixLen.h"
+
+namespace ml
+{
+template <size_t SIZE>
+using DSPSpectrum = DSPVectorArrayN<2, SIZE / 2>;
+
+// return log2 of the power of two x.
+constexpr int powerOfTwoBits(size_t x) { return (x > 1) ? 1 + powerOfTwoBits(x >> 1) : 0; }
+
+// An FFT plan holds the bit reversal and twiddle tables for one size, and scratch
+// space. Plans are cached by size, one per thread, because the scratch space
+// makes them unsafe to share between threads. The first use of a size on a thread
+// allocates its plan: call FFT<SIZE>::prepare() on each thread that will use the
+// size before real-time processing starts.
+template <size_t SIZE>
+inline ffft::FFTRealFixLen<powerOfTwoBits(SIZE)>& getFFTPlan()
+{
+  static thread_local ffft::FFTRealFixLen<powerOfTwoBits(SIZE)> plan;
+  return plan;
+}
+
+// Convert between the layout used by ffft and DSPSpectrum, multiplying by k. ffft
+// stores the imaginary parts of bins 1 to SIZE / 2 - 1 negated, so both directions
+// negate them. The Nyquist bin in row 1 at index 0 keeps its sign.
+template <size_t SIZE>
+inline void convertSpectrumLayout(const float* pSrc, float* pDest, float k)
+{
+  constexpr size_t kBins = SIZE / 2;
+  const SIMDVectorFloat vk = vecSet1(k);
+  const SIMDVectorFloat vNegK = vecSet1(-k);
+  alignas(kBytesPerSIMDVector) const float firstImag[kFloatsPerSIMDVector]{k, -k, -k, -k};
+
+  for (size_t n = 0; n < kBins; n += kFloatsPerSIMDVector)
+  {
+    vecStore(pDest + n, vecMul(vecLoad(pSrc + n), vk));
+  }
+  vecStore(pDest + kBins, vecMul(vecLoad(pSrc + kBins), vecLoad(firstImag)));
+  for (size_t n = kBins + kFloatsPerSIMDVector; n < SIZE; n += kFloatsPerSIMDVector)
+  {
+    vecStore(pDest + n, vecMul(vecLoad(pSrc + n), vNegK));
+  }
+}
+
+template <size_t SIZE>
+class FFT
+{
+  static_assert((SIZE >= 32) && ((SIZE & (SIZE - 1)) == 0),
+                "FFT: size must be a power of two, at least 32.");
+
+ public:
+  // make the plan for this size on the calling thread, if it doesn't exist yet.
+  static void prepare() { getFFTPlan<SIZE>(); }
+
+  // return the spectrum of the signal x.
+  static DSPSpectrum<SIZE> forward(const DSPVectorN<SIZE>& x)
+  {
+    DSPSpectrum<SIZE> y{kUninitialized};
+    getFFTPlan<SIZE>().do_fft(y.getBuffer(), x.getConstBuffer());
+    convertSpectrumLayout<SIZE>(y.getConstBuffer(), y.getBuffer(), 1.f);
+    return y;
+  }
+
+  // return the signal with the given spectrum, scaled so that inverse(forward(x)) == x.
+  static DSPVectorN<SIZE> inverse(const DSPSpectrum<SIZE>& spectrum)
+  {
+    DSPSpectrum<SIZE> packed{kUninitialized};
+    convertSpectrumLayout<SIZE>(spectrum.getConstBuffer(), packed.getBuffer(), 1.f / SIZE);
+    DSPVectorN<SIZE> y{kUninitialized};
+    getFFTPlan<SIZE>().do_ifft(packed.getConstBuffer(), y.getBuffer());
+    return y;
+  }
+};
+
+// ----------------------------------------------------------------
+// spectral operations
+//
+// Complex arithmetic on packed spectra. Each loop computes all the bins with SIMD,
+// then fixes up index 0, where the DC and Nyquist bins are real.
+
+// return the product of spectra a and b. Multiplying spectra is circular
+// convolution in the time domain.
+template <size_t BINS>
+inline DSPVectorArrayN<2, BINS> multiplySpectra(const DSPVectorArrayN<2, BINS>& a,
+                                                 const DSPVectorArrayN<2, BINS>& b)
+{
+  DSPVectorArrayN<2, BINS> y{kUninitialized};
+  const float* par = a.getConstBuffer();
+  const float* pai = par + BINS;
+  const float* pbr = b.getConstBuffer();
+  const float* pbi = pbr + BINS;
+  float* pyr = y.getBuffer();
+  float* pyi = pyr + BINS;
+  for (size_t n = 0; n < BINS; n += kFloatsPerSIMDVector)
+  {
+    SIMDVectorFloat ar = vecLoad(par + n);
+    SIMDVectorFloat ai = vecLoad(pai + n);
+    SIMDVectorFloat br = vecLoad(pbr + n);
+    SIMDVectorFloat bi = vecLoad(pbi + n);
+    vecStore(pyr + n, vecFMS(ar, br, vecMul(ai, bi)));
+    vecStore(pyi + n, vecFMA(ar, bi, vecMul(ai, br)));
+  }
+  pyr[0] = par[0] * pbr[0];
+  pyi[0] = pai[0] * pbi[0];
+  return y;
+}
+
+// return c plus the product of spectra a and b.
+template <size_t BINS>
+inline DSPVectorArrayN<2, BINS> multiplyAddSpectra(const DSPVectorArrayN<2, BINS>& a,
+                                                    const DSPVectorArrayN<2, BINS>& b,
+                                                    const DSPVectorArrayN<2, BINS>& c)
+{
+  DSPVectorArrayN<2, BINS> y{kUninitialized};
+  const float* par = a.getConstBuffer();
+  const float* pai = par + BINS;
+  const float* pbr = b.getConstBuffer();
+  const float* pbi = pbr + BINS;
+  const float* pcr = c.getConstBuffer();
+  const float* pci = pcr + BINS;
+  float* pyr = y.getBuffer();
+  float* pyi = pyr + BINS;
+  for (size_t n = 0; n < BINS; n += kFloatsPerSIMDVector)
+  {
+    SIMDVectorFloat ar = vecLoad(par + n);
+    SIMDVectorFloat ai = vecLoad(pai + n);
+    SIMDVectorFloat br = vecLoad(pbr + n);
+    SIMDVectorFloat bi = vecLoad(pbi + n);
+    vecStore(pyr + n, vecFNMA(ai, bi, vecFMA(ar, br, vecLoad(pcr + n))));
+    vecStore(pyi + n, vecFMA(ai, br, vecFMA(ar, bi, vecLoad(pci + n))));
+  }
+  pyr[0] = multiplyAdd(par[0], pbr[0], pcr[0]);
+  pyi[0] = multiplyAdd(pai[0], pbi[0], pci[0]);
+  return y;
+}
+
+// return the magnitudes of bins 0 to BINS - 1 of the spectrum a. The magnitude of
+// the Nyquist bin is not included.
+template <size_t BINS>
+inline DSPVectorN<BINS> magnitudes(const DSPVectorArrayN<2, BINS>& a)
+{
+  DSPVectorN<BINS> y{kUninitialized};
+  const float* par = a.getConstBuffer();
+  const float* pai = par + BINS;
+  float* py = y.getBuffer();
+  for (size_t n = 0; n < BINS; n += kFloatsPerSIMDVector)
+  {
+    SIMDVectorFloat ar = vecLoad(par + n);
+    SIMDVectorFloat ai = vecLoad(pai + n);
+    vecStore(py + n, vecSqrt(vecFMA(ar, ar, vecMul(ai, ai))));
+  }
+  py[0] = fabsf(par[0]);
+  return y;
+}
+
+}  // namespace ml
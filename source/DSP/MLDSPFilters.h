@@ -15,6 +15,14 @@
 // less code overall. For all filters, k is a damping parameter equal to 1/Q
 // where Q is the analog filter "quality." For bell and shelf filters, gain is
 // specified as an output / input ratio A.
+//
+// Filters with fixed coefficients can also run on DSPVectorN rows of other
+// lengths. Filters with signal-rate coefficients take DSPVectors only.
+//
+// OnePole, DCBlocker, Integrator and the SVF filters also have a method
+// processParallel() that computes four samples at a time with SIMD, for use
+// when the coefficients are fixed over each vector. See "linear recurrences"
+// below.
 
 #pragma once
 
@@ -35,7 +43,7 @@ template <size_t COEFFS_SIZE>
 DSPVectorArray<COEFFS_SIZE> interpolateCoeffsLinear(const std::array<float, COEFFS_SIZE> c0,
                                                     const std::array<float, COEFFS_SIZE> c1)
 {
-  DSPVectorArray<COEFFS_SIZE> vy;
+  DSPVectorArray<COEFFS_SIZE> vy{kUninitialized};
   for (int i = 0; i < COEFFS_SIZE; ++i)
   {
     vy.row(i) = interpolateDSPVectorLinear(c0[i], c1[i]);
@@ -43,6 +51,190 @@ DSPVectorArray<COEFFS_SIZE> interpolateCoeffsLinear(const std::array<float, COEF
   return vy;
 }
 
+// tan(pi * omega) for each sample of omega, used to make the shelf and bell
+// coefficients. omega is limited to keep the result finite.
+inline DSPVector tanPiOmega(const DSPVector omega)
+{
+  DSPVector piOmega = min(omega, DSPVector(0.49f)) * kPi;
+  return sin(piOmega) / cos(piOmega);
+}
+
+// --------------------------------------------------------------------------------
+// linear recurrences
+//
+// The feedback in a filter makes each output sample depend on the one before,
+// so a loop over the samples of a vector can't use SIMD. For a linear filter
+// with fixed coefficients, the four outputs of each block of four samples can
+// instead be written in terms of the four inputs and the state before the block.
+// Only the state is carried from block to block. These helpers compute filters
+// that way. Their results differ from the sample-by-sample loops by rounding
+// only. See dspFiltersTest.cpp for the tolerances.
+
+// Compute y[n] = u[n] + b * y[n - 1] over the vector u with a parallel prefix
+// scan inside each SIMD vector. y1 is y[-1] on entry and the last output on
+// return.
+template <size_t LEN>
+inline DSPVectorN<LEN> scanFirstOrder(const DSPVectorN<LEN>& u, float b, float& y1)
+{
+  DSPVectorN<LEN> vy{kUninitialized};
+  const float b2 = b * b;
+  alignas(kBytesPerSIMDVector) const float bPowers[kFloatsPerSIMDVector]{b, b2, b2 * b, b2 * b2};
+  const SIMDVectorFloat vb = vecSet1(b);
+  const SIMDVectorFloat vb2 = vecSet1(b2);
+  const SIMDVectorFloat vbPowers = vecLoad(bPowers);
+  const float* pu = u.getConstBuffer();
+  float* py = vy.getBuffer();
+
+  SIMDVectorFloat vy1 = vecSet1(y1);
+  for (size_t n = 0; n < LEN; n += kFloatsPerSIMDVector)
+  {
+    SIMDVectorFloat v = vecLoad(pu + n);
+    v = vecFMA(vb, vecShiftFloatsLeft(v, 1), v);
+    v = vecFMA(vb2, vecShiftFloatsLeft(v, 2), v);
+    v = vecFMA(vbPowers, vy1, v);
+    vecStore(py + n, v);
+    vy1 = vecBroadcast3(v);
+  }
+  y1 = vy[LEN - 1];
+  return vy;
+}
+
+// A second-order linear system with state s = (s1, s2), input x and output y:
+//   y[n] = d * x[n] + c1 * s1[n] + c2 * s2[n]
+//   s[n + 1] = A * s[n] + b * x[n]
+struct StateSpace2
+{
+  double a11, a12, a21, a22;
+  double b1, b2;
+  double c1, c2;
+  double d;
+};
+
+// Compute the system m over the vector vx, four samples at a time. s1 and s2
+// are the state on entry and are updated on return.
+template <size_t LEN>
+inline DSPVectorN<LEN> scanSecondOrder(const DSPVectorN<LEN>& vx, const StateSpace2& m, float& s1,
+                                       float& s2)
+{
+  constexpr int kBlock = kFloatsPerSIMDVector;
+  static_assert(kBlock == 4, "scanSecondOrder: SIMD vectors must have 4 floats");
+
+  // Make the responses over one block, in double precision. h[j] is the impulse
+  // response C A^(j-1) B, with h[0] = d. stateToY holds C A^j, the response of
+  // output j to the state before the block. inputToState holds A^(3-i) B, the
+  // response of the state after the block to input i.
+  double h[kBlock];
+  double stateToY[2][kBlock];
+  double inputToState[2][kBlock];
+  double p11{1}, p12{0}, p21{0}, p22{1};
+  h[0] = m.d;
+  for (int j = 0; j < kBlock; ++j)
+  {
+    stateToY[0][j] = m.c1 * p11 + m.c2 * p21;
+    stateToY[1][j] = m.c1 * p12 + m.c2 * p22;
+    if (j + 1 < kBlock)
+    {
+      h[j + 1] = stateToY[0][j] * m.b1 + stateToY[1][j] * m.b2;
+    }
+    inputToState[0][kBlock - 1 - j] = p11 * m.b1 + p12 * m.b2;
+    inputToState[1][kBlock - 1 - j] = p21 * m.b1 + p22 * m.b2;
+    double q11 = m.a11 * p11 + m.a12 * p21;
+    double q12 = m.a11 * p12 + m.a12 * p22;
+    double q21 = m.a21 * p11 + m.a22 * p21;
+    double q22 = m.a21 * p12 + m.a22 * p22;
+    p11 = q11, p12 = q12, p21 = q21, p22 = q22;
+  }
+
+  // Make SIMD coefficients. Output lane j gets h[j - i] * x[i] for i <= j. The
+  // state is kept in lanes 0 and 1 of a SIMD vector.
+  alignas(kBytesPerSIMDVector) float inputToYData[kBlock][kBlock];
+  alignas(kBytesPerSIMDVector) float stateToYData[2][kBlock];
+  alignas(kBytesPerSIMDVector) float inputToStateData[kBlock][kBlock]{};
+  alignas(kBytesPerSIMDVector) float stateToStateData[2][kBlock]{};
+  for (int i = 0; i < kBlock; ++i)
+  {
+    for (int j = 0; j < kBlock; ++j)
+    {
+      inputToYData[i][j] = (j >= i) ? h[j - i] : 0.f;
+    }
+    stateToYData[0][i] = stateToY[0][i];
+    stateToYData[1][i] = stateToY[1][i];
+    inputToStateData[i][0] = inputToState[0][i];
+    inputToStateData[i][1] = inputToState[1][i];
+  }
+  stateToStateData[0][0] = p11;
+  stateToStateData[0][1] = p21;
+  stateToStateData[1][0] = p12;
+  stateToStateData[1][1] = p22;
+
+  SIMDVectorFloat inputToY[kBlock], inputToS[kBlock];
+  for (int i = 0; i < kBlock; ++i)
+  {
+    inputToY[i] = vecLoad(inputToYData[i]);
+    inputToS[i] = vecLoad(inputToStateData[i]);
+  }
+  const SIMDVectorFloat s1ToY = vecLoad(stateToYData[0]);
+  const SIMDVectorFloat s2ToY = vecLoad(stateToYData[1]);
+  const SIMDVectorFloat s1ToS = vecLoad(stateToStateData[0]);
+  const SIMDVectorFloat s2ToS = vecLoad(stateToStateData[1]);
+
+  DSPVectorN<LEN> vy{kUninitialized};
+  const float* px = vx.getConstBuffer();
+  float* py = vy.getBuffer();
+  SIMDVectorFloat vs1 = vecSet1(s1);
+  SIMDVectorFloat vs2 = vecSet1(s2);
+  for (size_t n = 0; n < LEN; n += kBlock)
+  {
+    SIMDVectorFloat x = vecLoad(px + n);
+    SIMDVectorFloat x0 = vecBroadcast0(x);
+    SIMDVectorFloat x1 = vecBroadcast1(x);
+    SIMDVectorFloat x2 = vecBroadcast2(x);
+    SIMDVectorFloat x3 = vecBroadcast3(x);
+
+    SIMDVectorFloat y = vecMul(inputToY[0], x0);
+    y = vecFMA(inputToY[1], x1, y);
+    y = vecFMA(inputToY[2], x2, y);
+    y = vecFMA(inputToY[3], x3, y);
+    y = vecFMA(s1ToY, vs1, y);
+    y = vecFMA(s2ToY, vs2, y);
+    vecStore(py + n, y);
+
+    // the state terms are added last, to keep the dependency chain short.
+    SIMDVectorFloat s = vecMul(inputToS[0], x0);
+    s = vecFMA(inputToS[1], x1, s);
+    s = vecFMA(inputToS[2], x2, s);
+    s = vecFMA(inputToS[3], x3, s);
+    s = vecFMA(s1ToS, vs1, s);
+    s = vecFMA(s2ToS, vs2, s);
+    vs1 = vecBroadcast0(s);
+    vs2 = vecBroadcast1(s);
+  }
+
+  s1 = vecGetFirst(vs1);
+  s2 = vecGetFirst(vs2);
+  return vy;
+}
+
+// The SVFs below in state space form, with state (ic1eq, ic2eq), coefficients
+// a1, a2 and a3 as in the shelf and bell filters, and output
+// m0 * v0 + m1 * v1 + m2 * v2. Lopass, Hipass and Bandpass have a1 = g1 + 1,
+// a2 = g0 and a3 = g2.
+inline StateSpace2 makeSVFStateSpace(double a1, double a2, double a3, double m0, double m1,
+                                     double m2)
+{
+  StateSpace2 m;
+  m.a11 = 2. * a1 - 1.;
+  m.a12 = -2. * a2;
+  m.a21 = 2. * a2;
+  m.a22 = 1. - 2. * a3;
+  m.b1 = 2. * a2;
+  m.b2 = 2. * a3;
+  m.c1 = m1 * a1 + m2 * a2;
+  m.c2 = m2 * (1. - a3) - m1 * a2;
+  m.d = m0 + m1 * a2 + m2 * a3;
+  return m;
+}
+
 // --------------------------------------------------------------------------------
 // utility filters implemented as SVF variations
 // Thanks to Andrew Simper [www.cytomic.com] for sharing his work over the
@@ -94,58 +286,67 @@ struct Lopass
     return {g0, g1, g2};
   }
 
+  // get internal coefficients for omega and k changing every sample. A DSPVector
+  // is smaller than kMinFloatsForSIMDKernels, so sin() here runs the inline
+  // vecSin loop at the SIMD width the code is compiled for.
   static coeffsVec makeCoeffsVec(DSPVector omega, DSPVector k)
   {
-    coeffsVec vy;
-    // TODO SIMD
+    coeffsVec vy{kUninitialized};
     omega = min(omega, DSPVector(0.5f));
     k = max(k, DSPVector(0.01f));
 
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
-    {
-      float piOmega = kPi * omega[n];
-      float s1 = sinf(piOmega);
-      float s2 = sinf(2.0f * piOmega);
-      float nrm = 1.0f / (2.f + k[n] * s2);
-      vy.row(g0)[n] = s2 * nrm;
-      vy.row(g1)[n] = (-2.f * s1 * s1 - k[n] * s2) * nrm;
-      vy.row(g2)[n] = (2.0f * s1 * s1) * nrm;
-    }
+    DSPVector piOmega = omega * kPi;
+    DSPVector s1 = sin(piOmega);
+    DSPVector s2 = sin(piOmega * 2.0f);
+    DSPVector nrm = DSPVector(1.0f) / multiplyAdd(k, s2, DSPVector(2.f));
+    DSPVector twoS1Sq = s1 * s1 * 2.0f;
+    vy.row(g0) = s2 * nrm;
+    vy.row(g1) = multiplyAdd(k, s2, twoS1Sq) * (nrm * -1.f);
+    vy.row(g2) = twoS1Sq * nrm;
     return vy;
   }
 
   // filter the input vector vx with the stored coefficients.
-  DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       float v0 = vx[n];
       float t0 = v0 - ic2eq;
-      float t1 = coeffs[g0] * t0 + coeffs[g1] * ic1eq;
-      float t2 = coeffs[g2] * t0 + coeffs[g0] * ic1eq;
+      float t1 = multiplyAdd(coeffs[g0], t0, coeffs[g1] * ic1eq);
+      float t2 = multiplyAdd(coeffs[g2], t0, coeffs[g0] * ic1eq);
       float v2 = t2 + ic2eq;
-      ic1eq += 2.0f * t1;
-      ic2eq += 2.0f * t2;
+      ic1eq = multiplyAdd(2.0f, t1, ic1eq);
+      ic2eq = multiplyAdd(2.0f, t2, ic2eq);
       vy[n] = v2;
     }
     return vy;
   }
 
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    auto m = makeSVFStateSpace(coeffs[g1] + 1., coeffs[g0], coeffs[g2], 0., 0., 1.);
+    return scanSecondOrder(vx, m, ic1eq, ic2eq);
+  }
+
   // filter the input vector vx with the coefficients generated from parameters omega and k.
   DSPVector operator()(const DSPVector vx, const DSPVector omega, const DSPVector k)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     auto vc = makeCoeffsVec(omega, k);
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       float v0 = vx[n];
       float t0 = v0 - ic2eq;
-      float t1 = vc.constRow(g0)[n] * t0 + vc.constRow(g1)[n] * ic1eq;
-      float t2 = vc.constRow(g2)[n] * t0 + vc.constRow(g0)[n] * ic1eq;
+      float t1 = multiplyAdd(vc.constRow(g0)[n], t0, vc.constRow(g1)[n] * ic1eq);
+      float t2 = multiplyAdd(vc.constRow(g2)[n], t0, vc.constRow(g0)[n] * ic1eq);
       float v2 = t2 + ic2eq;
-      ic1eq += 2.0f * t1;
-      ic2eq += 2.0f * t2;
+      ic1eq = multiplyAdd(2.0f, t1, ic1eq);
+      ic2eq = multiplyAdd(2.0f, t2, ic2eq);
       vy[n] = v2;
     }
     return vy;
@@ -177,20 +378,60 @@ class Hipass
     return {g0, g1, g2, k};
   }
 
-  inline DSPVector operator()(const DSPVector vx)
+  // get coefficients for omega and k changing every sample. These are the same as the Lopass
+  // coefficients, and k is limited in the same way.
+  static Lopass::coeffsVec makeCoeffsVec(DSPVector omega, DSPVector k)
+  {
+    return Lopass::makeCoeffsVec(omega, k);
+  }
+
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
+  {
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
+    {
+      float v0 = vx[n];
+      float t0 = v0 - ic2eq;
+      float t1 = multiplyAdd(coeffs.g0, t0, coeffs.g1 * ic1eq);
+      float t2 = multiplyAdd(coeffs.g2, t0, coeffs.g0 * ic1eq);
+      float v1 = t1 + ic1eq;
+      float v2 = t2 + ic2eq;
+      ic1eq = multiplyAdd(2.0f, t1, ic1eq);
+      ic2eq = multiplyAdd(2.0f, t2, ic2eq);
+      vy[n] = multiplyAdd(-coeffs.k, v1, v0) - v2;
+    }
+    return vy;
+  }
+
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    auto m = makeSVFStateSpace(coeffs.g1 + 1., coeffs.g0, coeffs.g2, 1., -coeffs.k, -1.);
+    return scanSecondOrder(vx, m, ic1eq, ic2eq);
+  }
+
+  // filter the input vector vx with the coefficients generated from parameters omega and k.
+  DSPVector operator()(const DSPVector vx, const DSPVector omega, const DSPVector k)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
+    auto vc = makeCoeffsVec(omega, k);
+    DSPVector vk = max(k, DSPVector(0.01f));
+    const float* pg0 = vc.constRow(Lopass::g0).getConstBuffer();
+    const float* pg1 = vc.constRow(Lopass::g1).getConstBuffer();
+    const float* pg2 = vc.constRow(Lopass::g2).getConstBuffer();
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       float v0 = vx[n];
       float t0 = v0 - ic2eq;
-      float t1 = coeffs.g0 * t0 + coeffs.g1 * ic1eq;
-      float t2 = coeffs.g2 * t0 + coeffs.g0 * ic1eq;
+      float t1 = multiplyAdd(pg0[n], t0, pg1[n] * ic1eq);
+      float t2 = multiplyAdd(pg2[n], t0, pg0[n] * ic1eq);
       float v1 = t1 + ic1eq;
       float v2 = t2 + ic2eq;
-      ic1eq += 2.0f * t1;
-      ic2eq += 2.0f * t2;
-      vy[n] = v0 - coeffs.k * v1 - v2;
+      ic1eq = multiplyAdd(2.0f, t1, ic1eq);
+      ic2eq = multiplyAdd(2.0f, t2, ic2eq);
+      vy[n] = multiplyAdd(-vk[n], v1, v0) - v2;
     }
     return vy;
   }
@@ -221,18 +462,56 @@ class Bandpass
     return {g0, g1, g2};
   }
 
-  inline DSPVector operator()(const DSPVector vx)
+  // get coefficients for omega and k changing every sample. These are the same as the Lopass
+  // coefficients.
+  static Lopass::coeffsVec makeCoeffsVec(DSPVector omega, DSPVector k)
+  {
+    return Lopass::makeCoeffsVec(omega, k);
+  }
+
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
+  {
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
+    {
+      float v0 = vx[n];
+      float t0 = v0 - ic2eq;
+      float t1 = multiplyAdd(coeffs.g0, t0, coeffs.g1 * ic1eq);
+      float t2 = multiplyAdd(coeffs.g2, t0, coeffs.g0 * ic1eq);
+      float v1 = t1 + ic1eq;
+      ic1eq = multiplyAdd(2.0f, t1, ic1eq);
+      ic2eq = multiplyAdd(2.0f, t2, ic2eq);
+      vy[n] = v1;
+    }
+    return vy;
+  }
+
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    auto m = makeSVFStateSpace(coeffs.g1 + 1., coeffs.g0, coeffs.g2, 0., 1., 0.);
+    return scanSecondOrder(vx, m, ic1eq, ic2eq);
+  }
+
+  // filter the input vector vx with the coefficients generated from parameters omega and k.
+  DSPVector operator()(const DSPVector vx, const DSPVector omega, const DSPVector k)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
+    auto vc = makeCoeffsVec(omega, k);
+    const float* pg0 = vc.constRow(Lopass::g0).getConstBuffer();
+    const float* pg1 = vc.constRow(Lopass::g1).getConstBuffer();
+    const float* pg2 = vc.constRow(Lopass::g2).getConstBuffer();
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       float v0 = vx[n];
       float t0 = v0 - ic2eq;
-      float t1 = coeffs.g0 * t0 + coeffs.g1 * ic1eq;
-      float t2 = coeffs.g2 * t0 + coeffs.g0 * ic1eq;
+      float t1 = multiplyAdd(pg0[n], t0, pg1[n] * ic1eq);
+      float t2 = multiplyAdd(pg2[n], t0, pg0[n] * ic1eq);
       float v1 = t1 + ic1eq;
-      ic1eq += 2.0f * t1;
-      ic2eq += 2.0f * t2;
+      ic1eq = multiplyAdd(2.0f, t1, ic1eq);
+      ic2eq = multiplyAdd(2.0f, t2, ic2eq);
       vy[n] = v1;
     }
     return vy;
@@ -280,42 +559,71 @@ class LoShelf
     return r;
   }
 
+  // get internal coefficients for omega, k and A changing every sample.
+  static _vcoeffs makeCoeffsVec(DSPVector omega, DSPVector k, DSPVector A)
+  {
+    _vcoeffs vy{kUninitialized};
+    DSPVector g = tanPiOmega(omega) / sqrt(A);
+    vy.row(a1) = DSPVector(1.f) / multiplyAdd(g, g + k, DSPVector(1.f));
+    vy.row(a2) = g * vy.row(a1);
+    vy.row(a3) = g * vy.row(a2);
+    vy.row(m1) = k * (A - 1.f);
+    vy.row(m2) = multiplySubtract(A, A, DSPVector(1.f));
+    return vy;
+  }
+
   static _vcoeffs vcoeffs(const params p0, const params p1)
   {
     return interpolateCoeffsLinear(makeCoeffs(p0), makeCoeffs(p1));
   }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       float v0 = vx[n];
       float v3 = v0 - ic2eq;
-      float v1 = coeffs[a1] * ic1eq + coeffs[a2] * v3;
-      float v2 = ic2eq + coeffs[a2] * ic1eq + coeffs[a3] * v3;
-      ic1eq = 2 * v1 - ic1eq;
-      ic2eq = 2 * v2 - ic2eq;
-      vy[n] = v0 + coeffs[m1] * v1 + coeffs[m2] * v2;
+      float v1 = multiplyAdd(coeffs[a2], v3, coeffs[a1] * ic1eq);
+      float v2 = multiplyAdd(coeffs[a3], v3, multiplyAdd(coeffs[a2], ic1eq, ic2eq));
+      ic1eq = multiplySubtract(2.f, v1, ic1eq);
+      ic2eq = multiplySubtract(2.f, v2, ic2eq);
+      vy[n] = multiplyAdd(coeffs[m2], v2, multiplyAdd(coeffs[m1], v1, v0));
     }
     return vy;
   }
 
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    auto m = makeSVFStateSpace(coeffs[a1], coeffs[a2], coeffs[a3], 1., coeffs[m1], coeffs[m2]);
+    return scanSecondOrder(vx, m, ic1eq, ic2eq);
+  }
+
   inline DSPVector operator()(const DSPVector vx, const _vcoeffs vc)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       float v0 = vx[n];
       float v3 = v0 - ic2eq;
-      float v1 = vc.constRow(a1)[n] * ic1eq + vc.constRow(a2)[n] * v3;
-      float v2 = ic2eq + vc.constRow(a2)[n] * ic1eq + vc.constRow(a3)[n] * v3;
-      ic1eq = 2 * v1 - ic1eq;
-      ic2eq = 2 * v2 - ic2eq;
-      vy[n] = v0 + vc.constRow(m1)[n] * v1 + vc.constRow(m2)[n] * v2;
+      float v1 = multiplyAdd(vc.constRow(a2)[n], v3, vc.constRow(a1)[n] * ic1eq);
+      float v2 = multiplyAdd(vc.constRow(a3)[n], v3, multiplyAdd(vc.constRow(a2)[n], ic1eq, ic2eq));
+      ic1eq = multiplySubtract(2.f, v1, ic1eq);
+      ic2eq = multiplySubtract(2.f, v2, ic2eq);
+      vy[n] = multiplyAdd(vc.constRow(m2)[n], v2, multiplyAdd(vc.constRow(m1)[n], v1, v0));
     }
     return vy;
   }
+
+  // filter the input vector vx with the coefficients generated from parameters omega, k and A.
+  inline DSPVector operator()(const DSPVector vx, const DSPVector omega, const DSPVector k,
+                              const DSPVector A)
+  {
+    return operator()(vx, makeCoeffsVec(omega, k, A));
+  }
 };
 
 class HiShelf
@@ -361,42 +669,74 @@ class HiShelf
     return r;
   }
 
+  // get internal coefficients for omega, k and A changing every sample.
+  static _vcoeffs makeCoeffsVec(DSPVector omega, DSPVector k, DSPVector A)
+  {
+    _vcoeffs vy{kUninitialized};
+    DSPVector g = tanPiOmega(omega) * sqrt(A);
+    vy.row(a1) = DSPVector(1.f) / multiplyAdd(g, g + k, DSPVector(1.f));
+    vy.row(a2) = g * vy.row(a1);
+    vy.row(a3) = g * vy.row(a2);
+    vy.row(m0) = A * A;
+    vy.row(m1) = k * (1.f - A) * A;
+    vy.row(m2) = DSPVector(1.f) - A * A;
+    return vy;
+  }
+
   static _vcoeffs vcoeffs(const params p0, const params p1)
   {
     return interpolateCoeffsLinear(makeCoeffs(p0), makeCoeffs(p1));
   }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       float v0 = vx[n];
       float v3 = v0 - ic2eq;
-      float v1 = coeffs[a1] * ic1eq + coeffs[a2] * v3;
-      float v2 = ic2eq + coeffs[a2] * ic1eq + coeffs[a3] * v3;
-      ic1eq = 2 * v1 - ic1eq;
-      ic2eq = 2 * v2 - ic2eq;
-      vy[n] = coeffs[m0] * v0 + coeffs[m1] * v1 + coeffs[m2] * v2;
+      float v1 = multiplyAdd(coeffs[a2], v3, coeffs[a1] * ic1eq);
+      float v2 = multiplyAdd(coeffs[a3], v3, multiplyAdd(coeffs[a2], ic1eq, ic2eq));
+      ic1eq = multiplySubtract(2.f, v1, ic1eq);
+      ic2eq = multiplySubtract(2.f, v2, ic2eq);
+      vy[n] = multiplyAdd(coeffs[m2], v2, multiplyAdd(coeffs[m1], v1, coeffs[m0] * v0));
     }
     return vy;
   }
 
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    auto m = makeSVFStateSpace(coeffs[a1], coeffs[a2], coeffs[a3], coeffs[m0], coeffs[m1],
+                               coeffs[m2]);
+    return scanSecondOrder(vx, m, ic1eq, ic2eq);
+  }
+
   inline DSPVector operator()(const DSPVector vx, const _vcoeffs vc)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       float v0 = vx[n];
       float v3 = v0 - ic2eq;
-      float v1 = vc.constRow(a1)[n] * ic1eq + vc.constRow(a2)[n] * v3;
-      float v2 = ic2eq + vc.constRow(a2)[n] * ic1eq + vc.constRow(a3)[n] * v3;
-      ic1eq = 2 * v1 - ic1eq;
-      ic2eq = 2 * v2 - ic2eq;
-      vy[n] = vc.constRow(m0)[n] * v0 + vc.constRow(m1)[n] * v1 + vc.constRow(m2)[n] * v2;
+      float v1 = multiplyAdd(vc.constRow(a2)[n], v3, vc.constRow(a1)[n] * ic1eq);
+      float v2 = multiplyAdd(vc.constRow(a3)[n], v3, multiplyAdd(vc.constRow(a2)[n], ic1eq, ic2eq));
+      ic1eq = multiplySubtract(2.f, v1, ic1eq);
+      ic2eq = multiplySubtract(2.f, v2, ic2eq);
+      float y = multiplyAdd(vc.constRow(m1)[n], v1, vc.constRow(m0)[n] * v0);
+      vy[n] = multiplyAdd(vc.constRow(m2)[n], v2, y);
     }
     return vy;
   }
+
+  // filter the input vector vx with the coefficients generated from parameters omega, k and A.
+  inline DSPVector operator()(const DSPVector vx, const DSPVector omega, const DSPVector k,
+                              const DSPVector A)
+  {
+    return operator()(vx, makeCoeffsVec(omega, k, A));
+  }
 };
 
 class Bell
@@ -405,6 +745,15 @@ class Bell
   {
     float a1, a2, a3, m1;
   };
+  enum coeffNames
+  {
+    a1,
+    a2,
+    a3,
+    m1,
+    COEFFS_SIZE
+  };
+  typedef DSPVectorArray<COEFFS_SIZE> _vcoeffs;
 
   float ic1eq{0};
   float ic2eq{0};
@@ -424,18 +773,59 @@ class Bell
     return {a1, a2, a3, m1};
   }
 
-  inline DSPVector operator()(const DSPVector vx)
+  // get internal coefficients for omega, k and A changing every sample.
+  static _vcoeffs makeCoeffsVec(DSPVector omega, DSPVector k, DSPVector A)
+  {
+    _vcoeffs vy{kUninitialized};
+    DSPVector kc = k / A;
+    DSPVector g = tanPiOmega(omega);
+    vy.row(a1) = DSPVector(1.f) / multiplyAdd(g, g + kc, DSPVector(1.f));
+    vy.row(a2) = g * vy.row(a1);
+    vy.row(a3) = g * vy.row(a2);
+    vy.row(m1) = kc * multiplySubtract(A, A, DSPVector(1.f));
+    return vy;
+  }
+
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
+  {
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
+    {
+      float v0 = vx[n];
+      float v3 = v0 - ic2eq;
+      float v1 = multiplyAdd(coeffs.a2, v3, coeffs.a1 * ic1eq);
+      float v2 = multiplyAdd(coeffs.a3, v3, multiplyAdd(coeffs.a2, ic1eq, ic2eq));
+      ic1eq = multiplySubtract(2.f, v1, ic1eq);
+      ic2eq = multiplySubtract(2.f, v2, ic2eq);
+      vy[n] = multiplyAdd(coeffs.m1, v1, v0);
+    }
+    return vy;
+  }
+
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    auto m = makeSVFStateSpace(coeffs.a1, coeffs.a2, coeffs.a3, 1., coeffs.m1, 0.);
+    return scanSecondOrder(vx, m, ic1eq, ic2eq);
+  }
+
+  // filter the input vector vx with the coefficients generated from parameters omega, k and A.
+  DSPVector operator()(const DSPVector vx, const DSPVector omega, const DSPVector k,
+                       const DSPVector A)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
+    auto vc = makeCoeffsVec(omega, k, A);
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       float v0 = vx[n];
       float v3 = v0 - ic2eq;
-      float v1 = coeffs.a1 * ic1eq + coeffs.a2 * v3;
-      float v2 = ic2eq + coeffs.a2 * ic1eq + coeffs.a3 * v3;
-      ic1eq = 2 * v1 - ic1eq;
-      ic2eq = 2 * v2 - ic2eq;
-      vy[n] = v0 + coeffs.m1 * v1;
+      float v1 = multiplyAdd(vc.constRow(a2)[n], v3, vc.constRow(a1)[n] * ic1eq);
+      float v2 = multiplyAdd(vc.constRow(a3)[n], v3, multiplyAdd(vc.constRow(a2)[n], ic1eq, ic2eq));
+      ic1eq = multiplySubtract(2.f, v1, ic1eq);
+      ic2eq = multiplySubtract(2.f, v2, ic2eq);
+      vy[n] = multiplyAdd(vc.constRow(m1)[n], v1, v0);
     }
     return vy;
   }
@@ -463,10 +853,11 @@ struct OnePole
 
   static Coeffs passthru() { return {1.f, 0.f}; }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       y1 = coeffs.a0 * vx[n] + coeffs.b1 * y1;
       vy[n] = y1;
@@ -474,6 +865,13 @@ struct OnePole
     return vy;
   }
 
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    return scanFirstOrder(vx * coeffs.a0, coeffs.b1, y1);
+  }
+
   // jump to the new output value f without slewing there.
   void reset(float f) { y1 = f; }
 
@@ -497,10 +895,11 @@ class DCBlocker
 
   static Coeffs makeCoeffs(float omega) { return cosf(omega); }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       const float x0 = vx[n];
       const float y0 = x0 - x1 + coeffs * y1;
@@ -510,6 +909,20 @@ class DCBlocker
     }
     return vy;
   }
+
+  // filter the input vector vx with the stored coefficients, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    DSPVectorN<LEN> vu{kUninitialized};
+    vu[0] = vx[0] - x1;
+    for (size_t n = 1; n < LEN; ++n)
+    {
+      vu[n] = vx[n] - vx[n - 1];
+    }
+    x1 = vx[LEN - 1];
+    return scanFirstOrder(vu, coeffs, y1);
+  }
 };
 
 // Differentiator
@@ -519,17 +932,18 @@ class Differentiator
   float _x1{0};
 
  public:
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
+    DSPVectorN<LEN> vy{kUninitialized};
     vy[0] = vx[0] - _x1;
 
     // TODO SIMD
-    for (int n = 1; n < kFloatsPerDSPVector; ++n)
+    for (size_t n = 1; n < LEN; ++n)
     {
       vy[n] = vx[n] - vx[n - 1];
     }
-    _x1 = vx[kFloatsPerDSPVector - 1];
+    _x1 = vx[LEN - 1];
     return vy;
   }
 };
@@ -544,10 +958,11 @@ class Integrator
   // set leak to a value such as 0.001 for stability
   float mLeak{0};
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       y1 -= y1 * mLeak;
       y1 += vx[n];
@@ -555,6 +970,13 @@ class Integrator
     }
     return vy;
   }
+
+  // integrate the input vector vx, four samples at a time.
+  template <size_t LEN>
+  inline DSPVectorN<LEN> processParallel(const DSPVectorN<LEN> vx)
+  {
+    return scanFirstOrder(vx, 1.f - mLeak, y1);
+  }
 };
 
 // Peak with exponential decay
@@ -581,11 +1003,12 @@ class Peak
 
   static Coeffs passthru() { return {1.f, 0.f}; }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    DSPVector vxSquared = vx * vx;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    DSPVectorN<LEN> vxSquared = vx * vx;
+    for (size_t n = 0; n < LEN; ++n)
     {
       if (vxSquared[n] > y1)
       {
@@ -606,11 +1029,12 @@ class Peak
 
     if (peakHoldCounter > 0)
     {
-      peakHoldCounter -= kFloatsPerDSPVector;
+      peakHoldCounter -= LEN;
     }
 
     // use sqrt approximation. Return 0 for inputs near 0.
-    return select(sqrtApprox(vy), DSPVector{0.f}, greaterThan(vy, DSPVector{float(1e-20)}));
+    return select(sqrtApprox(vy), DSPVectorN<LEN>{0.f},
+                  greaterThan(vy, DSPVectorN<LEN>{float(1e-20)}));
   }
 };
 
@@ -636,19 +1060,21 @@ class RMS
 
   static Coeffs passthru() { return {1.f, 0.f}; }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    DSPVector vxSquared = vx * vx;
+    DSPVectorN<LEN> vy{kUninitialized};
+    DSPVectorN<LEN> vxSquared = vx * vx;
 
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    for (size_t n = 0; n < LEN; ++n)
     {
       y1 = coeffs.a0 * vxSquared[n] + coeffs.b1 * y1;
       vy[n] = y1;
     }
 
     // use sqrt approximation. Return 0 for inputs near 0.
-    return select(sqrtApprox(vy), DSPVector{0.f}, greaterThan(vy, DSPVector{float(1e-20)}));
+    return select(sqrtApprox(vy), DSPVectorN<LEN>{0.f},
+                  greaterThan(vy, DSPVectorN<LEN>{float(1e-20)}));
   }
 };
 
@@ -787,7 +1213,7 @@ struct ADSR
 
   inline DSPVector operator()(const DSPVector vx)
   {
-    DSPVector r;
+    DSPVector r{kUninitialized};
     for (int i = 0; i < kFloatsPerDSPVector; ++i)
     {
       r[i] = processSample(vx[i]);
@@ -800,11 +1226,20 @@ struct ADSR
 
 class IntegerDelay
 {
-  std::vector<float> mBuffer;
+  std::vector<float> mOwnMemory;
+  float* mpBuffer{nullptr};
   int mIntDelayInSamples{0};
   uintptr_t mWriteIndex{0};
   uintptr_t mLengthMask{0};
 
+  void useMemory(float* p, float d)
+  {
+    mpBuffer = p;
+    mLengthMask = getMemorySize(d) - 1;
+    mWriteIndex = 0;
+    clear();
+  }
+
  public:
   IntegerDelay() = default;
   IntegerDelay(int d)
@@ -814,22 +1249,51 @@ class IntegerDelay
   }
   ~IntegerDelay() = default;
 
+  // copies of a delay with its own memory get their own memory. Copies of a
+  // delay using memory from a DelayMemory use the same memory.
+  IntegerDelay(const IntegerDelay& b) { *this = b; }
+  IntegerDelay& operator=(const IntegerDelay& b)
+  {
+    const bool ownMemory = !b.mOwnMemory.empty();
+    mOwnMemory = b.mOwnMemory;
+    mpBuffer = ownMemory ? mOwnMemory.data() : b.mpBuffer;
+    mIntDelayInSamples = b.mIntDelayInSamples;
+    mWriteIndex = b.mWriteIndex;
+    mLengthMask = b.mLengthMask;
+    return *this;
+  }
+  IntegerDelay(IntegerDelay&&) = default;
+  IntegerDelay& operator=(IntegerDelay&&) = default;
+
   // for efficiency, no bounds checking is done. Because mLengthMask is used to
   // constrain all reads, bad values here may make bad sounds (buffer wraps) but
   // will not attempt to read from outside the buffer.
   inline void setDelayInSamples(int d) { mIntDelayInSamples = d; }
 
+  static size_t getMemorySize(float maxDelay)
+  {
+    int dMax = static_cast<int>(floorf(maxDelay));
+    return size_t(1) << bitsToContain(dMax + kFloatsPerDSPVector);
+  }
+
+  // allocate memory for delays up to d samples.
   void setMaxDelayInSamples(float d)
   {
-    int dMax = static_cast<int>(floorf(d));
-    int newSize = 1 << bitsToContain(dMax + kFloatsPerDSPVector);
-    mBuffer.resize(newSize);
-    mLengthMask = newSize - 1;
-    mWriteIndex = 0;
-    clear();
+    mOwnMemory.resize(getMemorySize(d));
+    useMemory(mOwnMemory.data(), d);
+  }
+
+  // use getMemorySize(d) floats at p for delays up to d samples.
+  void setMemory(float* p, float d)
+  {
+    std::vector<float>().swap(mOwnMemory);
+    useMemory(p, d);
   }
 
-  inline void clear() { std::fill(mBuffer.begin(), mBuffer.end(), 0.f); }
+  inline void clear()
+  {
+    if (mpBuffer) std::fill(mpBuffer, mpBuffer + mLengthMask + 1, 0.f);
+  }
 
   inline DSPVector operator()(const DSPVector vx)
   {
@@ -838,7 +1302,7 @@ class IntegerDelay
     if (writeEnd <= mLengthMask + 1)
     {
       const float* srcStart = vx.getConstBuffer();
-      std::copy(srcStart, srcStart + kFloatsPerDSPVector, mBuffer.data() + mWriteIndex);
+      std::copy(srcStart, srcStart + kFloatsPerDSPVector, mpBuffer + mWriteIndex);
     }
     else
     {
@@ -846,15 +1310,15 @@ class IntegerDelay
       const float* srcStart = vx.getConstBuffer();
       const float* srcSplice = srcStart + kFloatsPerDSPVector - excess;
       const float* srcEnd = srcStart + kFloatsPerDSPVector;
-      std::copy(srcStart, srcSplice, mBuffer.data() + mWriteIndex);
-      std::copy(srcSplice, srcEnd, mBuffer.data());
+      std::copy(srcStart, srcSplice, mpBuffer + mWriteIndex);
+      std::copy(srcSplice, srcEnd, mpBuffer);
     }
 
     // read
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     uintptr_t readStart = (mWriteIndex - mIntDelayInSamples) & mLengthMask;
     uintptr_t readEnd = readStart + kFloatsPerDSPVector;
-    float* srcBuf = mBuffer.data();
+    float* srcBuf = mpBuffer;
     if (readEnd <= mLengthMask + 1)
     {
       std::copy(srcBuf + readStart, srcBuf + readEnd, vy.getBuffer());
@@ -876,18 +1340,18 @@ class IntegerDelay
 
   inline DSPVector operator()(const DSPVector x, const DSPVector delay)
   {
-    DSPVector y;
+    DSPVector y{kUninitialized};
 
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       // write
-      mBuffer[mWriteIndex] = x[n];
+      mpBuffer[mWriteIndex] = x[n];
 
       // read
       mIntDelayInSamples = static_cast<int>(delay[n]);
       uintptr_t readIndex = (mWriteIndex - mIntDelayInSamples) & mLengthMask;
 
-      y[n] = mBuffer[readIndex];
+      y[n] = mpBuffer[readIndex];
       mWriteIndex++;
       mWriteIndex &= mLengthMask;
     }
@@ -900,11 +1364,11 @@ class IntegerDelay
     // write
     // note that, for performance, there is no bounds checking. If you crash
     // here, you probably didn't allocate enough delay memory.
-    mBuffer[mWriteIndex] = x;
+    mpBuffer[mWriteIndex] = x;
 
     // read
     uintptr_t readIndex = (mWriteIndex - mIntDelayInSamples) & mLengthMask;
-    float y = mBuffer[readIndex];
+    float y = mpBuffer[readIndex];
 
     // update index
     mWriteIndex++;
@@ -952,10 +1416,11 @@ class Allpass1
     return y;
   }
 
-  inline DSPVector operator()(const DSPVector vx)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> vx)
   {
-    DSPVector vy;
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{kUninitialized};
+    for (size_t n = 0; n < LEN; ++n)
     {
       vy[n] = processSample(vx[n]);
     }
@@ -1008,6 +1473,12 @@ class FractionalDelay
 
   inline void setMaxDelayInSamples(float d) { mIntegerDelay.setMaxDelayInSamples(floorf(d)); }
 
+  static size_t getMemorySize(float maxDelay)
+  {
+    return IntegerDelay::getMemorySize(floorf(maxDelay));
+  }
+  void setMemory(float* p, float d) { mIntegerDelay.setMemory(p, floorf(d)); }
+
   // return the input signal, delayed by the constant delay time
   // mDelayInSamples.
   inline DSPVector operator()(const DSPVector vx) { return mAllpassSection(mIntegerDelay(vx)); }
@@ -1015,7 +1486,7 @@ class FractionalDelay
   // return the input signal, delayed by the varying delay time vDelayInSamples.
   inline DSPVector operator()(const DSPVector vx, const DSPVector vDelayInSamples)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       setDelayInSamples(vDelayInSamples[n]);
@@ -1029,7 +1500,7 @@ class FractionalDelay
   inline DSPVector operator()(const DSPVector vx, const DSPVector vDelayInSamples,
                               const DSPVectorInt vChangeTicks)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     for (int n = 0; n < kFloatsPerDSPVector; ++n)
     {
       if (vChangeTicks[n] != 0)
@@ -1089,6 +1560,18 @@ class PitchbendableDelay
     mDelay2.setMaxDelayInSamples(d);
   }
 
+  static size_t getMemorySize(float maxDelay)
+  {
+    return 2 * FractionalDelay::getMemorySize(maxDelay);
+  }
+
+  // the two fractional delays take one half of the memory each.
+  void setMemory(float* p, float d)
+  {
+    mDelay1.setMemory(p, d);
+    mDelay2.setMemory(p + FractionalDelay::getMemorySize(d), d);
+  }
+
   inline void clear()
   {
     mDelay1.clear();
@@ -1105,89 +1588,473 @@ class PitchbendableDelay
   }
 };
 
-// General purpose allpass filter with arbitrary delay length.
-// For efficiency, the minimum delay time is one DSPVector.
+// DelayInterpolation selects how ModulatedDelay and MultiTapDelay read between
+// samples: linear, cubic Hermite or 4-point Lagrange interpolation.
 
-template <typename DELAY_TYPE>
-class Allpass
+enum DelayInterpolation
 {
-  DELAY_TYPE mDelay;
-  DSPVector vy1{};
+  kLinearInterpolation,
+  kHermiteInterpolation,
+  kLagrangeInterpolation
+};
 
- public:
-  float mGain{0.f};
+namespace delayUtils
+{
+// delay buffers are followed by a copy of their first kGuard samples, so that
+// the four taps for any read position are contiguous.
+constexpr int kGuard{3};
 
-  // use setDelayInSamples to set a constant delay time with DELAY_TYPE of
-  // IntegerDelay or FractionalDelay.
-  inline void setDelayInSamples(float d) { mDelay.setDelayInSamples(d - kFloatsPerDSPVector); }
+// the length of a buffer that can hold delays up to maxDelay, plus the four
+// taps around the read position, after a whole vector has been written.
+inline uint32_t bufferLength(float maxDelay)
+{
+  return 1 << bitsToContain(static_cast<int>(maxDelay) + kFloatsPerDSPVector + kGuard);
+}
 
-  inline void setMaxDelayInSamples(float d)
-  {
-    mDelay.setMaxDelayInSamples(d - kFloatsPerDSPVector);
-  }
+inline float* alignToSIMD(float* p)
+{
+  uintptr_t pM = reinterpret_cast<uintptr_t>(p) + kBytesPerSIMDVector - 1;
+  return reinterpret_cast<float*>(pM & ~uintptr_t(kBytesPerSIMDVector - 1));
+}
 
-  inline void clear()
-  {
-    mDelay.clear();
-    vy1 = DSPVector();
-  }
+inline size_t roundUpToSIMD(size_t floats)
+{
+  return (floats + kFloatsPerSIMDVector - 1) & ~size_t(kFloatsPerSIMDVector - 1);
+}
 
-  // use with constant delay time.
-  inline DSPVector operator()(const DSPVector vInput)
-  {
-    DSPVector vGain(-mGain);
-    DSPVector vDelayInput = vInput - vy1 * vGain;
-    DSPVector y = vDelayInput * vGain + vy1;
-    vy1 = mDelay(vDelayInput);
-    return y;
+// interpolate between b, at the integer delay, and c, one sample older, by the
+// fraction t. a is one sample newer than b, and d one sample older than c.
+template <DelayInterpolation INTERPOLATION>
+inline SIMDVectorFloat interpolate(SIMDVectorFloat a, SIMDVectorFloat b, SIMDVectorFloat c,
+                                   SIMDVectorFloat d, SIMDVectorFloat t)
+{
+  if constexpr (INTERPOLATION == kLinearInterpolation)
+  {
+    return vecFMA(t, vecSub(c, b), b);
+  }
+  else if constexpr (INTERPOLATION == kHermiteInterpolation)
+  {
+    // Catmull-Rom spline.
+    const SIMDVectorFloat c0 = vecMul(vecSet1(0.5f), vecSub(c, a));
+    const SIMDVectorFloat c1 =
+        vecSub(vecAdd(a, vecAdd(c, c)), vecMul(vecSet1(0.5f), vecFMA(vecSet1(5.f), b, d)));
+    const SIMDVectorFloat c2 =
+        vecFMA(vecSet1(1.5f), vecSub(b, c), vecMul(vecSet1(0.5f), vecSub(d, a)));
+    return vecFMA(vecFMA(vecFMA(c2, t, c1), t, c0), t, b);
+  }
+  else
+  {
+    // Lagrange polynomial through a, b, c, d at -1, 0, 1, 2.
+    const SIMDVectorFloat one = vecSet1(1.f);
+    const SIMDVectorFloat tp1 = vecAdd(t, one);
+    const SIMDVectorFloat tm1 = vecSub(t, one);
+    const SIMDVectorFloat tm2 = vecSub(tm1, one);
+    const SIMDVectorFloat t01 = vecMul(t, tm1);
+    const SIMDVectorFloat t12 = vecMul(tm1, tm2);
+    const SIMDVectorFloat ka = vecMul(vecSet1(-1.f / 6.f), vecMul(t01, tm2));
+    const SIMDVectorFloat kb = vecMul(vecSet1(0.5f), vecMul(tp1, t12));
+    const SIMDVectorFloat kc = vecMul(vecSet1(-0.5f), vecMul(vecMul(tp1, t), tm2));
+    const SIMDVectorFloat kd = vecMul(vecSet1(1.f / 6.f), vecMul(tp1, t01));
+    return vecFMA(ka, a, vecFMA(kb, b, vecFMA(kc, c, vecMul(kd, d))));
   }
+}
 
-  // use vDelayInSamples parameter to set a varying delay time with DELAY_TYPE =
-  // PitchbendableDelay.
-  inline DSPVector operator()(const DSPVector vInput, const DSPVector vDelayInSamples)
+// write one vector to a buffer with a guard at writeIndex, which is always a
+// multiple of kFloatsPerDSPVector, so the write never wraps.
+inline void writeVector(float* pBuf, uint32_t lengthMask, uint32_t writeIndex, const float* px)
+{
+  std::copy(px, px + kFloatsPerDSPVector, pBuf + writeIndex);
+  if (writeIndex == 0)
   {
-    DSPVector vGain(-mGain);
-    DSPVector vDelayInput = vInput - vy1 * vGain;
-    DSPVector y = vDelayInput * vGain + vy1;
-    vy1 = mDelay(vDelayInput, vDelayInSamples - DSPVector(kFloatsPerDSPVector));
-    return y;
+    std::copy(pBuf, pBuf + kGuard, pBuf + lengthMask + 1);
   }
-};
-
-// FDN
-// A general Feedback Delay Network with N delay lines connected in an NxN
-// matrix.
-// TODO DELAY_TYPE parameter for modulation?
+}
 
-template <int SIZE>
-class FDN
+// read the vector of samples delayed by a whole number of samples from the
+// vector last written at writeIndex.
+inline void readVector(const float* pBuf, uint32_t lengthMask, uint32_t writeIndex, int delay,
+                       float* pDest)
 {
-  std::array<IntegerDelay, SIZE> mDelays;
-  std::array<OnePole, SIZE> mFilters;
-  std::array<DSPVector, SIZE> mDelayInputVectors{{{DSPVector(0.f)}}};
-
- public:
-  // feedback gains array is public—just copy values to set.
-  std::array<float, SIZE> mFeedbackGains{{0}};
+  const uint32_t readStart = (writeIndex - delay) & lengthMask;
+  const uint32_t firstPart = std::min(lengthMask + 1 - readStart, uint32_t(kFloatsPerDSPVector));
+  std::copy(pBuf + readStart, pBuf + readStart + firstPart, pDest);
+  std::copy(pBuf, pBuf + kFloatsPerDSPVector - firstPart, pDest + firstPart);
+}
 
-  void setDelaysInSamples(std::array<float, SIZE> times)
-  {
-    for (int n = 0; n < SIZE; ++n)
+// read one vector of samples delayed by the times at pDelay from the vector
+// last written at writeIndex. The read positions and fractions are computed
+// four at a time. The four taps around each position are contiguous, so each
+// set is gathered with one unaligned load, and a transpose gives each tap for
+// four outputs. Delay times are clamped to [1, maxDelay]: with interpolation
+// around the read position, a delay under one sample would need the next input.
+template <DelayInterpolation INTERPOLATION>
+inline void readInterpolated(const float* pBuf, uint32_t lengthMask, uint32_t writeIndex,
+                             float maxDelay, const float* pDelay, float* pDest)
+{
+  const SIMDVectorFloat vMin = vecSet1(1.f);
+  const SIMDVectorFloat vMax = vecSet1(maxDelay);
+  const SIMDVectorInt vLanes = vecSetInt4(0, 1, 2, 3);
+  alignas(kBytesPerSIMDVector) uint32_t tapIndex[kFloatsPerSIMDVector];
+
+  for (int n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+  {
+    SIMDVectorFloat vd = vecClamp(vecLoad(pDelay + n), vMin, vMax);
+    SIMDVectorInt vdInt = vecFloatToIntTruncate(vd);
+    SIMDVectorFloat vt = vecSub(vd, vecIntToFloat(vdInt));
+
+    // the index of the oldest tap, two samples before the sample at the integer
+    // delay. Masking as unsigned wraps negative values.
+    SIMDVectorInt vStart = vecAddInt(vecSet1Int(writeIndex + n - 2), vLanes);
+    vecStore(reinterpret_cast<float*>(tapIndex), VecI2F(vecSubInt(vStart, vdInt)));
+
+    // gather the taps from oldest to newest, then transpose so that vTap[k]
+    // holds the samples at delay (d + 2 - k) for all four outputs.
+    SIMDVectorFloat vTap[4];
+    for (int j = 0; j < kFloatsPerSIMDVector; ++j)
     {
-      // we have one DSPVector feedback latency, so compensate delay times for
-      // that.
-      int len = times[n] - kFloatsPerDSPVector;
-      len = max(1, len);
-      mDelays[n].setDelayInSamples(len);
+      vTap[j] = vecLoadUnaligned(pBuf + (tapIndex[j] & lengthMask));
     }
+    vecTranspose4(vTap[0], vTap[1], vTap[2], vTap[3]);
+    vecStore(pDest + n, interpolate<INTERPOLATION>(vTap[3], vTap[2], vTap[1], vTap[0], vt));
   }
+}
 
-  void setFilterCutoffs(std::array<float, SIZE> omegas)
+// Storage is the buffer with a guard used by ModulatedDelay and MultiTapDelay,
+// and the position of the next write. The buffer is either its own memory or
+// memory from a DelayMemory. Because mpBuffer may point into mOwnMemory, copies
+// would share it, so Storage is not copyable.
+class Storage
+{
+  std::vector<float> mOwnMemory;
+  float* mpBuffer{nullptr};
+  uint32_t mWriteIndex{0};
+  uint32_t mLengthMask{0};
+  float mMaxDelay{1.f};
+
+  void useMemory(float* p, float d)
   {
-    for (int n = 0; n < SIZE; ++n)
-    {
-      mFilters[n].coeffs = ml::OnePole::makeCoeffs(omegas[n]);
-    }
+    mpBuffer = p;
+    mMaxDelay = std::max(floorf(d), 1.f);
+    mLengthMask = bufferLength(d) - 1;
+    mWriteIndex = 0;
+    clear();
+  }
+
+ public:
+  Storage() = default;
+  Storage(const Storage&) = delete;
+  Storage& operator=(const Storage&) = delete;
+
+  static size_t getMemorySize(float maxDelay)
+  {
+    return roundUpToSIMD(bufferLength(maxDelay) + kGuard);
+  }
+
+  // allocate memory for delays up to d samples.
+  void setMaxDelayInSamples(float d)
+  {
+    mOwnMemory.assign(getMemorySize(d) + kFloatsPerSIMDVector, 0.f);
+    useMemory(alignToSIMD(mOwnMemory.data()), d);
+  }
+
+  // use getMemorySize(d) floats at p, which must be aligned to a SIMD vector,
+  // for delays up to d samples.
+  void setMemory(float* p, float d)
+  {
+    std::vector<float>().swap(mOwnMemory);
+    useMemory(p, d);
+  }
+
+  inline void clear()
+  {
+    if (mpBuffer) std::fill(mpBuffer, mpBuffer + getMemorySize(mMaxDelay), 0.f);
+  }
+
+  float getMaxDelay() const { return mMaxDelay; }
+
+  // write the next vector of input. After all the reads for this vector, call
+  // advance().
+  inline void write(const float* px) { writeVector(mpBuffer, mLengthMask, mWriteIndex, px); }
+
+  inline void read(int delay, float* pDest) const
+  {
+    readVector(mpBuffer, mLengthMask, mWriteIndex, delay, pDest);
+  }
+
+  template <DelayInterpolation INTERPOLATION>
+  inline void readInterpolated(const float* pDelay, float* pDest) const
+  {
+    delayUtils::readInterpolated<INTERPOLATION>(mpBuffer, mLengthMask, mWriteIndex, mMaxDelay,
+                                                pDelay, pDest);
+  }
+
+  inline void advance() { mWriteIndex = (mWriteIndex + kFloatsPerDSPVector) & mLengthMask; }
+};
+}  // namespace delayUtils
+
+// DelayMemory is one aligned block of memory that can be shared by any number
+// of delays, so that the delays in a reverb or diffuser are next to each other
+// instead of scattered over the heap. Any delay with getMemorySize() and
+// setMemory() can use it: IntegerDelay, FractionalDelay, PitchbendableDelay,
+// Allpass, ModulatedDelay and MultiTapDelay. Size the block with the sum of
+// each delay's getMemorySize(), then hand out the memory with assign(). The
+// delays must not outlive the block.
+//
+//   DelayMemory memory;
+//   memory.resize(MultiTapDelay<4>::getMemorySize(1000.f) +
+//                 Allpass<PitchbendableDelay>::getMemorySize(500.f));
+//   memory.assign(taps, 1000.f);
+//   memory.assign(allpass, 500.f);
+
+class DelayMemory
+{
+  std::vector<float> mData;
+  size_t mUsed{0};
+
+ public:
+  // allocate a zeroed block of the given number of floats. This frees any
+  // previous block, so delays using it must be assigned memory again.
+  void resize(size_t floats)
+  {
+    mData.assign(floats + kFloatsPerSIMDVector, 0.f);
+    mUsed = 0;
+  }
+
+  // return the next floats of the block, aligned to a SIMD vector, or nullptr
+  // if there is not enough left.
+  float* take(size_t floats)
+  {
+    if (mData.empty()) return nullptr;
+    float* pStart = delayUtils::alignToSIMD(mData.data());
+    const size_t capacity = mData.size() - (pStart - mData.data());
+    const size_t n = delayUtils::roundUpToSIMD(floats);
+    if (mUsed + n > capacity) return nullptr;
+    float* p = pStart + mUsed;
+    mUsed += n;
+    return p;
+  }
+
+  // give a delay enough of the block for the maximum delay maxDelay. Returns
+  // false if there is not enough left.
+  template <typename DELAY_TYPE>
+  bool assign(DELAY_TYPE& delay, float maxDelay)
+  {
+    float* p = take(DELAY_TYPE::getMemorySize(maxDelay));
+    if (!p) return false;
+    delay.setMemory(p, maxDelay);
+    return true;
+  }
+};
+
+// ModulatedDelay delays a signal by a time that can change every sample, with
+// the interpolation INTERPOLATION. Each vector of input is written at once, then
+// the outputs are read four at a time with SIMD: see
+// delayUtils::readInterpolated().
+
+template <DelayInterpolation INTERPOLATION = kHermiteInterpolation>
+class ModulatedDelay
+{
+  delayUtils::Storage mStorage;
+
+ public:
+  ModulatedDelay() = default;
+  ModulatedDelay(float d) { setMaxDelayInSamples(d); }
+  ~ModulatedDelay() = default;
+
+  static size_t getMemorySize(float maxDelay)
+  {
+    return delayUtils::Storage::getMemorySize(maxDelay);
+  }
+
+  // allocate memory for delays up to d samples.
+  void setMaxDelayInSamples(float d) { mStorage.setMaxDelayInSamples(d); }
+
+  // use getMemorySize(d) floats at p, which must be aligned to a SIMD vector,
+  // for delays up to d samples.
+  void setMemory(float* p, float d) { mStorage.setMemory(p, d); }
+
+  inline void clear() { mStorage.clear(); }
+
+  // return the input signal, delayed by the varying delay time vDelayInSamples.
+  inline DSPVector operator()(const DSPVector vx, const DSPVector vDelayInSamples)
+  {
+    DSPVector vy{kUninitialized};
+    mStorage.write(vx.getConstBuffer());
+    mStorage.readInterpolated<INTERPOLATION>(vDelayInSamples.getConstBuffer(), vy.getBuffer());
+    mStorage.advance();
+    return vy;
+  }
+};
+
+// MultiTapDelay writes its input once and reads TAPS outputs from it, returned
+// as the rows of a DSPVectorArray. Each tap can have a constant delay time set
+// with setDelaysInSamples(), or a time changing every sample. Constant whole
+// number delays are read as vector copies, and other delays with the
+// interpolation INTERPOLATION.
+
+template <int TAPS, DelayInterpolation INTERPOLATION = kHermiteInterpolation>
+class MultiTapDelay
+{
+  delayUtils::Storage mStorage;
+  std::array<float, TAPS> mDelays{};
+
+ public:
+  MultiTapDelay() = default;
+  MultiTapDelay(float d) { setMaxDelayInSamples(d); }
+  ~MultiTapDelay() = default;
+
+  static size_t getMemorySize(float maxDelay)
+  {
+    return delayUtils::Storage::getMemorySize(maxDelay);
+  }
+
+  // allocate memory for delays up to d samples.
+  void setMaxDelayInSamples(float d) { mStorage.setMaxDelayInSamples(d); }
+
+  // use getMemorySize(d) floats at p, which must be aligned to a SIMD vector,
+  // for delays up to d samples.
+  void setMemory(float* p, float d) { mStorage.setMemory(p, d); }
+
+  inline void clear() { mStorage.clear(); }
+
+  // set constant delay times, clamped to [0, max]. Fractional times are
+  // clamped to [1, max].
+  void setDelaysInSamples(std::array<float, TAPS> times)
+  {
+    for (int i = 0; i < TAPS; ++i)
+    {
+      mDelays[i] = ml::clamp(times[i], 0.f, mStorage.getMaxDelay());
+    }
+  }
+
+  // return the input signal, delayed by the constant delay times.
+  inline DSPVectorArray<TAPS> operator()(const DSPVector vx)
+  {
+    DSPVectorArray<TAPS> vy{kUninitialized};
+    mStorage.write(vx.getConstBuffer());
+    for (int i = 0; i < TAPS; ++i)
+    {
+      const float d = mDelays[i];
+      if (d == floorf(d))
+      {
+        mStorage.read(static_cast<int>(d), vy.row(i).getBuffer());
+      }
+      else
+      {
+        const DSPVector vDelay(d);
+        mStorage.readInterpolated<INTERPOLATION>(vDelay.getConstBuffer(), vy.row(i).getBuffer());
+      }
+    }
+    mStorage.advance();
+    return vy;
+  }
+
+  // return the input signal, delayed by the varying delay times on each row of
+  // vDelayInSamples.
+  inline DSPVectorArray<TAPS> operator()(const DSPVector vx,
+                                         const DSPVectorArray<TAPS>& vDelayInSamples)
+  {
+    DSPVectorArray<TAPS> vy{kUninitialized};
+    mStorage.write(vx.getConstBuffer());
+    for (int i = 0; i < TAPS; ++i)
+    {
+      mStorage.readInterpolated<INTERPOLATION>(vDelayInSamples.constRow(i).getConstBuffer(),
+                                               vy.row(i).getBuffer());
+    }
+    mStorage.advance();
+    return vy;
+  }
+};
+
+// General purpose allpass filter with arbitrary delay length.
+// For efficiency, the minimum delay time is one DSPVector.
+
+template <typename DELAY_TYPE>
+class Allpass
+{
+  DELAY_TYPE mDelay;
+  DSPVector vy1{};
+
+ public:
+  float mGain{0.f};
+
+  // use setDelayInSamples to set a constant delay time with DELAY_TYPE of
+  // IntegerDelay or FractionalDelay.
+  inline void setDelayInSamples(float d) { mDelay.setDelayInSamples(d - kFloatsPerDSPVector); }
+
+  inline void setMaxDelayInSamples(float d)
+  {
+    mDelay.setMaxDelayInSamples(d - kFloatsPerDSPVector);
+  }
+
+  static size_t getMemorySize(float maxDelay)
+  {
+    return DELAY_TYPE::getMemorySize(maxDelay - kFloatsPerDSPVector);
+  }
+  void setMemory(float* p, float d) { mDelay.setMemory(p, d - kFloatsPerDSPVector); }
+
+  inline void clear()
+  {
+    mDelay.clear();
+    vy1 = DSPVector();
+  }
+
+  // use with constant delay time.
+  inline DSPVector operator()(const DSPVector vInput)
+  {
+    DSPVector vGain(-mGain);
+    DSPVector vDelayInput = vInput - vy1 * vGain;
+    DSPVector y = vDelayInput * vGain + vy1;
+    vy1 = mDelay(vDelayInput);
+    return y;
+  }
+
+  // use vDelayInSamples parameter to set a varying delay time with DELAY_TYPE =
+  // PitchbendableDelay.
+  inline DSPVector operator()(const DSPVector vInput, const DSPVector vDelayInSamples)
+  {
+    DSPVector vGain(-mGain);
+    DSPVector vDelayInput = vInput - vy1 * vGain;
+    DSPVector y = vDelayInput * vGain + vy1;
+    vy1 = mDelay(vDelayInput, vDelayInSamples - DSPVector(kFloatsPerDSPVector));
+    return y;
+  }
+};
+
+// FDN
+// A general Feedback Delay Network with N delay lines connected in an NxN
+// matrix. For modulated delays, other matrices or more outputs, see
+// FeedbackDelayNetwork below.
+
+template <int SIZE>
+class FDN
+{
+  std::array<IntegerDelay, SIZE> mDelays;
+  std::array<OnePole, SIZE> mFilters;
+  std::array<DSPVector, SIZE> mDelayInputVectors{{{DSPVector(0.f)}}};
+
+ public:
+  // feedback gains array is public—just copy values to set.
+  std::array<float, SIZE> mFeedbackGains{{0}};
+
+  void setDelaysInSamples(std::array<float, SIZE> times)
+  {
+    for (int n = 0; n < SIZE; ++n)
+    {
+      // we have one DSPVector feedback latency, so compensate delay times for
+      // that.
+      int len = times[n] - kFloatsPerDSPVector;
+      len = max(1, len);
+      mDelays[n].setDelayInSamples(len);
+    }
+  }
+
+  void setFilterCutoffs(std::array<float, SIZE> omegas)
+  {
+    for (int n = 0; n < SIZE; ++n)
+    {
+      mFilters[n].coeffs = ml::OnePole::makeCoeffs(omegas[n]);
+    }
   }
 
   // stereo output function
@@ -1241,13 +2108,28 @@ class FDN
 // Half Band Filter
 // Polyphase allpass filter used to upsample or downsample a signal by 2x.
 // Structure due to fred harris, A. G. Constantinides and Valenzuela.
+// For many channels at once, see HalfBandBank.
 
 class HalfBandFilter
 {
  public:
+  // allpass coefficients of the two branches. order=4, rejection=70dB, transition band=0.1.
+  static constexpr float kA0{0.07986642623635751f}, kA1{0.5453536510711322f},
+      kB0{0.28382934487410993f}, kB1{0.8344118914807379f};
+
+  // The group delay at low frequencies, in samples at the higher rate, of either
+  // upsampling or downsampling. Each first order allpass section with
+  // coefficient c delays its branch by (1 - c) / (1 + c) samples at the lower
+  // rate, and the odd branch is offset by one sample at the higher rate.
+  static constexpr float getGroupDelay()
+  {
+    auto d = [](float c) { return (1.f - c) / (1.f + c); };
+    return d(kA0) + d(kA1) + d(kB0) + d(kB1) + 0.5f;
+  }
+
   inline DSPVector upsampleFirstHalf(const DSPVector vx)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     int i2 = 0;
     for (int i = 0; i < kFloatsPerDSPVector / 2; ++i)
     {
@@ -1259,7 +2141,7 @@ class HalfBandFilter
 
   inline DSPVector upsampleSecondHalf(const DSPVector vx)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     int i2 = 0;
     for (int i = kFloatsPerDSPVector / 2; i < kFloatsPerDSPVector; ++i)
     {
@@ -1271,7 +2153,7 @@ class HalfBandFilter
 
   inline DSPVector downsample(const DSPVector vx1, const DSPVector vx2)
   {
-    DSPVector vy;
+    DSPVector vy{kUninitialized};
     int i2 = 0;
     for (int i = 0; i < kFloatsPerDSPVector / 2; ++i)
     {
@@ -1303,16 +2185,14 @@ class HalfBandFilter
   }
 
  private:
-  // order=4, rejection=70dB, transition band=0.1.
-  Allpass1 apa0{0.07986642623635751f}, apa1{0.5453536510711322f}, apb0{0.28382934487410993f},
-      apb1{0.8344118914807379f};
+  Allpass1 apa0{kA0}, apa1{kA1}, apb0{kB0}, apb1{kB1};
   float b1{0};
 };
 
 // Downsampler
 // a cascade of half band filters, one for each octave.
-// TODO this is complicated. replace with single-channel version then use Bank<Downsampler> for
-// multiple channels?
+// For oversampling many channels at once, OversampleFunction in MLDSPFunctional.h runs a
+// cascade of HalfBandBanks, which filters four channels with each SIMD operation.
 class Downsampler
 {
   std::vector<HalfBandFilter> _filters;
@@ -1456,7 +2336,7 @@ struct Upsampler
   // after a write, 1 << octaves reads are available.
   DSPVector read()
   {
-    DSPVector result;
+    DSPVector result{kUninitialized};
     load(result, bufferPtr(readIdx_++));
     return result;
   }
@@ -1578,4 +2458,862 @@ class TempoLock
   }
 };
 
+// --------------------------------------------------------------------------------
+// filter banks
+//
+// These filter banks process one filter on each row of a DSPVectorArray<N>. Unlike
+// Bank<T, N>, which runs each filter in turn, they keep their coefficients and state in
+// structure-of-arrays form and each SIMD operation advances kFloatsPerSIMDVector filters
+// by one sample. Coefficients are set per row, and are constant over each DSPVector.
+
+// Filter the rows of x in groups of four, for the filter banks below. For each group of
+// rows g and each four samples starting at time n, the samples are transposed so that
+// v[j] holds the sample at time n + j from each row in the group. The kernel filters
+// v[0] to v[3] in place, in time order. If N is not a multiple of four the last group is
+// padded with rows of zeroes.
+template <size_t N, typename KERNEL>
+inline DSPVectorArray<N> processRowGroups(const DSPVectorArray<N>& x, KERNEL&& kernel)
+{
+  static_assert(kFloatsPerSIMDVector == 4, "processRowGroups: SIMD vectors must have 4 floats");
+  constexpr size_t kGroups = (N + kFloatsPerSIMDVector - 1) / kFloatsPerSIMDVector;
+
+  DSPVectorArray<N> y{kUninitialized};
+  DSPVector zeros;
+  DSPVector discard{kUninitialized};
+  for (size_t g = 0; g < kGroups; ++g)
+  {
+    const float* px[kFloatsPerSIMDVector];
+    float* py[kFloatsPerSIMDVector];
+    for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+    {
+      size_t row = g * kFloatsPerSIMDVector + i;
+      px[i] = (row < N) ? x.constRow(row).getConstBuffer() : zeros.getConstBuffer();
+      py[i] = (row < N) ? y.row(row).getBuffer() : discard.getBuffer();
+    }
+
+    for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+    {
+      SIMDVectorFloat v[kFloatsPerSIMDVector];
+      for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+      {
+        v[i] = vecLoad(px[i] + n);
+      }
+      vecTranspose4(v[0], v[1], v[2], v[3]);
+      kernel(g, v);
+      vecTranspose4(v[0], v[1], v[2], v[3]);
+      for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+      {
+        vecStore(py[i] + n, v[i]);
+      }
+    }
+  }
+  return y;
+}
+
+// storage for one float per filter in a bank, padded to a whole number of SIMD vectors.
+template <size_t N>
+struct alignas(kBytesPerSIMDVector) BankLanes
+{
+  static constexpr size_t kSize =
+      (N + kFloatsPerSIMDVector - 1) / kFloatsPerSIMDVector * kFloatsPerSIMDVector;
+  std::array<float, kSize> data{};
+
+  float& operator[](size_t i) { return data[i]; }
+  SIMDVectorFloat load(size_t group) const
+  {
+    return vecLoad(data.data() + group * kFloatsPerSIMDVector);
+  }
+  void store(size_t group, SIMDVectorFloat v)
+  {
+    vecStore(data.data() + group * kFloatsPerSIMDVector, v);
+  }
+  void fill(float f) { data.fill(f); }
+};
+
+// N one pole filters, computing the same recurrence as OnePole.
+
+template <size_t N>
+class OnePoleBank
+{
+  BankLanes<N> _a0, _b1, _y1;
+
+ public:
+  typedef OnePole::Coeffs Coeffs;
+
+  static Coeffs makeCoeffs(float omega) { return OnePole::makeCoeffs(omega); }
+
+  // set the coefficients of filter i.
+  void setCoeffs(size_t i, Coeffs c)
+  {
+    _a0[i] = c.a0;
+    _b1[i] = c.b1;
+  }
+
+  // set the coefficients of all the filters.
+  void setCoeffs(Coeffs c)
+  {
+    _a0.fill(c.a0);
+    _b1.fill(c.b1);
+  }
+
+  inline DSPVectorArray<N> operator()(const DSPVectorArray<N>& x)
+  {
+    return processRowGroups(x, [&](size_t g, SIMDVectorFloat* v) {
+      const SIMDVectorFloat a0 = _a0.load(g);
+      const SIMDVectorFloat b1 = _b1.load(g);
+      SIMDVectorFloat y1 = _y1.load(g);
+      for (size_t j = 0; j < kFloatsPerSIMDVector; ++j)
+      {
+        y1 = vecAdd(vecMul(a0, v[j]), vecMul(b1, y1));
+        v[j] = y1;
+      }
+      _y1.store(g, y1);
+    });
+  }
+
+  void clear() { _y1.fill(0.f); }
+};
+
+// N state variable filters, computing the same recurrence as Lopass, Bandpass and Hipass.
+// Each filter has its own response type, set by the output mix coefficients m0, m1 and m2.
+
+template <size_t N>
+class SVFBank
+{
+  BankLanes<N> _g0, _g1, _g2, _m0, _m1, _m2;
+  BankLanes<N> _ic1eq, _ic2eq;
+
+ public:
+  struct Coeffs
+  {
+    float g0, g1, g2, m0, m1, m2;
+  };
+
+  static Coeffs lopassCoeffs(float omega, float k)
+  {
+    auto c = Lopass::makeCoeffs(omega, k);
+    return {c[Lopass::g0], c[Lopass::g1], c[Lopass::g2], 0.f, 0.f, 1.f};
+  }
+
+  static Coeffs bandpassCoeffs(float omega, float k)
+  {
+    auto c = Lopass::makeCoeffs(omega, k);
+    return {c[Lopass::g0], c[Lopass::g1], c[Lopass::g2], 0.f, 1.f, 0.f};
+  }
+
+  static Coeffs hipassCoeffs(float omega, float k)
+  {
+    auto c = Lopass::makeCoeffs(omega, k);
+    return {c[Lopass::g0], c[Lopass::g1], c[Lopass::g2], 1.f, -k, -1.f};
+  }
+
+  // set the coefficients of filter i.
+  void setCoeffs(size_t i, Coeffs c)
+  {
+    _g0[i] = c.g0;
+    _g1[i] = c.g1;
+    _g2[i] = c.g2;
+    _m0[i] = c.m0;
+    _m1[i] = c.m1;
+    _m2[i] = c.m2;
+  }
+
+  // set the coefficients of all the filters.
+  void setCoeffs(Coeffs c)
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      setCoeffs(i, c);
+    }
+  }
+
+  inline DSPVectorArray<N> operator()(const DSPVectorArray<N>& x)
+  {
+    return processRowGroups(x, [&](size_t g, SIMDVectorFloat* v) {
+      const SIMDVectorFloat g0 = _g0.load(g);
+      const SIMDVectorFloat g1 = _g1.load(g);
+      const SIMDVectorFloat g2 = _g2.load(g);
+      const SIMDVectorFloat m0 = _m0.load(g);
+      const SIMDVectorFloat m1 = _m1.load(g);
+      const SIMDVectorFloat m2 = _m2.load(g);
+      const SIMDVectorFloat two = vecSet1(2.0f);
+      SIMDVectorFloat ic1eq = _ic1eq.load(g);
+      SIMDVectorFloat ic2eq = _ic2eq.load(g);
+      for (size_t j = 0; j < kFloatsPerSIMDVector; ++j)
+      {
+        SIMDVectorFloat v0 = v[j];
+        SIMDVectorFloat t0 = vecSub(v0, ic2eq);
+        SIMDVectorFloat t1 = vecFMA(g0, t0, vecMul(g1, ic1eq));
+        SIMDVectorFloat t2 = vecFMA(g2, t0, vecMul(g0, ic1eq));
+        SIMDVectorFloat v1 = vecAdd(t1, ic1eq);
+        SIMDVectorFloat v2 = vecAdd(t2, ic2eq);
+        ic1eq = vecFMA(two, t1, ic1eq);
+        ic2eq = vecFMA(two, t2, ic2eq);
+        v[j] = vecFMA(m2, v2, vecFMA(m1, v1, vecMul(m0, v0)));
+      }
+      _ic1eq.store(g, ic1eq);
+      _ic2eq.store(g, ic2eq);
+    });
+  }
+
+  void clear()
+  {
+    _ic1eq.fill(0.f);
+    _ic2eq.fill(0.f);
+  }
+};
+
+// N biquad filters in transposed direct form II. The coefficients are normalized so that
+// a0 = 1. Designs are from the RBJ Audio EQ Cookbook, using omega and k as elsewhere.
+
+template <size_t N>
+class BiquadBank
+{
+  BankLanes<N> _b0, _b1, _b2, _a1, _a2;
+  BankLanes<N> _s1, _s2;
+
+ public:
+  struct Coeffs
+  {
+    float b0, b1, b2, a1, a2;
+  };
+
+  static Coeffs passthru() { return {1.f, 0.f, 0.f, 0.f, 0.f}; }
+
+  static Coeffs lopassCoeffs(float omega, float k)
+  {
+    float w0 = kTwoPi * omega;
+    float cosW0 = cosf(w0);
+    float alpha = sinf(w0) * k * 0.5f;
+    float nrm = 1.f / (1.f + alpha);
+    float b1 = (1.f - cosW0) * nrm;
+    return {b1 * 0.5f, b1, b1 * 0.5f, -2.f * cosW0 * nrm, (1.f - alpha) * nrm};
+  }
+
+  static Coeffs hipassCoeffs(float omega, float k)
+  {
+    float w0 = kTwoPi * omega;
+    float cosW0 = cosf(w0);
+    float alpha = sinf(w0) * k * 0.5f;
+    float nrm = 1.f / (1.f + alpha);
+    float b1 = -(1.f + cosW0) * nrm;
+    return {b1 * -0.5f, b1, b1 * -0.5f, -2.f * cosW0 * nrm, (1.f - alpha) * nrm};
+  }
+
+  // bandpass with 0 dB peak gain.
+  static Coeffs bandpassCoeffs(float omega, float k)
+  {
+    float w0 = kTwoPi * omega;
+    float cosW0 = cosf(w0);
+    float alpha = sinf(w0) * k * 0.5f;
+    float nrm = 1.f / (1.f + alpha);
+    return {alpha * nrm, 0.f, -alpha * nrm, -2.f * cosW0 * nrm, (1.f - alpha) * nrm};
+  }
+
+  // set the coefficients of filter i.
+  void setCoeffs(size_t i, Coeffs c)
+  {
+    _b0[i] = c.b0;
+    _b1[i] = c.b1;
+    _b2[i] = c.b2;
+    _a1[i] = c.a1;
+    _a2[i] = c.a2;
+  }
+
+  // set the coefficients of all the filters.
+  void setCoeffs(Coeffs c)
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      setCoeffs(i, c);
+    }
+  }
+
+  inline DSPVectorArray<N> operator()(const DSPVectorArray<N>& x)
+  {
+    return processRowGroups(x, [&](size_t g, SIMDVectorFloat* v) {
+      const SIMDVectorFloat b0 = _b0.load(g);
+      const SIMDVectorFloat b1 = _b1.load(g);
+      const SIMDVectorFloat b2 = _b2.load(g);
+      const SIMDVectorFloat a1 = _a1.load(g);
+      const SIMDVectorFloat a2 = _a2.load(g);
+      SIMDVectorFloat s1 = _s1.load(g);
+      SIMDVectorFloat s2 = _s2.load(g);
+      for (size_t j = 0; j < kFloatsPerSIMDVector; ++j)
+      {
+        SIMDVectorFloat x0 = v[j];
+        SIMDVectorFloat y0 = vecFMA(b0, x0, s1);
+        s1 = vecFNMA(a1, y0, vecFMA(b1, x0, s2));
+        s2 = vecFNMA(a2, y0, vecMul(b2, x0));
+        v[j] = y0;
+      }
+      _s1.store(g, s1);
+      _s2.store(g, s2);
+    });
+  }
+
+  void clear()
+  {
+    _s1.fill(0.f);
+    _s2.fill(0.f);
+  }
+};
+
+// N half band filters, computing the same recurrences as HalfBandFilter. Each row of the
+// input is a channel. Like HalfBandFilter, one bank should be used either for upsampling or
+// for downsampling, not both.
+
+template <size_t N>
+class HalfBandBank
+{
+  static_assert(kFloatsPerSIMDVector == 4, "HalfBandBank: SIMD vectors must have 4 floats");
+  static constexpr size_t kGroups = (N + kFloatsPerSIMDVector - 1) / kFloatsPerSIMDVector;
+
+  // the state of the four allpass sections and the delayed odd branch for one group of rows.
+  struct GroupState
+  {
+    SIMDVectorFloat x1[4], y1[4], b1;
+  };
+  std::array<GroupState, kGroups> _state;
+
+  static inline SIMDVectorFloat allpass(SIMDVectorFloat x, float c, SIMDVectorFloat& x1,
+                                        SIMDVectorFloat& y1)
+  {
+    SIMDVectorFloat y = vecFMA(vecSub(x, y1), vecSet1(c), x1);
+    x1 = x;
+    y1 = y;
+    return y;
+  }
+  static inline SIMDVectorFloat branchA(SIMDVectorFloat x, GroupState& s)
+  {
+    return allpass(allpass(x, HalfBandFilter::kA0, s.x1[0], s.y1[0]), HalfBandFilter::kA1,
+                   s.x1[1], s.y1[1]);
+  }
+  static inline SIMDVectorFloat branchB(SIMDVectorFloat x, GroupState& s)
+  {
+    return allpass(allpass(x, HalfBandFilter::kB0, s.x1[2], s.y1[2]), HalfBandFilter::kB1,
+                   s.x1[3], s.y1[3]);
+  }
+
+ public:
+  HalfBandBank() { clear(); }
+
+  // upsample x by 2, writing the first and second halves of the result to y1 and y2.
+  void upsample(const DSPVectorArray<N>& x, DSPVectorArray<N>& y1, DSPVectorArray<N>& y2)
+  {
+    DSPVector zeros;
+    DSPVector discard{kUninitialized};
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      GroupState& s = _state[g];
+      const float* px[kFloatsPerSIMDVector];
+      float* py1[kFloatsPerSIMDVector];
+      float* py2[kFloatsPerSIMDVector];
+      for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+      {
+        size_t row = g * kFloatsPerSIMDVector + i;
+        px[i] = (row < N) ? x.constRow(row).getConstBuffer() : zeros.getConstBuffer();
+        py1[i] = (row < N) ? y1.row(row).getBuffer() : discard.getBuffer();
+        py2[i] = (row < N) ? y2.row(row).getBuffer() : discard.getBuffer();
+      }
+
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        SIMDVectorFloat v[4];
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          v[i] = vecLoad(px[i] + n);
+        }
+        vecTranspose4(v[0], v[1], v[2], v[3]);
+
+        // each input sample makes an even and an odd output sample.
+        SIMDVectorFloat w[8];
+        for (size_t j = 0; j < 4; ++j)
+        {
+          w[j * 2] = branchA(v[j], s);
+          w[j * 2 + 1] = branchB(v[j], s);
+        }
+        vecTranspose4(w[0], w[1], w[2], w[3]);
+        vecTranspose4(w[4], w[5], w[6], w[7]);
+
+        const size_t m = (n * 2) % kFloatsPerDSPVector;
+        float** py = (n * 2 < kFloatsPerDSPVector) ? py1 : py2;
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          vecStore(py[i] + m, w[i]);
+          vecStore(py[i] + m + kFloatsPerSIMDVector, w[i + 4]);
+        }
+      }
+    }
+  }
+
+  // downsample the signal made of x1 followed by x2 by 2.
+  DSPVectorArray<N> downsample(const DSPVectorArray<N>& x1, const DSPVectorArray<N>& x2)
+  {
+    DSPVectorArray<N> y{kUninitialized};
+    DSPVector zeros;
+    DSPVector discard{kUninitialized};
+    const SIMDVectorFloat half = vecSet1(0.5f);
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      GroupState& s = _state[g];
+      const float* px1[kFloatsPerSIMDVector];
+      const float* px2[kFloatsPerSIMDVector];
+      float* py[kFloatsPerSIMDVector];
+      for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+      {
+        size_t row = g * kFloatsPerSIMDVector + i;
+        px1[i] = (row < N) ? x1.constRow(row).getConstBuffer() : zeros.getConstBuffer();
+        px2[i] = (row < N) ? x2.constRow(row).getConstBuffer() : zeros.getConstBuffer();
+        py[i] = (row < N) ? y.row(row).getBuffer() : discard.getBuffer();
+      }
+
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        // load the eight input samples for four output samples.
+        const size_t m = (n * 2) % kFloatsPerDSPVector;
+        const float** px = (n * 2 < kFloatsPerDSPVector) ? px1 : px2;
+        SIMDVectorFloat v[8];
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          v[i] = vecLoad(px[i] + m);
+          v[i + 4] = vecLoad(px[i] + m + kFloatsPerSIMDVector);
+        }
+        vecTranspose4(v[0], v[1], v[2], v[3]);
+        vecTranspose4(v[4], v[5], v[6], v[7]);
+
+        SIMDVectorFloat w[4];
+        for (size_t j = 0; j < 4; ++j)
+        {
+          SIMDVectorFloat a0 = branchA(v[j * 2], s);
+          SIMDVectorFloat b0 = branchB(v[j * 2 + 1], s);
+          w[j] = vecMul(vecAdd(a0, s.b1), half);
+          s.b1 = b0;
+        }
+        vecTranspose4(w[0], w[1], w[2], w[3]);
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          vecStore(py[i] + n, w[i]);
+        }
+      }
+    }
+    return y;
+  }
+
+  void clear()
+  {
+    for (auto& s : _state)
+    {
+      for (int i = 0; i < 4; ++i)
+      {
+        s.x1[i] = s.y1[i] = vecZeros();
+      }
+      s.b1 = vecZeros();
+    }
+  }
+};
+
+// N ADSR envelopes, computing the same recurrence as ADSR. Each input row is the
+// gate + amp signal for one envelope. The envelopes are advanced four at a time,
+// and the segment changes are made with comparisons and selects instead of
+// branches, so the cost does not depend on the segments of the envelopes.
+
+template <size_t N>
+class ADSRBank
+{
+  BankLanes<N> _ka, _kd, _s, _kr;
+  BankLanes<N> _y, _y1, _x1, _threshold, _target, _k, _amp, _segment;
+
+ public:
+  typedef ADSR::Coeffs Coeffs;
+
+  ADSRBank() { clear(); }
+
+  static Coeffs calcCoeffs(float a, float d, float s, float r, float sr)
+  {
+    return ADSR::calcCoeffs(a, d, s, r, sr);
+  }
+
+  // set the coefficients of envelope i.
+  void setCoeffs(size_t i, Coeffs c)
+  {
+    _ka[i] = c.ka;
+    _kd[i] = c.kd;
+    _s[i] = c.s;
+    _kr[i] = c.kr;
+  }
+
+  // set the coefficients of all the envelopes.
+  void setCoeffs(Coeffs c)
+  {
+    _ka.fill(c.ka);
+    _kd.fill(c.kd);
+    _s.fill(c.s);
+    _kr.fill(c.kr);
+  }
+
+  void clear() { _segment.fill(float(ADSR::off)); }
+
+  // run the envelopes with a gate + amp signal on each row of x.
+  inline DSPVectorArray<N> operator()(const DSPVectorArray<N>& x)
+  {
+    // unlike the filter banks, each group is advanced by four samples in turn,
+    // so that the groups' long chains of dependent operations can overlap.
+    DSPVectorArray<N> y{kUninitialized};
+    DSPVector zeros;
+    DSPVector discard{kUninitialized};
+    const float* px[kGroups][kFloatsPerSIMDVector];
+    float* py[kGroups][kFloatsPerSIMDVector];
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+      {
+        size_t row = g * kFloatsPerSIMDVector + i;
+        px[g][i] = (row < N) ? x.constRow(row).getConstBuffer() : zeros.getConstBuffer();
+        py[g][i] = (row < N) ? y.row(row).getBuffer() : discard.getBuffer();
+      }
+    }
+
+    for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+    {
+      for (size_t g = 0; g < kGroups; ++g)
+      {
+        SIMDVectorFloat v[kFloatsPerSIMDVector];
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          v[i] = vecLoad(px[g][i] + n);
+        }
+        vecTranspose4(v[0], v[1], v[2], v[3]);
+        process4(g, v);
+        vecTranspose4(v[0], v[1], v[2], v[3]);
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          vecStore(py[g][i] + n, v[i]);
+        }
+      }
+    }
+    return y;
+  }
+
+  // run the envelopes with separate gate and amp signals. Each envelope is
+  // triggered when its gate rises above 0 with an amp above 0, and scaled by
+  // the amp at that time.
+  inline DSPVectorArray<N> operator()(const DSPVectorArray<N>& gate, const DSPVectorArray<N>& amp)
+  {
+    const DSPVectorArray<N> zero(0.f);
+    return operator()(select(amp, zero, greaterThan(gate, zero)));
+  }
+
+ private:
+  static constexpr size_t kGroups = (N + kFloatsPerSIMDVector - 1) / kFloatsPerSIMDVector;
+
+  // advance the envelopes in group g by four samples. v[j] holds the inputs at time j
+  // and is replaced by the outputs.
+  inline void process4(size_t g, SIMDVectorFloat* v)
+  {
+    const SIMDVectorFloat zero = vecZeros();
+    const SIMDVectorFloat one = vecSet1(1.f);
+    const SIMDVectorFloat segA = vecSet1(float(ADSR::A));
+    const SIMDVectorFloat segD = vecSet1(float(ADSR::D));
+    const SIMDVectorFloat segS = vecSet1(float(ADSR::S));
+    const SIMDVectorFloat segR = vecSet1(float(ADSR::R));
+    const SIMDVectorFloat segOff = vecSet1(float(ADSR::off));
+    const SIMDVectorFloat bias = vecSet1(ADSR::bias);
+    const SIMDVectorFloat ka = _ka.load(g);
+    const SIMDVectorFloat kd = _kd.load(g);
+    const SIMDVectorFloat s = _s.load(g);
+    const SIMDVectorFloat kr = _kr.load(g);
+    SIMDVectorFloat y = _y.load(g);
+    SIMDVectorFloat y1 = _y1.load(g);
+    SIMDVectorFloat x1 = _x1.load(g);
+    SIMDVectorFloat threshold = _threshold.load(g);
+    SIMDVectorFloat target = _target.load(g);
+    SIMDVectorFloat k = _k.load(g);
+    SIMDVectorFloat amp = _amp.load(g);
+    SIMDVectorFloat segment = _segment.load(g);
+
+    for (size_t j = 0; j < kFloatsPerSIMDVector; ++j)
+    {
+      const SIMDVectorFloat x = v[j];
+
+      // envelopes that are off with no input output 0 and keep their state.
+      const SIMDVectorFloat active = vecOr(vecNotEqual(segment, segOff), vecNotEqual(x, zero));
+      if (!vecAnyTrue(active))
+      {
+        v[j] = zero;
+        continue;
+      }
+
+      // crossing the threshold advances to the next segment, and the gate
+      // starts the attack or release.
+      const SIMDVectorFloat above1 = vecAnd(vecGreaterThan(y1, threshold), one);
+      const SIMDVectorFloat above = vecAnd(vecGreaterThan(y, threshold), one);
+      const SIMDVectorFloat advance =
+          vecAnd(vecNotEqual(above1, above), vecLessThan(segment, segOff));
+      const SIMDVectorFloat trigOn = vecAnd(vecEqual(x1, zero), vecGreaterThan(x, zero));
+      const SIMDVectorFloat trigOff = vecAnd(vecGreaterThan(x1, zero), vecEqual(x, zero));
+      const SIMDVectorFloat recalc = vecAnd(vecOr(advance, vecOr(trigOn, trigOff)), active);
+
+      // set up the new segments: their start, end and rate. Entering S or off
+      // also sets the output. Segments change rarely, so this is skipped when
+      // no envelope in the group needs it.
+      SIMDVectorFloat newY = y;
+      if (vecAnyTrue(recalc))
+      {
+        SIMDVectorFloat newSegment = vecAdd(segment, vecAnd(advance, one));
+        newSegment = vecSelect(segA, vecSelect(segR, newSegment, trigOff), trigOn);
+        const SIMDVectorFloat isA = vecEqual(newSegment, segA);
+        const SIMDVectorFloat isD = vecEqual(newSegment, segD);
+        const SIMDVectorFloat isS = vecEqual(newSegment, segS);
+        const SIMDVectorFloat isR = vecEqual(newSegment, segR);
+        const SIMDVectorFloat startEnv = vecSelect(one, vecSelect(s, zero, vecOr(isS, isR)), isD);
+        const SIMDVectorFloat endEnv = vecSelect(one, vecSelect(s, zero, vecOr(isD, isS)), isA);
+        const SIMDVectorFloat newK =
+            vecSelect(ka, vecSelect(kd, vecSelect(kr, zero, isR), isD), isA);
+        const SIMDVectorFloat segmentBias = vecMul(vecSub(endEnv, startEnv), bias);
+        const SIMDVectorFloat setsOutput =
+            vecAnd(recalc, vecOr(isS, vecEqual(newSegment, segOff)));
+
+        newY = vecSelect(endEnv, y, setsOutput);
+        segment = vecSelect(newSegment, segment, recalc);
+        amp = vecSelect(x, amp, trigOn);
+        threshold = vecSelect(endEnv, threshold, recalc);
+        target = vecSelect(vecAdd(endEnv, segmentBias), target, recalc);
+        k = vecSelect(newK, k, recalc);
+      }
+
+      // history and IIR filter, for the active envelopes.
+      const SIMDVectorFloat nextY = vecAdd(newY, vecMul(k, vecSub(target, newY)));
+      x1 = vecSelect(x, x1, active);
+      y1 = vecSelect(newY, y1, active);
+      y = vecSelect(nextY, y, active);
+
+      // scale by amp
+      v[j] = vecAnd(vecMul(y, amp), active);
+    }
+
+    _y.store(g, y);
+    _y1.store(g, y1);
+    _x1.store(g, x1);
+    _threshold.store(g, threshold);
+    _target.store(g, target);
+    _k.store(g, k);
+    _amp.store(g, amp);
+    _segment.store(g, segment);
+  }
+};
+
+// FeedbackDelayNetwork
+// A Feedback Delay Network with SIZE delay lines of type DELAY_TYPE and OUTPUTS outputs.
+// The outputs of the lines are kept in a DSPVectorArray<SIZE>, so that the feedback
+// matrix, the damping filters (a OnePoleBank) and the output sums are all computed with
+// SIMD operations on whole rows. The feedback matrix can be a Householder matrix, a
+// normalized Hadamard matrix (if SIZE is a power of two) or any SIZE x SIZE matrix.
+//
+// With IntegerDelay or FractionalDelay lines, set constant delay times with
+// setDelaysInSamples() and call operator()(x). With any delay type, including
+// PitchbendableDelay, call operator()(x, delayTimes) to modulate the delay time of each
+// line every sample. setMaxDelayInSamples() must be called before processing. As in FDN,
+// the feedback loop has one DSPVector of latency, which is subtracted from all delay
+// times, so delay times must be at least kFloatsPerDSPVector + 1 samples.
+
+template <int SIZE, int OUTPUTS = 2, typename DELAY_TYPE = IntegerDelay>
+class FeedbackDelayNetwork
+{
+ public:
+  using Matrix = std::array<std::array<float, SIZE>, SIZE>;
+  using OutputMatrix = std::array<std::array<float, SIZE>, OUTPUTS>;
+
+  FeedbackDelayNetwork()
+  {
+    _filters.setCoeffs(OnePole::passthru());
+    _feedbackGains.fill(0.f);
+    _inputGains.fill(1.f);
+
+    // by default, line n is added to output n % OUTPUTS.
+    for (int k = 0; k < OUTPUTS; ++k)
+    {
+      for (int n = 0; n < SIZE; ++n)
+      {
+        _outputMatrix[k][n] = (n % OUTPUTS == k) ? 1.f : 0.f;
+      }
+    }
+  }
+
+  void setMaxDelayInSamples(float d)
+  {
+    for (auto& delay : _delays)
+    {
+      delay.setMaxDelayInSamples(d);
+    }
+  }
+
+  // set constant delay times, for delay types that have setDelayInSamples().
+  void setDelaysInSamples(std::array<float, SIZE> times)
+  {
+    for (int n = 0; n < SIZE; ++n)
+    {
+      _delays[n].setDelayInSamples(std::max(times[n] - kFloatsPerDSPVector, 1.f));
+    }
+  }
+
+  void setFilterCutoffs(std::array<float, SIZE> omegas)
+  {
+    for (int n = 0; n < SIZE; ++n)
+    {
+      _filters.setCoeffs(n, OnePole::makeCoeffs(omegas[n]));
+    }
+  }
+
+  void setFeedbackGains(std::array<float, SIZE> gains) { _feedbackGains = gains; }
+  void setInputGains(std::array<float, SIZE> gains) { _inputGains = gains; }
+  void setOutputMatrix(const OutputMatrix& m) { _outputMatrix = m; }
+
+  // use the Householder matrix I - (2 / SIZE) * ones.
+  void setHouseholderMatrix() { _matrixType = kHouseholder; }
+
+  // use the Hadamard matrix of size SIZE, normalized by 1 / sqrt(SIZE).
+  void setHadamardMatrix()
+  {
+    static_assert((SIZE & (SIZE - 1)) == 0, "FeedbackDelayNetwork: Hadamard size must be 2^n.");
+    _matrixType = kHadamard;
+  }
+
+  // use any matrix m, where m[i][j] is the gain from line j to line i.
+  void setMatrix(const Matrix& m)
+  {
+    _matrix = m;
+    _matrixType = kArbitrary;
+  }
+
+  void clear()
+  {
+    for (auto& delay : _delays)
+    {
+      delay.clear();
+    }
+    _filters.clear();
+    _lineInputs = DSPVectorArray<SIZE>();
+  }
+
+  // run with constant delay times.
+  DSPVectorArray<OUTPUTS> operator()(const DSPVector x)
+  {
+    DSPVectorArray<SIZE> lineOutputs{kUninitialized};
+    for (int n = 0; n < SIZE; ++n)
+    {
+      lineOutputs.row(n) = _delays[n](_lineInputs.constRow(n));
+    }
+    return feedback(x, lineOutputs);
+  }
+
+  // run with the delay time of line n, in samples, on row n of delayTimes.
+  DSPVectorArray<OUTPUTS> operator()(const DSPVector x, const DSPVectorArray<SIZE>& delayTimes)
+  {
+    DSPVectorArray<SIZE> lineOutputs{kUninitialized};
+    const DSPVector latency(kFloatsPerDSPVector);
+    for (int n = 0; n < SIZE; ++n)
+    {
+      lineOutputs.row(n) = _delays[n](_lineInputs.constRow(n), delayTimes.constRow(n) - latency);
+    }
+    return feedback(x, lineOutputs);
+  }
+
+ private:
+  enum MatrixType
+  {
+    kHouseholder,
+    kHadamard,
+    kArbitrary
+  };
+
+  // make the outputs, and the inputs to the lines for the next vector.
+  DSPVectorArray<OUTPUTS> feedback(const DSPVector x, const DSPVectorArray<SIZE>& lineOutputs)
+  {
+    DSPVectorArray<OUTPUTS> y;
+    for (int k = 0; k < OUTPUTS; ++k)
+    {
+      for (int n = 0; n < SIZE; ++n)
+      {
+        if (_outputMatrix[k][n] != 0.f)
+        {
+          y.row(k) = multiplyAdd(lineOutputs.constRow(n), _outputMatrix[k][n], y.constRow(k));
+        }
+      }
+    }
+
+    DSPVectorArray<SIZE> mixed = _filters(multiplyByMatrix(lineOutputs));
+    for (int n = 0; n < SIZE; ++n)
+    {
+      _lineInputs.row(n) = multiplyAdd(mixed.constRow(n), _feedbackGains[n], x * _inputGains[n]);
+    }
+    return y;
+  }
+
+  DSPVectorArray<SIZE> multiplyByMatrix(const DSPVectorArray<SIZE>& v)
+  {
+    DSPVectorArray<SIZE> y{kUninitialized};
+    switch (_matrixType)
+    {
+      case kHouseholder:
+      {
+        DSPVector sum;
+        for (int n = 0; n < SIZE; ++n)
+        {
+          sum += v.constRow(n);
+        }
+        sum *= DSPVector(2.0f / SIZE);
+        for (int n = 0; n < SIZE; ++n)
+        {
+          y.row(n) = v.constRow(n) - sum;
+        }
+        break;
+      }
+      case kHadamard:
+      {
+        // fast Walsh-Hadamard transform: log2(SIZE) stages of butterflies.
+        y = v;
+        for (int h = 1; h < SIZE; h *= 2)
+        {
+          for (int i = 0; i < SIZE; i += h * 2)
+          {
+            for (int j = i; j < i + h; ++j)
+            {
+              DSPVector a = y.constRow(j);
+              DSPVector b = y.constRow(j + h);
+              y.row(j) = a + b;
+              y.row(j + h) = a - b;
+            }
+          }
+        }
+        y *= DSPVectorArray<SIZE>(1.f / sqrtf(SIZE));
+        break;
+      }
+      case kArbitrary:
+      {
+        for (int i = 0; i < SIZE; ++i)
+        {
+          DSPVector sum;
+          for (int j = 0; j < SIZE; ++j)
+          {
+            sum = multiplyAdd(v.constRow(j), _matrix[i][j], sum);
+          }
+          y.row(i) = sum;
+        }
+        break;
+      }
+    }
+    return y;
+  }
+
+  std::array<DELAY_TYPE, SIZE> _delays;
+  OnePoleBank<SIZE> _filters;
+  DSPVectorArray<SIZE> _lineInputs;
+  std::array<float, SIZE> _feedbackGains;
+  std::array<float, SIZE> _inputGains;
+  OutputMatrix _outputMatrix;
+  Matrix _matrix{};
+  MatrixType _matrixType{kHouseholder};
+};
+
 }  // namespace ml
@@ -11,6 +11,7 @@
 #include <functional>
 
 #include "MLDSPFilters.h"
+#include "MLDSPUtils.h"
 
 namespace ml
 {
@@ -23,8 +24,8 @@ namespace ml
 template <size_t ROWS>
 inline DSPVectorArray<ROWS> map(std::function<float()> f, const DSPVectorArray<ROWS> x)
 {
-  DSPVectorArray<ROWS> y;
-  for (int n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
+  DSPVectorArray<ROWS> y{kUninitialized};
+  for (size_t n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
   {
     y[n] = f();
   }
@@ -36,8 +37,8 @@ inline DSPVectorArray<ROWS> map(std::function<float()> f, const DSPVectorArray<R
 template <size_t ROWS>
 inline DSPVectorArray<ROWS> map(std::function<float(float)> f, const DSPVectorArray<ROWS> x)
 {
-  DSPVectorArray<ROWS> y;
-  for (int n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
+  DSPVectorArray<ROWS> y{kUninitialized};
+  for (size_t n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
   {
     y[n] = f(x[n]);
   }
@@ -49,8 +50,8 @@ inline DSPVectorArray<ROWS> map(std::function<float(float)> f, const DSPVectorAr
 template <size_t ROWS>
 inline DSPVectorArray<ROWS> map(std::function<float(int)> f, const DSPVectorArrayInt<ROWS> x)
 {
-  DSPVectorArray<ROWS> y;
-  for (int n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
+  DSPVectorArray<ROWS> y{kUninitialized};
+  for (size_t n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
   {
     y[n] = f(x[n]);
   }
@@ -63,8 +64,8 @@ template <size_t ROWS>
 inline DSPVectorArray<ROWS> map(std::function<DSPVector(const DSPVector)> f,
                                 const DSPVectorArray<ROWS> x)
 {
-  DSPVectorArray<ROWS> y;
-  for (int j = 0; j < ROWS; ++j)
+  DSPVectorArray<ROWS> y{kUninitialized};
+  for (size_t j = 0; j < ROWS; ++j)
   {
     y.row(j) = f(x.constRow(j));
   }
@@ -77,8 +78,8 @@ template <size_t ROWS>
 inline DSPVectorArray<ROWS> map(std::function<DSPVector(const DSPVector, int)> f,
                                 const DSPVectorArray<ROWS> x)
 {
-  DSPVectorArray<ROWS> y;
-  for (int j = 0; j < ROWS; ++j)
+  DSPVectorArray<ROWS> y{kUninitialized};
+  for (size_t j = 0; j < ROWS; ++j)
   {
     y.row(j) = f(x.constRow(j), j);
   }
@@ -91,7 +92,7 @@ template <size_t ROWS>
 inline DSPVectorArray<ROWS> map(std::function<DSPVector(const DSPVector, const DSPVector)> f,
                                 const DSPVectorArray<ROWS> x)
 {
-  DSPVectorArray<ROWS> y;
+  DSPVectorArray<ROWS> y{kUninitialized};
   for (int j = 0; j < ROWS; ++j)
   {
     y.row(j) = f(x.constRow(j), j);
@@ -179,7 +180,7 @@ class Downsample2xFunction
   inline DSPVectorArray<OUT_ROWS> operator()(ProcessFn fn,
                                              const DSPVectorArray<IN_ROWS> vx = DSPVectorArray<0>())
   {
-    DSPVectorArray<OUT_ROWS> vy;
+    DSPVectorArray<OUT_ROWS> vy{kUninitialized};
     if (mPhase)
     {
       // downsample each row of input to 1/2x buffers
@@ -222,25 +223,216 @@ class Downsample2xFunction
   bool mPhase{false};
 };
 
-// OverlapAddFunction TODO
-/*
-template<int LENGTH, int DIVISIONS, int IN_ROWS, int OUT_ROWS>
+// OversampleFunction is a function object that given a process function f,
+// upsamples the input x by FACTOR, applies f to each of the FACTOR resulting
+// DSPVectorArrays, downsamples and returns the result. FACTOR can be 2, 4, 8 or
+// 16. Each octave is a HalfBandBank, so all the rows are resampled together with
+// SIMD. getGroupDelay() returns the delay of the resampling filters at low
+// frequencies, in samples at the original rate.
+
+template <int FACTOR, int IN_ROWS, int OUT_ROWS = IN_ROWS>
+class OversampleFunction
+{
+  static_assert((FACTOR == 2) || (FACTOR == 4) || (FACTOR == 8) || (FACTOR == 16),
+                "OversampleFunction: FACTOR must be 2, 4, 8 or 16.");
+  static constexpr int kOctaves = (FACTOR == 2) ? 1 : (FACTOR == 4) ? 2 : (FACTOR == 8) ? 3 : 4;
+
+ public:
+  static constexpr float getGroupDelay()
+  {
+    // octave k runs at 2^(k + 1) times the original rate, and adds one filter
+    // delay upsampling and one downsampling.
+    float delay{0};
+    for (int k = 0; k < kOctaves; ++k)
+    {
+      delay += 2.f * HalfBandFilter::getGroupDelay() / (2 << k);
+    }
+    return delay;
+  }
+
+  // operator() takes two arguments: a process function and an input
+  // DSPVectorArray.
+  template <typename ProcessFn>
+  inline DSPVectorArray<OUT_ROWS> operator()(ProcessFn&& fn, const DSPVectorArray<IN_ROWS>& vx)
+  {
+    // upsample one octave at a time, in place, ending at the end of the buffer.
+    mInputs[FACTOR - 1] = vx;
+    for (int k = 0; k < kOctaves; ++k)
+    {
+      const int sources = 1 << k;
+      const int srcStart = FACTOR - sources;
+      const int destStart = FACTOR - sources * 2;
+      for (int i = 0; i < sources; ++i)
+      {
+        const DSPVectorArray<IN_ROWS> src = mInputs[srcStart + i];
+        mUppers[k].upsample(src, mInputs[destStart + i * 2], mInputs[destStart + i * 2 + 1]);
+      }
+    }
+
+    for (int i = 0; i < FACTOR; ++i)
+    {
+      mOutputs[i] = fn(static_cast<const DSPVectorArray<IN_ROWS>&>(mInputs[i]));
+    }
+
+    // downsample one octave at a time, in place, ending at the start of the buffer.
+    for (int k = kOctaves - 1; k >= 0; --k)
+    {
+      for (int i = 0; i < (1 << k); ++i)
+      {
+        mOutputs[i] = mDowners[k].downsample(mOutputs[i * 2], mOutputs[i * 2 + 1]);
+      }
+    }
+    return mOutputs[0];
+  }
+
+  void clear()
+  {
+    for (auto& f : mUppers) f.clear();
+    for (auto& f : mDowners) f.clear();
+  }
+
+ private:
+  std::array<HalfBandBank<IN_ROWS>, kOctaves> mUppers;
+  std::array<HalfBandBank<OUT_ROWS>, kOctaves> mDowners;
+  std::array<DSPVectorArray<IN_ROWS>, FACTOR> mInputs;
+  std::array<DSPVectorArray<OUT_ROWS>, FACTOR> mOutputs;
+};
+
+// OverlapAddFunction is a function object that given a process function f,
+// applies f to overlapping windowed frames of the input x and overlap-adds the
+// results. Each frame is LENGTH samples long, and a new frame starts every
+// LENGTH / DIVISIONS samples (the hop size). f takes a DSPVectorArrayN<IN_ROWS,
+// LENGTH> frame that has been multiplied by the analysis window, and returns a
+// DSPVectorArrayN<OUT_ROWS, LENGTH> frame that is multiplied by the synthesis
+// window before it is added to the output. The synthesis window is the analysis
+// window scaled so that the products of the two windows overlap-add to 1. So if f
+// returns its input, the output is the input delayed by getLatency() samples.
+//
+// The hop size must be a multiple of kFloatsPerDSPVector or divide it. All the
+// buffers are members, so operator() does not allocate. f is a template parameter
+// instead of a std::function so that a lambda with captures doesn't allocate either.
+
+template <int LENGTH, int DIVISIONS, int IN_ROWS, int OUT_ROWS>
 class OverlapAddFunction
 {
-        typedef std::function<DSPVectorArray<OUT_ROWS>(const
-DSPVectorArray<IN_ROWS>)> ProcessFn;
-
-public:
-        inline DSPVectorArray<OUT_ROWS> operator()(ProcessFn fn, const
-DSPVectorArray<IN_ROWS> vx)
-        {
-        }
-
-private:
-        //Matrix mHistory;
-        const DSPVector& mWindow;
+  static constexpr int kHop = LENGTH / DIVISIONS;
+  static constexpr int kVectorSize = kFloatsPerDSPVector;
+
+  // samples of input and output handled per step: one hop, or one DSPVector if
+  // the hop is longer.
+  static constexpr int kStep = std::min(kHop, kVectorSize);
+
+  static_assert((DIVISIONS > 0) && (kHop * DIVISIONS == LENGTH),
+                "OverlapAddFunction: DIVISIONS must divide LENGTH.");
+  static_assert((kHop % kVectorSize == 0) || (kVectorSize % kHop == 0),
+                "OverlapAddFunction: the hop size must be a multiple or divisor of the "
+                "DSPVector size.");
+
+ public:
+  using inputFrameType = DSPVectorArrayN<IN_ROWS, LENGTH>;
+  using outputFrameType = DSPVectorArrayN<OUT_ROWS, LENGTH>;
+
+  // make the windows from a shape in dspwindows or any Projection on [0, 1].
+  OverlapAddFunction(Projection windowShape = dspwindows::raisedCosine)
+  {
+    float* pw = mAnalysisWindow.getBuffer();
+    makeWindow(pw, LENGTH, windowShape);
+
+    // the synthesis window at each sample is divided by the sum of the squared
+    // analysis window over all the frames that overlap there.
+    std::array<float, kHop> overlapSum{};
+    for (int i = 0; i < LENGTH; ++i)
+    {
+      overlapSum[i % kHop] += pw[i] * pw[i];
+    }
+    for (int i = 0; i < LENGTH; ++i)
+    {
+      float sum = overlapSum[i % kHop];
+      mSynthesisWindow[i] = (sum > kOverlapSumMin) ? pw[i] / sum : 0.f;
+    }
+  }
+
+  // the delay in samples from the input to the output if f returns its input.
+  static constexpr int getLatency() { return LENGTH - kStep; }
+
+  void clear()
+  {
+    mHistory = inputFrameType();
+    mAccumulator = outputFrameType();
+    mHopPosition = 0;
+    mOutputPosition = 0;
+  }
+
+  // operator() takes two arguments: a process function and an input
+  // DSPVectorArray.
+  template <typename ProcessFn>
+  inline DSPVectorArray<OUT_ROWS> operator()(ProcessFn&& fn, const DSPVectorArray<IN_ROWS>& vx)
+  {
+    DSPVectorArray<OUT_ROWS> vy{kUninitialized};
+    for (int start = 0; start < kVectorSize; start += kStep)
+    {
+      // append the input to the end of the history
+      for (int j = 0; j < IN_ROWS; ++j)
+      {
+        std::copy_n(vx.constRow(j).getConstBuffer() + start, kStep,
+                    mHistory.row(j).getBuffer() + LENGTH - kHop + mHopPosition);
+      }
+
+      mHopPosition += kStep;
+      if (mHopPosition == kHop)
+      {
+        processFrame(fn);
+        mHopPosition = 0;
+        mOutputPosition = 0;
+      }
+
+      // the first hop of the accumulator is complete: no later frames overlap it.
+      for (int j = 0; j < OUT_ROWS; ++j)
+      {
+        std::copy_n(mAccumulator.constRow(j).getConstBuffer() + mOutputPosition, kStep,
+                    vy.row(j).getBuffer() + start);
+      }
+      mOutputPosition += kStep;
+    }
+    return vy;
+  }
+
+ private:
+  static constexpr float kOverlapSumMin{1e-6f};
+
+  template <typename ProcessFn>
+  inline void processFrame(ProcessFn& fn)
+  {
+    for (int j = 0; j < IN_ROWS; ++j)
+    {
+      mFrame.row(j) = mHistory.constRow(j) * mAnalysisWindow;
+
+      // shift the history by one hop
+      float* ph = mHistory.row(j).getBuffer();
+      std::copy(ph + kHop, ph + LENGTH, ph);
+    }
+
+    const outputFrameType y = fn(static_cast<const inputFrameType&>(mFrame));
+
+    for (int j = 0; j < OUT_ROWS; ++j)
+    {
+      // discard the hop that has been output, then add the new frame
+      float* pa = mAccumulator.row(j).getBuffer();
+      std::copy(pa + kHop, pa + LENGTH, pa);
+      std::fill(pa + LENGTH - kHop, pa + LENGTH, 0.f);
+      mAccumulator.row(j) =
+          multiplyAdd(y.constRow(j), mSynthesisWindow, mAccumulator.constRow(j));
+    }
+  }
+
+  DSPVectorN<LENGTH> mAnalysisWindow;
+  DSPVectorN<LENGTH> mSynthesisWindow;
+  inputFrameType mHistory;
+  inputFrameType mFrame;
+  outputFrameType mAccumulator;
+  int mHopPosition{0};
+  int mOutputPosition{0};
 };
-*/
 
 // FeedbackDelayFunction
 // Wraps a function in a pitchbendable delay with feedback per row.
@@ -261,7 +453,7 @@ class FeedbackDelayFunction
   inline DSPVectorArray<ROWS> operator()(const DSPVectorArray<ROWS> vx, ProcessFn fn,
                                          const DSPVector vDelayTime)
   {
-    DSPVectorArray<ROWS> vFnOutput;
+    DSPVectorArray<ROWS> vFnOutput{kUninitialized};
     vFnOutput = fn(vx + vy1 * DSPVectorArray<ROWS>(feedbackGain));
 
     for (int j = 0; j < ROWS; ++j)
@@ -297,7 +489,7 @@ class FeedbackDelayFunctionWithTap
   inline DSPVectorArray<ROWS> operator()(const DSPVectorArray<ROWS> vx, ProcessFn fn,
                                          const DSPVector vDelayTime)
   {
-    DSPVectorArray<ROWS> vFeedback;
+    DSPVectorArray<ROWS> vFeedback{kUninitialized};
     DSPVectorArray<ROWS> vOutputTap;
     vFeedback = fn(vx + vy1 * DSPVectorArray<ROWS>(feedbackGain), vOutputTap);
 
@@ -317,6 +509,8 @@ class FeedbackDelayFunctionWithTap
 // that outputs a single DSPVector and has only DSPVectors as arguments.
 // Each input is a DSPVectorArray with arguments for processor i on row i.
 // The output is a DSPVectorArray with output from processor i on row i.
+// For banks of one pole, SVF or biquad filters, OnePoleBank, SVFBank and BiquadBank in
+// MLDSPFilters.h are faster because they filter several rows with each SIMD operation.
 
 template <typename T, int ROWS>
 class Bank
@@ -328,7 +522,7 @@ class Bank
   template <typename... Args>
   inline DSPVectorArray<ROWS> operator()(Args... args)
   {
-    DSPVectorArray<ROWS> output;
+    DSPVectorArray<ROWS> output{kUninitialized};
     for (int i = 0; i < ROWS; ++i)
     {
       output.row(i) = _processors[i](args.constRow(i)...);
@@ -340,7 +534,7 @@ class Bank
   template <typename... Args>
   inline DSPVectorArray<ROWS> processArrays(Args... args)
   {
-    DSPVectorArray<ROWS> output;
+    DSPVectorArray<ROWS> output{kUninitialized};
     for (int i = 0; i < ROWS; ++i)
     {
       output.row(i) = _processors[i](args[i]...);
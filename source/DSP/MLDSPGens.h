@@ -11,6 +11,10 @@
 // compiler should have many opportunities to optimize these graphs. For dynamic
 // graphs changeable at runtime, see MLProcs. In general MLProcs will be written
 // using DSPGens, DSPOps, DSPFilters.
+//
+// The simpler generators also run on DSPVectorN rows of other lengths. Each of
+// these keeps a DSPVector overload, so that floats and other values convertible
+// to a DSPVector can still be passed in.
 
 #pragma once
 
@@ -26,14 +30,15 @@ class TickGen
   float mOmega{0};
 
  public:
-  inline DSPVector operator()(const DSPVector cyclesPerSample)
+  template <size_t LEN>
+  inline DSPVectorN<LEN> operator()(const DSPVectorN<LEN> cyclesPerSample)
   {
     // calculate counter delta per sample
-    DSPVector stepsPerSampleV = cyclesPerSample;
+    DSPVectorN<LEN> stepsPerSampleV = cyclesPerSample;
 
     // accumulate phase and wrap to generate ticks
-    DSPVector vy{0.f};
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    DSPVectorN<LEN> vy{0.f};
+    for (size_t n = 0; n < LEN; ++n)
     {
       mOmega += stepsPerSampleV[n];
       if (mOmega > 1.0f)
@@ -44,6 +49,10 @@ class TickGen
     }
     return vy;
   }
+  DSPVector operator()(const DSPVector cyclesPerSample)
+  {
+    return operator()<kFloatsPerDSPVector>(cyclesPerSample);
+  }
 };
 
 // generate an antialiased impulse, repeating at a frequency given by the input.
@@ -129,10 +138,11 @@ class NoiseGen
   }
 
   // TODO SIMD
-  inline DSPVector operator()()
+  template <size_t LEN = kFloatsPerDSPVector>
+  inline DSPVectorN<LEN> operator()()
   {
-    DSPVector y;
-    for (int i = 0; i < kFloatsPerDSPVector; ++i)
+    DSPVectorN<LEN> y{kUninitialized};
+    for (size_t i = 0; i < LEN; ++i)
     {
       step();
       uint32_t temp = ((mSeed >> 9) & 0x007FFFFF) | 0x3F800000;
@@ -147,6 +157,185 @@ class NoiseGen
   uint32_t mSeed = 0;
 };
 
+// NoiseBank generates ROWS independent streams of noise, one on each row of a
+// DSPVectorArray. Each row steps the same generator as NoiseGen, and the rows are
+// stepped four at a time in SIMD lanes, then transposed into place, so a row with
+// seed x makes the same white noise as a NoiseGen with seed x. The seeds of the
+// rows are made from a single seed with setSeeds(), or set one at a time with
+// setSeed(), so that any row is reproducible.
+//
+// white() makes uniform noise from -1 to 1. pink() filters the white noise with
+// Paul Kellet's "refined" pink noise filter, which is within 0.05 dB of -3 dB per
+// octave above 1/4800 of the sample rate, scaled to a similar peak level.
+// gaussian() makes noise with a mean of 0 and a standard deviation of 1 using the
+// Box-Muller transform, from two white samples for each output.
+
+template <size_t ROWS>
+class NoiseBank
+{
+  static constexpr size_t kGroups = (ROWS + kFloatsPerSIMDVector - 1) / kFloatsPerSIMDVector;
+  static constexpr size_t kPinkPoles{7};
+  static constexpr float kPinkScale{0.11f};
+
+ public:
+  NoiseBank() { setSeeds(0); }
+
+  // set the seed of each row from the single seed x.
+  void setSeeds(uint32_t x)
+  {
+    for (size_t j = 0; j < ROWS; ++j)
+    {
+      // a different, well mixed seed for each row.
+      uint32_t h = x + static_cast<uint32_t>(j) * 0x9E3779B9;
+      h = (h ^ (h >> 16)) * 0x85EBCA6B;
+      h = (h ^ (h >> 13)) * 0xC2B2AE35;
+      mInitialSeeds[j] = h ^ (h >> 16);
+    }
+    reset();
+  }
+
+  // set the seed of one row.
+  void setSeed(size_t row, uint32_t x)
+  {
+    mInitialSeeds[row] = x;
+    mSeeds[row] = x;
+  }
+
+  // restart all the rows from their seeds, and clear the pink noise filters.
+  void reset()
+  {
+    for (size_t j = 0; j < ROWS; ++j)
+    {
+      mSeeds[j] = mInitialSeeds[j];
+    }
+    for (auto& p : mPink)
+    {
+      p.fill(0.f);
+    }
+  }
+
+  template <size_t LEN = kFloatsPerDSPVector>
+  inline DSPVectorArrayN<ROWS, LEN> white()
+  {
+    return generate<LEN>([](size_t, SIMDVectorFloat*) {});
+  }
+
+  template <size_t LEN = kFloatsPerDSPVector>
+  inline DSPVectorArrayN<ROWS, LEN> pink()
+  {
+    return generate<LEN>([&](size_t g, SIMDVectorFloat* v) {
+      const size_t offset = g * kFloatsPerSIMDVector;
+      SIMDVectorFloat b0 = vecLoad(mPink[0].data() + offset);
+      SIMDVectorFloat b1 = vecLoad(mPink[1].data() + offset);
+      SIMDVectorFloat b2 = vecLoad(mPink[2].data() + offset);
+      SIMDVectorFloat b3 = vecLoad(mPink[3].data() + offset);
+      SIMDVectorFloat b4 = vecLoad(mPink[4].data() + offset);
+      SIMDVectorFloat b5 = vecLoad(mPink[5].data() + offset);
+      SIMDVectorFloat b6 = vecLoad(mPink[6].data() + offset);
+      for (size_t t = 0; t < kFloatsPerSIMDVector; ++t)
+      {
+        const SIMDVectorFloat w = v[t];
+        b0 = vecAdd(vecMul(b0, vecSet1(0.99886f)), vecMul(w, vecSet1(0.0555179f)));
+        b1 = vecAdd(vecMul(b1, vecSet1(0.99332f)), vecMul(w, vecSet1(0.0750759f)));
+        b2 = vecAdd(vecMul(b2, vecSet1(0.96900f)), vecMul(w, vecSet1(0.1538520f)));
+        b3 = vecAdd(vecMul(b3, vecSet1(0.86650f)), vecMul(w, vecSet1(0.3104856f)));
+        b4 = vecAdd(vecMul(b4, vecSet1(0.55000f)), vecMul(w, vecSet1(0.5329522f)));
+        b5 = vecSub(vecMul(b5, vecSet1(-0.7616f)), vecMul(w, vecSet1(0.0168980f)));
+        SIMDVectorFloat sum = vecAdd(vecAdd(vecAdd(b0, b1), vecAdd(b2, b3)),
+                                     vecAdd(vecAdd(b4, b5), b6));
+        sum = vecAdd(sum, vecMul(w, vecSet1(0.5362f)));
+        b6 = vecMul(w, vecSet1(0.115926f));
+        v[t] = vecMul(sum, vecSet1(kPinkScale));
+      }
+      vecStore(mPink[0].data() + offset, b0);
+      vecStore(mPink[1].data() + offset, b1);
+      vecStore(mPink[2].data() + offset, b2);
+      vecStore(mPink[3].data() + offset, b3);
+      vecStore(mPink[4].data() + offset, b4);
+      vecStore(mPink[5].data() + offset, b5);
+      vecStore(mPink[6].data() + offset, b6);
+    });
+  }
+
+  template <size_t LEN = kFloatsPerDSPVector>
+  inline DSPVectorArrayN<ROWS, LEN> gaussian()
+  {
+    // map white noise to (0, 1] for the log, and to [-pi, pi) for the angle.
+    const DSPVectorArrayN<ROWS, LEN> u1 = white<LEN>() * -0.5f + 0.5f;
+    const DSPVectorArrayN<ROWS, LEN> angle = white<LEN>() * kPi;
+    return sqrt(log(u1) * -2.f) * cos(angle);
+  }
+
+  template <size_t LEN = kFloatsPerDSPVector>
+  inline DSPVectorArrayN<ROWS, LEN> operator()()
+  {
+    return white<LEN>();
+  }
+
+ private:
+  // step the generators for LEN samples, four rows at a time. For each group of
+  // rows g and each four samples, v[t] holds the white noise at time t for each
+  // row in the group. The kernel processes v[0] to v[3] in place, in time order,
+  // and the results are transposed into the rows of the output. All the groups
+  // are stepped for each four samples, so that their chains of multiplies
+  // overlap.
+  template <size_t LEN, typename KERNEL>
+  inline DSPVectorArrayN<ROWS, LEN> generate(KERNEL&& kernel)
+  {
+    DSPVectorArrayN<ROWS, LEN> y{kUninitialized};
+    DSPVectorN<LEN> discard{kUninitialized};
+    const SIMDVectorInt a = vecSet1Int(0x0019660D);
+    const SIMDVectorInt c = vecSet1Int(0x3C6EF35F);
+    const SIMDVectorInt exponent = vecSet1Int(0x3F800000);
+    float* pSeeds = reinterpret_cast<float*>(mSeeds.data());
+
+    float* py[kGroups][kFloatsPerSIMDVector];
+    SIMDVectorInt seeds[kGroups];
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+      {
+        size_t row = g * kFloatsPerSIMDVector + i;
+        py[g][i] = (row < ROWS) ? y.row(row).getBuffer() : discard.getBuffer();
+      }
+      seeds[g] = VecF2I(vecLoad(pSeeds + g * kFloatsPerSIMDVector));
+    }
+
+    for (size_t n = 0; n < LEN; n += kFloatsPerSIMDVector)
+    {
+      for (size_t g = 0; g < kGroups; ++g)
+      {
+        // as in NoiseGen::getSample(), make a float from 1 to 2 from the top 23
+        // bits of the seed, then map it to [-1, 1).
+        SIMDVectorFloat v[kFloatsPerSIMDVector];
+        for (size_t t = 0; t < kFloatsPerSIMDVector; ++t)
+        {
+          seeds[g] = vecAddInt(vecMulInt32(seeds[g], a), c);
+          SIMDVectorFloat f = VecI2F(vecOrInt(vecShiftRightInt32(seeds[g], 9), exponent));
+          v[t] = vecSub(vecMul(f, vecSet1(2.f)), vecSet1(3.f));
+        }
+        kernel(g, v);
+        vecTranspose4(v[0], v[1], v[2], v[3]);
+        for (size_t i = 0; i < kFloatsPerSIMDVector; ++i)
+        {
+          vecStore(py[g][i] + n, v[i]);
+        }
+      }
+    }
+
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      vecStore(pSeeds + g * kFloatsPerSIMDVector, VecI2F(seeds[g]));
+    }
+    return y;
+  }
+
+  std::array<uint32_t, ROWS> mInitialSeeds{};
+  alignas(kBytesPerSIMDVector) std::array<uint32_t, kGroups * kFloatsPerSIMDVector> mSeeds{};
+  using Lanes = std::array<float, kGroups * kFloatsPerSIMDVector>;
+  alignas(kBytesPerSIMDVector) std::array<Lanes, kPinkPoles> mPink{};
+};
+
 // super slow + accurate sine generator for testing
 class TestSineGen
 {
@@ -155,11 +344,12 @@ class TestSineGen
  public:
   void clear() { mOmega = 0; }
 
-  DSPVector operator()(const DSPVector freq)
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> freq)
   {
-    DSPVector vy;
+    DSPVectorN<LEN> vy{kUninitialized};
 
-    for (int i = 0; i < kFloatsPerDSPVector; ++i)
+    for (size_t i = 0; i < LEN; ++i)
     {
       float step = ml::kTwoPi * freq[i];
       mOmega += step;
@@ -168,6 +358,10 @@ class TestSineGen
     }
     return vy;
   }
+  DSPVector operator()(const DSPVector freq)
+  {
+    return operator()<kFloatsPerDSPVector>(freq);
+  }
 };
 
 // PhasorGen is a naive (not antialiased) sawtooth generator.
@@ -184,22 +378,31 @@ class PhasorGen
   static constexpr float stepsPerCycle{static_cast<float>(const_math::pow(2., 32))};
   static constexpr float cyclesPerStep{1.f / stepsPerCycle};
 
-  DSPVector operator()(const DSPVector cyclesPerSample)
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> cyclesPerSample)
   {
-    // calculate int steps per sample
-    DSPVector stepsPerSampleV = cyclesPerSample * DSPVector(stepsPerCycle);
-    DSPVectorInt intStepsPerSampleV = roundFloatToInt(stepsPerSampleV);
-
-    // accumulate 32-bit phase with wrap
-    DSPVectorInt omega32V;
-    for (int n = 0; n < kIntsPerDSPVector; ++n)
+    DSPVectorN<LEN> y{kUninitialized};
+    const float* px = cyclesPerSample.getConstBuffer();
+    float* py = y.getBuffer();
+    SIMDVectorInt omega32 = vecSet1Int(mOmega32);
+    for (size_t n = 0; n < LEN; n += kFloatsPerSIMDVector)
     {
-      mOmega32 += intStepsPerSampleV[n];
-      omega32V[n] = mOmega32;
-    }
+      // calculate int steps per sample
+      SIMDVectorInt steps = vecFloatToIntRound(vecMul(vecLoad(px + n), vecSet1(stepsPerCycle)));
 
-    // convert counter to float output range
-    return unsignedIntToFloat(omega32V) * DSPVector(cyclesPerStep);
+      // accumulate 32-bit phase with wrap: a prefix sum over the four samples,
+      // added to the last phase of the four before.
+      omega32 = vecAddInt(vecPrefixSumInt(steps), vecBroadcastLastInt(omega32));
+
+      // convert counter to float output range
+      vecStore(py + n, vecMul(vecUnsignedIntToFloat(omega32), vecSet1(cyclesPerStep)));
+    }
+    mOmega32 = vecGetLastInt(omega32);
+    return y;
+  }
+  DSPVector operator()(const DSPVector cyclesPerSample)
+  {
+    return operator()<kFloatsPerDSPVector>(cyclesPerSample);
   }
 
   float nextSample(const float cyclesPerSample)
@@ -216,6 +419,53 @@ class PhasorGen
   }
 };
 
+// PhasorGenBank runs ROWS PhasorGens, one on each row of a DSPVectorArray. The
+// phase of each row is accumulated with the same prefix sums as PhasorGen, and
+// all the rows are stepped for each four samples, so that their chains of adds
+// overlap. The output of each row is exactly that of a PhasorGen with the same
+// input.
+template <size_t ROWS>
+class PhasorGenBank
+{
+ public:
+  void clear() { mOmega32.fill(0); }
+  void clear(size_t row, uint32_t omega = 0) { mOmega32[row] = omega; }
+
+  template <size_t LEN>
+  DSPVectorArrayN<ROWS, LEN> operator()(const DSPVectorArrayN<ROWS, LEN>& cyclesPerSample)
+  {
+    DSPVectorArrayN<ROWS, LEN> y{kUninitialized};
+    const SIMDVectorFloat vStepsPerCycle = vecSet1(PhasorGen::stepsPerCycle);
+    const SIMDVectorFloat vCyclesPerStep = vecSet1(PhasorGen::cyclesPerStep);
+    const float* px = cyclesPerSample.getConstBuffer();
+    float* py = y.getBuffer();
+
+    SIMDVectorInt omega32[ROWS];
+    for (size_t j = 0; j < ROWS; ++j)
+    {
+      omega32[j] = vecSet1Int(mOmega32[j]);
+    }
+    for (size_t n = 0; n < LEN; n += kFloatsPerSIMDVector)
+    {
+      for (size_t j = 0; j < ROWS; ++j)
+      {
+        const size_t i = j * LEN + n;
+        SIMDVectorInt steps = vecFloatToIntRound(vecMul(vecLoad(px + i), vStepsPerCycle));
+        omega32[j] = vecAddInt(vecPrefixSumInt(steps), vecBroadcastLastInt(omega32[j]));
+        vecStore(py + i, vecMul(vecUnsignedIntToFloat(omega32[j]), vCyclesPerStep));
+      }
+    }
+    for (size_t j = 0; j < ROWS; ++j)
+    {
+      mOmega32[j] = vecGetLastInt(omega32[j]);
+    }
+    return y;
+  }
+
+ private:
+  std::array<uint32_t, ROWS> mOmega32{};
+};
+
 // OneShotGen, when triggered, makes a single ramp from 0-1 then resets to 0. The speed
 // of the ramp is a signal input, giving a ramp with the same speed as PhasorGen.
 class OneShotGen
@@ -235,27 +485,46 @@ class OneShotGen
   static constexpr float stepsPerCycle{static_cast<float>(const_math::pow(2., 32))};
   static constexpr float cyclesPerStep{1.f / stepsPerCycle};
 
-  DSPVector operator()(const DSPVector cyclesPerSample)
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> cyclesPerSample)
   {
-    // calculate int steps per sample
-    DSPVector stepsPerSampleV = cyclesPerSample * DSPVector(stepsPerCycle);
-    DSPVectorInt intStepsPerSampleV = roundFloatToInt(stepsPerSampleV);
-
-    // accumulate 32-bit phase with wrap
-    // we test for wrap at every sample to get a clean ending
-    DSPVectorInt omega32V;
-    for (int n = 0; n < kIntsPerDSPVector; ++n)
+    // when not triggered, the phase stays at the start.
+    DSPVectorN<LEN> y;
+    if (!mGate) return y;
+
+    const float* px = cyclesPerSample.getConstBuffer();
+    float* py = y.getBuffer();
+    SIMDVectorInt omega32 = vecSet1Int(mOmega32);
+    for (size_t n = 0; n < LEN; n += kFloatsPerSIMDVector)
     {
-      mOmega32 += intStepsPerSampleV[n] * mGate;
-      if (mOmega32 < mOmegaPrev)
+      // calculate int steps per sample
+      SIMDVectorInt steps = vecFloatToIntRound(vecMul(vecLoad(px + n), vecSet1(stepsPerCycle)));
+
+      // accumulate 32-bit phase with wrap, as in PhasorGen.
+      SIMDVectorInt prev = omega32;
+      omega32 = vecAddInt(vecPrefixSumInt(steps), vecBroadcastLastInt(prev));
+
+      // we test for wrap at every sample to get a clean ending: the phase is
+      // at the start from the first sample that is less than the one before.
+      SIMDVectorInt wrapped =
+          vecPrefixOrInt(vecLessThanUnsignedInt(omega32, vecShiftInLastInt(omega32, prev)));
+      omega32 = vecAndNotInt(wrapped, omega32);
+
+      // convert counter to float output range
+      vecStore(py + n, vecMul(vecUnsignedIntToFloat(omega32), vecSet1(cyclesPerStep)));
+      if (vecAnyTrue(VecI2F(wrapped)))
       {
         mGate = 0;
-        mOmega32 = start;
+        mOmega32 = mOmegaPrev = start;
+        return y;
       }
-      omega32V[n] = mOmegaPrev = mOmega32;
     }
-    // convert counter to float output range
-    return unsignedIntToFloat(omega32V) * DSPVector(cyclesPerStep);
+    mOmega32 = mOmegaPrev = vecGetLastInt(omega32);
+    return y;
+  }
+  DSPVector operator()(const DSPVector cyclesPerSample)
+  {
+    return operator()<kFloatsPerDSPVector>(cyclesPerSample);
   }
 
   float nextSample(const float cyclesPerSample)
@@ -266,8 +535,6 @@ class OneShotGen
 
     // accumulate 32-bit phase with wrap
     // we test for wrap at every sample to get a clean ending
-    DSPVectorInt omega32V;
-
     mOmega32 += intStepsPerSample * mGate;
     if (mOmega32 < mOmegaPrev)
     {
@@ -282,11 +549,12 @@ class OneShotGen
 };
 
 // bandlimited step function for reducing aliasing.
-static DSPVector polyBLEP(const DSPVector phase, const DSPVector freq)
+template <size_t LEN>
+static DSPVectorN<LEN> polyBLEP(const DSPVectorN<LEN> phase, const DSPVectorN<LEN> freq)
 {
-  DSPVector blep;
+  DSPVectorN<LEN> blep{kUninitialized};
 
-  for (int n = 0; n < kFloatsPerDSPVector; ++n)
+  for (size_t n = 0; n < LEN; ++n)
   {
     // could possibly differentiate to get dt instead of passing it in.
     // but that would require state.
@@ -313,25 +581,27 @@ static DSPVector polyBLEP(const DSPVector phase, const DSPVector freq)
 // input: phasor on (0, 1)
 // output: sine aproximation using Taylor series on range(-1, 1). There is distortion in odd
 // harmonics only, with the 3rd harmonic at about -40dB.
-inline DSPVector phasorToSine(DSPVector phasorV)
+template <size_t LEN>
+inline DSPVectorN<LEN> phasorToSine(DSPVectorN<LEN> phasorV)
 {
   constexpr float sqrt2(static_cast<float>(const_math::sqrt(2.0f)));
   constexpr float domain(sqrt2 * 4.f);
-  DSPVector domainScaleV(domain);
-  DSPVector domainOffsetV(-sqrt2);
+  DSPVectorN<LEN> domainScaleV(domain);
+  DSPVectorN<LEN> domainOffsetV(-sqrt2);
   constexpr float range(sqrt2 - sqrt2 * sqrt2 * sqrt2 / 6.f);
-  DSPVector scaleV(1.0f / range);
-  DSPVector flipOffsetV(sqrt2 * 2.f);
-  DSPVector zeroV(0.f);
-  DSPVector oneV(1.f);
-  DSPVector oneSixthV(1.0f / 6.f);
+  DSPVectorN<LEN> scaleV(1.0f / range);
+  DSPVectorN<LEN> flipOffsetV(sqrt2 * 2.f);
+  DSPVectorN<LEN> zeroV(0.f);
+  DSPVectorN<LEN> oneV(1.f);
+  DSPVectorN<LEN> oneSixthV(1.0f / 6.f);
 
   // scale and offset input phasor on (0, 1) to sine approx domain (-sqrt(2), 3*sqrt(2))
-  DSPVector omegaV = phasorV * (domainScaleV) + (domainOffsetV);
+  DSPVectorN<LEN> omegaV = phasorV * (domainScaleV) + (domainOffsetV);
 
   // reverse upper half of phasor to get triangle
   // equivalent to: if (phasor > 0) x = flipOffset - fOmega; else x = fOmega;
-  DSPVector triangleV = select(flipOffsetV - omegaV, omegaV, greaterThan(omegaV, DSPVector(sqrt2)));
+  DSPVectorN<LEN> triangleV =
+      select(flipOffsetV - omegaV, omegaV, greaterThan(omegaV, DSPVectorN<LEN>(sqrt2)));
 
   // convert triangle to sine approx.
   return scaleV * triangleV * (oneV - triangleV * triangleV * oneSixthV);
@@ -339,19 +609,21 @@ inline DSPVector phasorToSine(DSPVector phasorV)
 
 // input: phasor on (0, 1), normalized freq, pulse width
 // output: antialiased pulse
-inline DSPVector phasorToPulse(DSPVector omegaV, DSPVector freqV, DSPVector pulseWidthV)
+template <size_t LEN>
+inline DSPVectorN<LEN> phasorToPulse(DSPVectorN<LEN> omegaV, DSPVectorN<LEN> freqV,
+                                     DSPVectorN<LEN> pulseWidthV)
 {
   // get pulse selector mask
-  DSPVectorInt maskV = greaterThanOrEqual(omegaV, pulseWidthV);
+  DSPVectorIntN<LEN> maskV = greaterThanOrEqual(omegaV, pulseWidthV);
 
   // select -1 or 1 (could be a multiply instead?)
-  DSPVector pulseV = select(DSPVector(-1.f), DSPVector(1.f), maskV);
+  DSPVectorN<LEN> pulseV = select(DSPVectorN<LEN>(-1.f), DSPVectorN<LEN>(1.f), maskV);
 
   // add blep for up-going transition
   pulseV += polyBLEP(omegaV, freqV);
 
   // subtract blep for down-going transition
-  DSPVector omegaVDown = fractionalPart(omegaV - pulseWidthV + DSPVector(1.0f));
+  DSPVectorN<LEN> omegaVDown = fractionalPart(omegaV - pulseWidthV + DSPVectorN<LEN>(1.0f));
   pulseV -= polyBLEP(omegaVDown, freqV);
 
   return pulseV;
@@ -359,10 +631,11 @@ inline DSPVector phasorToPulse(DSPVector omegaV, DSPVector freqV, DSPVector puls
 
 // input: phasor on (0, 1), normalized freq
 // output: antialiased saw on (-1, 1)
-inline DSPVector phasorToSaw(DSPVector omegaV, DSPVector freqV)
+template <size_t LEN>
+inline DSPVectorN<LEN> phasorToSaw(DSPVectorN<LEN> omegaV, DSPVectorN<LEN> freqV)
 {
   // scale phasor to saw range (-1, 1)
-  DSPVector sawV = omegaV * DSPVector(2.f) - DSPVector(1.f);
+  DSPVectorN<LEN> sawV = omegaV * DSPVectorN<LEN>(2.f) - DSPVectorN<LEN>(1.f);
 
   // subtract BLEP from saw to smooth down-going transition
   return sawV - polyBLEP(omegaV, freqV);
@@ -377,7 +650,12 @@ class SineGen
 
  public:
   void clear() { _phasor.clear(kZeroPhase); }
-  DSPVector operator()(const DSPVector freq) { return phasorToSine(_phasor(freq)); }
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> freq) { return phasorToSine(_phasor(freq)); }
+  DSPVector operator()(const DSPVector freq)
+  {
+    return operator()<kFloatsPerDSPVector>(freq);
+  }
 };
 
 class PulseGen
@@ -386,10 +664,15 @@ class PulseGen
 
  public:
   void clear() { _phasor.clear(0); }
-  DSPVector operator()(const DSPVector freq, const DSPVector width)
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> freq, const DSPVectorN<LEN> width)
   {
     return phasorToPulse(_phasor(freq), freq, width);
   }
+  DSPVector operator()(const DSPVector freq, const DSPVector width)
+  {
+    return operator()<kFloatsPerDSPVector>(freq, width);
+  }
 };
 
 class SawGen
@@ -398,7 +681,15 @@ class SawGen
 
  public:
   void clear() { _phasor.clear(0); }
-  DSPVector operator()(const DSPVector freq) { return phasorToSaw(_phasor(freq), freq); }
+  template <size_t LEN>
+  DSPVectorN<LEN> operator()(const DSPVectorN<LEN> freq)
+  {
+    return phasorToSaw(_phasor(freq), freq);
+  }
+  DSPVector operator()(const DSPVector freq)
+  {
+    return operator()<kFloatsPerDSPVector>(freq);
+  }
 };
 
 // ----------------------------------------------------------------
@@ -406,9 +697,6 @@ class SawGen
 
 // linear interpolate over signal length to next value.
 
-constexpr float unityRampFn(int i) { return (i + 1) / static_cast<float>(kFloatsPerDSPVector); }
-ConstDSPVector kUnityRampVec{unityRampFn};
-
 struct Interpolator1
 {
   float currentValue{0};
@@ -589,4 +877,180 @@ class SampleAccurateLinearGlide
   }
 };
 
+// ----------------------------------------------------------------
+// ParameterSmootherBank
+
+// ParameterSmootherBank smooths N parameters with the same glides as LinearGlide.
+// The targets, steps and counters of the glides are kept in structure-of-arrays
+// form and advanced four at a time, and only the groups of four with a glide in
+// progress are visited, so idle parameters cost nothing.
+//
+// The outputs are written to the rows of a DSPVectorArray<N>, or of a
+// DSPVectorDynamic with at least N rows. Only the rows of parameters that are
+// gliding or have just been set are written, so the same destination should be
+// passed to every call of process(). Every row is written by the first call and
+// after clear().
+
+template <size_t N>
+class ParameterSmootherBank
+{
+  static constexpr size_t kGroups = (N + kFloatsPerSIMDVector - 1) / kFloatsPerSIMDVector;
+  using Lanes = std::array<float, kGroups * kFloatsPerSIMDVector>;
+
+ public:
+  ParameterSmootherBank()
+  {
+    mVectorsPerGlide.fill(32);
+    clear();
+  }
+
+  // set the glide time of every parameter.
+  void setGlideTimeInSamples(float t)
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      setGlideTimeInSamples(i, t);
+    }
+  }
+
+  void setGlideTimeInSamples(size_t i, float t)
+  {
+    mVectorsPerGlide[i] = std::max(static_cast<int>(t / kFloatsPerDSPVector), 1);
+  }
+
+  // set the target of parameter i. If the target changes, a glide starts from
+  // the current value.
+  void setTarget(size_t i, float f)
+  {
+    if (f != mTarget[i])
+    {
+      mTarget[i] = f;
+      mStep[i] = (f - mValue[i]) / mVectorsPerGlide[i];
+      mVectorsRemaining[i] = static_cast<float>(mVectorsPerGlide[i]);
+      setActive(i);
+    }
+  }
+
+  // set parameter i to the given value immediately, without gliding.
+  void setValue(size_t i, float f)
+  {
+    mTarget[i] = f;
+    mVectorsRemaining[i] = 0.f;
+    setActive(i);
+  }
+
+  float getTarget(size_t i) const { return mTarget[i]; }
+
+  // return the value of parameter i at the end of the last vector processed.
+  float getValue(size_t i) const { return mValue[i]; }
+
+  // return true if no parameter will change in the next vector.
+  bool isIdle() const { return mActiveGroupCount == 0; }
+
+  // set every parameter to 0 immediately.
+  void clear()
+  {
+    mValue.fill(0.f);
+    mTarget.fill(0.f);
+    mStep.fill(0.f);
+    mVectorsRemaining.fill(0.f);
+    for (size_t g = 0; g < kGroups; ++g)
+    {
+      mActiveGroups[g] = g;
+      mGroupIsActive[g] = true;
+    }
+    mActiveGroupCount = kGroups;
+  }
+
+  void process(DSPVectorArray<N>& y)
+  {
+    processActiveGroups([&](size_t i) { return y.row(i).getBuffer(); });
+  }
+
+  void process(DSPVectorDynamic& y)
+  {
+    processActiveGroups([&](size_t i) { return y[static_cast<int>(i)].getBuffer(); });
+  }
+
+ private:
+  void setActive(size_t i)
+  {
+    const size_t g = i / kFloatsPerSIMDVector;
+    if (!mGroupIsActive[g])
+    {
+      mGroupIsActive[g] = true;
+      mActiveGroups[mActiveGroupCount++] = g;
+    }
+  }
+
+  template <typename ROW_FN>
+  void processActiveGroups(ROW_FN getRow)
+  {
+    size_t stillActive{0};
+    for (size_t k = 0; k < mActiveGroupCount; ++k)
+    {
+      const size_t g = mActiveGroups[k];
+      if (processGroup(g, getRow))
+      {
+        mActiveGroups[stillActive++] = g;
+      }
+      else
+      {
+        mGroupIsActive[g] = false;
+      }
+    }
+    mActiveGroupCount = stillActive;
+  }
+
+  // advance the glides in group g by one vector and write the rows of the
+  // parameters that change. Return true if any of them will change again.
+  template <typename ROW_FN>
+  bool processGroup(size_t g, ROW_FN getRow)
+  {
+    const size_t i0 = g * kFloatsPerSIMDVector;
+    const SIMDVectorFloat zero = vecZeros();
+    const SIMDVectorFloat remaining = vecLoad(mVectorsRemaining.data() + i0);
+    const SIMDVectorFloat active = vecGreaterThanOrEqual(remaining, zero);
+
+    // as in LinearGlide, when no vectors remain the output is set to the target.
+    const SIMDVectorFloat done = vecEqual(remaining, zero);
+    const SIMDVectorFloat start =
+        vecSelect(vecLoad(mTarget.data() + i0), vecLoad(mValue.data() + i0), done);
+    const SIMDVectorFloat step = vecAnd(vecSelect(zero, vecLoad(mStep.data() + i0), done), active);
+    const SIMDVectorFloat nextRemaining = vecMax(vecSub(remaining, vecSet1(1.f)), vecSet1(-1.f));
+    vecStore(mValue.data() + i0, vecAdd(start, step));
+    vecStore(mStep.data() + i0, step);
+    vecStore(mVectorsRemaining.data() + i0, nextRemaining);
+
+    alignas(kBytesPerSIMDVector) float starts[kFloatsPerSIMDVector];
+    alignas(kBytesPerSIMDVector) float steps[kFloatsPerSIMDVector];
+    alignas(kBytesPerSIMDVector) float remainingLanes[kFloatsPerSIMDVector];
+    vecStore(starts, start);
+    vecStore(steps, step);
+    vecStore(remainingLanes, remaining);
+    const float* pRamp = kUnityRampVec.getConstBuffer();
+    for (size_t j = 0; (j < kFloatsPerSIMDVector) && (i0 + j < N); ++j)
+    {
+      if (remainingLanes[j] < 0.f) continue;
+      const SIMDVectorFloat vStart = vecSet1(starts[j]);
+      const SIMDVectorFloat vStep = vecSet1(steps[j]);
+      float* py = getRow(i0 + j);
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        vecStore(py + n, vecAdd(vStart, vecMul(vecLoad(pRamp + n), vStep)));
+      }
+    }
+    return vecAnyTrue(vecGreaterThanOrEqual(nextRemaining, zero));
+  }
+
+  alignas(kBytesPerSIMDVector) Lanes mValue{};
+  alignas(kBytesPerSIMDVector) Lanes mTarget{};
+  alignas(kBytesPerSIMDVector) Lanes mStep{};
+  alignas(kBytesPerSIMDVector) Lanes mVectorsRemaining{};
+  std::array<int, N> mVectorsPerGlide{};
+  std::array<size_t, kGroups> mActiveGroups{};
+  std::array<bool, kGroups> mGroupIsActive{};
+  size_t mActiveGroupCount{0};
+};
+
 }  // namespace ml
@@ -12,8 +12,9 @@ static_assert((kFloatsPerDSPVectorBits <= 8),
 
 // Load definitions for low-level SIMD math.
 // These must define SIMDVectorFloat, SIMDVectorInt, their sizes, and a bunch of
-// operations on them. We are currently only using 4-element vectors on both SSE
-// and NEON.
+// operations on them. SIMDVectorFloat is a 4-element vector on both SSE
+// and NEON. On x86, wider AVX kernels for some array operations are also
+// compiled in and chosen at runtime if the CPU supports them.
 
 #if (defined __ARM_NEON) || (defined __ARM_NEON__)
 
@@ -28,8 +29,14 @@ static_assert((kFloatsPerDSPVectorBits <= 8),
 
 #include "MLDSPMathSSE.h"
 
+// AVX2 and AVX-512, for use only after runtime detection.
+#include "MLDSPMathAVX.h"
+
 #endif
 
+// Runtime selection of the widest available array kernels.
+#include "MLDSPMathDispatch.h"
+
 // A C++11 implementation of std::integer_sequence from C++14
 // Copyright Jonathan Wakely 2012-2013
 // Distributed under the Boost Software License, Version 1.0.
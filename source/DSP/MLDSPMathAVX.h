@@ -0,0 +1,517 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// MLDSPMathAVX.h
+// AVX2 (8-wide) and AVX-512 (16-wide) implementations of madronalib SIMD
+// primitives, and array kernels built from them.
+//
+// Everything here is compiled with function-level target attributes, so a
+// binary built for baseline SSE2 can contain these functions. They must not be
+// called unless the CPU has been checked for support at runtime. The kernels
+// are only meant to be reached through the table in MLDSPMathDispatch.h, which
+// does that check once at startup.
+//
+// The cephes-derived exp, log, sin and cos below are straight ports of the SSE
+// versions in MLDSPMathSSE.h (adapted from code by Julien Pommier, zlib
+// license, see that file) with the Horner steps done using FMA.
+
+#pragma once
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && \
+    !defined(ML_SSE_TO_NEON)
+#define ML_HAS_AVX_KERNELS 1
+#endif
+
+#ifdef ML_HAS_AVX_KERNELS
+
+#include <immintrin.h>
+
+#include <cstddef>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+// MSVC allows AVX intrinsics in any function without special flags.
+#define ML_TARGET_AVX2
+#define ML_TARGET_AVX512
+#else
+#define ML_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define ML_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+// AVX types
+typedef __m256 SIMDVectorFloat8;
+typedef __m256i SIMDVectorInt8;
+typedef __m512 SIMDVectorFloat16;
+typedef __m512i SIMDVectorInt16;
+
+constexpr int kFloatsPerSIMDVector8 = 8;
+constexpr int kFloatsPerSIMDVector16 = 16;
+
+// ----------------------------------------------------------------
+// primitive AVX2 operations. These may only be used inside functions
+// declared ML_TARGET_AVX2.
+
+#define vecAdd8 _mm256_add_ps
+#define vecSub8 _mm256_sub_ps
+#define vecMul8 _mm256_mul_ps
+#define vecDiv8 _mm256_div_ps
+#define vecMin8 _mm256_min_ps
+#define vecMax8 _mm256_max_ps
+#define vecSqrt8 _mm256_sqrt_ps
+#define vecFMA8 _mm256_fmadd_ps
+#define vecFMS8 _mm256_fmsub_ps
+#define vecSet18 _mm256_set1_ps
+#define vecLoad8 _mm256_loadu_ps
+#define vecStore8 _mm256_storeu_ps
+#define vecAbs8(x) (_mm256_andnot_ps(_mm256_set1_ps(-0.0f), x))
+#define vecClamp8(x1, x2, x3) _mm256_min_ps(_mm256_max_ps(x1, x2), x3)
+
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecSelect8(SIMDVectorFloat8 a, SIMDVectorFloat8 b,
+                                                  SIMDVectorFloat8 conditionMask)
+{
+  return _mm256_or_ps(_mm256_and_ps(conditionMask, a), _mm256_andnot_ps(conditionMask, b));
+}
+
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecLog8(SIMDVectorFloat8 x)
+{
+  const SIMDVectorFloat8 one = _mm256_set1_ps(1.0f);
+  const SIMDVectorFloat8 invalidMask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OQ);
+
+  // cut off denormalized stuff
+  x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000)));
+  SIMDVectorInt8 emm0 = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+
+  // keep only the fractional part
+  x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+  x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+
+  emm0 = _mm256_sub_epi32(emm0, _mm256_set1_epi32(0x7f));
+  SIMDVectorFloat8 e = _mm256_add_ps(_mm256_cvtepi32_ps(emm0), one);
+
+  const SIMDVectorFloat8 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  SIMDVectorFloat8 tmp = _mm256_and_ps(x, mask);
+  x = _mm256_sub_ps(x, one);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+  x = _mm256_add_ps(x, tmp);
+
+  const SIMDVectorFloat8 z = _mm256_mul_ps(x, x);
+
+  SIMDVectorFloat8 y = _mm256_set1_ps(7.0376836292E-2f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.1514610310E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.1676998740E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.2420140846E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(+1.4249322787E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.6668057665E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(+2.0000714765E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-2.4999993993E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(+3.3333331174E-1f));
+  y = _mm256_mul_ps(y, x);
+  y = _mm256_mul_ps(y, z);
+
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+
+  x = _mm256_add_ps(x, y);
+  x = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), x);
+
+  // negative arg will be NAN
+  return _mm256_or_ps(x, invalidMask);
+}
+
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecExp8(SIMDVectorFloat8 x)
+{
+  const SIMDVectorFloat8 one = _mm256_set1_ps(1.0f);
+
+  x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+  x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+  // express exp(x) as exp(g + n*log(2))
+  SIMDVectorFloat8 fx =
+      _mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(0.693359375f), x);
+  x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(-2.12194440e-4f), x);
+  const SIMDVectorFloat8 z = _mm256_mul_ps(x, x);
+
+  SIMDVectorFloat8 y = _mm256_set1_ps(1.9875691500E-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507E-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073E-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894E-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201E-1f));
+  y = _mm256_fmadd_ps(y, z, x);
+  y = _mm256_add_ps(y, one);
+
+  // build 2^n
+  SIMDVectorInt8 emm0 = _mm256_cvttps_epi32(fx);
+  emm0 = _mm256_add_epi32(emm0, _mm256_set1_epi32(0x7f));
+  emm0 = _mm256_slli_epi32(emm0, 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(emm0));
+}
+
+// shared part of sin and cos: given the reduced argument x and the
+// polynomial selection mask, evaluate both polynomials and select.
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecSinCosPoly8(SIMDVectorFloat8 x,
+                                                      SIMDVectorFloat8 polyMask)
+{
+  const SIMDVectorFloat8 z = _mm256_mul_ps(x, x);
+
+  // first polynomial (0 <= x <= Pi/4)
+  SIMDVectorFloat8 y = _mm256_set1_ps(2.443315711809948E-005f);
+  y = _mm256_fmadd_ps(y, z, _mm256_set1_ps(-1.388731625493765E-003f));
+  y = _mm256_fmadd_ps(y, z, _mm256_set1_ps(4.166664568298827E-002f));
+  y = _mm256_mul_ps(y, z);
+  y = _mm256_mul_ps(y, z);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  // second polynomial (Pi/4 <= x <= 0)
+  SIMDVectorFloat8 y2 = _mm256_set1_ps(-1.9515295891E-4f);
+  y2 = _mm256_fmadd_ps(y2, z, _mm256_set1_ps(8.3321608736E-3f));
+  y2 = _mm256_fmadd_ps(y2, z, _mm256_set1_ps(-1.6666654611E-1f));
+  y2 = _mm256_mul_ps(y2, z);
+  y2 = _mm256_fmadd_ps(y2, x, x);
+
+  return _mm256_blendv_ps(y, y2, polyMask);
+}
+
+// extended precision modular arithmetic: x = ((x - y * DP1) - y * DP2) - y * DP3
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecReduceQuadrant8(SIMDVectorFloat8 x, SIMDVectorFloat8 y)
+{
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-0.78515625f), x);
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4f), x);
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-3.77489497744594108e-8f), x);
+  return x;
+}
+
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecSin8(SIMDVectorFloat8 x)
+{
+  const SIMDVectorFloat8 signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+  SIMDVectorFloat8 signBit = _mm256_and_ps(x, signMask);
+  x = _mm256_andnot_ps(signMask, x);
+
+  // scale by 4/Pi, j = (j+1) & (~1)
+  SIMDVectorInt8 emm2 = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+  emm2 = _mm256_add_epi32(emm2, _mm256_set1_epi32(1));
+  emm2 = _mm256_and_si256(emm2, _mm256_set1_epi32(~1));
+  const SIMDVectorFloat8 y = _mm256_cvtepi32_ps(emm2);
+
+  // swap sign flag and polynomial selection mask
+  const SIMDVectorInt8 emm0 = _mm256_slli_epi32(_mm256_and_si256(emm2, _mm256_set1_epi32(4)), 29);
+  emm2 = _mm256_cmpeq_epi32(_mm256_and_si256(emm2, _mm256_set1_epi32(2)), _mm256_setzero_si256());
+  signBit = _mm256_xor_ps(signBit, _mm256_castsi256_ps(emm0));
+
+  x = vecReduceQuadrant8(x, y);
+  const SIMDVectorFloat8 r = vecSinCosPoly8(x, _mm256_castsi256_ps(emm2));
+  return _mm256_xor_ps(r, signBit);
+}
+
+ML_TARGET_AVX2 inline SIMDVectorFloat8 vecCos8(SIMDVectorFloat8 x)
+{
+  x = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000)), x);
+
+  // scale by 4/Pi, j = (j+1) & (~1)
+  SIMDVectorInt8 emm2 = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+  emm2 = _mm256_add_epi32(emm2, _mm256_set1_epi32(1));
+  emm2 = _mm256_and_si256(emm2, _mm256_set1_epi32(~1));
+  const SIMDVectorFloat8 y = _mm256_cvtepi32_ps(emm2);
+  emm2 = _mm256_sub_epi32(emm2, _mm256_set1_epi32(2));
+
+  // swap sign flag and polynomial selection mask
+  const SIMDVectorInt8 emm0 =
+      _mm256_slli_epi32(_mm256_andnot_si256(emm2, _mm256_set1_epi32(4)), 29);
+  emm2 = _mm256_cmpeq_epi32(_mm256_and_si256(emm2, _mm256_set1_epi32(2)), _mm256_setzero_si256());
+
+  x = vecReduceQuadrant8(x, y);
+  const SIMDVectorFloat8 r = vecSinCosPoly8(x, _mm256_castsi256_ps(emm2));
+  return _mm256_xor_ps(r, _mm256_castsi256_ps(emm0));
+}
+
+// ----------------------------------------------------------------
+// primitive AVX-512 operations. These may only be used inside functions
+// declared ML_TARGET_AVX512.
+//
+// With GCC 12, the unmasked forms of some intrinsics, such as _mm512_min_ps()
+// and _mm512_cvttps_epi32(), pass _mm512_undefined_*() as their masked-off
+// source, which warns with -Wmaybe-uninitialized wherever they are inlined.
+// Those are used here in their zero-masking forms with all lanes selected,
+// which compile to the same unmasked instructions.
+constexpr __mmask16 kAllLanes16{0xFFFF};
+
+#define vecAdd16 _mm512_add_ps
+#define vecSub16 _mm512_sub_ps
+#define vecMul16 _mm512_mul_ps
+#define vecDiv16 _mm512_div_ps
+#define vecMin16(x1, x2) _mm512_maskz_min_ps(kAllLanes16, x1, x2)
+#define vecMax16(x1, x2) _mm512_maskz_max_ps(kAllLanes16, x1, x2)
+#define vecSqrt16(x) _mm512_maskz_sqrt_ps(kAllLanes16, x)
+#define vecFMA16 _mm512_fmadd_ps
+#define vecFMS16 _mm512_fmsub_ps
+#define vecSet116 _mm512_set1_ps
+#define vecLoad16 _mm512_loadu_ps
+#define vecStore16 _mm512_storeu_ps
+#define vecAbs16(x) (_mm512_abs_ps(x))
+#define vecClamp16(x1, x2, x3) vecMin16(vecMax16(x1, x2), x3)
+
+// bitwise select, using ternary logic function 0xCA: (a & mask) | (b & ~mask)
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecSelect16(SIMDVectorFloat16 a, SIMDVectorFloat16 b,
+                                                      SIMDVectorFloat16 conditionMask)
+{
+  return _mm512_castsi512_ps(_mm512_ternarylogic_epi32(
+      _mm512_castps_si512(conditionMask), _mm512_castps_si512(a), _mm512_castps_si512(b), 0xCA));
+}
+
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecLog16(SIMDVectorFloat16 x)
+{
+  const SIMDVectorFloat16 one = _mm512_set1_ps(1.0f);
+  const __mmask16 invalidMask = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LE_OQ);
+
+  // cut off denormalized stuff
+  x = _mm512_maskz_max_ps(kAllLanes16, x, _mm512_castsi512_ps(_mm512_set1_epi32(0x00800000)));
+  SIMDVectorInt16 emm0 = _mm512_maskz_srli_epi32(kAllLanes16, _mm512_castps_si512(x), 23);
+
+  // keep only the fractional part
+  SIMDVectorInt16 xi = _mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32(~0x7f800000));
+  xi = _mm512_or_si512(xi, _mm512_castps_si512(_mm512_set1_ps(0.5f)));
+  x = _mm512_castsi512_ps(xi);
+
+  emm0 = _mm512_sub_epi32(emm0, _mm512_set1_epi32(0x7f));
+  SIMDVectorFloat16 e = _mm512_add_ps(_mm512_maskz_cvtepi32_ps(kAllLanes16, emm0), one);
+
+  const __mmask16 mask = _mm512_cmp_ps_mask(x, _mm512_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  const SIMDVectorFloat16 tmp = _mm512_maskz_mov_ps(mask, x);
+  x = _mm512_sub_ps(x, one);
+  e = _mm512_mask_sub_ps(e, mask, e, one);
+  x = _mm512_add_ps(x, tmp);
+
+  const SIMDVectorFloat16 z = _mm512_mul_ps(x, x);
+
+  SIMDVectorFloat16 y = _mm512_set1_ps(7.0376836292E-2f);
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-1.1514610310E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.1676998740E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-1.2420140846E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(+1.4249322787E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-1.6668057665E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(+2.0000714765E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(-2.4999993993E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(+3.3333331174E-1f));
+  y = _mm512_mul_ps(y, x);
+  y = _mm512_mul_ps(y, z);
+
+  y = _mm512_fmadd_ps(e, _mm512_set1_ps(-2.12194440e-4f), y);
+  y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+
+  x = _mm512_add_ps(x, y);
+  x = _mm512_fmadd_ps(e, _mm512_set1_ps(0.693359375f), x);
+
+  // negative arg will be NAN
+  return _mm512_mask_mov_ps(x, invalidMask, _mm512_castsi512_ps(_mm512_set1_epi32(-1)));
+}
+
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecExp16(SIMDVectorFloat16 x)
+{
+  x = _mm512_maskz_min_ps(kAllLanes16, x, _mm512_set1_ps(88.3762626647949f));
+  x = _mm512_maskz_max_ps(kAllLanes16, x, _mm512_set1_ps(-88.3762626647949f));
+
+  // express exp(x) as exp(g + n*log(2))
+  SIMDVectorFloat16 fx =
+      _mm512_fmadd_ps(x, _mm512_set1_ps(1.44269504088896341f), _mm512_set1_ps(0.5f));
+  fx = _mm512_maskz_roundscale_ps(kAllLanes16, fx, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+
+  x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(0.693359375f), x);
+  x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(-2.12194440e-4f), x);
+  const SIMDVectorFloat16 z = _mm512_mul_ps(x, x);
+
+  SIMDVectorFloat16 y = _mm512_set1_ps(1.9875691500E-4f);
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507E-3f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073E-3f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894E-2f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459E-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201E-1f));
+  y = _mm512_fmadd_ps(y, z, x);
+  y = _mm512_add_ps(y, _mm512_set1_ps(1.0f));
+
+  // build 2^n
+  SIMDVectorInt16 emm0 = _mm512_maskz_cvttps_epi32(kAllLanes16, fx);
+  emm0 = _mm512_add_epi32(emm0, _mm512_set1_epi32(0x7f));
+  emm0 = _mm512_maskz_slli_epi32(kAllLanes16, emm0, 23);
+  return _mm512_mul_ps(y, _mm512_castsi512_ps(emm0));
+}
+
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecSinCosPoly16(SIMDVectorFloat16 x, __mmask16 polyMask)
+{
+  const SIMDVectorFloat16 z = _mm512_mul_ps(x, x);
+
+  // first polynomial (0 <= x <= Pi/4)
+  SIMDVectorFloat16 y = _mm512_set1_ps(2.443315711809948E-005f);
+  y = _mm512_fmadd_ps(y, z, _mm512_set1_ps(-1.388731625493765E-003f));
+  y = _mm512_fmadd_ps(y, z, _mm512_set1_ps(4.166664568298827E-002f));
+  y = _mm512_mul_ps(y, z);
+  y = _mm512_mul_ps(y, z);
+  y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+  y = _mm512_add_ps(y, _mm512_set1_ps(1.0f));
+
+  // second polynomial (Pi/4 <= x <= 0)
+  SIMDVectorFloat16 y2 = _mm512_set1_ps(-1.9515295891E-4f);
+  y2 = _mm512_fmadd_ps(y2, z, _mm512_set1_ps(8.3321608736E-3f));
+  y2 = _mm512_fmadd_ps(y2, z, _mm512_set1_ps(-1.6666654611E-1f));
+  y2 = _mm512_mul_ps(y2, z);
+  y2 = _mm512_fmadd_ps(y2, x, x);
+
+  return _mm512_mask_blend_ps(polyMask, y, y2);
+}
+
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecReduceQuadrant16(SIMDVectorFloat16 x,
+                                                              SIMDVectorFloat16 y)
+{
+  x = _mm512_fmadd_ps(y, _mm512_set1_ps(-0.78515625f), x);
+  x = _mm512_fmadd_ps(y, _mm512_set1_ps(-2.4187564849853515625e-4f), x);
+  x = _mm512_fmadd_ps(y, _mm512_set1_ps(-3.77489497744594108e-8f), x);
+  return x;
+}
+
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecSin16(SIMDVectorFloat16 x)
+{
+  const SIMDVectorInt16 signMask = _mm512_set1_epi32((int)0x80000000);
+  SIMDVectorInt16 signBit = _mm512_and_si512(_mm512_castps_si512(x), signMask);
+  x = _mm512_abs_ps(x);
+
+  // scale by 4/Pi, j = (j+1) & (~1)
+  SIMDVectorInt16 emm2 =
+      _mm512_maskz_cvttps_epi32(kAllLanes16, _mm512_mul_ps(x, _mm512_set1_ps(1.27323954473516f)));
+  emm2 = _mm512_add_epi32(emm2, _mm512_set1_epi32(1));
+  emm2 = _mm512_and_si512(emm2, _mm512_set1_epi32(~1));
+  const SIMDVectorFloat16 y = _mm512_maskz_cvtepi32_ps(kAllLanes16, emm2);
+
+  // swap sign flag and polynomial selection mask
+  const SIMDVectorInt16 emm0 =
+      _mm512_maskz_slli_epi32(kAllLanes16, _mm512_and_si512(emm2, _mm512_set1_epi32(4)), 29);
+  const __mmask16 polyMask =
+      _mm512_cmpeq_epi32_mask(_mm512_and_si512(emm2, _mm512_set1_epi32(2)), _mm512_setzero_si512());
+  signBit = _mm512_xor_si512(signBit, emm0);
+
+  x = vecReduceQuadrant16(x, y);
+  const SIMDVectorFloat16 r = vecSinCosPoly16(x, polyMask);
+  return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(r), signBit));
+}
+
+ML_TARGET_AVX512 inline SIMDVectorFloat16 vecCos16(SIMDVectorFloat16 x)
+{
+  x = _mm512_abs_ps(x);
+
+  // scale by 4/Pi, j = (j+1) & (~1)
+  SIMDVectorInt16 emm2 =
+      _mm512_maskz_cvttps_epi32(kAllLanes16, _mm512_mul_ps(x, _mm512_set1_ps(1.27323954473516f)));
+  emm2 = _mm512_add_epi32(emm2, _mm512_set1_epi32(1));
+  emm2 = _mm512_and_si512(emm2, _mm512_set1_epi32(~1));
+  const SIMDVectorFloat16 y = _mm512_maskz_cvtepi32_ps(kAllLanes16, emm2);
+  emm2 = _mm512_sub_epi32(emm2, _mm512_set1_epi32(2));
+
+  // swap sign flag and polynomial selection mask
+  const SIMDVectorInt16 emm0 = _mm512_maskz_slli_epi32(
+      kAllLanes16, _mm512_maskz_andnot_epi32(kAllLanes16, emm2, _mm512_set1_epi32(4)), 29);
+  const __mmask16 polyMask =
+      _mm512_cmpeq_epi32_mask(_mm512_and_si512(emm2, _mm512_set1_epi32(2)), _mm512_setzero_si512());
+
+  x = vecReduceQuadrant16(x, y);
+  const SIMDVectorFloat16 r = vecSinCosPoly16(x, polyMask);
+  return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(r), emm0));
+}
+
+// ----------------------------------------------------------------
+// array kernels. Each processes n floats, where n must be a multiple of 16.
+// Pointers need not be aligned beyond the 16 bytes a DSPVectorArray has.
+
+#define DEFINE_AVX_KERNEL1(kernelName, target, width, vecLoadW, vecStoreW, opComputation) \
+  target inline void kernelName(const float* px1, float* py1, size_t n)                   \
+  {                                                                                       \
+    for (size_t i = 0; i < n; i += width)                                                 \
+    {                                                                                     \
+      auto x = vecLoadW(px1 + i);                                                         \
+      vecStoreW(py1 + i, (opComputation));                                                \
+    }                                                                                     \
+  }
+
+#define DEFINE_AVX_KERNEL2(kernelName, target, width, vecLoadW, vecStoreW, opComputation) \
+  target inline void kernelName(const float* px1, const float* px2, float* py1, size_t n) \
+  {                                                                                       \
+    for (size_t i = 0; i < n; i += width)                                                 \
+    {                                                                                     \
+      auto x1 = vecLoadW(px1 + i);                                                        \
+      auto x2 = vecLoadW(px2 + i);                                                        \
+      vecStoreW(py1 + i, (opComputation));                                                \
+    }                                                                                     \
+  }
+
+#define DEFINE_AVX_KERNEL3(kernelName, target, width, vecLoadW, vecStoreW, opComputation) \
+  target inline void kernelName(const float* px1, const float* px2, const float* px3,     \
+                                float* py1, size_t n)                                     \
+  {                                                                                       \
+    for (size_t i = 0; i < n; i += width)                                                 \
+    {                                                                                     \
+      auto x1 = vecLoadW(px1 + i);                                                        \
+      auto x2 = vecLoadW(px2 + i);                                                        \
+      auto x3 = vecLoadW(px3 + i);                                                        \
+      vecStoreW(py1 + i, (opComputation));                                                \
+    }                                                                                     \
+  }
+
+#define DEFINE_AVX2_KERNEL1(kernelName, opComputation) \
+  DEFINE_AVX_KERNEL1(kernelName, ML_TARGET_AVX2, 8, vecLoad8, vecStore8, opComputation)
+#define DEFINE_AVX2_KERNEL2(kernelName, opComputation) \
+  DEFINE_AVX_KERNEL2(kernelName, ML_TARGET_AVX2, 8, vecLoad8, vecStore8, opComputation)
+#define DEFINE_AVX2_KERNEL3(kernelName, opComputation) \
+  DEFINE_AVX_KERNEL3(kernelName, ML_TARGET_AVX2, 8, vecLoad8, vecStore8, opComputation)
+
+#define DEFINE_AVX512_KERNEL1(kernelName, opComputation) \
+  DEFINE_AVX_KERNEL1(kernelName, ML_TARGET_AVX512, 16, vecLoad16, vecStore16, opComputation)
+#define DEFINE_AVX512_KERNEL2(kernelName, opComputation) \
+  DEFINE_AVX_KERNEL2(kernelName, ML_TARGET_AVX512, 16, vecLoad16, vecStore16, opComputation)
+#define DEFINE_AVX512_KERNEL3(kernelName, opComputation) \
+  DEFINE_AVX_KERNEL3(kernelName, ML_TARGET_AVX512, 16, vecLoad16, vecStore16, opComputation)
+
+namespace ml
+{
+DEFINE_AVX2_KERNEL1(kernelSqrt8, vecSqrt8(x));
+DEFINE_AVX2_KERNEL1(kernelAbs8, vecAbs8(x));
+DEFINE_AVX2_KERNEL1(kernelExp8, vecExp8(x));
+DEFINE_AVX2_KERNEL1(kernelLog8, vecLog8(x));
+DEFINE_AVX2_KERNEL1(kernelSin8, vecSin8(x));
+DEFINE_AVX2_KERNEL1(kernelCos8, vecCos8(x));
+
+DEFINE_AVX2_KERNEL2(kernelAdd8, vecAdd8(x1, x2));
+DEFINE_AVX2_KERNEL2(kernelSubtract8, vecSub8(x1, x2));
+DEFINE_AVX2_KERNEL2(kernelMultiply8, vecMul8(x1, x2));
+DEFINE_AVX2_KERNEL2(kernelDivide8, vecDiv8(x1, x2));
+DEFINE_AVX2_KERNEL2(kernelMin8, vecMin8(x1, x2));
+DEFINE_AVX2_KERNEL2(kernelMax8, vecMax8(x1, x2));
+
+DEFINE_AVX2_KERNEL3(kernelLerp8, vecFMA8(x3, vecSub8(x2, x1), x1));
+DEFINE_AVX2_KERNEL3(kernelClamp8, vecClamp8(x1, x2, x3));
+DEFINE_AVX2_KERNEL3(kernelSelect8, vecSelect8(x1, x2, x3));
+DEFINE_AVX2_KERNEL3(kernelMultiplyAdd8, vecFMA8(x1, x2, x3));
+DEFINE_AVX2_KERNEL3(kernelMultiplySubtract8, vecFMS8(x1, x2, x3));
+
+DEFINE_AVX512_KERNEL1(kernelSqrt16, vecSqrt16(x));
+DEFINE_AVX512_KERNEL1(kernelAbs16, vecAbs16(x));
+DEFINE_AVX512_KERNEL1(kernelExp16, vecExp16(x));
+DEFINE_AVX512_KERNEL1(kernelLog16, vecLog16(x));
+DEFINE_AVX512_KERNEL1(kernelSin16, vecSin16(x));
+DEFINE_AVX512_KERNEL1(kernelCos16, vecCos16(x));
+
+DEFINE_AVX512_KERNEL2(kernelAdd16, vecAdd16(x1, x2));
+DEFINE_AVX512_KERNEL2(kernelSubtract16, vecSub16(x1, x2));
+DEFINE_AVX512_KERNEL2(kernelMultiply16, vecMul16(x1, x2));
+DEFINE_AVX512_KERNEL2(kernelDivide16, vecDiv16(x1, x2));
+DEFINE_AVX512_KERNEL2(kernelMin16, vecMin16(x1, x2));
+DEFINE_AVX512_KERNEL2(kernelMax16, vecMax16(x1, x2));
+
+DEFINE_AVX512_KERNEL3(kernelLerp16, vecFMA16(x3, vecSub16(x2, x1), x1));
+DEFINE_AVX512_KERNEL3(kernelClamp16, vecClamp16(x1, x2, x3));
+DEFINE_AVX512_KERNEL3(kernelSelect16, vecSelect16(x1, x2, x3));
+DEFINE_AVX512_KERNEL3(kernelMultiplyAdd16, vecFMA16(x1, x2, x3));
+DEFINE_AVX512_KERNEL3(kernelMultiplySubtract16, vecFMS16(x1, x2, x3));
+}  // namespace ml
+
+#endif  // ML_HAS_AVX_KERNELS
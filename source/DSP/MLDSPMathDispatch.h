@@ -0,0 +1,264 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// MLDSPMathDispatch.h
+// Runtime selection of SIMD array kernels.
+//
+// A SIMDKernels table holds array versions of the most common operations for
+// one instruction set. The table for the widest instruction set the CPU
+// supports is chosen once, the first time getSIMDKernels() is called, so a
+// single binary built for SSE2 will use AVX2 or AVX-512 where available.
+//
+// The most common ops in MLDSPOps.h call these kernels through the table, but
+// only for arrays of at least kMinFloatsForSIMDKernels floats, and only when a
+// level wider than the base one was selected. Smaller ops keep their inline
+// SIMD loops, which the compiler can combine with the code around them.
+//
+// The AVX2 and AVX-512 kernels evaluate their polynomials, lerp, multiplyAdd
+// and multiplySubtract with FMA, rounding once where the inline loops round
+// twice unless compiled with FMA enabled. So the same op on the same data can
+// differ in its last bits depending on the size of the array and on the CPU.
+// sin, cos, log and exp stay within 1e-6 of the inline results for arguments
+// of moderate size, lerp within 1e-5 for inputs of order 10 and multiplyAdd
+// within one rounding of its product. All other kernels give identical
+// results. The "SIMD kernels" section of dspOpsTest checks these bounds.
+
+#pragma once
+
+#include <cstddef>
+
+#ifdef ML_HAS_AVX_KERNELS
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace ml
+{
+enum SIMDLevel
+{
+  kSIMDLevelBase = 0,  // SSE2, or NEON via sse2neon: 4 floats
+  kSIMDLevelAVX2,      // AVX2 + FMA: 8 floats
+  kSIMDLevelAVX512,    // AVX-512F: 16 floats
+  kNumSIMDLevels
+};
+
+using SIMDKernel1 = void (*)(const float* px1, float* py1, size_t n);
+using SIMDKernel2 = void (*)(const float* px1, const float* px2, float* py1, size_t n);
+using SIMDKernel3 = void (*)(const float* px1, const float* px2, const float* px3, float* py1,
+                             size_t n);
+
+// Each kernel processes n floats, where n must be a multiple of 16. The ternary
+// select kernel takes its condition mask as the bits of the third argument.
+// multiplyAdd and multiplySubtract compute x1 * x2 + x3 and x1 * x2 - x3, with
+// a single rounding in the AVX kernels.
+struct SIMDKernels
+{
+  SIMDLevel level;
+  const char* name;
+  int floatsPerVector;
+
+  SIMDKernel1 sqrt;
+  SIMDKernel1 abs;
+  SIMDKernel1 exp;
+  SIMDKernel1 log;
+  SIMDKernel1 sin;
+  SIMDKernel1 cos;
+
+  SIMDKernel2 add;
+  SIMDKernel2 subtract;
+  SIMDKernel2 multiply;
+  SIMDKernel2 divide;
+  SIMDKernel2 min;
+  SIMDKernel2 max;
+
+  SIMDKernel3 lerp;
+  SIMDKernel3 clamp;
+  SIMDKernel3 select;
+  SIMDKernel3 multiplyAdd;
+  SIMDKernel3 multiplySubtract;
+};
+
+// ----------------------------------------------------------------
+// base kernels, using the 4-wide primitives from MLDSPMathSSE.h.
+
+#define DEFINE_BASE_KERNEL1(kernelName, opComputation)           \
+  inline void kernelName(const float* px1, float* py1, size_t n) \
+  {                                                              \
+    for (size_t i = 0; i < n; i += kFloatsPerSIMDVector)         \
+    {                                                            \
+      SIMDVectorFloat x = vecLoad(px1 + i);                      \
+      vecStore(py1 + i, (opComputation));                        \
+    }                                                            \
+  }
+
+#define DEFINE_BASE_KERNEL2(kernelName, opComputation)                             \
+  inline void kernelName(const float* px1, const float* px2, float* py1, size_t n) \
+  {                                                                                \
+    for (size_t i = 0; i < n; i += kFloatsPerSIMDVector)                           \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1 + i);                                       \
+      SIMDVectorFloat x2 = vecLoad(px2 + i);                                       \
+      vecStore(py1 + i, (opComputation));                                          \
+    }                                                                              \
+  }
+
+#define DEFINE_BASE_KERNEL3(kernelName, opComputation)                                     \
+  inline void kernelName(const float* px1, const float* px2, const float* px3, float* py1, \
+                         size_t n)                                                         \
+  {                                                                                        \
+    for (size_t i = 0; i < n; i += kFloatsPerSIMDVector)                                   \
+    {                                                                                      \
+      SIMDVectorFloat x1 = vecLoad(px1 + i);                                               \
+      SIMDVectorFloat x2 = vecLoad(px2 + i);                                               \
+      SIMDVectorFloat x3 = vecLoad(px3 + i);                                               \
+      vecStore(py1 + i, (opComputation));                                                  \
+    }                                                                                      \
+  }
+
+DEFINE_BASE_KERNEL1(kernelSqrt4, vecSqrt(x));
+DEFINE_BASE_KERNEL1(kernelAbs4, vecAbs(x));
+DEFINE_BASE_KERNEL1(kernelExp4, vecExp(x));
+DEFINE_BASE_KERNEL1(kernelLog4, vecLog(x));
+DEFINE_BASE_KERNEL1(kernelSin4, vecSin(x));
+DEFINE_BASE_KERNEL1(kernelCos4, vecCos(x));
+
+DEFINE_BASE_KERNEL2(kernelAdd4, vecAdd(x1, x2));
+DEFINE_BASE_KERNEL2(kernelSubtract4, vecSub(x1, x2));
+DEFINE_BASE_KERNEL2(kernelMultiply4, vecMul(x1, x2));
+DEFINE_BASE_KERNEL2(kernelDivide4, vecDiv(x1, x2));
+DEFINE_BASE_KERNEL2(kernelMin4, vecMin(x1, x2));
+DEFINE_BASE_KERNEL2(kernelMax4, vecMax(x1, x2));
+
+DEFINE_BASE_KERNEL3(kernelLerp4, vecFMA(x3, vecSub(x2, x1), x1));
+DEFINE_BASE_KERNEL3(kernelClamp4, vecClamp(x1, x2, x3));
+DEFINE_BASE_KERNEL3(kernelSelect4, vecSelect(x1, x2, x3));
+DEFINE_BASE_KERNEL3(kernelMultiplyAdd4, vecFMA(x1, x2, x3));
+DEFINE_BASE_KERNEL3(kernelMultiplySubtract4, vecFMS(x1, x2, x3));
+
+// ----------------------------------------------------------------
+// kernel tables
+
+inline const SIMDKernels& getBaseSIMDKernels()
+{
+  static const SIMDKernels k{kSIMDLevelBase, "SSE2", 4, kernelSqrt4, kernelAbs4, kernelExp4,
+                             kernelLog4, kernelSin4, kernelCos4, kernelAdd4, kernelSubtract4,
+                             kernelMultiply4, kernelDivide4, kernelMin4, kernelMax4, kernelLerp4,
+                             kernelClamp4, kernelSelect4, kernelMultiplyAdd4,
+                             kernelMultiplySubtract4};
+  return k;
+}
+
+#ifdef ML_HAS_AVX_KERNELS
+
+// Dispatch is worth it on x86 where wider kernels may exist.
+constexpr bool kUseSIMDKernels = true;
+
+inline const SIMDKernels& getAVX2SIMDKernels()
+{
+  static const SIMDKernels k{kSIMDLevelAVX2, "AVX2", 8, kernelSqrt8, kernelAbs8, kernelExp8,
+                             kernelLog8, kernelSin8, kernelCos8, kernelAdd8, kernelSubtract8,
+                             kernelMultiply8, kernelDivide8, kernelMin8, kernelMax8, kernelLerp8,
+                             kernelClamp8, kernelSelect8, kernelMultiplyAdd8,
+                             kernelMultiplySubtract8};
+  return k;
+}
+
+inline const SIMDKernels& getAVX512SIMDKernels()
+{
+  static const SIMDKernels k{kSIMDLevelAVX512, "AVX-512", 16, kernelSqrt16, kernelAbs16,
+                             kernelExp16, kernelLog16, kernelSin16, kernelCos16, kernelAdd16,
+                             kernelSubtract16, kernelMultiply16, kernelDivide16, kernelMin16,
+                             kernelMax16, kernelLerp16, kernelClamp16, kernelSelect16,
+                             kernelMultiplyAdd16, kernelMultiplySubtract16};
+  return k;
+}
+
+// Return the widest SIMDLevel supported by both the CPU and the OS.
+inline SIMDLevel detectSIMDLevel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  if (maxLeaf < 7) return kSIMDLevelBase;
+
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool fma = (info[2] & (1 << 12)) != 0;
+  if (!osxsave) return kSIMDLevelBase;
+
+  // the OS must save the ymm registers, and the zmm registers for AVX-512.
+  const unsigned long long xcr0 = _xgetbv(0);
+  const bool osYmm = (xcr0 & 0x06) == 0x06;
+  const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+
+  __cpuidex(info, 7, 0);
+  const bool avx2 = (info[1] & (1 << 5)) != 0;
+  const bool avx512f = (info[1] & (1 << 16)) != 0;
+
+  if (avx512f && avx2 && fma && osZmm) return kSIMDLevelAVX512;
+  if (avx2 && fma && osYmm) return kSIMDLevelAVX2;
+  return kSIMDLevelBase;
+#else
+  // __builtin_cpu_supports also checks that the OS has enabled the registers.
+  __builtin_cpu_init();
+  const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if (avx2 && __builtin_cpu_supports("avx512f")) return kSIMDLevelAVX512;
+  if (avx2) return kSIMDLevelAVX2;
+  return kSIMDLevelBase;
+#endif
+}
+
+#else
+
+constexpr bool kUseSIMDKernels = false;
+
+inline SIMDLevel detectSIMDLevel() { return kSIMDLevelBase; }
+
+#endif  // ML_HAS_AVX_KERNELS
+
+// ops on arrays smaller than this use inline SIMD loops instead of the kernels.
+// A call through the table can't be inlined, so each op makes its own pass over
+// memory instead of being combined with its neighbors. That fixed cost is only
+// paid back by the wider vectors on arrays of several DSPVectors.
+constexpr size_t kMinFloatsForSIMDKernels{256};
+
+// true if an op on an array of FLOATS floats should call the kernels when a wider
+// level is available.
+template <size_t FLOATS>
+constexpr bool useSIMDKernels()
+{
+  return kUseSIMDKernels && (FLOATS >= kMinFloatsForSIMDKernels);
+}
+
+// Return the kernel table for the given level, or for the widest level the CPU
+// supports if that is lower. Useful for testing.
+inline const SIMDKernels& getSIMDKernels(SIMDLevel level)
+{
+#ifdef ML_HAS_AVX_KERNELS
+  static const SIMDLevel maxLevel = detectSIMDLevel();
+  if (level > maxLevel) level = maxLevel;
+  switch (level)
+  {
+    case kSIMDLevelAVX512:
+      return getAVX512SIMDKernels();
+    case kSIMDLevelAVX2:
+      return getAVX2SIMDKernels();
+    default:
+      break;
+  }
+#endif
+  return getBaseSIMDKernels();
+}
+
+// Return the kernel table for the widest level the CPU supports. This is
+// selected once, on the first call.
+inline const SIMDKernels& getSIMDKernels()
+{
+  static const SIMDKernels& k = getSIMDKernels(kNumSIMDLevels);
+  return k;
+}
+
+}  // namespace ml
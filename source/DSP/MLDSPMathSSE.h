@@ -33,6 +33,12 @@
 
 #ifndef ML_SSE_TO_NEON
 #include <emmintrin.h>
+#if defined(__FMA__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
 #endif
 
 #include <float.h>
@@ -93,6 +99,27 @@ inline bool isSIMDAligned(float* p)
 #define vecClamp(x1, x2, x3) _mm_min_ps(_mm_max_ps(x1, x2), x3)
 #define vecWithin(x1, x2, x3) _mm_and_ps(_mm_cmpge_ps(x1, x2), _mm_cmplt_ps(x1, x3))
 
+// fused multiply-add: vecFMA(x1, x2, x3) = x1 * x2 + x3, vecFMS(x1, x2, x3) =
+// x1 * x2 - x3 and vecFNMA(x1, x2, x3) = x3 - x1 * x2. These round once when
+// the target has FMA instructions: on AArch64, or on x86 when compiling with
+// FMA enabled (-mfma, -march=haswell, /arch:AVX2). Otherwise they are a
+// separate multiply and add.
+#if defined(ML_SSE_TO_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define ML_HAS_FMA 1
+#define vecFMA(x1, x2, x3) vfmaq_f32(x3, x1, x2)
+#define vecFMS(x1, x2, x3) vnegq_f32(vfmsq_f32(x3, x1, x2))
+#define vecFNMA(x1, x2, x3) vfmsq_f32(x3, x1, x2)
+#elif !defined(ML_SSE_TO_NEON) && (defined(__FMA__) || defined(__AVX2__))
+#define ML_HAS_FMA 1
+#define vecFMA _mm_fmadd_ps
+#define vecFMS _mm_fmsub_ps
+#define vecFNMA _mm_fnmadd_ps
+#else
+#define vecFMA(x1, x2, x3) (_mm_add_ps(_mm_mul_ps(x1, x2), x3))
+#define vecFMS(x1, x2, x3) (_mm_sub_ps(_mm_mul_ps(x1, x2), x3))
+#define vecFNMA(x1, x2, x3) (_mm_sub_ps(x3, _mm_mul_ps(x1, x2)))
+#endif
+
 #define vecEqual _mm_cmpeq_ps
 #define vecNotEqual _mm_cmpneq_ps
 #define vecGreaterThan _mm_cmpgt_ps
@@ -118,6 +145,9 @@ inline bool isSIMDAligned(float* p)
 #define vecZeros _mm_setzero_ps
 #define vecOnes vecEqual(vecZeros, vecZeros)
 
+// true if any element of the comparison result mask is true.
+inline bool vecAnyTrue(SIMDVectorFloat mask) { return _mm_movemask_ps(mask) != 0; }
+
 #define vecShiftLeft _mm_slli_si128
 #define vecShiftRight _mm_srli_si128
 
@@ -137,6 +167,73 @@ inline SIMDVectorFloat vecUnsignedIntToFloat(SIMDVectorInt v)
 #define vecAddInt _mm_add_epi32
 #define vecSubInt _mm_sub_epi32
 #define vecSet1Int _mm_set1_epi32
+#define vecAndInt _mm_and_si128
+#define vecOrInt _mm_or_si128
+#define vecXorInt _mm_xor_si128
+
+// (~a) & b
+#define vecAndNotInt _mm_andnot_si128
+
+// shift each 32-bit element by a constant number of bits.
+#define vecShiftLeftInt32 _mm_slli_epi32
+#define vecShiftRightInt32 _mm_srli_epi32
+
+// multiply 32-bit elements, keeping the low 32 bits of each product. This is one
+// instruction with SSE4.1 or NEON. SSE2 only has a 32 x 32 -> 64 bit multiply of
+// the even elements, so there the odd elements are shifted down and multiplied
+// separately.
+inline SIMDVectorInt vecMulInt32(SIMDVectorInt a, SIMDVectorInt b)
+{
+#if defined(ML_SSE_TO_NEON) || defined(__SSE4_1__)
+  return _mm_mullo_epi32(a, b);
+#else
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+// return the running sums of the elements of x, with 32-bit wraparound:
+// {x0, x0 + x1, x0 + x1 + x2, x0 + x1 + x2 + x3}.
+inline SIMDVectorInt vecPrefixSumInt(SIMDVectorInt x)
+{
+  x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+  return _mm_add_epi32(x, _mm_slli_si128(x, 8));
+}
+
+// return the running bitwise or of the elements of x.
+inline SIMDVectorInt vecPrefixOrInt(SIMDVectorInt x)
+{
+  x = _mm_or_si128(x, _mm_slli_si128(x, 4));
+  return _mm_or_si128(x, _mm_slli_si128(x, 8));
+}
+
+// return every element set to the last element of x.
+inline SIMDVectorInt vecBroadcastLastInt(SIMDVectorInt x)
+{
+  return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// return the last element of x.
+inline uint32_t vecGetLastInt(SIMDVectorInt x)
+{
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(vecBroadcastLastInt(x)));
+}
+
+// return the elements of x moved up by one, with the last element of prev in
+// element 0: {prev3, x0, x1, x2}.
+inline SIMDVectorInt vecShiftInLastInt(SIMDVectorInt x, SIMDVectorInt prev)
+{
+  return _mm_or_si128(_mm_slli_si128(x, 4), _mm_srli_si128(prev, 12));
+}
+
+// compare 32-bit elements as unsigned ints, returning a mask of all ones where a < b.
+inline SIMDVectorInt vecLessThanUnsignedInt(SIMDVectorInt a, SIMDVectorInt b)
+{
+  const SIMDVectorInt sign = _mm_set1_epi32(0x80000000);
+  return _mm_cmplt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+}
 
 typedef union
 {
@@ -178,11 +275,21 @@ const SIMDVectorFloat vecMaskE = {X, X, X, 0};
 const SIMDVectorFloat vecMaskF = {X, X, X, X};
 
 #define SHUFFLE(a, b, c, d) ((a << 6) | (b << 4) | (c << 2) | (d))
+#define vecBroadcast0(x1) _mm_shuffle_ps(x1, x1, SHUFFLE(0, 0, 0, 0))
+#define vecBroadcast1(x1) _mm_shuffle_ps(x1, x1, SHUFFLE(1, 1, 1, 1))
+#define vecBroadcast2(x1) _mm_shuffle_ps(x1, x1, SHUFFLE(2, 2, 2, 2))
 #define vecBroadcast3(x1) _mm_shuffle_ps(x1, x1, SHUFFLE(3, 3, 3, 3))
 
+// return the first element of x.
+inline float vecGetFirst(SIMDVectorFloat x) { return _mm_cvtss_f32(x); }
+
 #define vecShiftElementsLeft(x1, i) _mm_slli_si128(x1, 4 * i);
 #define vecShiftElementsRight(x1, i) _mm_srli_si128(x1, 4 * i);
 
+// shift the elements of a float vector i places toward element 3, shifting in zeroes.
+// Given [ a, b, c, d ], vecShiftFloatsLeft(x1, 1) returns [ 0, a, b, c ].
+#define vecShiftFloatsLeft(x1, i) VecI2F(_mm_slli_si128(VecF2I(x1), 4 * (i)))
+
 inline std::ostream& operator<<(std::ostream& out, SIMDVectorFloat v)
 {
   SIMDVectorFloatUnion u;
@@ -755,20 +862,16 @@ STATIC_M128_CONST(kSinC3Vec, 8.30897875130176544189453125e-3f);
 STATIC_M128_CONST(kSinC4Vec, -1.92649182281456887722015380859375e-4f);
 STATIC_M128_CONST(kSinC5Vec, 2.147840177713078446686267852783203125e-6f);
 
-inline __m128 vecSinApprox(__m128 x)
+// the polynomials are evaluated in Horner form with vecFMA.
+
+inline SIMDVectorFloat vecSinApprox(SIMDVectorFloat x)
 {
-  __m128 x2 = _mm_mul_ps(x, x);
-  return _mm_mul_ps(
-      x, _mm_add_ps(
-             kSinC1Vec,
-             _mm_mul_ps(
-                 x2,
-                 _mm_add_ps(
-                     kSinC2Vec,
-                     _mm_mul_ps(
-                         x2, _mm_add_ps(kSinC3Vec,
-                                        _mm_mul_ps(x2, _mm_add_ps(kSinC4Vec,
-                                                                  _mm_mul_ps(x2, kSinC5Vec)))))))));
+  SIMDVectorFloat x2 = _mm_mul_ps(x, x);
+  SIMDVectorFloat y = vecFMA(x2, kSinC5Vec, kSinC4Vec);
+  y = vecFMA(y, x2, kSinC3Vec);
+  y = vecFMA(y, x2, kSinC2Vec);
+  y = vecFMA(y, x2, kSinC1Vec);
+  return _mm_mul_ps(x, y);
 }
 
 STATIC_M128_CONST(kCosC1Vec, 0.999959766864776611328125f);
@@ -780,15 +883,10 @@ STATIC_M128_CONST(kCosC5Vec, 1.8791708498611114919185638427734375e-5f);
 inline SIMDVectorFloat vecCosApprox(SIMDVectorFloat x)
 {
   SIMDVectorFloat x2 = _mm_mul_ps(x, x);
-  return _mm_add_ps(
-      kCosC1Vec,
-      _mm_mul_ps(
-          x2,
-          _mm_add_ps(
-              kCosC2Vec,
-              _mm_mul_ps(x2, _mm_add_ps(kCosC3Vec,
-                                        _mm_mul_ps(x2, _mm_add_ps(kCosC4Vec,
-                                                                  _mm_mul_ps(x2, kCosC5Vec))))))));
+  SIMDVectorFloat y = vecFMA(x2, kCosC5Vec, kCosC4Vec);
+  y = vecFMA(y, x2, kCosC3Vec);
+  y = vecFMA(y, x2, kCosC2Vec);
+  return vecFMA(y, x2, kCosC1Vec);
 }
 STATIC_M128_CONST(kExpC1Vec, 2139095040.f);
 STATIC_M128_CONST(kExpC2Vec, 12102203.1615614f);
@@ -806,7 +904,7 @@ inline SIMDVectorFloat vecExpApprox(SIMDVectorFloat x)
   SIMDVectorFloat val2, val3, val4;
   SIMDVectorInt val4i;
 
-  val2 = _mm_add_ps(_mm_mul_ps(x, kExpC2Vec), kExpC3Vec);
+  val2 = vecFMA(x, kExpC2Vec, kExpC3Vec);
   val3 = _mm_min_ps(val2, kExpC1Vec);
   val4 = _mm_max_ps(val3, kZeroVec);
   val4i = _mm_cvttps_epi32(val4);
@@ -815,17 +913,11 @@ inline SIMDVectorFloat vecExpApprox(SIMDVectorFloat x)
   SIMDVectorFloat b = _mm_or_ps(_mm_and_ps(VecI2F(val4i), VecI2F(_mm_set1_epi32(0x7FFFFF))),
                                 VecI2F(_mm_set1_epi32(0x3F800000)));
 
-  return _mm_mul_ps(
-      xu,
-      (_mm_add_ps(
-          kExpC4Vec,
-          _mm_mul_ps(
-              b, _mm_add_ps(
-                     kExpC5Vec,
-                     _mm_mul_ps(
-                         b, _mm_add_ps(kExpC6Vec,
-                                       _mm_mul_ps(b, _mm_add_ps(kExpC7Vec,
-                                                                _mm_mul_ps(b, kExpC8Vec))))))))));
+  SIMDVectorFloat y = vecFMA(b, kExpC8Vec, kExpC7Vec);
+  y = vecFMA(y, b, kExpC6Vec);
+  y = vecFMA(y, b, kExpC5Vec);
+  y = vecFMA(y, b, kExpC4Vec);
+  return _mm_mul_ps(xu, y);
 }
 
 STATIC_M128_CONST(kLogC1Vec, -89.970756366f);
@@ -848,18 +940,13 @@ inline SIMDVectorFloat vecLogApprox(SIMDVectorFloat val)
                        VecI2F(_mm_set1_epi32(0x3F800000))));
   SIMDVectorFloat x = VecI2F(valAsIntMasked);
 
-  SIMDVectorFloat poly = _mm_mul_ps(
-      x, _mm_add_ps(
-             kLogC2Vec,
-             _mm_mul_ps(
-                 x, _mm_add_ps(
-                        kLogC3Vec,
-                        _mm_mul_ps(
-                            x, _mm_add_ps(kLogC4Vec,
-                                          _mm_mul_ps(x, _mm_add_ps(kLogC5Vec,
-                                                                   _mm_mul_ps(x, kLogC6Vec)))))))));
-
-  SIMDVectorFloat addCstResult = _mm_add_ps(addcst, _mm_mul_ps(kLogC7Vec, _mm_cvtepi32_ps(expi)));
+  SIMDVectorFloat poly = vecFMA(x, kLogC6Vec, kLogC5Vec);
+  poly = vecFMA(poly, x, kLogC4Vec);
+  poly = vecFMA(poly, x, kLogC3Vec);
+  poly = vecFMA(poly, x, kLogC2Vec);
+  poly = _mm_mul_ps(poly, x);
+
+  SIMDVectorFloat addCstResult = vecFMA(kLogC7Vec, _mm_cvtepi32_ps(expi), addcst);
   return _mm_add_ps(poly, addCstResult);
 }
 
@@ -890,6 +977,14 @@ inline SIMDVectorFloat vecShuffleLeft(SIMDVectorFloat v1, SIMDVectorFloat v2)
   return _mm_shuffle_ps(v1, _mm_shuffle_ps(v1, v2, SHUFFLE(0, 0, 3, 3)), SHUFFLE(3, 0, 2, 1));
 }
 
+// Given vectors [ 0, 1, 2, 3 ], [ 4, 5, 6, 7 ], [ 8, 9, 10, 11 ], [ 12, 13, 14, 15 ]
+// Transposes in place to [ 0, 4, 8, 12 ], [ 1, 5, 9, 13 ], [ 2, 6, 10, 14 ], [ 3, 7, 11, 15 ]
+inline void vecTranspose4(SIMDVectorFloat& v0, SIMDVectorFloat& v1, SIMDVectorFloat& v2,
+                          SIMDVectorFloat& v3)
+{
+  _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+}
+
 // define infix operators for native SSE / MSVC.
 #ifndef ML_SSE_TO_NEON
 #ifdef WIN32
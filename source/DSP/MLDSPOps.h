@@ -87,25 +87,56 @@ inline T* DSPVectorAlignPointer(const T* p)
 // Knowing the array size at compile time helps efficiency by allowing the compiler to
 // unroll loops.
 //
+// DSPVectorArray< ROWS > is DSPVectorArrayN< ROWS, kFloatsPerDSPVector >. Other row
+// lengths (powers of two from 16) can be used in the same program: shorter ones for
+// lower latency, longer ones to spread per-vector overhead over more samples. The ops
+// here work on any length, as long as all their arguments have the same one.
+//
 // Note that "Vector" is used in the mathematical sense of an n-tuple of real values.
 
 namespace ml
 {
-template <size_t ROWS>
-class DSPVectorArray
+// row() and constRow() below return references to rows of a DSPVectorArray as
+// DSPVectorArrays of one row. Without this attribute, GCC and Clang may assume
+// that those references and the whole array can't refer to the same data, and
+// reorder reads and writes through them.
+#if defined(__GNUC__) || defined(__clang__)
+#define ML_MAY_ALIAS __attribute__((__may_alias__))
+#else
+#define ML_MAY_ALIAS
+#endif
+
+// lazy expressions, defined in MLDSPExpressions.h.
+template <class F, class... Args>
+class DSPExpression;
+
+// Pass kUninitialized to a DSPVectorArray or DSPVectorArrayInt constructor to
+// skip zero-filling its data. This is only safe when every element will be
+// written before it is read, as in the outputs of the ops below.
+struct UninitializedTag
+{
+};
+constexpr UninitializedTag kUninitialized{};
+
+template <size_t ROWS, size_t LEN>
+class ML_MAY_ALIAS DSPVectorArrayN
 {
+  static_assert((LEN >= kFloatsPerSIMDVector * 4) && ((LEN & (LEN - 1)) == 0),
+                "DSPVectorArrayN: length must be a power of two, at least 16.");
+  static constexpr size_t kSIMDVectorsPerRow = LEN / kFloatsPerSIMDVector;
+
   // union def'n
 #ifdef MANUAL_ALIGN_DSPVECTOR
   union Data
   {
-    float asFloat[kFloatsPerDSPVector * ROWS + kDSPVectorAlignFloats];
+    float asFloat[LEN * ROWS + kDSPVectorAlignFloats];
 
     Data() {}
 
-    Data(std::array<float, kFloatsPerDSPVector * ROWS> a)
+    Data(std::array<float, LEN * ROWS> a)
     {
       float* py = DSPVectorAlignPointer<float>(this->asFloat);
-      for (int i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
+      for (int i = 0; i < LEN * ROWS; ++i)
       {
         py[i] = a[i];
       }
@@ -114,12 +145,12 @@ class DSPVectorArray
 #else
   union Data
   {
-    SIMDVectorFloat _align[kSIMDVectorsPerDSPVector * ROWS];   // unused except to force alignment
-    std::array<float, kFloatsPerDSPVector * ROWS> arrayData_;  // for constexpr ctor
-    float asFloat[kFloatsPerDSPVector * ROWS];
+    SIMDVectorFloat _align[kSIMDVectorsPerRow * ROWS];  // unused except to force alignment
+    std::array<float, LEN * ROWS> arrayData_;           // for constexpr ctor
+    float asFloat[LEN * ROWS];
 
     Data() {}
-    constexpr Data(std::array<float, kFloatsPerDSPVector * ROWS> a) : arrayData_(a) {}
+    constexpr Data(std::array<float, LEN * ROWS> a) : arrayData_(a) {}
   };
 
 #endif
@@ -137,11 +168,11 @@ class DSPVectorArray
 #endif  // MANUAL_ALIGN_DSPVECTOR
 
   // constexpr constructor taking a std::array. Use with make_array
-  constexpr DSPVectorArray(std::array<float, kFloatsPerDSPVector * ROWS> a) : data_(a) {}
+  constexpr DSPVectorArrayN(std::array<float, LEN * ROWS> a) : data_(a) {}
 
   // constexpr constructor taking a function(int -> float)
-  constexpr DSPVectorArray(float (*fn)(int))
-      : DSPVectorArray(make_array<kFloatsPerDSPVector * ROWS>(fn))
+  constexpr DSPVectorArrayN(float (*fn)(int))
+      : DSPVectorArrayN(make_array<LEN * ROWS>(fn))
   {
   }
 
@@ -149,31 +180,33 @@ class DSPVectorArray
   // rewrite without std::function
 
   // default constructor: zeroes the data.
-  // TODO this seems to be taking a lot of time! investigate
-  DSPVectorArray() { data_.arrayData_.fill(0.f); }
+  DSPVectorArrayN() { data_.arrayData_.fill(0.f); }
+
+  // constructor leaving the data uninitialized.
+  explicit DSPVectorArrayN(UninitializedTag) {}
 
   // conversion constructor to float.  This keeps the syntax of common DSP code
   // shorter: "va + DSPVector(1.f)" becomes just "va + 1.f".
-  DSPVectorArray(float k) { operator=(k); }
+  DSPVectorArrayN(float k) { operator=(k); }
 
   // unaligned data * ctors
-  explicit DSPVectorArray(float* pData) { load(*this, pData); }
-  explicit DSPVectorArray(const float* pData) { load(*this, pData); }
+  explicit DSPVectorArrayN(float* pData) { load(*this, pData); }
+  explicit DSPVectorArrayN(const float* pData) { load(*this, pData); }
 
   // aligned data * ctors
-  explicit DSPVectorArray(DSPVectorArray* pData) { loadAligned(*this, pData); }
-  explicit DSPVectorArray(const DSPVectorArray* pData) { loadAligned(*this, pData); }
+  explicit DSPVectorArrayN(DSPVectorArrayN* pData) { loadAligned(*this, pData); }
+  explicit DSPVectorArrayN(const DSPVectorArrayN* pData) { loadAligned(*this, pData); }
 
   inline float& operator[](size_t i) { return getBuffer()[i]; }
   inline const float operator[](size_t i) const { return getConstBuffer()[i]; }
 
   // = float: set each element of the DSPVectorArray to the float value k.
-  inline DSPVectorArray operator=(float k)
+  inline DSPVectorArrayN& operator=(float k)
   {
     const SIMDVectorFloat vk = vecSet1(k);
     float* py1 = getBuffer();
 
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)
+    for (size_t n = 0; n < kSIMDVectorsPerRow * ROWS; ++n)
     {
       vecStore(py1, vk);
       py1 += kFloatsPerSIMDVector;
@@ -181,18 +214,32 @@ class DSPVectorArray
     return *this;
   }
 
+  // evaluate a lazy expression (see MLDSPExpressions.h) in one pass.
+  template <class F, class... Args>
+  DSPVectorArrayN(const DSPExpression<F, Args...>& e)
+  {
+    e.template evaluate<ROWS, LEN, false>(getBuffer());
+  }
+
+  template <class F, class... Args>
+  inline DSPVectorArrayN& operator=(const DSPExpression<F, Args...>& e)
+  {
+    e.template evaluate<ROWS, LEN, false>(getBuffer());
+    return *this;
+  }
+
   // default copy and = constructors.
 
-  DSPVectorArray(const DSPVectorArray& x1) noexcept = default;
-  DSPVectorArray& operator=(const DSPVectorArray& x1) noexcept = default;
+  DSPVectorArrayN(const DSPVectorArrayN& x1) noexcept = default;
+  DSPVectorArrayN& operator=(const DSPVectorArrayN& x1) noexcept = default;
 
   // equality by value
-  bool operator==(const DSPVectorArray& x1) const
+  bool operator==(const DSPVectorArrayN& x1) const
   {
     const float* px1 = x1.getConstBuffer();
     const float* py1 = getConstBuffer();
 
-    for (int n = 0; n < kFloatsPerDSPVector * ROWS; ++n)
+    for (size_t n = 0; n < LEN * ROWS; ++n)
     {
       if (py1[n] != px1[n]) return false;
     }
@@ -204,7 +251,7 @@ class DSPVectorArray
 
   // return row J from this DSPVectorArray, when J is known at compile time.
   template <int J>
-  inline DSPVectorArray<1> getRowVector() const
+  inline DSPVectorArrayN<1, LEN> getRowVector() const
   {
     static_assert((J >= 0) && (J < ROWS), "getRowVector index out of bounds");
     return getRowVectorUnchecked(J);
@@ -212,7 +259,7 @@ class DSPVectorArray
 
   // set row J of this DSPVectorArray to x1, when J is known at compile time.
   template <int J>
-  inline void setRowVector(const DSPVectorArray<1> x1)
+  inline void setRowVector(const DSPVectorArrayN<1, LEN> x1)
   {
     static_assert((J >= 0) && (J < ROWS), "setRowVector index out of bounds");
     setRowVectorUnchecked(J, x1);
@@ -221,13 +268,13 @@ class DSPVectorArray
 #ifdef MANUAL_ALIGN_DSPVECTOR
 
   // get a row vector j when j is not known at compile time.
-  inline DSPVectorArray<1> getRowVectorUnchecked(size_t j) const
+  inline DSPVectorArrayN<1, LEN> getRowVectorUnchecked(size_t j) const
   {
-    DSPVectorArray<1> vy;
-    const float* px1 = getConstBuffer() + kFloatsPerDSPVector * j;
+    DSPVectorArrayN<1, LEN> vy{kUninitialized};
+    const float* px1 = getConstBuffer() + LEN * j;
     float* py1 = vy.getBuffer();
 
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    for (int n = 0; n < LEN; ++n)
     {
       py1[n] = px1[n];
     }
@@ -235,12 +282,12 @@ class DSPVectorArray
   }
 
   // set a row vector j when j is not known at compile time.
-  inline void setRowVectorUnchecked(size_t j, const DSPVectorArray<1> x1)
+  inline void setRowVectorUnchecked(size_t j, const DSPVectorArrayN<1, LEN> x1)
   {
     const float* px1 = x1.getConstBuffer();
-    float* py1 = getBuffer() + kFloatsPerDSPVector * j;
+    float* py1 = getBuffer() + LEN * j;
 
-    for (int n = 0; n < kFloatsPerDSPVector; ++n)
+    for (int n = 0; n < LEN; ++n)
     {
       py1[n] = px1[n];
     }
@@ -248,13 +295,13 @@ class DSPVectorArray
 #else
 
   // get a row vector j when j is not known at compile time.
-  inline DSPVectorArray<1> getRowVectorUnchecked(size_t j) const
+  inline DSPVectorArrayN<1, LEN> getRowVectorUnchecked(size_t j) const
   {
-    DSPVectorArray<1> vy;
-    const float* px1 = getConstBuffer() + kFloatsPerDSPVector * j;
+    DSPVectorArrayN<1, LEN> vy{kUninitialized};
+    const float* px1 = getConstBuffer() + LEN * j;
     float* py1 = vy.getBuffer();
 
-    for (int n = 0; n < kSIMDVectorsPerDSPVector; ++n)
+    for (size_t n = 0; n < kSIMDVectorsPerRow; ++n)
     {
       vecStore(py1, vecLoad(px1));
       px1 += kFloatsPerSIMDVector;
@@ -264,12 +311,12 @@ class DSPVectorArray
   }
 
   // set a row vector j when j is not known at compile time.
-  inline void setRowVectorUnchecked(size_t j, const DSPVectorArray<1> x1)
+  inline void setRowVectorUnchecked(size_t j, const DSPVectorArrayN<1, LEN> x1)
   {
     const float* px1 = x1.getConstBuffer();
-    float* py1 = getBuffer() + kFloatsPerDSPVector * j;
+    float* py1 = getBuffer() + LEN * j;
 
-    for (int n = 0; n < kSIMDVectorsPerDSPVector; ++n)
+    for (size_t n = 0; n < kSIMDVectorsPerRow; ++n)
     {
       vecStore(py1, vecLoad(px1));
       px1 += kFloatsPerSIMDVector;
@@ -282,49 +329,49 @@ class DSPVectorArray
   // DSPVectorArray.
   inline const float* getRowDataConst(int j) const
   {
-    const float* py1 = getConstBuffer() + kFloatsPerDSPVector * j;
+    const float* py1 = getConstBuffer() + LEN * j;
     return py1;
   }
 
   // return a pointer to the first element in row J of this DSPVectorArray.
   inline float* getRowData(int j)
   {
-    float* py1 = getBuffer() + kFloatsPerDSPVector * j;
+    float* py1 = getBuffer() + LEN * j;
     return py1;
   }
 
   // return a reference to a row of this DSPVectorArray.
-  inline DSPVectorArray<1>& row(int j)
+  inline DSPVectorArrayN<1, LEN>& row(int j)
   {
-    float* py1 = getBuffer() + kFloatsPerDSPVector * j;
-    DSPVectorArray<1>* pRow = reinterpret_cast<DSPVectorArray<1>*>(py1);
+    float* py1 = getBuffer() + LEN * j;
+    DSPVectorArrayN<1, LEN>* pRow = reinterpret_cast<DSPVectorArrayN<1, LEN>*>(py1);
     return *pRow;
   }
 
   // return a const reference to a row of this DSPVectorArray.
-  inline const DSPVectorArray<1>& constRow(int j) const
+  inline const DSPVectorArrayN<1, LEN>& constRow(int j) const
   {
-    const float* py1 = getConstBuffer() + kFloatsPerDSPVector * j;
-    const DSPVectorArray<1>* pRow = reinterpret_cast<const DSPVectorArray<1>*>(py1);
+    const float* py1 = getConstBuffer() + LEN * j;
+    const DSPVectorArrayN<1, LEN>* pRow = reinterpret_cast<const DSPVectorArrayN<1, LEN>*>(py1);
     return *pRow;
   }
 
-  inline DSPVectorArray& operator+=(const DSPVectorArray& x1)
+  inline DSPVectorArrayN& operator+=(const DSPVectorArrayN& x1)
   {
     *this = add(*this, x1);
     return *this;
   }
-  inline DSPVectorArray& operator-=(const DSPVectorArray& x1)
+  inline DSPVectorArrayN& operator-=(const DSPVectorArrayN& x1)
   {
     *this = subtract(*this, x1);
     return *this;
   }
-  inline DSPVectorArray& operator*=(const DSPVectorArray& x1)
+  inline DSPVectorArrayN& operator*=(const DSPVectorArrayN& x1)
   {
     *this = multiply(*this, x1);
     return *this;
   }
-  inline DSPVectorArray& operator/=(const DSPVectorArray& x1)
+  inline DSPVectorArrayN& operator/=(const DSPVectorArrayN& x1)
   {
     *this = divide(*this, x1);
     return *this;
@@ -334,23 +381,28 @@ class DSPVectorArray
   // functions enables the compiler to call implicit conversions on either
   // argument.
 
-  friend inline DSPVectorArray operator+(const DSPVectorArray& x1, const DSPVectorArray& x2)
+  friend inline DSPVectorArrayN operator+(const DSPVectorArrayN& x1, const DSPVectorArrayN& x2)
   {
     return add(x1, x2);
   }
-  friend inline DSPVectorArray operator-(const DSPVectorArray& x1, const DSPVectorArray& x2)
+  friend inline DSPVectorArrayN operator-(const DSPVectorArrayN& x1, const DSPVectorArrayN& x2)
   {
     return subtract(x1, x2);
   }
-  friend inline DSPVectorArray operator*(const DSPVectorArray& x1, const DSPVectorArray& x2)
+  friend inline DSPVectorArrayN operator*(const DSPVectorArrayN& x1, const DSPVectorArrayN& x2)
   {
     return multiply(x1, x2);
   }
-  friend inline DSPVectorArray operator/(const DSPVectorArray& x1, const DSPVectorArray& x2)
+  friend inline DSPVectorArrayN operator/(const DSPVectorArrayN& x1, const DSPVectorArrayN& x2)
   {
     return divide(x1, x2);
   }
-};  // class DSPVectorArray
+};  // class DSPVectorArrayN
+
+// DSPVectorArray: a DSPVectorArrayN with the default length,
+// kFloatsPerDSPVector. Code that does not care about the length can use this.
+template <size_t ROWS>
+using DSPVectorArray = DSPVectorArrayN<ROWS, kFloatsPerDSPVector>;
 
 // ----------------------------------------------------------------
 // DSPVector
@@ -360,6 +412,10 @@ class DSPVectorArray
 
 typedef DSPVectorArray<1> DSPVector;
 
+// a single row of any length.
+template <size_t LEN>
+using DSPVectorN = DSPVectorArrayN<1, LEN>;
+
 // ----------------------------------------------------------------
 // DSPVectorArrayInt
 //
@@ -367,22 +423,26 @@ typedef DSPVectorArray<1> DSPVector;
 
 constexpr size_t kIntsPerDSPVector = kFloatsPerDSPVector;
 
-template <size_t ROWS>
-class DSPVectorArrayInt
+template <size_t ROWS, size_t LEN>
+class ML_MAY_ALIAS DSPVectorArrayIntN
 {
+  static_assert((LEN >= kIntsPerSIMDVector * 4) && ((LEN & (LEN - 1)) == 0),
+                "DSPVectorArrayIntN: length must be a power of two, at least 16.");
+  static constexpr size_t kSIMDVectorsPerRow = LEN / kIntsPerSIMDVector;
+
 #ifdef MANUAL_ALIGN_DSPVECTOR
   union Data
   {
-    std::array<int, kIntsPerDSPVector * ROWS + kDSPVectorAlignInts> mArrayData;
-    int32_t asInt[kIntsPerDSPVector * ROWS + kDSPVectorAlignInts];
-    float asFloat[kFloatsPerDSPVector * ROWS + kDSPVectorAlignFloats];
+    std::array<int, LEN * ROWS + kDSPVectorAlignInts> mArrayData;
+    int32_t asInt[LEN * ROWS + kDSPVectorAlignInts];
+    float asFloat[LEN * ROWS + kDSPVectorAlignFloats];
 
     Data() {}
 
-    Data(std::array<int, kIntsPerDSPVector * ROWS> a)
+    Data(std::array<int, LEN * ROWS> a)
     {
       int* py = DSPVectorAlignPointer<int>(this->asFloat);
-      for (int i = 0; i < kIntsPerDSPVector * ROWS; ++i)
+      for (int i = 0; i < LEN * ROWS; ++i)
       {
         py[i] = a[i];
       }
@@ -391,13 +451,13 @@ class DSPVectorArrayInt
 #else
   union Data
   {
-    SIMDVectorInt _align[kSIMDVectorsPerDSPVector * ROWS];     // unused except to force alignment
-    std::array<int32_t, kIntsPerDSPVector * ROWS> arrayData_;  // for constexpr ctor
-    int32_t asInt[kIntsPerDSPVector * ROWS];
-    float asFloat[kFloatsPerDSPVector * ROWS];
+    SIMDVectorInt _align[kSIMDVectorsPerRow * ROWS];  // unused except to force alignment
+    std::array<int32_t, LEN * ROWS> arrayData_;       // for constexpr ctor
+    int32_t asInt[LEN * ROWS];
+    float asFloat[LEN * ROWS];
 
     Data() {}
-    constexpr Data(std::array<int32_t, kIntsPerDSPVector * ROWS> a) : arrayData_(a) {}
+    constexpr Data(std::array<int32_t, LEN * ROWS> a) : arrayData_(a) {}
   };
 #endif  // MANUAL_ALIGN_DSPVECTOR
 
@@ -420,19 +480,34 @@ class DSPVectorArrayInt
   inline const int32_t* getConstBufferInt() const { return data_.asInt; }
 #endif  // MANUAL_ALIGN_DSPVECTOR
 
-  explicit DSPVectorArrayInt() { operator=(0); }
-  explicit DSPVectorArrayInt(int32_t k) { operator=(k); }
+  explicit DSPVectorArrayIntN() { operator=(0); }
+  explicit DSPVectorArrayIntN(int32_t k) { operator=(k); }
+  explicit DSPVectorArrayIntN(UninitializedTag) {}
+
+  // evaluate a lazy expression (see MLDSPExpressions.h) in one pass.
+  template <class F, class... Args>
+  DSPVectorArrayIntN(const DSPExpression<F, Args...>& e)
+  {
+    e.template evaluate<ROWS, LEN, true>(getBuffer());
+  }
+
+  template <class F, class... Args>
+  inline DSPVectorArrayIntN& operator=(const DSPExpression<F, Args...>& e)
+  {
+    e.template evaluate<ROWS, LEN, true>(getBuffer());
+    return *this;
+  }
 
   inline int32_t& operator[](int i) { return getBufferInt()[i]; }
   inline const int32_t operator[](int i) const { return getConstBufferInt()[i]; }
 
   // set each element of the DSPVectorArray to the int32_t value k.
-  inline DSPVectorArrayInt operator=(int32_t k)
+  inline DSPVectorArrayIntN& operator=(int32_t k)
   {
     SIMDVectorFloat vk = VecI2F(vecSetInt1(k));
     int32_t* py1 = getBufferInt();
 
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)
+    for (size_t n = 0; n < kSIMDVectorsPerRow * ROWS; ++n)
     {
       vecStore(reinterpret_cast<float*>(py1), vk);
       py1 += kIntsPerSIMDVector;
@@ -441,24 +516,24 @@ class DSPVectorArrayInt
   }
 
   // constexpr constructor taking a std::array. Use with make_array
-  constexpr DSPVectorArrayInt(std::array<int32_t, kFloatsPerDSPVector * ROWS> a) : data_(a) {}
+  constexpr DSPVectorArrayIntN(std::array<int32_t, LEN * ROWS> a) : data_(a) {}
 
   // constexpr constructor taking a function(int -> int)
-  constexpr DSPVectorArrayInt(int (*fn)(int))
-      : DSPVectorArrayInt(make_array<kFloatsPerDSPVector * ROWS>(fn))
+  constexpr DSPVectorArrayIntN(int (*fn)(int))
+      : DSPVectorArrayIntN(make_array<LEN * ROWS>(fn))
   {
   }
 
-  DSPVectorArrayInt(const DSPVectorArrayInt& x1) noexcept = default;
-  DSPVectorArrayInt& operator=(const DSPVectorArrayInt& x1) noexcept = default;
+  DSPVectorArrayIntN(const DSPVectorArrayIntN& x1) noexcept = default;
+  DSPVectorArrayIntN& operator=(const DSPVectorArrayIntN& x1) noexcept = default;
 
   // equality by value
-  bool operator==(const DSPVectorArrayInt& x1)
+  bool operator==(const DSPVectorArrayIntN& x1) const
   {
     const int* px1 = x1.getConstBufferInt();
     const int* py1 = getConstBufferInt();
 
-    for (int n = 0; n < kIntsPerDSPVector * ROWS; ++n)
+    for (size_t n = 0; n < LEN * ROWS; ++n)
     {
       if (py1[n] != px1[n]) return false;
     }
@@ -466,37 +541,52 @@ class DSPVectorArrayInt
   }
 
   // return a reference to a row of this DSPVectorArrayInt.
-  inline DSPVectorArrayInt<1>& row(int j)
+  inline DSPVectorArrayIntN<1, LEN>& row(int j)
   {
-    float* py1 = getBuffer() + kIntsPerDSPVector * j;
-    DSPVectorArrayInt<1>* pRow = reinterpret_cast<DSPVectorArrayInt<1>*>(py1);
+    float* py1 = getBuffer() + LEN * j;
+    DSPVectorArrayIntN<1, LEN>* pRow = reinterpret_cast<DSPVectorArrayIntN<1, LEN>*>(py1);
     return *pRow;
   }
 
   // return a reference to a row of this DSPVectorArrayInt.
-  inline const DSPVectorArrayInt<1>& constRow(int j) const
+  inline const DSPVectorArrayIntN<1, LEN>& constRow(int j) const
   {
-    const float* py1 = getConstBuffer() + kIntsPerDSPVector * j;
-    const DSPVectorArrayInt<1>* pRow = reinterpret_cast<const DSPVectorArrayInt<1>*>(py1);
+    const float* py1 = getConstBuffer() + LEN * j;
+    const DSPVectorArrayIntN<1, LEN>* pRow =
+        reinterpret_cast<const DSPVectorArrayIntN<1, LEN>*>(py1);
     return *pRow;
   }
 
-  friend inline DSPVectorArrayInt operator+(const DSPVectorArrayInt& x1,
-                                            const DSPVectorArrayInt& x2)
+  friend inline DSPVectorArrayIntN operator+(const DSPVectorArrayIntN& x1,
+                                             const DSPVectorArrayIntN& x2)
   {
     return addInt32(x1, x2);
   }
 
-  friend inline DSPVectorArrayInt operator-(const DSPVectorArrayInt& x1,
-                                            const DSPVectorArrayInt& x2)
+  friend inline DSPVectorArrayIntN operator-(const DSPVectorArrayIntN& x1,
+                                             const DSPVectorArrayIntN& x2)
   {
     return subtractInt32(x1, x2);
   }
 
-};  // class DSPVectorArrayInt
+};  // class DSPVectorArrayIntN
+
+template <size_t ROWS>
+using DSPVectorArrayInt = DSPVectorArrayIntN<ROWS, kIntsPerDSPVector>;
 
 typedef DSPVectorArrayInt<1> DSPVectorInt;
 
+template <size_t LEN>
+using DSPVectorIntN = DSPVectorArrayIntN<1, LEN>;
+
+// DSPVectorArrays are plain data, copied by the defaulted copy constructor and
+// assignment. Rows handed out by row() and constRow() rely on ML_MAY_ALIAS
+// rather than on custom copies, so the copies can stay trivial.
+static_assert(std::is_trivially_copyable<DSPVectorArray<2> >::value,
+              "DSPVectorArray should be trivially copyable.");
+static_assert(std::is_trivially_copyable<DSPVectorArrayInt<2> >::value,
+              "DSPVectorArrayInt should be trivially copyable.");
+
 // ----------------------------------------------------------------
 // DSPVectorDynamic: for holding a number of DSPVectors only known at runtime.
 
@@ -520,26 +610,26 @@ class DSPVectorDynamic final
 // load and store
 
 // some loads and stores may be unaligned, let std::copy handle this
-template <size_t ROWS>
-inline void load(DSPVectorArray<ROWS>& vecDest, const float* pSrc)
+template <size_t ROWS, size_t LEN>
+inline void load(DSPVectorArrayN<ROWS, LEN>& vecDest, const float* pSrc)
 {
-  std::copy(pSrc, pSrc + kFloatsPerDSPVector * ROWS, vecDest.getBuffer());
+  std::copy(pSrc, pSrc + LEN * ROWS, vecDest.getBuffer());
 }
 
-template <size_t ROWS>
-inline void store(const DSPVectorArray<ROWS>& vecSrc, float* pDest)
+template <size_t ROWS, size_t LEN>
+inline void store(const DSPVectorArrayN<ROWS, LEN>& vecSrc, float* pDest)
 {
-  std::copy(vecSrc.getConstBuffer(), vecSrc.getConstBuffer() + kFloatsPerDSPVector * ROWS, pDest);
+  std::copy(vecSrc.getConstBuffer(), vecSrc.getConstBuffer() + LEN * ROWS, pDest);
 }
 
 // if the pointers are known to be aligned, copy as SIMD vectors
-template <size_t ROWS>
-inline void loadAligned(DSPVectorArray<ROWS>& vecDest, const float* pSrc)
+template <size_t ROWS, size_t LEN>
+inline void loadAligned(DSPVectorArrayN<ROWS, LEN>& vecDest, const float* pSrc)
 {
   const float* px1 = pSrc;
   float* py1 = vecDest.getBuffer();
 
-  for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)
+  for (int n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)
   {
     vecStore(py1, vecLoad(px1));
     px1 += kFloatsPerSIMDVector;
@@ -547,13 +637,13 @@ inline void loadAligned(DSPVectorArray<ROWS>& vecDest, const float* pSrc)
   }
 }
 
-template <size_t ROWS>
-inline void storeAligned(const DSPVectorArray<ROWS>& vecSrc, float* pDest)
+template <size_t ROWS, size_t LEN>
+inline void storeAligned(const DSPVectorArrayN<ROWS, LEN>& vecSrc, float* pDest)
 {
   const float* px1 = vecSrc.getConstBuffer();
   float* py1 = pDest;
 
-  for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)
+  for (int n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)
   {
     vecStore(py1, vecLoad(px1));
     px1 += kFloatsPerSIMDVector;
@@ -564,26 +654,55 @@ inline void storeAligned(const DSPVectorArray<ROWS>& vecSrc, float* pDest)
 // ----------------------------------------------------------------
 // unary vector operators (float) -> float
 
-#define DEFINE_OP1(opName, opComputation)                              \
-  template <size_t ROWS>                                               \
-  inline DSPVectorArray<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1) \
-  {                                                                    \
-    DSPVectorArray<ROWS> vy;                                           \
-    const float* px1 = vx1.getConstBuffer();                           \
-    float* py1 = vy.getBuffer();                                       \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)          \
-    {                                                                  \
-      SIMDVectorFloat x = vecLoad(px1);                                \
-      vecStore(py1, (opComputation));                                  \
-      px1 += kFloatsPerSIMDVector;                                     \
-      py1 += kFloatsPerSIMDVector;                                     \
-    }                                                                  \
-    return vy;                                                         \
-  }
-
-DEFINE_OP1(sqrt, (vecSqrt(x)));
+#define DEFINE_OP1(opName, opComputation)                                          \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)               \
+    {                                                                              \
+      SIMDVectorFloat x = vecLoad(px1);                                            \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+// unary operators that can use the widest SIMD kernels available at runtime.
+// see MLDSPMathDispatch.h.
+
+#define DEFINE_OP1_KERNEL(opName, kernelName, opComputation)                       \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    if constexpr (useSIMDKernels<LEN * ROWS>())                                    \
+    {                                                                              \
+      const SIMDKernels& k = getSIMDKernels();                                     \
+      if (k.level != kSIMDLevelBase)                                               \
+      {                                                                            \
+        k.kernelName(px1, py1, LEN * ROWS);                                        \
+        return vy;                                                                 \
+      }                                                                            \
+    }                                                                              \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)               \
+    {                                                                              \
+      SIMDVectorFloat x = vecLoad(px1);                                            \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+DEFINE_OP1_KERNEL(sqrt, sqrt, (vecSqrt(x)));
 DEFINE_OP1(sqrtApprox, vecSqrtApprox(x));
-DEFINE_OP1(abs, vecAbs(x));
+DEFINE_OP1_KERNEL(abs, abs, vecAbs(x));
 
 // float sign: -1, 0, or 1
 DEFINE_OP1(sign, vecSign(x));
@@ -592,10 +711,10 @@ DEFINE_OP1(sign, vecSign(x));
 DEFINE_OP1(signBit, vecSignBit(x));
 
 // trig, log and exp, using accurate cephes-derived library
-DEFINE_OP1(sin, (vecSin(x)));
-DEFINE_OP1(cos, (vecCos(x)));
-DEFINE_OP1(log, (vecLog(x)));
-DEFINE_OP1(exp, (vecExp(x)));
+DEFINE_OP1_KERNEL(sin, sin, (vecSin(x)));
+DEFINE_OP1_KERNEL(cos, cos, (vecCos(x)));
+DEFINE_OP1_KERNEL(log, log, (vecLog(x)));
+DEFINE_OP1_KERNEL(exp, exp, (vecExp(x)));
 
 // lazy log2 and exp2 from natural log / exp
 STATIC_M128_CONST(kLogTwoVec, 0.69314718055994529f);
@@ -616,63 +735,93 @@ DEFINE_OP1(exp2Approx, (vecExpApprox(vecMul(kLogTwoVec, x))));
 // ----------------------------------------------------------------
 // binary vector operators (float, float) -> float
 
-#define DEFINE_OP2(opName, opComputation)                              \
-  template <size_t ROWS>                                               \
-  inline DSPVectorArray<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1, \
-                                      const DSPVectorArray<ROWS>& vx2) \
-  {                                                                    \
-    DSPVectorArray<ROWS> vy;                                           \
-    const float* px1 = vx1.getConstBuffer();                           \
-    const float* px2 = vx2.getConstBuffer();                           \
-    float* py1 = vy.getBuffer();                                       \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)          \
-    {                                                                  \
-      SIMDVectorFloat x1 = vecLoad(px1);                               \
-      SIMDVectorFloat x2 = vecLoad(px2);                               \
-      vecStore(py1, (opComputation));                                  \
-      px1 += kFloatsPerSIMDVector;                                     \
-      px2 += kFloatsPerSIMDVector;                                     \
-      py1 += kFloatsPerSIMDVector;                                     \
-    }                                                                  \
-    return vy;                                                         \
-  }
-
-DEFINE_OP2(add, (vecAdd(x1, x2)));
-DEFINE_OP2(subtract, (vecSub(x1, x2)));
-DEFINE_OP2(multiply, (vecMul(x1, x2)));
-DEFINE_OP2(divide, (vecDiv(x1, x2)));
+#define DEFINE_OP2(opName, opComputation)                                          \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx2) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    const float* px2 = vx2.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    for (int n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      SIMDVectorFloat x2 = vecLoad(px2);                                           \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      px2 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+#define DEFINE_OP2_KERNEL(opName, kernelName, opComputation)                       \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx2) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    const float* px2 = vx2.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    if constexpr (useSIMDKernels<LEN * ROWS>())                                    \
+    {                                                                              \
+      const SIMDKernels& k = getSIMDKernels();                                     \
+      if (k.level != kSIMDLevelBase)                                               \
+      {                                                                            \
+        k.kernelName(px1, px2, py1, LEN * ROWS);                                   \
+        return vy;                                                                 \
+      }                                                                            \
+    }                                                                              \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)               \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      SIMDVectorFloat x2 = vecLoad(px2);                                           \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      px2 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+DEFINE_OP2_KERNEL(add, add, (vecAdd(x1, x2)));
+DEFINE_OP2_KERNEL(subtract, subtract, (vecSub(x1, x2)));
+DEFINE_OP2_KERNEL(multiply, multiply, (vecMul(x1, x2)));
+DEFINE_OP2_KERNEL(divide, divide, (vecDiv(x1, x2)));
 
 DEFINE_OP2(divideApprox, vecDivApprox(x1, x2));
 DEFINE_OP2(pow, (vecExp(vecMul(vecLog(x1), x2))));
 DEFINE_OP2(powApprox, (vecExpApprox(vecMul(vecLogApprox(x1), x2))));
-DEFINE_OP2(min, (vecMin(x1, x2)));
-DEFINE_OP2(max, (vecMax(x1, x2)));
+DEFINE_OP2_KERNEL(min, min, (vecMin(x1, x2)));
+DEFINE_OP2_KERNEL(max, max, (vecMax(x1, x2)));
 
 // ----------------------------------------------------------------
 // binary vector operators (float, float) -> float
 // from multiple-row and single-row operands
 
-#define DEFINE_OP2_MS(opName, opComputation)                           \
-  template <size_t ROWS>                                               \
-  inline DSPVectorArray<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1, \
-                                      const DSPVectorArray<1>& vx2)    \
-  {                                                                    \
-    DSPVectorArray<ROWS> vy;                                           \
-    const float* px1 = vx1.getConstBuffer();                           \
-    const float* px2 = vx2.getConstBuffer();                           \
-    float* py1 = vy.getBuffer();                                       \
-    size_t px2Offset = 0;                                              \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)          \
-    {                                                                  \
-      SIMDVectorFloat x1 = vecLoad(px1);                               \
-      SIMDVectorFloat x2 = vecLoad(px2 + px2Offset);                   \
-      vecStore(py1, (opComputation));                                  \
-      px1 += kFloatsPerSIMDVector;                                     \
-      px2Offset += kFloatsPerSIMDVector;                               \
-      px2Offset &= kFloatsPerDSPVector - 1;                            \
-      py1 += kFloatsPerSIMDVector;                                     \
-    }                                                                  \
-    return vy;                                                         \
+#define DEFINE_OP2_MS(opName, opComputation)                                       \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            const DSPVectorArrayN<1, LEN>& vx2)    \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    const float* px2 = vx2.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    size_t px2Offset = 0;                                                          \
+    for (int n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      SIMDVectorFloat x2 = vecLoad(px2 + px2Offset);                               \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      px2Offset += kFloatsPerSIMDVector;                                           \
+      px2Offset &= LEN - 1;                                                        \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
   }
 
 DEFINE_OP2_MS(add1, (vecAdd(x1, x2)));
@@ -689,25 +838,25 @@ DEFINE_OP2_MS(max1, (vecMax(x1, x2)));
 // ----------------------------------------------------------------
 // binary vector operators (int32, int32) -> int32
 
-#define DEFINE_OP2_INT32(opName, opComputation)                              \
-  template <size_t ROWS>                                                     \
-  inline DSPVectorArrayInt<ROWS>(opName)(const DSPVectorArrayInt<ROWS>& vx1, \
-                                         const DSPVectorArrayInt<ROWS>& vx2) \
-  {                                                                          \
-    DSPVectorArrayInt<ROWS> vy;                                              \
-    const float* px1 = vx1.getConstBuffer();                                 \
-    const float* px2 = vx2.getConstBuffer();                                 \
-    float* py1 = vy.getBuffer();                                             \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)                \
-    {                                                                        \
-      SIMDVectorInt x1 = VecF2I(vecLoad(px1));                               \
-      SIMDVectorInt x2 = VecF2I(vecLoad(px2));                               \
-      vecStore(py1, VecI2F(opComputation));                                  \
-      px1 += kIntsPerSIMDVector;                                             \
-      px2 += kIntsPerSIMDVector;                                             \
-      py1 += kIntsPerSIMDVector;                                             \
-    }                                                                        \
-    return vy;                                                               \
+#define DEFINE_OP2_INT32(opName, opComputation)                                          \
+  template <size_t ROWS, size_t LEN>                                                     \
+  inline DSPVectorArrayIntN<ROWS, LEN>(opName)(const DSPVectorArrayIntN<ROWS, LEN>& vx1, \
+                                               const DSPVectorArrayIntN<ROWS, LEN>& vx2) \
+  {                                                                                      \
+    DSPVectorArrayIntN<ROWS, LEN> vy{kUninitialized};                                    \
+    const float* px1 = vx1.getConstBuffer();                                             \
+    const float* px2 = vx2.getConstBuffer();                                             \
+    float* py1 = vy.getBuffer();                                                         \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                     \
+    {                                                                                    \
+      SIMDVectorInt x1 = VecF2I(vecLoad(px1));                                           \
+      SIMDVectorInt x2 = VecF2I(vecLoad(px2));                                           \
+      vecStore(py1, VecI2F(opComputation));                                              \
+      px1 += kIntsPerSIMDVector;                                                         \
+      px2 += kIntsPerSIMDVector;                                                         \
+      py1 += kIntsPerSIMDVector;                                                         \
+    }                                                                                    \
+    return vy;                                                                           \
   }
 
 DEFINE_OP2_INT32(subtractInt32, (vecSubInt(x1, x2)));
@@ -716,56 +865,146 @@ DEFINE_OP2_INT32(addInt32, (vecAddInt(x1, x2)));
 // ----------------------------------------------------------------
 // ternary vector operators (float, float, float) -> float
 
-#define DEFINE_OP3(opName, opComputation)                              \
-  template <size_t ROWS>                                               \
-  inline DSPVectorArray<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1, \
-                                      const DSPVectorArray<ROWS>& vx2, \
-                                      const DSPVectorArray<ROWS>& vx3) \
-  {                                                                    \
-    DSPVectorArray<ROWS> vy;                                           \
-    const float* px1 = vx1.getConstBuffer();                           \
-    const float* px2 = vx2.getConstBuffer();                           \
-    const float* px3 = vx3.getConstBuffer();                           \
-    float* py1 = vy.getBuffer();                                       \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)          \
-    {                                                                  \
-      SIMDVectorFloat x1 = vecLoad(px1);                               \
-      SIMDVectorFloat x2 = vecLoad(px2);                               \
-      SIMDVectorFloat x3 = vecLoad(px3);                               \
-      vecStore(py1, (opComputation));                                  \
-      px1 += kFloatsPerSIMDVector;                                     \
-      px2 += kFloatsPerSIMDVector;                                     \
-      px3 += kFloatsPerSIMDVector;                                     \
-      py1 += kFloatsPerSIMDVector;                                     \
-    }                                                                  \
-    return vy;                                                         \
-  }
-
-DEFINE_OP3(lerp, vecAdd(x1, (vecMul(x3, vecSub(x2, x1)))));       // x = lerp(a, b, mix)
+#define DEFINE_OP3(opName, opComputation)                                          \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx2, \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx3) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    const float* px2 = vx2.getConstBuffer();                                       \
+    const float* px3 = vx3.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    for (int n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      SIMDVectorFloat x2 = vecLoad(px2);                                           \
+      SIMDVectorFloat x3 = vecLoad(px3);                                           \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      px2 += kFloatsPerSIMDVector;                                                 \
+      px3 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+#define DEFINE_OP3_KERNEL(opName, kernelName, opComputation)                       \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx2, \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx3) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    const float* px2 = vx2.getConstBuffer();                                       \
+    const float* px3 = vx3.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    if constexpr (useSIMDKernels<LEN * ROWS>())                                    \
+    {                                                                              \
+      const SIMDKernels& k = getSIMDKernels();                                     \
+      if (k.level != kSIMDLevelBase)                                               \
+      {                                                                            \
+        k.kernelName(px1, px2, px3, py1, LEN * ROWS);                              \
+        return vy;                                                                 \
+      }                                                                            \
+    }                                                                              \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)               \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      SIMDVectorFloat x2 = vecLoad(px2);                                           \
+      SIMDVectorFloat x3 = vecLoad(px3);                                           \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      px2 += kFloatsPerSIMDVector;                                                 \
+      px3 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+DEFINE_OP3_KERNEL(lerp, lerp, vecFMA(x3, vecSub(x2, x1), x1));  // x = lerp(a, b, mix)
 DEFINE_OP3(inverseLerp, vecDiv(vecSub(x3, x1), vecSub(x2, x1)));  // mix = inverseLerp(a, b, x)
 
-DEFINE_OP3(clamp, vecClamp(x1, x2, x3));    // clamp(x, minBound, maxBound)
+DEFINE_OP3_KERNEL(clamp, clamp, vecClamp(x1, x2, x3));  // clamp(x, minBound, maxBound)
 DEFINE_OP3(within, vecWithin(x1, x2, x3));  // is x in the open interval [x2, x3) ?
 
+// fused multiply-add ops. With hardware FMA these round only once, so they are
+// more accurate than a separate multiply and add as well as faster.
+DEFINE_OP3_KERNEL(multiplyAdd, multiplyAdd, vecFMA(x1, x2, x3));  // a * b + c
+DEFINE_OP3_KERNEL(multiplySubtract, multiplySubtract, vecFMS(x1, x2, x3));  // a * b - c
+
+// ----------------------------------------------------------------
+// ternary vector operators with the second argument, or the second and third
+// arguments, broadcast from scalar floats.
+
+#define DEFINE_OP3_VSV(opName, opComputation)                                      \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            float k2,                              \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx3) \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    const float* px3 = vx3.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    const SIMDVectorFloat x2 = vecSet1(k2);                                        \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)               \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      SIMDVectorFloat x3 = vecLoad(px3);                                           \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      px3 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+#define DEFINE_OP3_VSS(opName, opComputation)                                      \
+  template <size_t ROWS, size_t LEN>                                               \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                            float k2, float k3)                    \
+  {                                                                                \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                       \
+    float* py1 = vy.getBuffer();                                                   \
+    const SIMDVectorFloat x2 = vecSet1(k2);                                        \
+    const SIMDVectorFloat x3 = vecSet1(k3);                                        \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)               \
+    {                                                                              \
+      SIMDVectorFloat x1 = vecLoad(px1);                                           \
+      vecStore(py1, (opComputation));                                              \
+      px1 += kFloatsPerSIMDVector;                                                 \
+      py1 += kFloatsPerSIMDVector;                                                 \
+    }                                                                              \
+    return vy;                                                                     \
+  }
+
+DEFINE_OP3_VSV(multiplyAdd, vecFMA(x1, x2, x3));       // a * k + c
+DEFINE_OP3_VSV(multiplySubtract, vecFMS(x1, x2, x3));  // a * k - c
+DEFINE_OP3_VSS(multiplyAdd, vecFMA(x1, x2, x3));       // a * k + j
+DEFINE_OP3_VSS(multiplySubtract, vecFMS(x1, x2, x3));  // a * k - j
+
 // ----------------------------------------------------------------
 // lerp two vectors with scalar float mixture (constant over each vector)
 
-template <size_t ROWS>
-inline DSPVectorArray<ROWS> lerp(const DSPVectorArray<ROWS>& vx1, const DSPVectorArray<ROWS>& vx2,
-                                 float m)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> lerp(const DSPVectorArrayN<ROWS, LEN>& vx1,
+                                       const DSPVectorArrayN<ROWS, LEN>& vx2, float m)
 {
-  DSPVectorArray<ROWS> vy;
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
   const float* px1 = vx1.getConstBuffer();
   const float* px2 = vx2.getConstBuffer();
-  DSPVector vmix(m);
   float* py1 = vy.getBuffer();
   const SIMDVectorFloat vConstMix = vecSet1(m);
 
-  for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)
+  for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)
   {
     SIMDVectorFloat x1 = vecLoad(px1);
     SIMDVectorFloat x2 = vecLoad(px2);
-    vecStore(py1, vecAdd(x1, (vecMul(vConstMix, vecSub(x2, x1)))));
+    vecStore(py1, vecFMA(vConstMix, vecSub(x2, x1), x1));
     px1 += kFloatsPerSIMDVector;
     px2 += kFloatsPerSIMDVector;
     py1 += kFloatsPerSIMDVector;
@@ -776,21 +1015,21 @@ inline DSPVectorArray<ROWS> lerp(const DSPVectorArray<ROWS>& vx1, const DSPVecto
 // ----------------------------------------------------------------
 // vector operators (float) -> int
 
-#define DEFINE_OP1_F2I(opName, opComputation)                             \
-  template <size_t ROWS>                                                  \
-  inline DSPVectorArrayInt<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1) \
-  {                                                                       \
-    DSPVectorArrayInt<ROWS> vy;                                           \
-    const float* px1 = vx1.getConstBuffer();                              \
-    float* py1 = vy.getBuffer();                                          \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)             \
-    {                                                                     \
-      SIMDVectorFloat x = vecLoad(px1);                                   \
-      vecStore((py1), (opComputation));                                   \
-      px1 += kFloatsPerSIMDVector;                                        \
-      py1 += kIntsPerSIMDVector;                                          \
-    }                                                                     \
-    return vy;                                                            \
+#define DEFINE_OP1_F2I(opName, opComputation)                                         \
+  template <size_t ROWS, size_t LEN>                                                  \
+  inline DSPVectorArrayIntN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1) \
+  {                                                                                   \
+    DSPVectorArrayIntN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                          \
+    float* py1 = vy.getBuffer();                                                      \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                                 \
+      SIMDVectorFloat x = vecLoad(px1);                                               \
+      vecStore((py1), (opComputation));                                               \
+      px1 += kFloatsPerSIMDVector;                                                    \
+      py1 += kIntsPerSIMDVector;                                                      \
+    }                                                                                 \
+    return vy;                                                                        \
   }
 
 DEFINE_OP1_F2I(roundFloatToInt, (VecI2F(vecFloatToIntRound(x))));
@@ -799,21 +1038,21 @@ DEFINE_OP1_F2I(truncateFloatToInt, (VecI2F(vecFloatToIntTruncate(x))));
 // ----------------------------------------------------------------
 // vector operators (int) -> float
 
-#define DEFINE_OP1_I2F(opName, opComputation)                             \
-  template <size_t ROWS>                                                  \
-  inline DSPVectorArray<ROWS>(opName)(const DSPVectorArrayInt<ROWS>& vx1) \
-  {                                                                       \
-    DSPVectorArray<ROWS> vy;                                              \
-    const float* px1 = vx1.getConstBuffer();                              \
-    float* py1 = vy.getBuffer();                                          \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)             \
-    {                                                                     \
-      SIMDVectorInt x = VecF2I(vecLoad(px1));                             \
-      vecStore((py1), (opComputation));                                   \
-      px1 += kIntsPerSIMDVector;                                          \
-      py1 += kFloatsPerSIMDVector;                                        \
-    }                                                                     \
-    return vy;                                                            \
+#define DEFINE_OP1_I2F(opName, opComputation)                                         \
+  template <size_t ROWS, size_t LEN>                                                  \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayIntN<ROWS, LEN>& vx1) \
+  {                                                                                   \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                    \
+    const float* px1 = vx1.getConstBuffer();                                          \
+    float* py1 = vy.getBuffer();                                                      \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                                 \
+      SIMDVectorInt x = VecF2I(vecLoad(px1));                                         \
+      vecStore((py1), (opComputation));                                               \
+      px1 += kIntsPerSIMDVector;                                                      \
+      py1 += kFloatsPerSIMDVector;                                                    \
+    }                                                                                 \
+    return vy;                                                                        \
   }
 
 DEFINE_OP1_I2F(intToFloat, (vecIntToFloat(x)));
@@ -827,25 +1066,25 @@ DEFINE_OP1(fractionalPart, (vecSub(x, vecIntToFloat(vecFloatToIntTruncate(x)))))
 // ----------------------------------------------------------------
 // binary float vector, float vector -> int vector operators
 
-#define DEFINE_OP2_FF2I(opName, opComputation)                            \
-  template <size_t ROWS>                                                  \
-  inline DSPVectorArrayInt<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1, \
-                                         const DSPVectorArray<ROWS>& vx2) \
-  {                                                                       \
-    DSPVectorArrayInt<ROWS> vy;                                           \
-    const float* px1 = vx1.getConstBuffer();                              \
-    const float* px2 = vx2.getConstBuffer();                              \
-    float* py1 = vy.getBuffer();                                          \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)             \
-    {                                                                     \
-      SIMDVectorFloat x1 = vecLoad(px1);                                  \
-      SIMDVectorFloat x2 = vecLoad(px2);                                  \
-      vecStore((py1), (opComputation));                                   \
-      px1 += kFloatsPerSIMDVector;                                        \
-      px2 += kFloatsPerSIMDVector;                                        \
-      py1 += kIntsPerSIMDVector;                                          \
-    }                                                                     \
-    return vy;                                                            \
+#define DEFINE_OP2_FF2I(opName, opComputation)                                        \
+  template <size_t ROWS, size_t LEN>                                                  \
+  inline DSPVectorArrayIntN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1, \
+                                               const DSPVectorArrayN<ROWS, LEN>& vx2) \
+  {                                                                                   \
+    DSPVectorArrayIntN<ROWS, LEN> vy{kUninitialized};                                 \
+    const float* px1 = vx1.getConstBuffer();                                          \
+    const float* px2 = vx2.getConstBuffer();                                          \
+    float* py1 = vy.getBuffer();                                                      \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                                 \
+      SIMDVectorFloat x1 = vecLoad(px1);                                              \
+      SIMDVectorFloat x2 = vecLoad(px2);                                              \
+      vecStore((py1), (opComputation));                                               \
+      px1 += kFloatsPerSIMDVector;                                                    \
+      px2 += kFloatsPerSIMDVector;                                                    \
+      py1 += kIntsPerSIMDVector;                                                      \
+    }                                                                                 \
+    return vy;                                                                        \
   }
 
 DEFINE_OP2_FF2I(equal, (vecEqual(x1, x2)));
@@ -858,60 +1097,69 @@ DEFINE_OP2_FF2I(lessThanOrEqual, (vecLessThanOrEqual(x1, x2)));
 // ----------------------------------------------------------------
 // ternary operators float vector, float vector, int vector -> float vector
 
-#define DEFINE_OP3_FFI2F(opName, opComputation)                           \
-  template <size_t ROWS>                                                  \
-  inline DSPVectorArray<ROWS>(opName)(const DSPVectorArray<ROWS>& vx1,    \
-                                      const DSPVectorArray<ROWS>& vx2,    \
-                                      const DSPVectorArrayInt<ROWS>& vx3) \
-  {                                                                       \
-    DSPVectorArray<ROWS> vy;                                              \
-    const float* px1 = vx1.getConstBuffer();                              \
-    const float* px2 = vx2.getConstBuffer();                              \
-    const float* px3 = vx3.getConstBuffer();                              \
-    float* py1 = vy.getBuffer();                                          \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)             \
-    {                                                                     \
-      SIMDVectorFloat x1 = vecLoad(px1);                                  \
-      SIMDVectorFloat x2 = vecLoad(px2);                                  \
-      SIMDVectorInt x3 = VecF2I(vecLoad(px3));                            \
-      vecStore(py1, (opComputation));                                     \
-      px1 += kFloatsPerSIMDVector;                                        \
-      px2 += kFloatsPerSIMDVector;                                        \
-      px3 += kFloatsPerSIMDVector;                                        \
-      py1 += kFloatsPerSIMDVector;                                        \
-    }                                                                     \
-    return vy;                                                            \
-  }
-
-DEFINE_OP3_FFI2F(select, vecSelect(x1, x2, x3));  // bitwise select(resultIfTrue,
-                                                  // resultIfFalse, conditionMask)
+#define DEFINE_OP3_FFI2F(opName, kernelName, opComputation)                           \
+  template <size_t ROWS, size_t LEN>                                                  \
+  inline DSPVectorArrayN<ROWS, LEN>(opName)(const DSPVectorArrayN<ROWS, LEN>& vx1,    \
+                                            const DSPVectorArrayN<ROWS, LEN>& vx2,    \
+                                            const DSPVectorArrayIntN<ROWS, LEN>& vx3) \
+  {                                                                                   \
+    DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};                                    \
+    const float* px1 = vx1.getConstBuffer();                                          \
+    const float* px2 = vx2.getConstBuffer();                                          \
+    const float* px3 = vx3.getConstBuffer();                                          \
+    float* py1 = vy.getBuffer();                                                      \
+    if constexpr (useSIMDKernels<LEN * ROWS>())                                       \
+    {                                                                                 \
+      const SIMDKernels& k = getSIMDKernels();                                        \
+      if (k.level != kSIMDLevelBase)                                                  \
+      {                                                                               \
+        k.kernelName(px1, px2, px3, py1, LEN * ROWS);                                 \
+        return vy;                                                                    \
+      }                                                                               \
+    }                                                                                 \
+    for (size_t n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                  \
+    {                                                                                 \
+      SIMDVectorFloat x1 = vecLoad(px1);                                              \
+      SIMDVectorFloat x2 = vecLoad(px2);                                              \
+      SIMDVectorInt x3 = VecF2I(vecLoad(px3));                                        \
+      vecStore(py1, (opComputation));                                                 \
+      px1 += kFloatsPerSIMDVector;                                                    \
+      px2 += kFloatsPerSIMDVector;                                                    \
+      px3 += kFloatsPerSIMDVector;                                                    \
+      py1 += kFloatsPerSIMDVector;                                                    \
+    }                                                                                 \
+    return vy;                                                                        \
+  }
+
+DEFINE_OP3_FFI2F(select, select, vecSelect(x1, x2, x3));  // bitwise select(resultIfTrue,
+                                                          // resultIfFalse, conditionMask)
 
 // ----------------------------------------------------------------
 // ternary operators int vector, int vector, int vector -> int vector
 
-#define DEFINE_OP3_III2I(opName, opComputation)                              \
-  template <size_t ROWS>                                                     \
-  inline DSPVectorArrayInt<ROWS>(opName)(const DSPVectorArrayInt<ROWS>& vx1, \
-                                         const DSPVectorArrayInt<ROWS>& vx2, \
-                                         const DSPVectorArrayInt<ROWS>& vx3) \
-  {                                                                          \
-    DSPVectorArrayInt<ROWS> vy;                                              \
-    const float* px1 = vx1.getConstBuffer();                                 \
-    const float* px2 = vx2.getConstBuffer();                                 \
-    const float* px3 = vx3.getConstBuffer();                                 \
-    float* py1 = vy.getBuffer();                                             \
-    for (int n = 0; n < kSIMDVectorsPerDSPVector * ROWS; ++n)                \
-    {                                                                        \
-      SIMDVectorInt x1 = VecF2I(vecLoad(px1));                               \
-      SIMDVectorInt x2 = VecF2I(vecLoad(px2));                               \
-      SIMDVectorInt x3 = VecF2I(vecLoad(px3));                               \
-      vecStore(py1, VecI2F(opComputation));                                  \
-      px1 += kIntsPerSIMDVector;                                             \
-      px2 += kIntsPerSIMDVector;                                             \
-      px3 += kIntsPerSIMDVector;                                             \
-      py1 += kIntsPerSIMDVector;                                             \
-    }                                                                        \
-    return vy;                                                               \
+#define DEFINE_OP3_III2I(opName, opComputation)                                          \
+  template <size_t ROWS, size_t LEN>                                                     \
+  inline DSPVectorArrayIntN<ROWS, LEN>(opName)(const DSPVectorArrayIntN<ROWS, LEN>& vx1, \
+                                               const DSPVectorArrayIntN<ROWS, LEN>& vx2, \
+                                               const DSPVectorArrayIntN<ROWS, LEN>& vx3) \
+  {                                                                                      \
+    DSPVectorArrayIntN<ROWS, LEN> vy{kUninitialized};                                    \
+    const float* px1 = vx1.getConstBuffer();                                             \
+    const float* px2 = vx2.getConstBuffer();                                             \
+    const float* px3 = vx3.getConstBuffer();                                             \
+    float* py1 = vy.getBuffer();                                                         \
+    for (int n = 0; n < (LEN / kFloatsPerSIMDVector) * ROWS; ++n)                        \
+    {                                                                                    \
+      SIMDVectorInt x1 = VecF2I(vecLoad(px1));                                           \
+      SIMDVectorInt x2 = VecF2I(vecLoad(px2));                                           \
+      SIMDVectorInt x3 = VecF2I(vecLoad(px3));                                           \
+      vecStore(py1, VecI2F(opComputation));                                              \
+      px1 += kIntsPerSIMDVector;                                                         \
+      px2 += kIntsPerSIMDVector;                                                         \
+      px3 += kIntsPerSIMDVector;                                                         \
+      py1 += kIntsPerSIMDVector;                                                         \
+    }                                                                                    \
+    return vy;                                                                           \
   }
 
 DEFINE_OP3_III2I(select, vecSelect(x1, x2, x3));  // bitwise select(resultIfTrue,
@@ -922,14 +1170,14 @@ DEFINE_OP3_III2I(select, vecSelect(x1, x2, x3));  // bitwise select(resultIfTrue
 
 // add (a, b, c, ...)
 
-template <size_t ROWS>
-DSPVectorArray<ROWS> add(DSPVectorArray<ROWS> a)
+template <size_t ROWS, size_t LEN>
+DSPVectorArrayN<ROWS, LEN> add(DSPVectorArrayN<ROWS, LEN> a)
 {
   return a;
 }
 
-template <size_t ROWS, typename... Args>
-DSPVectorArray<ROWS> add(DSPVectorArray<ROWS> first, Args... args)
+template <size_t ROWS, size_t LEN, typename... Args>
+DSPVectorArrayN<ROWS, LEN> add(DSPVectorArrayN<ROWS, LEN> first, Args... args)
 {
   // the + here is the operator defined using vecAdd() above
   return first + add(args...);
@@ -965,38 +1213,49 @@ constexpr int indexFn(int i) { return i; }
 inline ConstDSPVector columnIndex() { return (make_array<kFloatsPerDSPVector>(intToFloatCastFn)); }
 inline ConstDSPVectorInt columnIndexInt() { return (make_array<kIntsPerDSPVector>(indexFn)); }
 
+// a ramp from 1/kFloatsPerDSPVector to 1 over one vector, for interpolating to a new value.
+constexpr float unityRampFn(int i) { return (i + 1) / static_cast<float>(kFloatsPerDSPVector); }
+ConstDSPVector kUnityRampVec{unityRampFn};
+
 // return a linear sequence from start to end, where end will fall on the first
 // index of the next vector.
-inline DSPVector rangeOpen(float start, float end)
+template <size_t LEN = kFloatsPerDSPVector>
+inline DSPVectorN<LEN> rangeOpen(float start, float end)
 {
-  float interval = (end - start) / (kFloatsPerDSPVector);
-  return columnIndex() * DSPVector(interval) + DSPVector(start);
+  float interval = (end - start) / (LEN);
+  DSPVectorN<LEN> index(make_array<LEN>(intToFloatCastFn));
+  return index * DSPVectorN<LEN>(interval) + DSPVectorN<LEN>(start);
 }
 
 // return a linear sequence from start to end, where end falls on the last index
 // of this vector.
-inline DSPVector rangeClosed(float start, float end)
+template <size_t LEN = kFloatsPerDSPVector>
+inline DSPVectorN<LEN> rangeClosed(float start, float end)
 {
-  float interval = (end - start) / (kFloatsPerDSPVector - 1.f);
-  return columnIndex() * DSPVector(interval) + DSPVector(start);
+  float interval = (end - start) / (LEN - 1.f);
+  DSPVectorN<LEN> index(make_array<LEN>(intToFloatCastFn));
+  return index * DSPVectorN<LEN>(interval) + DSPVectorN<LEN>(start);
 }
 
 // return a linear sequence from start to end, where start falls one sample
 // "before" this vector and end falls on the last index of this vector.
-inline DSPVector interpolateDSPVectorLinear(float start, float end)
+template <size_t LEN = kFloatsPerDSPVector>
+inline DSPVectorN<LEN> interpolateDSPVectorLinear(float start, float end)
 {
-  float interval = (end - start) / (kFloatsPerDSPVector);
-  return columnIndex() * DSPVector(interval) + DSPVector(start + interval);
+  float interval = (end - start) / (LEN);
+  DSPVectorN<LEN> index(make_array<LEN>(intToFloatCastFn));
+  return index * DSPVectorN<LEN>(interval) + DSPVectorN<LEN>(start + interval);
 }
 
 // ----------------------------------------------------------------
 // single-vector horizontal operators returning float
 
-inline float sum(const DSPVector& x)
+template <size_t LEN>
+inline float sum(const DSPVectorN<LEN>& x)
 {
   const float* px1 = x.getConstBuffer();
   float sum = 0;
-  for (int n = 0; n < kSIMDVectorsPerDSPVector; ++n)
+  for (size_t n = 0; n < LEN / kFloatsPerSIMDVector; ++n)
   {
     sum += vecSumH(vecLoad(px1));
     px1 += kFloatsPerSIMDVector;
@@ -1004,17 +1263,19 @@ inline float sum(const DSPVector& x)
   return sum;
 }
 
-inline float mean(const DSPVector& x)
+template <size_t LEN>
+inline float mean(const DSPVectorN<LEN>& x)
 {
-  constexpr float kGain = 1.0f / kFloatsPerDSPVector;
+  constexpr float kGain = 1.0f / LEN;
   return sum(x) * kGain;
 }
 
-inline float max(const DSPVector& x)
+template <size_t LEN>
+inline float max(const DSPVectorN<LEN>& x)
 {
   const float* px1 = x.getConstBuffer();
   float fmax = FLT_MIN;
-  for (int n = 0; n < kSIMDVectorsPerDSPVector; ++n)
+  for (size_t n = 0; n < LEN / kFloatsPerSIMDVector; ++n)
   {
     fmax = ml::max(fmax, vecMaxH(vecLoad(px1)));
     px1 += kFloatsPerSIMDVector;
@@ -1022,11 +1283,12 @@ inline float max(const DSPVector& x)
   return fmax;
 }
 
-inline float min(const DSPVector& x)
+template <size_t LEN>
+inline float min(const DSPVectorN<LEN>& x)
 {
   const float* px1 = x.getConstBuffer();
   float fmin = FLT_MAX;
-  for (int n = 0; n < kSIMDVectorsPerDSPVector; ++n)
+  for (int n = 0; n < LEN / kFloatsPerSIMDVector; ++n)
   {
     fmin = ml::min(fmin, vecMinH(vecLoad(px1)));
     px1 += kFloatsPerSIMDVector;
@@ -1037,11 +1299,11 @@ inline float min(const DSPVector& x)
 // ----------------------------------------------------------------
 // normalize
 
-template <size_t ROWS>
-inline DSPVectorArray<ROWS> normalize(const DSPVectorArray<ROWS>& x1)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> normalize(const DSPVectorArrayN<ROWS, LEN>& x1)
 {
-  DSPVectorArray<ROWS> vy;
-  for (int j = 0; j < ROWS; ++j)
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
+  for (size_t j = 0; j < ROWS; ++j)
   {
     auto inputRow = x1.getRowVectorUnchecked(j);
     vy.setRowVectorUnchecked(j, inputRow / sum(inputRow));
@@ -1054,11 +1316,11 @@ inline DSPVectorArray<ROWS> normalize(const DSPVectorArray<ROWS>& x1)
 
 // for the given output ROWS and given an input DSPVectorArray with N rows,
 // repeat all the input rows enough times to fill the output DSPVectorArray.
-template <size_t ROWS, size_t N>
-inline DSPVectorArray<ROWS * N> repeatRows(const DSPVectorArray<N>& x1)
+template <size_t ROWS, size_t N, size_t LEN>
+inline DSPVectorArrayN<ROWS * N, LEN> repeatRows(const DSPVectorArrayN<N, LEN>& x1)
 {
-  DSPVectorArray<ROWS * N> vy;
-  for (int j = 0, k = 0; j < ROWS * N; ++j)
+  DSPVectorArrayN<ROWS * N, LEN> vy{kUninitialized};
+  for (size_t j = 0, k = 0; j < ROWS * N; ++j)
   {
     vy.setRowVectorUnchecked(j, x1.getRowVectorUnchecked(k));
     if (++k >= N) k = 0;
@@ -1069,11 +1331,11 @@ inline DSPVectorArray<ROWS * N> repeatRows(const DSPVectorArray<N>& x1)
 // for the given ROWS and given an input DSPVectorArray x with N rows,
 // stretch x by repeating rows as necessary to make an output DSPVectorArray
 // with ROWS rows.
-template <size_t ROWS, size_t N>
-inline DSPVectorArray<ROWS> stretchRows(const DSPVectorArray<N>& x)
+template <size_t ROWS, size_t N, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> stretchRows(const DSPVectorArrayN<N, LEN>& x)
 {
-  DSPVectorArray<ROWS> vy;
-  for (int j = 0; j < ROWS; ++j)
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
+  for (size_t j = 0; j < ROWS; ++j)
   {
     int k = roundf((j * (N - 1.f)) / (ROWS - 1.f));
     vy.setRowVectorUnchecked(j, x.getRowVectorUnchecked(k));
@@ -1084,13 +1346,13 @@ inline DSPVectorArray<ROWS> stretchRows(const DSPVectorArray<N>& x)
 // for the given ROWS and given an input DSPVectorArray x with N rows,
 // fill an output array by copying rows of the input, then adding rows of zeros as
 // necessary.
-template <size_t ROWS, size_t N>
-inline DSPVectorArray<ROWS> zeroPadRows(const DSPVectorArray<N>& x)
+template <size_t ROWS, size_t N, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> zeroPadRows(const DSPVectorArrayN<N, LEN>& x)
 {
   // default constructor currently zero-fills
-  DSPVectorArray<ROWS> vy;
+  DSPVectorArrayN<ROWS, LEN> vy;
   constexpr size_t rowsToCopy = min(ROWS, N);
-  for (int j = 0; j < rowsToCopy; ++j)
+  for (size_t j = 0; j < rowsToCopy; ++j)
   {
     vy.setRowVectorUnchecked(j, x.getRowVectorUnchecked(j));
   }
@@ -1100,12 +1362,12 @@ inline DSPVectorArray<ROWS> zeroPadRows(const DSPVectorArray<N>& x)
 // Shift the array down by the number of rows given in rowsToShift.
 // Any rows shifted in from outside the range [0, ROWS) are zeroed. Negative
 // shifts are OK.
-template <size_t ROWS>
-inline DSPVectorArray<ROWS> shiftRows(const DSPVectorArray<ROWS>& x, int rowsToShift)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> shiftRows(const DSPVectorArrayN<ROWS, LEN>& x, int rowsToShift)
 {
-  DSPVectorArray<ROWS> vy;
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
   int k = -rowsToShift;
-  for (int j = 0; j < ROWS; ++j)
+  for (size_t j = 0; j < ROWS; ++j)
   {
     if (within(k, 0, static_cast<int>(ROWS)))
     {
@@ -1123,14 +1385,14 @@ inline DSPVectorArray<ROWS> shiftRows(const DSPVectorArray<ROWS>& x, int rowsToS
 // Rotate the array down by the number of rows given in rowsToRotate.
 // Any rows rotated in from outside the range [0, ROWS) are wrapped. Negative
 // rotations are OK.
-template <size_t ROWS>
-inline DSPVectorArray<ROWS> rotateRows(const DSPVectorArray<ROWS>& x, int rowsToRotate)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> rotateRows(const DSPVectorArrayN<ROWS, LEN>& x, int rowsToRotate)
 {
-  DSPVectorArray<ROWS> vy;
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
 
   // get start index k to which row 0 is mapped
-  int k = modulo(-rowsToRotate, ROWS);
-  for (int j = 0; j < ROWS; ++j)
+  size_t k = modulo(-rowsToRotate, static_cast<int>(ROWS));
+  for (size_t j = 0; j < ROWS; ++j)
   {
     vy.setRowVectorUnchecked(j, x.getRowVectorUnchecked(k));
     if (++k >= ROWS) k = 0;
@@ -1142,16 +1404,16 @@ inline DSPVectorArray<ROWS> rotateRows(const DSPVectorArray<ROWS>& x, int rowsTo
 // row-wise combining
 
 // concatRows with two arguments: append one DSPVectorArray after another.
-template <size_t ROWSA, size_t ROWSB>
-inline DSPVectorArray<ROWSA + ROWSB> concatRows(const DSPVectorArray<ROWSA>& x1,
-                                                const DSPVectorArray<ROWSB>& x2)
+template <size_t ROWSA, size_t ROWSB, size_t LEN>
+inline DSPVectorArrayN<ROWSA + ROWSB, LEN> concatRows(const DSPVectorArrayN<ROWSA, LEN>& x1,
+                                                      const DSPVectorArrayN<ROWSB, LEN>& x2)
 {
-  DSPVectorArray<ROWSA + ROWSB> vy;
-  for (int j = 0; j < ROWSA; ++j)
+  DSPVectorArrayN<ROWSA + ROWSB, LEN> vy{kUninitialized};
+  for (size_t j = 0; j < ROWSA; ++j)
   {
     vy.setRowVectorUnchecked(j, x1.getRowVectorUnchecked(j));
   }
-  for (int j = 0; j < ROWSB; ++j)
+  for (size_t j = 0; j < ROWSB; ++j)
   {
     vy.setRowVectorUnchecked(j + ROWSA, x2.getRowVectorUnchecked(j));
   }
@@ -1159,21 +1421,21 @@ inline DSPVectorArray<ROWSA + ROWSB> concatRows(const DSPVectorArray<ROWSA>& x1,
 }
 
 // concatRows with three arguments.
-template <size_t ROWSA, size_t ROWSB, size_t ROWSC>
-inline DSPVectorArray<ROWSA + ROWSB + ROWSC> concatRows(const DSPVectorArray<ROWSA>& x1,
-                                                        const DSPVectorArray<ROWSB>& x2,
-                                                        const DSPVectorArray<ROWSC>& x3)
+template <size_t ROWSA, size_t ROWSB, size_t ROWSC, size_t LEN>
+inline DSPVectorArrayN<ROWSA + ROWSB + ROWSC, LEN> concatRows(
+    const DSPVectorArrayN<ROWSA, LEN>& x1, const DSPVectorArrayN<ROWSB, LEN>& x2,
+    const DSPVectorArrayN<ROWSC, LEN>& x3)
 {
-  DSPVectorArray<ROWSA + ROWSB + ROWSC> vy;
-  for (int j = 0; j < ROWSA; ++j)
+  DSPVectorArrayN<ROWSA + ROWSB + ROWSC, LEN> vy{kUninitialized};
+  for (size_t j = 0; j < ROWSA; ++j)
   {
     vy.setRowVectorUnchecked(j, x1.getRowVectorUnchecked(j));
   }
-  for (int j = 0; j < ROWSB; ++j)
+  for (size_t j = 0; j < ROWSB; ++j)
   {
     vy.setRowVectorUnchecked(j + ROWSA, x2.getRowVectorUnchecked(j));
   }
-  for (int j = 0; j < ROWSC; ++j)
+  for (size_t j = 0; j < ROWSC; ++j)
   {
     vy.setRowVectorUnchecked(j + ROWSA + ROWSB, x3.getRowVectorUnchecked(j));
   }
@@ -1188,13 +1450,12 @@ inline DSPVectorArray<ROWSA + ROWSB + ROWSC> concatRows(const DSPVectorArray<ROW
 // by wrapping the concatRows template in another template - give it a try.
 
 // concatRows with four arguments.
-template <size_t ROWSA, size_t ROWSB, size_t ROWSC, size_t ROWSD>
-inline DSPVectorArray<ROWSA + ROWSB + ROWSC + ROWSD> concatRows(const DSPVectorArray<ROWSA>& x1,
-                                                                const DSPVectorArray<ROWSB>& x2,
-                                                                const DSPVectorArray<ROWSC>& x3,
-                                                                const DSPVectorArray<ROWSD>& x4)
+template <size_t ROWSA, size_t ROWSB, size_t ROWSC, size_t ROWSD, size_t LEN>
+inline DSPVectorArrayN<ROWSA + ROWSB + ROWSC + ROWSD, LEN> concatRows(
+    const DSPVectorArrayN<ROWSA, LEN>& x1, const DSPVectorArrayN<ROWSB, LEN>& x2,
+    const DSPVectorArrayN<ROWSC, LEN>& x3, const DSPVectorArrayN<ROWSD, LEN>& x4)
 {
-  DSPVectorArray<ROWSA + ROWSB + ROWSC + ROWSD> vy;
+  DSPVectorArrayN<ROWSA + ROWSB + ROWSC + ROWSD, LEN> vy{kUninitialized};
   for (int j = 0; j < ROWSA; ++j)
   {
     vy.setRowVectorUnchecked(j, x1.getRowVectorUnchecked(j));
@@ -1216,18 +1477,18 @@ inline DSPVectorArray<ROWSA + ROWSB + ROWSC + ROWSD> concatRows(const DSPVectorA
 
 // Rotate the elements of each row of a DSPVectorArray by one element left.
 // The first element of each row is moved to the end
-template <size_t ROWS>
-inline ml::DSPVectorArray<ROWS> rotateLeft(const ml::DSPVectorArray<ROWS>& x)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> rotateLeft(const DSPVectorArrayN<ROWS, LEN>& x)
 {
-  ml::DSPVectorArray<ROWS> vy;
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
 
   for (size_t row = 0; row < ROWS; row++)
   {
-    const float* px1 = x.getConstBuffer() + (row * kFloatsPerDSPVector);
+    const float* px1 = x.getConstBuffer() + (row * LEN);
     const float* px2 = px1 + kFloatsPerSIMDVector;
-    float* py1 = vy.getBuffer() + (row * kFloatsPerDSPVector);
+    float* py1 = vy.getBuffer() + (row * LEN);
 
-    for (int n = 0; n < kSIMDVectorsPerDSPVector - 1; ++n)
+    for (int n = 0; n < (LEN / kFloatsPerSIMDVector) - 1; ++n)
     {
       vecStore(py1, vecShuffleLeft(vecLoad(px1), vecLoad(px2)));
 
@@ -1236,7 +1497,7 @@ inline ml::DSPVectorArray<ROWS> rotateLeft(const ml::DSPVectorArray<ROWS>& x)
       py1 += kFloatsPerSIMDVector;
     }
 
-    px2 = x.getConstBuffer() + (row * kFloatsPerDSPVector);
+    px2 = x.getConstBuffer() + (row * LEN);
 
     vecStore(py1, vecShuffleLeft(vecLoad(px1), vecLoad(px2)));
   }
@@ -1246,18 +1507,18 @@ inline ml::DSPVectorArray<ROWS> rotateLeft(const ml::DSPVectorArray<ROWS>& x)
 
 // Rotate the elements of each row of a DSPVectorArray by one element right.
 // The last element of each row is moved to the start
-template <size_t ROWS>
-inline ml::DSPVectorArray<ROWS> rotateRight(const ml::DSPVectorArray<ROWS>& x)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS, LEN> rotateRight(const DSPVectorArrayN<ROWS, LEN>& x)
 {
-  ml::DSPVectorArray<ROWS> vy;
+  DSPVectorArrayN<ROWS, LEN> vy{kUninitialized};
 
   for (size_t row = 0; row < ROWS; row++)
   {
-    const float* px1 = x.getConstBuffer() + (row * kFloatsPerDSPVector);
+    const float* px1 = x.getConstBuffer() + (row * LEN);
     const float* px2 = px1 + kFloatsPerSIMDVector;
-    float* py1 = vy.getBuffer() + (row * kFloatsPerDSPVector) + kFloatsPerSIMDVector;
+    float* py1 = vy.getBuffer() + (row * LEN) + kFloatsPerSIMDVector;
 
-    for (int n = 0; n < kSIMDVectorsPerDSPVector - 1; ++n)
+    for (int n = 0; n < (LEN / kFloatsPerSIMDVector) - 1; ++n)
     {
       vecStore(py1, vecShuffleRight(vecLoad(px1), vecLoad(px2)));
 
@@ -1266,8 +1527,8 @@ inline ml::DSPVectorArray<ROWS> rotateRight(const ml::DSPVectorArray<ROWS>& x)
       py1 += kFloatsPerSIMDVector;
     }
 
-    px2 = x.getConstBuffer() + (row * kFloatsPerDSPVector);
-    py1 = vy.getBuffer() + (row * kFloatsPerDSPVector);
+    px2 = x.getConstBuffer() + (row * LEN);
+    py1 = vy.getBuffer() + (row * LEN);
 
     vecStore(py1, vecShuffleRight(vecLoad(px1), vecLoad(px2)));
   }
@@ -1278,11 +1539,11 @@ inline ml::DSPVectorArray<ROWS> rotateRight(const ml::DSPVectorArray<ROWS>& x)
 // shuffle two DSPVectorArrays, alternating x1 to even rows of result and x2 to
 // odd rows. if the sources are different sizes, the excess rows are all
 // appended to the destination after shuffling is done.
-template <size_t ROWSA, size_t ROWSB>
-inline DSPVectorArray<ROWSA + ROWSB> shuffleRows(const DSPVectorArray<ROWSA> x1,
-                                                 const DSPVectorArray<ROWSB> x2)
+template <size_t ROWSA, size_t ROWSB, size_t LEN>
+inline DSPVectorArrayN<ROWSA + ROWSB, LEN> shuffleRows(const DSPVectorArrayN<ROWSA, LEN> x1,
+                                                       const DSPVectorArrayN<ROWSB, LEN> x2)
 {
-  DSPVectorArray<ROWSA + ROWSB> vy;
+  DSPVectorArrayN<ROWSA + ROWSB, LEN> vy{kUninitialized};
   int ja = 0;
   int jb = 0;
   int jy = 0;
@@ -1307,10 +1568,10 @@ inline DSPVectorArray<ROWSA + ROWSB> shuffleRows(const DSPVectorArray<ROWSA> x1,
 // ----------------------------------------------------------------
 // separating rows
 
-template <size_t ROWS>
-inline DSPVectorArray<(ROWS + 1) / 2> evenRows(const DSPVectorArray<ROWS>& x1)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<(ROWS + 1) / 2, LEN> evenRows(const DSPVectorArrayN<ROWS, LEN>& x1)
 {
-  DSPVectorArray<(ROWS + 1) / 2> vy;
+  DSPVectorArrayN<(ROWS + 1) / 2, LEN> vy{kUninitialized};
   for (int j = 0; j < (ROWS + 1) / 2; ++j)
   {
     vy.setRowVectorUnchecked(j, x1.getRowVectorUnchecked(j * 2));
@@ -1318,10 +1579,10 @@ inline DSPVectorArray<(ROWS + 1) / 2> evenRows(const DSPVectorArray<ROWS>& x1)
   return vy;
 }
 
-template <size_t ROWS>
-inline DSPVectorArray<ROWS / 2> oddRows(const DSPVectorArray<ROWS>& x1)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<ROWS / 2, LEN> oddRows(const DSPVectorArrayN<ROWS, LEN>& x1)
 {
-  DSPVectorArray<ROWS / 2> vy;
+  DSPVectorArrayN<ROWS / 2, LEN> vy{kUninitialized};
   for (int j = 0; j < ROWS / 2; ++j)
   {
     vy.setRowVectorUnchecked(j, x1.getRowVectorUnchecked(j * 2 + 1));
@@ -1330,13 +1591,13 @@ inline DSPVectorArray<ROWS / 2> oddRows(const DSPVectorArray<ROWS>& x1)
 }
 
 // return the DSPVectorArray consisting of rows [A-B) of the input.
-template <size_t A, size_t B, size_t ROWS>
-inline DSPVectorArray<B - A> separateRows(const DSPVectorArray<ROWS>& x)
+template <size_t A, size_t B, size_t ROWS, size_t LEN>
+inline DSPVectorArrayN<B - A, LEN> separateRows(const DSPVectorArrayN<ROWS, LEN>& x)
 {
   static_assert(B <= ROWS, "separateRows: range out of bounds!");
   static_assert(A < ROWS, "separateRows: range out of bounds!");
-  DSPVectorArray<B - A> vy;
-  for (int j = A; j < B; ++j)
+  DSPVectorArrayN<B - A, LEN> vy{kUninitialized};
+  for (size_t j = A; j < B; ++j)
   {
     vy.setRowVectorUnchecked(j - A, x.getRowVectorUnchecked(j));
   }
@@ -1346,10 +1607,10 @@ inline DSPVectorArray<B - A> separateRows(const DSPVectorArray<ROWS>& x)
 // ----------------------------------------------------------------
 // add rows to get row-wise sum
 
-template <size_t ROWS>
-inline DSPVector addRows(const DSPVectorArray<ROWS>& x)
+template <size_t ROWS, size_t LEN>
+inline DSPVectorN<LEN> addRows(const DSPVectorArrayN<ROWS, LEN>& x)
 {
-  DSPVector vy{0.f};
+  DSPVectorN<LEN> vy{0.f};
 
   for (int j = 0; j < ROWS; ++j)
   {
@@ -1362,13 +1623,13 @@ inline DSPVector addRows(const DSPVectorArray<ROWS>& x)
 // rowIndex - returns a DSPVector of j rows, each row filled
 // with the index of its row
 
-template <size_t ROWS>
-inline DSPVectorArray<ROWS> rowIndex()
+template <size_t ROWS, size_t LEN = kFloatsPerDSPVector>
+inline DSPVectorArrayN<ROWS, LEN> rowIndex()
 {
-  DSPVectorArray<ROWS> y;
-  for (int j = 0; j < ROWS; ++j)
+  DSPVectorArrayN<ROWS, LEN> y{kUninitialized};
+  for (size_t j = 0; j < ROWS; ++j)
   {
-    y.setRowVectorUnchecked(j, DSPVector(j));
+    y.setRowVectorUnchecked(j, DSPVectorN<LEN>(j));
   }
   return y;
 }
@@ -1376,10 +1637,10 @@ inline DSPVectorArray<ROWS> rowIndex()
 // ----------------------------------------------------------------
 // columnIndex<n> - shorthand for repeatRows<n>(columnIndex())
 
-template <size_t ROWS>
-inline DSPVectorArray<ROWS> columnIndex()
+template <size_t ROWS, size_t LEN = kFloatsPerDSPVector>
+inline DSPVectorArrayN<ROWS, LEN> columnIndex()
 {
-  return repeatRows<ROWS>(DSPVector(make_array<kFloatsPerDSPVector>(intToFloatCastFn)));
+  return repeatRows<ROWS>(DSPVectorN<LEN>(make_array<LEN>(intToFloatCastFn)));
 }
 
 // TODO variadic splitRows(bundleSIg, outputRow1, outputRow2, ... )
@@ -1387,18 +1648,18 @@ inline DSPVectorArray<ROWS> columnIndex()
 // ----------------------------------------------------------------
 // for testing
 
-template <size_t ROWS>
-inline std::ostream& operator<<(std::ostream& out, const DSPVectorArray<ROWS>& vecArray)
+template <size_t ROWS, size_t LEN>
+inline std::ostream& operator<<(std::ostream& out, const DSPVectorArrayN<ROWS, LEN>& vecArray)
 {
   //    if(ROWS > 1) out << "[   ";
-  for (int v = 0; v < ROWS; ++v)
+  for (size_t v = 0; v < ROWS; ++v)
   {
     //  if(ROWS > 1) if(v > 0) out << "\n    ";
     if (ROWS > 1) out << "\n    v" << v << ": ";
     out << "[";
-    for (int i = 0; i < kFloatsPerDSPVector; ++i)
+    for (size_t i = 0; i < LEN; ++i)
     {
-      out << vecArray[v * kFloatsPerDSPVector + i] << " ";
+      out << vecArray[v * LEN + i] << " ";
     }
     out << "] ";
   }
@@ -1406,20 +1667,20 @@ inline std::ostream& operator<<(std::ostream& out, const DSPVectorArray<ROWS>& v
   return out;
 }
 
-template <size_t ROWS>
-inline std::ostream& operator<<(std::ostream& out, const DSPVectorArrayInt<ROWS>& vecArray)
+template <size_t ROWS, size_t LEN>
+inline std::ostream& operator<<(std::ostream& out, const DSPVectorArrayIntN<ROWS, LEN>& vecArray)
 {
   out << "@" << std::hex << reinterpret_cast<unsigned long>(&vecArray) << std::dec << "\n ";
   //    if(ROWS > 1) out << "[   ";
-  for (int v = 0; v < ROWS; ++v)
+  for (size_t v = 0; v < ROWS; ++v)
   {
     if (ROWS > 1)
       if (v > 0) out << "\n    ";
     if (ROWS > 1) out << "v" << v << ": ";
     out << "[";
-    for (int i = 0; i < kIntsPerDSPVector; ++i)
+    for (size_t i = 0; i < LEN; ++i)
     {
-      out << vecArray[v * kIntsPerDSPVector + i] << " ";
+      out << vecArray[v * LEN + i] << " ";
     }
     out << "] ";
   }
@@ -1427,10 +1688,11 @@ inline std::ostream& operator<<(std::ostream& out, const DSPVectorArrayInt<ROWS>
   return out;
 }
 
-inline bool validate(const DSPVector& x)
+template <size_t LEN>
+inline bool validate(const DSPVectorN<LEN>& x)
 {
   bool r = true;
-  for (int n = 0; n < kFloatsPerDSPVector; ++n)
+  for (int n = 0; n < LEN; ++n)
   {
     const float maxUsefulValue = 1e8;
     if (ml::isNaN(x[n]) || (fabs(x[n]) > maxUsefulValue))
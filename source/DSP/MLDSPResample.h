@@ -0,0 +1,283 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// Resampler: sample rate conversion by any ratio, with a polyphase windowed
+// sinc filter.
+//
+// Each output sample is the inner product of kTaps input samples with one phase
+// of the filter, computed with SIMD. If the input and output rates are integers
+// with a ratio in lowest terms of L / M, with L (the number of distinct output
+// phases) at most kMaxExactPhases, the filter is made with exactly L phases and
+// the output is exact polyphase resampling. For other ratios, such as 44100 to
+// 44100.5 when following a drifting clock, the filter is made with
+// kInterpolatedPhases phases and the coefficients for each output are
+// interpolated between the two nearest phases.
+//
+// For downsampling the cutoff is lowered with the output rate, so there is no
+// aliasing, but the filter does not get any longer.
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "MLDSPOps.h"
+#include "MLDSPSample.h"
+
+namespace ml
+{
+class Resampler
+{
+ public:
+  static constexpr int kTaps{64};
+  static constexpr int kMaxExactPhases{1024};
+  static constexpr int kInterpolatedPhases{256};
+
+  // the cutoff relative to the lower Nyquist frequency, and the Kaiser window
+  // parameter. With kTaps taps, these give a stopband of at least 80 dB that
+  // starts at the lower Nyquist frequency.
+  static constexpr double kCutoff{0.92};
+  static constexpr double kKaiserBeta{8.0};
+
+  Resampler() { setRates(1., 1.); }
+
+  // set the input and output sample rates and make the filter. This allocates
+  // memory, so it should not be called from the audio thread.
+  void setRates(double inputRate, double outputRate)
+  {
+    if (!(inputRate > 0.) || !(outputRate > 0.)) return;
+    mRatio = outputRate / inputRate;
+
+    const bool integerRates = (inputRate == std::floor(inputRate)) &&
+                              (outputRate == std::floor(outputRate)) &&
+                              (inputRate < 1e9) && (outputRate < 1e9);
+    int64_t up{0}, down{0};
+    if (integerRates)
+    {
+      const int64_t in = (int64_t)inputRate;
+      const int64_t out = (int64_t)outputRate;
+      const int64_t d = std::gcd(in, out);
+      up = out / d;
+      down = in / d;
+    }
+
+    mExact = integerRates && (up <= kMaxExactPhases);
+    if (mExact)
+    {
+      mPhases = (int)up;
+      mPhaseStep = (int)down;
+      makeFilter(mPhases, mPhases);
+    }
+    else
+    {
+      mPhases = kInterpolatedPhases;
+      mFractionStep = 1. / mRatio;
+      makeFilter(mPhases, mPhases + 1);
+    }
+    clear();
+  }
+
+  void clear()
+  {
+    // kTaps / 2 - 1 zeros precede the first input sample, so that the first
+    // output is at the time of the first input.
+    std::fill(mBuffer.begin(), mBuffer.end(), 0.f);
+    mFill = kTaps / 2 - 1;
+    mIndex = 0;
+    mPhase = 0;
+    mFraction = 0.;
+  }
+
+  double getRatio() const { return mRatio; }
+
+  // the most output samples that process() can make from inputFrames samples.
+  size_t getMaxOutputFrames(size_t inputFrames) const
+  {
+    return (size_t)std::ceil(inputFrames * mRatio) + 1;
+  }
+
+  // An output sample is made once the input has reached kTaps / 2 samples past
+  // its time.
+  static constexpr int getLatencyInInputSamples() { return kTaps / 2; }
+
+  // Read inputFrames samples from pSrc, write all the output samples they
+  // complete to pDest and return the number written, which is at most
+  // getMaxOutputFrames(inputFrames). Does not allocate.
+  size_t process(const float* pSrc, size_t inputFrames, float* pDest)
+  {
+    size_t outputFrames{0};
+    while (inputFrames > 0)
+    {
+      const size_t n = std::min(inputFrames, kBufferSize - mFill);
+      std::copy_n(pSrc, n, mBuffer.data() + mFill);
+      mFill += n;
+      pSrc += n;
+      inputFrames -= n;
+
+      while (mIndex + kTaps <= mFill)
+      {
+        pDest[outputFrames++] = mExact ? nextExactOutput() : nextInterpolatedOutput();
+      }
+
+      // move the samples that are still needed to the start of the buffer.
+      if (mIndex >= mFill)
+      {
+        mIndex -= mFill;
+        mFill = 0;
+      }
+      else
+      {
+        std::copy(mBuffer.data() + mIndex, mBuffer.data() + mFill, mBuffer.data());
+        mFill -= mIndex;
+        mIndex = 0;
+      }
+    }
+    return outputFrames;
+  }
+
+ private:
+  static constexpr size_t kBufferSize{kTaps + 256};
+
+  // return the inner product of kTaps samples at pa and pb.
+  static inline float innerProduct(const float* pa, const float* pb)
+  {
+    SIMDVectorFloat sum = vecMul(vecLoadUnaligned(pa), vecLoadUnaligned(pb));
+    for (int j = kFloatsPerSIMDVector; j < kTaps; j += kFloatsPerSIMDVector)
+    {
+      sum = vecFMA(vecLoadUnaligned(pa + j), vecLoadUnaligned(pb + j), sum);
+    }
+    return vecSumH(sum);
+  }
+
+  static double besselI0(double x)
+  {
+    double sum{1.}, term{1.};
+    for (int k = 1; k < 32; ++k)
+    {
+      const double t = x / (2. * k);
+      term *= t * t;
+      sum += term;
+    }
+    return sum;
+  }
+
+  // Make rows of the filter for output phases p / phases. Each row is
+  // normalized to a DC gain of 1.
+  void makeFilter(int phases, int rows)
+  {
+    const double cutoff = kCutoff * std::min(1., mRatio);
+    const double halfWidth = kTaps / 2.;
+    const double windowScale = 1. / besselI0(kKaiserBeta);
+    mFilter.resize((size_t)rows * kTaps);
+    for (int p = 0; p < rows; ++p)
+    {
+      float* pRow = mFilter.data() + (size_t)p * kTaps;
+      double sum{0.};
+      for (int j = 0; j < kTaps; ++j)
+      {
+        // tap j is at this time relative to the output.
+        const double t = j - (kTaps / 2 - 1) - double(p) / phases;
+        const double x = cutoff * t;
+        const double sinc = (std::fabs(x) < 1e-9) ? 1. : std::sin(kPi * x) / (kPi * x);
+        const double r = t / halfWidth;
+        const double window =
+            (std::fabs(r) < 1.) ? besselI0(kKaiserBeta * std::sqrt(1. - r * r)) * windowScale : 0.;
+        pRow[j] = (float)(sinc * window);
+        sum += pRow[j];
+      }
+      for (int j = 0; j < kTaps; ++j)
+      {
+        pRow[j] = (float)(pRow[j] / sum);
+      }
+    }
+  }
+
+  inline float nextExactOutput()
+  {
+    const float y = innerProduct(mBuffer.data() + mIndex, mFilter.data() + (size_t)mPhase * kTaps);
+    mPhase += mPhaseStep;
+    mIndex += mPhase / mPhases;
+    mPhase %= mPhases;
+    return y;
+  }
+
+  inline float nextInterpolatedOutput()
+  {
+    const double position = mFraction * mPhases;
+    const int row = std::min((int)position, mPhases - 1);
+    const float mix = (float)(position - row);
+    const float* pRow = mFilter.data() + (size_t)row * kTaps;
+    const float* px = mBuffer.data() + mIndex;
+    const float y0 = innerProduct(px, pRow);
+    const float y1 = innerProduct(px, pRow + kTaps);
+    mFraction += mFractionStep;
+    const double advance = std::floor(mFraction);
+    mIndex += (size_t)advance;
+    mFraction -= advance;
+    return lerp(y0, y1, mix);
+  }
+
+  std::vector<float> mFilter;
+  std::array<float, kBufferSize> mBuffer{};
+  size_t mFill{0};
+  size_t mIndex{0};
+  double mRatio{1.};
+  bool mExact{true};
+  int mPhases{1};
+
+  // exact phases: the phase of the next output is mPhase / mPhases.
+  int mPhase{0};
+  int mPhaseStep{1};
+
+  // interpolated phases: the phase of the next output is mFraction.
+  double mFraction{0.};
+  double mFractionStep{1.};
+};
+
+// Resample src to the sample rate destRate, writing the result to dest. The
+// output is aligned in time with the input and has the same duration, rounded
+// up to a whole frame. Returns false if src has no sample rate or memory could
+// not be allocated.
+inline bool resample(const Sample& src, Sample& dest, size_t destRate)
+{
+  const size_t frames = getFrames(src);
+  const size_t channels = src.channels;
+  if (!src.sampleRate || !destRate || !frames) return false;
+  const size_t destFrames = (frames * destRate + src.sampleRate - 1) / src.sampleRate;
+  if (!resize(dest, destFrames, channels)) return false;
+  dest.sampleRate = destRate;
+
+  Resampler r;
+  r.setRates((double)src.sampleRate, (double)destRate);
+  const size_t flushFrames = Resampler::getLatencyInInputSamples();
+  std::vector<float> channelIn, channelOut;
+  try
+  {
+    channelIn.resize(frames + flushFrames);
+    channelOut.resize(r.getMaxOutputFrames(frames + flushFrames));
+  }
+  catch (...)
+  {
+    return false;
+  }
+
+  for (size_t c = 0; c < channels; ++c)
+  {
+    for (size_t i = 0; i < frames; ++i)
+    {
+      channelIn[i] = src[i * channels + c];
+    }
+    r.clear();
+    const size_t made = r.process(channelIn.data(), channelIn.size(), channelOut.data());
+    for (size_t i = 0; i < destFrames; ++i)
+    {
+      dest[i * channels + c] = (i < made) ? channelOut[i] : 0.f;
+    }
+  }
+  return true;
+}
+
+}  // namespace ml
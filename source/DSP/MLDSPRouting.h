@@ -26,6 +26,7 @@
 #include <type_traits>
 
 #include "MLDSPMath.h"
+#include "MLDSPOps.h"
 #include "MLDSPScalarMath.h"
 
 namespace ml
@@ -49,11 +50,10 @@ Parallel
 
 // mix (DSPVectorArray<INPUTS>gains, a, b, c, ... )
 // returns the sum of each input DSPVectorArray multiplied by the corresponding row
-// of the gains array.
-// NOTE: if the gains DSPVectorArray contains a number of rows smaller than the number of inputs,
-// unsafe behavior results.
-// TODO: with the right template-fu it should be possible to check the sizes at compile time,
-// and to avoid passing inputIndex at runtime.
+// of the gains array. The gains DSPVectorArray must have at least as many rows as there are
+// inputs, which is checked at compile time.
+// TODO: with the right template-fu it should be possible to avoid passing inputIndex at runtime.
+// For mixing many inputs to many outputs, see MixMatrix below.
 
 template <size_t ROWS, size_t INPUTS, typename... Args>
 DSPVectorArray<ROWS> mix_n(size_t inputIndex, DSPVectorArray<INPUTS> gains,
@@ -73,9 +73,182 @@ DSPVectorArray<ROWS> mix_n(size_t inputIndex, DSPVectorArray<INPUTS> gains,
 template <size_t ROWS, size_t INPUTS, typename... Args>
 DSPVectorArray<ROWS> mix(DSPVectorArray<INPUTS> gains, DSPVectorArray<ROWS> first, Args... args)
 {
+  static_assert(INPUTS >= sizeof...(Args) + 1, "mix: fewer gains than inputs");
   return mix_n(0, gains, first, args...);
 }
 
+// MixMatrix<IN, OUT> mixes the rows of a DSPVectorArray<IN> into a DSPVectorArray<OUT>
+// through an OUT x IN matrix of gains: output row j is the sum over i of input row i
+// times gain(j, i).
+//
+// A gain set with setGain() ramps linearly from its old value over the next vector,
+// reaching the new value at the last sample. Only the nonzero entries are mixed: for each
+// output, the matrix keeps a list of the inputs with steady nonzero gains, and a list of
+// the inputs with ramping gains. The lists are made again only for the outputs whose gains
+// have changed, so a sparse matrix costs in proportion to its number of connections.
+
+template <size_t IN, size_t OUT>
+class MixMatrix
+{
+  static_assert((IN > 0) && (OUT > 0), "MixMatrix: sizes must be nonzero");
+  static_assert(IN < 65536, "MixMatrix: too many inputs");
+
+ public:
+  MixMatrix() { mChanged.fill(true); }
+
+  // set the gain from input i to output j, ramping to it over the next vector.
+  void setGain(size_t j, size_t i, float g)
+  {
+    const size_t k = j * IN + i;
+    mTarget[k] = g;
+    if (g != mGain[k]) mChanged[j] = true;
+  }
+
+  // set the gain from input I to output J, when both are known at compile time.
+  template <size_t J, size_t I>
+  void setGain(float g)
+  {
+    static_assert((J < OUT) && (I < IN), "MixMatrix: gain index out of bounds");
+    setGain(J, I, g);
+  }
+
+  // set the gain from input i to output j immediately, without a ramp.
+  void setGainNow(size_t j, size_t i, float g)
+  {
+    const size_t k = j * IN + i;
+    mTarget[k] = mGain[k] = g;
+    mChanged[j] = true;
+  }
+
+  // set all the gains from a table, gains[j][i] for output j and
+  // input i, ramping to them over the next vector.
+  void setGains(const std::array<std::array<float, IN>, OUT>& gains)
+  {
+    for (size_t j = 0; j < OUT; ++j)
+    {
+      for (size_t i = 0; i < IN; ++i)
+      {
+        setGain(j, i, gains[j][i]);
+      }
+    }
+  }
+
+  // return the gain from input i to output j that is being ramped to.
+  float getGain(size_t j, size_t i) const { return mTarget[j * IN + i]; }
+
+  // return true if input i is connected to output j by a nonzero gain.
+  bool isConnected(size_t j, size_t i) const
+  {
+    const size_t k = j * IN + i;
+    return (mGain[k] != 0.f) || (mTarget[k] != 0.f);
+  }
+
+  // set all the gains to zero immediately.
+  void clear()
+  {
+    mGain.fill(0.f);
+    mTarget.fill(0.f);
+    mChanged.fill(true);
+  }
+
+  DSPVectorArray<OUT> operator()(const DSPVectorArray<IN>& x)
+  {
+    DSPVectorArray<OUT> y;
+    for (size_t j = 0; j < OUT; ++j)
+    {
+      if (mChanged[j]) updateOutput(j);
+      mixOutput(j, x, y.row(j).getBuffer());
+    }
+    return y;
+  }
+
+ private:
+  // make the lists of steady and ramping inputs for output j.
+  void updateOutput(size_t j)
+  {
+    const float* pGain = mGain.data() + j * IN;
+    const float* pTarget = mTarget.data() + j * IN;
+    uint16_t* pInputs = mInputs.data() + j * IN;
+    size_t steady{0}, ramping{0};
+    for (size_t i = 0; i < IN; ++i)
+    {
+      if ((pGain[i] == pTarget[i]) && (pGain[i] != 0.f))
+      {
+        pInputs[steady++] = static_cast<uint16_t>(i);
+      }
+    }
+    for (size_t i = 0; i < IN; ++i)
+    {
+      if (pGain[i] != pTarget[i])
+      {
+        pInputs[steady + ramping++] = static_cast<uint16_t>(i);
+      }
+    }
+    mSteadyCount[j] = static_cast<uint16_t>(steady);
+    mRampingCount[j] = static_cast<uint16_t>(ramping);
+    mChanged[j] = false;
+  }
+
+  void mixOutput(size_t j, const DSPVectorArray<IN>& x, float* py)
+  {
+    float* pGain = mGain.data() + j * IN;
+    const float* pTarget = mTarget.data() + j * IN;
+    const uint16_t* pInputs = mInputs.data() + j * IN;
+    const size_t steady = mSteadyCount[j];
+    const size_t ramping = mRampingCount[j];
+
+    // mix the steady inputs two at a time.
+    size_t k{0};
+    for (; k + 1 < steady; k += 2)
+    {
+      const float* pa = x.constRow(pInputs[k]).getConstBuffer();
+      const float* pb = x.constRow(pInputs[k + 1]).getConstBuffer();
+      const SIMDVectorFloat ga = vecSet1(pGain[pInputs[k]]);
+      const SIMDVectorFloat gb = vecSet1(pGain[pInputs[k + 1]]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        const SIMDVectorFloat sum = vecFMA(vecLoad(pa + n), ga, vecLoad(py + n));
+        vecStore(py + n, vecFMA(vecLoad(pb + n), gb, sum));
+      }
+    }
+    if (k < steady)
+    {
+      const float* pa = x.constRow(pInputs[k]).getConstBuffer();
+      const SIMDVectorFloat ga = vecSet1(pGain[pInputs[k]]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        vecStore(py + n, vecFMA(vecLoad(pa + n), ga, vecLoad(py + n)));
+      }
+    }
+
+    // mix the ramping inputs, then make their targets the new gains. The lists will be
+    // made again for the next vector.
+    if (!ramping) return;
+    const float* pRamp = kUnityRampVec.getConstBuffer();
+    for (k = steady; k < steady + ramping; ++k)
+    {
+      const size_t i = pInputs[k];
+      const float* pa = x.constRow(i).getConstBuffer();
+      const SIMDVectorFloat g0 = vecSet1(pGain[i]);
+      const SIMDVectorFloat dg = vecSet1(pTarget[i] - pGain[i]);
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        const SIMDVectorFloat g = vecFMA(vecLoad(pRamp + n), dg, g0);
+        vecStore(py + n, vecFMA(vecLoad(pa + n), g, vecLoad(py + n)));
+      }
+      pGain[i] = pTarget[i];
+    }
+    mChanged[j] = true;
+  }
+
+  std::array<float, IN * OUT> mGain{};
+  std::array<float, IN * OUT> mTarget{};
+  std::array<uint16_t, IN * OUT> mInputs{};
+  std::array<uint16_t, OUT> mSteadyCount{};
+  std::array<uint16_t, OUT> mRampingCount{};
+  std::array<bool, OUT> mChanged{};
+};
+
 // multiplex. selector is a signal that controls what mix of the inputs to send to the output.
 // the selector range [0--1) is mapped to cover the range of inputs equally.
 
@@ -85,10 +258,10 @@ DSPVectorArray<ROWS> multiplex(DSPVector selector, DSPVectorArray<ROWS> first, A
   DSPVectorArray<ROWS> inputs[]{first, args...};
   constexpr int nInputs = sizeof...(Args) + 1;
 
-  DSPVectorArray<ROWS> y;
+  DSPVectorArray<ROWS> y{kUninitialized};
 
   // iterate on each sample of input selector
-  for (int i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
+  for (size_t i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
   {
     // TODO SIMD
     int selectorIdx = i % kFloatsPerDSPVector;
@@ -113,10 +286,10 @@ DSPVectorArray<ROWS> multiplexLinear(DSPVector selector, DSPVectorArray<ROWS> fi
   DSPVectorArray<ROWS> inputs[]{first, args...};
   constexpr int nInputs = sizeof...(Args) + 1;
 
-  DSPVectorArray<ROWS> y;
+  DSPVectorArray<ROWS> y{kUninitialized};
 
   // iterate on each sample of input selector
-  for (int i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
+  for (size_t i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
   {
     // TODO SIMD
     int selectorIdx = i % kFloatsPerDSPVector;
@@ -145,10 +318,10 @@ void demultiplex(DSPVector selector, DSPVectorArray<ROWS> input, DSPVectorArray<
   DSPVectorArray<ROWS>* outputs[]{firstOutput, args...};
   constexpr int nOutputs = sizeof...(Args) + 1;
 
-  DSPVector outputIntSafe;
+  DSPVector outputIntSafe{kUninitialized};
 
   // for each sample, get the output index from the selector
-  for (int i = 0; i < kFloatsPerDSPVector; ++i)
+  for (size_t i = 0; i < kFloatsPerDSPVector; ++i)
   {
     // TODO SIMD
     float s = selector[i];
@@ -161,10 +334,10 @@ void demultiplex(DSPVector selector, DSPVectorArray<ROWS> input, DSPVectorArray<
 
   // for each output, for each sample, if the selected output index at the
   // sample equals the output, write the input that that output. Else write 0.
-  for (int j = 0; j < nOutputs; ++j)
+  for (size_t j = 0; j < nOutputs; ++j)
   {
     DSPVectorArray<ROWS>* pOutput = outputs[j];
-    for (int i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
+    for (size_t i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
     {
       int selectorIdx = i % kFloatsPerDSPVector;
       size_t outputInt = outputIntSafe[selectorIdx];
@@ -183,12 +356,12 @@ void demultiplexLinear(DSPVector selector, DSPVectorArray<ROWS> input,
   DSPVectorArray<ROWS>* outputs[]{firstOutput, args...};
   constexpr int nOutputs = sizeof...(Args) + 1;
 
-  DSPVector outputInt1Safe;
-  DSPVector outputInt2Safe;
-  DSPVector outputMix;
+  DSPVector outputInt1Safe{kUninitialized};
+  DSPVector outputInt2Safe{kUninitialized};
+  DSPVector outputMix{kUninitialized};
 
   // for each sample, get the two output indexes and mix amount from the selector
-  for (int i = 0; i < kFloatsPerDSPVector; ++i)
+  for (size_t i = 0; i < kFloatsPerDSPVector; ++i)
   {
     // TODO SIMD
     float s = selector[i];
@@ -205,10 +378,10 @@ void demultiplexLinear(DSPVector selector, DSPVectorArray<ROWS> input,
 
   // for each output, for each sample, if the selected output index at the
   // sample equals the output, write the input that that output. Else write 0.
-  for (int j = 0; j < nOutputs; ++j)
+  for (size_t j = 0; j < nOutputs; ++j)
   {
     DSPVectorArray<ROWS>* pOutput = outputs[j];
-    for (int i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
+    for (size_t i = 0; i < kFloatsPerDSPVector * ROWS; ++i)
     {
       int selectorIdx = i % kFloatsPerDSPVector;
       size_t outputInt1 = outputInt1Safe[selectorIdx];
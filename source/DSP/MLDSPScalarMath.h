@@ -99,6 +99,26 @@ constexpr inline int(sign)(const c& x)
 
 #pragma mark utility functions on scalars
 
+// a * b + c and a * b - c, with a single rounding where the target has a fast
+// fused multiply-add. Otherwise these are a separate multiply and add.
+inline float multiplyAdd(float a, float b, float c)
+{
+#ifdef FP_FAST_FMAF
+  return std::fma(a, b, c);
+#else
+  return a * b + c;
+#endif
+}
+
+inline float multiplySubtract(float a, float b, float c)
+{
+#ifdef FP_FAST_FMAF
+  return std::fma(a, b, -c);
+#else
+  return a * b - c;
+#endif
+}
+
 inline int ilog2(int x)
 {
   int b = 0;
@@ -0,0 +1,253 @@
+// madronalib: a C++ framework for DSP applications.
+// Copyright (c) 2020-2022 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// Wavetable oscillators.
+//
+// A Wavetable holds any number of single-cycle frames of kFrameSize samples.
+// When the frames are set, each one is made into a mipmap of band-limited
+// levels with the FFT: level L keeps the harmonics below kFrameSize / 2^(L + 1),
+// so a level can be played up to kFrameSize / 2^L cycles per table without
+// aliasing. Each level is stored with twice the samples its harmonics need, so
+// that interpolation stays accurate up to the highest harmonic, but not fewer
+// than kMinLevelSize. The whole mipmap for a frame is about four times the size
+// of the frame.
+//
+// WavetableBank plays ROWS voices from one Wavetable, one on each row of a
+// DSPVectorArray. The mipmap level of each voice is chosen once per vector from
+// its highest frequency, and the table is read with the interpolation used by
+// the modulated delays: linear, Hermite (cubic) or Lagrange. A frame position
+// for each sample morphs between adjacent frames.
+
+#pragma once
+
+#include <vector>
+
+#include "MLDSPFFT.h"
+#include "MLDSPFilters.h"
+#include "MLDSPGens.h"
+
+namespace ml
+{
+class Wavetable
+{
+ public:
+  static constexpr size_t kFrameSize{2048};
+  static constexpr int kLevels{10};
+  static constexpr size_t kMinLevelSize{128};
+
+  // levels are stored with at least twice as many samples as the number of
+  // harmonics needs, so that interpolation between the samples is accurate.
+  static constexpr size_t kOversampledSize{kFrameSize * 2};
+
+  // each level is stored with one sample of the end of the cycle before it and
+  // three samples of the start after it, so that the four samples around any
+  // read position are contiguous.
+  static constexpr size_t kGuard{4};
+
+  static constexpr size_t getLevelSize(int level)
+  {
+    return std::max(kOversampledSize >> level, kMinLevelSize);
+  }
+
+  // the number of harmonics kept in a level.
+  static constexpr size_t getLevelHarmonics(int level) { return (kFrameSize >> (level + 1)) - 1; }
+
+  // the start of a level's guard, relative to the start of its frame.
+  static constexpr size_t getLevelOffset(int level)
+  {
+    return level ? getLevelOffset(level - 1) + getLevelSize(level - 1) + kGuard : 0;
+  }
+
+  // the length of the mipmap for one frame.
+  static constexpr size_t getFrameStride() { return getLevelOffset(kLevels); }
+
+  // return the level to use for a frequency in cycles per sample: the first level
+  // whose harmonics are all below half the sample rate.
+  static int getLevel(float cyclesPerSample)
+  {
+    const float cyclesPerTable = std::fabs(cyclesPerSample) * kFrameSize;
+    if (!(cyclesPerTable > 1.f)) return 0;
+    int exponent;
+    const float mantissa = std::frexp(cyclesPerTable, &exponent);
+    const int level = (mantissa == 0.5f) ? exponent - 1 : exponent;
+    return std::min(level, kLevels - 1);
+  }
+
+  Wavetable() = default;
+  Wavetable(const float* pFrames, size_t frames) { setFrames(pFrames, frames); }
+
+  // make the mipmaps from frames * kFrameSize samples starting at pFrames. This
+  // allocates memory, so it should not be called from the audio thread.
+  void setFrames(const float* pFrames, size_t frames)
+  {
+    constexpr size_t kBins{kFrameSize / 2};
+    mData.assign(frames * getFrameStride(), 0.f);
+    mFrames = frames;
+    for (size_t f = 0; f < frames; ++f)
+    {
+      const auto spectrum =
+          FFT<kFrameSize>::forward(DSPVectorN<kFrameSize>(pFrames + f * kFrameSize));
+      for (int level = 0; level < kLevels; ++level)
+      {
+        // copy the harmonics of the level into a spectrum twice as long, leaving
+        // out the Nyquist bin. The longer inverse transform interpolates the
+        // cycle to kOversampledSize samples, and scaling by 2 keeps the gain.
+        DSPSpectrum<kOversampledSize> levelSpectrum;
+        const size_t bins = getLevelHarmonics(level) + 1;
+        for (int part = 0; part < 2; ++part)
+        {
+          std::transform(spectrum.constRow(part).getConstBuffer(),
+                         spectrum.constRow(part).getConstBuffer() + std::min(bins, kBins),
+                         levelSpectrum.row(part).getBuffer(), [](float x) { return x * 2.f; });
+        }
+        levelSpectrum.row(1)[0] = 0.f;
+        const auto x = FFT<kOversampledSize>::inverse(levelSpectrum);
+
+        // with its high harmonics removed, the level can be downsampled exactly.
+        const size_t size = getLevelSize(level);
+        const size_t step = kOversampledSize / size;
+        float* p = mData.data() + f * getFrameStride() + getLevelOffset(level) + 1;
+        for (size_t n = 0; n < size; ++n)
+        {
+          p[n] = x[n * step];
+        }
+        p[-1] = p[size - 1];
+        std::copy(p, p + kGuard - 1, p + size);
+      }
+    }
+  }
+
+  size_t getFrames() const { return mFrames; }
+
+  // return the first sample of a level in a frame. The guard samples before and
+  // after it can be read too.
+  const float* getLevelData(size_t frame, int level) const
+  {
+    return mData.data() + frame * getFrameStride() + getLevelOffset(level) + 1;
+  }
+
+  const float* getData() const { return mData.data(); }
+
+ private:
+  std::vector<float> mData;
+  size_t mFrames{0};
+};
+
+// WavetableBank plays ROWS wavetable voices. Each voice has its own 32-bit phase,
+// which steps exactly as a PhasorGen's does for the same frequencies, four
+// samples at a time with a prefix sum. For each four samples, the four table
+// samples around each read position are gathered with one unaligned load, then
+// transposed for interpolation.
+//
+// The Wavetable is shared, not copied, and must outlive the bank. Changing the
+// wavetable's frames while the bank is running is not safe.
+
+template <size_t ROWS, DelayInterpolation INTERPOLATION = kHermiteInterpolation>
+class WavetableBank
+{
+ public:
+  void setWavetable(const Wavetable* pTable) { mpTable = pTable; }
+
+  // set the phase of every voice to zero.
+  void clear() { mPhases.fill(0); }
+
+  // set the phase of one voice, in cycles from 0 to 1.
+  void setPhase(size_t row, float phase)
+  {
+    mPhases[row] = static_cast<uint32_t>(static_cast<int64_t>(phase * PhasorGen::stepsPerCycle));
+  }
+
+  // play frame 0 of the wavetable at the given frequencies in cycles per sample.
+  DSPVectorArray<ROWS> operator()(const DSPVectorArray<ROWS>& cyclesPerSample)
+  {
+    return process<false>(cyclesPerSample, cyclesPerSample);
+  }
+
+  // play the wavetable, morphing between frames. A position of 0 is the first
+  // frame and 1 is the last.
+  DSPVectorArray<ROWS> operator()(const DSPVectorArray<ROWS>& cyclesPerSample,
+                                  const DSPVectorArray<ROWS>& positions)
+  {
+    return process<true>(cyclesPerSample, positions);
+  }
+
+ private:
+  // interpolate the table around pData + index for each lane, where each index
+  // is the integer part of the read position, and t is the fraction.
+  static inline SIMDVectorFloat read(const float* pData, SIMDVectorInt index, SIMDVectorFloat t)
+  {
+    alignas(kBytesPerSIMDVector) uint32_t tapIndex[kFloatsPerSIMDVector];
+    vecStore(reinterpret_cast<float*>(tapIndex), VecI2F(index));
+    SIMDVectorFloat a = vecLoadUnaligned(pData + tapIndex[0] - 1);
+    SIMDVectorFloat b = vecLoadUnaligned(pData + tapIndex[1] - 1);
+    SIMDVectorFloat c = vecLoadUnaligned(pData + tapIndex[2] - 1);
+    SIMDVectorFloat d = vecLoadUnaligned(pData + tapIndex[3] - 1);
+    vecTranspose4(a, b, c, d);
+    return delayUtils::interpolate<INTERPOLATION>(a, b, c, d, t);
+  }
+
+  template <bool MORPH>
+  DSPVectorArray<ROWS> process(const DSPVectorArray<ROWS>& cyclesPerSample,
+                               const DSPVectorArray<ROWS>& positions)
+  {
+    if (!mpTable || !mpTable->getFrames()) return DSPVectorArray<ROWS>();
+
+    DSPVectorArray<ROWS> y{kUninitialized};
+    const float* pData = mpTable->getData();
+    const SIMDVectorFloat vStepsPerCycle = vecSet1(PhasorGen::stepsPerCycle);
+    const SIMDVectorFloat vLastFrame = vecSet1(static_cast<float>(mpTable->getFrames() - 1));
+    const SIMDVectorInt vFrameStride = vecSet1Int(static_cast<int>(Wavetable::getFrameStride()));
+
+    for (size_t j = 0; j < ROWS; ++j)
+    {
+      const float* pFreq = cyclesPerSample.constRow(j).getConstBuffer();
+      const float* pPos = positions.constRow(j).getConstBuffer();
+      float* py = y.row(j).getBuffer();
+
+      // choose the level for the highest frequency in the vector. The phase is
+      // scaled to the level size from its top 24 bits.
+      const int level = Wavetable::getLevel(max(abs(cyclesPerSample.constRow(j))));
+      const SIMDVectorInt vLevelStart =
+          vecSet1Int(static_cast<int>(Wavetable::getLevelOffset(level) + 1));
+      const SIMDVectorFloat vLevelScale = vecSet1(Wavetable::getLevelSize(level) / 16777216.f);
+      SIMDVectorInt phase = vecSet1Int(mPhases[j]);
+
+      for (size_t n = 0; n < kFloatsPerDSPVector; n += kFloatsPerSIMDVector)
+      {
+        const SIMDVectorInt steps =
+            vecFloatToIntRound(vecMul(vecLoad(pFreq + n), vStepsPerCycle));
+        phase = vecAddInt(vecPrefixSumInt(steps), vecBroadcastLastInt(phase));
+        const SIMDVectorFloat x = vecMul(vecIntToFloat(vecShiftRightInt32(phase, 8)), vLevelScale);
+        const SIMDVectorInt xInt = vecFloatToIntTruncate(x);
+        const SIMDVectorFloat xFrac = vecSub(x, vecIntToFloat(xInt));
+        const SIMDVectorInt index = vecAddInt(vLevelStart, xInt);
+        if constexpr (MORPH)
+        {
+          // read the two frames around the position, and crossfade. At the last
+          // frame, both reads are from it.
+          const SIMDVectorFloat f =
+              vecMul(vecClamp(vecLoad(pPos + n), vecZeros(), vecSet1(1.f)), vLastFrame);
+          const SIMDVectorInt fInt = vecFloatToIntTruncate(f);
+          const SIMDVectorFloat fFrac = vecSub(f, vecIntToFloat(fInt));
+          const SIMDVectorInt i0 = vecAddInt(index, vecMulInt32(fInt, vFrameStride));
+          const SIMDVectorInt next = vecAndInt(vFrameStride, VecF2I(vecLessThan(f, vLastFrame)));
+          const SIMDVectorFloat y0 = read(pData, i0, xFrac);
+          const SIMDVectorFloat y1 = read(pData, vecAddInt(i0, next), xFrac);
+          vecStore(py + n, vecFMA(fFrac, vecSub(y1, y0), y0));
+        }
+        else
+        {
+          vecStore(py + n, read(pData, index, xFrac));
+        }
+      }
+      mPhases[j] = vecGetLastInt(phase);
+    }
+    return y;
+  }
+
+  const Wavetable* mpTable{nullptr};
+  std::array<uint32_t, ROWS> mPhases{};
+};
+
+}  // namespace ml
@@ -128,7 +128,7 @@ void AudioContext::processVector(int startOffset)
 
 DSPVector AudioContext::getInputController(size_t n) const
 {
-  return eventsToSignals.getController(n).output;
+  return eventsToSignals.getControllerSignal(n);
 }
 
 void AudioContext::addInputEvent(const Event& e) { eventsToSignals.addEvent(e); }
@@ -77,6 +77,10 @@ class AudioContext final
 
   void addInputEvent(const Event& e);
   void clearInputEvents() { eventsToSignals.clearEvents(); }
+  void rescaleInputEventTimes(double ratio, double offset)
+  {
+    eventsToSignals.rescaleEventTimes(ratio, offset);
+  }
 
   void setInputPitchBend(float p) { eventsToSignals.setPitchBendInSemitones(p); }
   void setInputMPEPitchBend(float p) { eventsToSignals.setMPEPitchBendInSemitones(p); }
@@ -5,6 +5,7 @@
 #include "MLSymbol.h"
 #include "MLEventsToSignals.h"
 #include <cassert>
+#include <cmath>
 
 namespace ml
 {
@@ -256,30 +257,6 @@ void EventsToSignals::Voice::endProcess(float pitchBend)
   outputs.row(kPitch) += driftSig * driftAmount * kDriftScale;
 }
 
-#pragma mark -
-//
-// SmoothedController
-//
-
-void EventsToSignals::SmoothedController::setSampleRate(double r)
-{
-  sr = r;
-  recalcNeeded = true;
-}
-
-void EventsToSignals::SmoothedController::process()
-{
-  if (recalcNeeded)
-  {
-    // send sample rate to controller glides.
-    int glideTimeInSamples = sr * kControllerGlideTimeSeconds;
-    glide.setGlideTimeInSamples(glideTimeInSamples);
-    recalcNeeded = false;
-  }
-
-  output = glide(inputValue);
-}
-
 #pragma mark -
 //
 // EventsToSignals
@@ -298,8 +275,6 @@ EventsToSignals::EventsToSignals()
     // set vox output signal
     voices[i].outputs.row(kVoice) = DSPVector((float)i - 1);
   }
-
-  controllers.resize(kNumControllers);
 }
 
 EventsToSignals::~EventsToSignals() {}
@@ -313,10 +288,7 @@ void EventsToSignals::setSampleRate(double r)
     v.setSampleRate(r);
   }
 
-  for (auto& c : controllers)
-  {
-    c.setSampleRate(r);
-  }
+  controllerSmoothers_.setGlideTimeInSamples(sr * kControllerGlideTimeSeconds);
 }
 
 size_t EventsToSignals::setPolyphony(size_t n)
@@ -378,6 +350,15 @@ void EventsToSignals::addEvent(const Event& e)
 
 void EventsToSignals::clearEvents() { eventBuffer_.clear(); }
 
+// the mapping is monotonic, so the buffer stays in sorted order.
+void EventsToSignals::rescaleEventTimes(double ratio, double offset)
+{
+  for (auto& e : eventBuffer_)
+  {
+    e.time = std::max(0, static_cast<int>(std::floor((e.time - offset) * ratio)));
+  }
+}
+
 // assuming the buffer is in sorted order, process all the events within
 // the vector starting at startOffset.
 void EventsToSignals::processVector(int startTime)
@@ -429,10 +410,7 @@ void EventsToSignals::processVector(int startTime)
   }
 
   // make smoothed controller signals
-  for (auto& c : controllers)
-  {
-    c.process();
-  }
+  controllerSmoothers_.process(controllerSignals_);
 
   // in MIDI mode, add smoothed Channel Pressure to z output
   // in MPE mode, add main voice signals to other voices
@@ -442,7 +420,7 @@ void EventsToSignals::processVector(int startTime)
     {
       for (int v = 1; v < polyphony_ + 1; ++v)
       {
-        voices[v].outputs.row(kZ) += controllers[kChannelPressureControllerIdx].output;
+        voices[v].outputs.row(kZ) += controllerSignals_.constRow(kChannelPressureControllerIdx);
       }
       break;
     }
@@ -647,7 +625,7 @@ void EventsToSignals::processChannelPressureEvent(const Event& event)
     case (hash("MIDI")):
     {
       float val = event.value1;
-      controllers[kChannelPressureControllerIdx].inputValue = val;
+      controllerSmoothers_.setTarget(kChannelPressureControllerIdx, val);
       break;
     }
     case (hash("MPE")):
@@ -741,7 +719,7 @@ void EventsToSignals::processControllerEvent(const Event& event)
 
   // store values directly into array so they can be read by clients
   size_t ctrl = clamp(size_t(event.sourceIdx), (size_t)0, kNumControllers - 1);
-  controllers[ctrl].inputValue = val;
+  controllerSmoothers_.setTarget(ctrl, val);
 
   // handle special meanings for some MIDI controllers
   if (ctrl == 120)
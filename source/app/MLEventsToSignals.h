@@ -74,6 +74,11 @@ class EventsToSignals final
 
   void clearEvents();
 
+  // change the time t of each event in the queue to (t - offset) * ratio, rounding down
+  // and clamping at zero. Used when the events are processed at a different sample rate
+  // from the one they were timed at.
+  void rescaleEventTimes(double ratio, double offset);
+
   // process incoming events in buffer and generate output signals.
   // events in the queue in the time range [startOffset, startOffset + kFloatsPerDSPVector) will
   // be processed. it is assumed that all events in the queue are sorted by start time. Any
@@ -167,18 +172,6 @@ class EventsToSignals final
     bool recalcNeeded{false};
   };
 
-  struct SmoothedController
-  {
-    void setSampleRate(double r);
-    void process();
-
-    LinearGlide glide;
-    DSPVector output{0.f};
-    float inputValue{0.f};
-    double sr{0};
-    bool recalcNeeded{false};
-  };
-
   // get a const reference to a Voice for reading its output.
   // Lifetime management is an issue though: don't hang onto this reference!
   const Voice& getVoice(int n) const { return voices[n + 1]; }
@@ -186,7 +179,8 @@ class EventsToSignals final
   // get voice which had a note on event most recently, if any
   int getNewestVoice() const { return newestVoice_ - 1; }
 
-  const SmoothedController& getController(size_t n) const { return controllers[n]; }
+  // get the smoothed signal of a continuous controller.
+  const DSPVector& getControllerSignal(size_t n) const { return controllerSignals_.constRow(n); }
 
  private:
   size_t countHeldNotes();
@@ -207,8 +201,9 @@ class EventsToSignals final
   // voices[0] is the "main voice" used for MPE.
   std::vector<Voice> voices;
 
-  // output values for continuous controllers.
-  std::vector<SmoothedController> controllers;
+  // smoothed output signals for continuous controllers.
+  ParameterSmootherBank<kNumControllers> controllerSmoothers_;
+  DSPVectorArray<kNumControllers> controllerSignals_;
 
   Symbol protocol_{"MIDI"};
 
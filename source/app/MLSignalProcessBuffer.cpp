@@ -11,7 +11,8 @@ namespace ml
 {
 // SignalProcessBuffer: utility class to serve a main loop with varying
 // arbitrary chunk sizes, buffer inputs and outputs, and compute DSP in
-// DSPVector-sized chunks.
+// DSPVector-sized chunks. Optionally, the process function can run at its own
+// internal sample rate, with the inputs and outputs resampled.
 
 SignalProcessBuffer::SignalProcessBuffer(size_t inputs, size_t outputs, size_t maxFrames)
     : maxFrames_(maxFrames)
@@ -31,6 +32,54 @@ SignalProcessBuffer::SignalProcessBuffer(size_t inputs, size_t outputs, size_t m
 
 SignalProcessBuffer::~SignalProcessBuffer() {}
 
+void SignalProcessBuffer::setSampleRates(double externalRate, double internalRate)
+{
+  size_t nInputs = inputBuffers_.size();
+  size_t nOutputs = outputBuffers_.size();
+  resampling_ = (externalRate != internalRate) && (externalRate > 0.) && (internalRate > 0.);
+  rateRatio_ = resampling_ ? internalRate / externalRate : 1.;
+  vectorStartTime_ = 0.;
+  if (!resampling_)
+  {
+    inputResamplers_.clear();
+    outputResamplers_.clear();
+    for (auto& b : inputBuffers_) b.resize((int)maxFrames_);
+    for (auto& b : outputBuffers_) b.resize((int)maxFrames_);
+    return;
+  }
+
+  inputResamplers_.resize(nInputs);
+  for (auto& r : inputResamplers_)
+  {
+    r.setRates(externalRate, internalRate);
+  }
+  outputResamplers_.resize(nOutputs);
+  for (auto& r : outputResamplers_)
+  {
+    r.setRates(internalRate, externalRate);
+  }
+
+  // The resamplers hold back some samples, so a few more vectors may run before
+  // the first output is ready. Start each input buffer with enough zeros to
+  // cover them.
+  const double ratio = internalRate / externalRate;
+  const size_t inputPriming = Resampler::kTaps + 2 * kFloatsPerDSPVector;
+  const size_t maxInternalFrames = (size_t)std::ceil(maxFrames_ * ratio) + 1;
+  const size_t maxExternalFramesPerVector =
+      (size_t)std::ceil(kFloatsPerDSPVector / ratio) + 1;
+  for (auto& b : inputBuffers_)
+  {
+    b.resize((int)(maxInternalFrames + inputPriming + kFloatsPerDSPVector));
+    std::vector<float> zeros(inputPriming);
+    b.write(zeros.data(), zeros.size());
+  }
+  for (auto& b : outputBuffers_)
+  {
+    b.resize((int)(maxFrames_ + maxExternalFramesPerVector));
+  }
+  resampleBuffer_.resize(std::max(maxInternalFrames, maxExternalFramesPerVector));
+}
+
 // Buffer the external context and provide an internal context for the process function.
 // Then run the process function in the internal context, updating its state.
 void SignalProcessBuffer::process(const float** externalInputs, float** externalOutputs,
@@ -48,10 +97,28 @@ void SignalProcessBuffer::process(const float** externalInputs, float** external
   {
     if (externalInputs[c])
     {
-      inputBuffers_[c].write(externalInputs[c], externalFrames);
+      if (resampling_)
+      {
+        size_t frames = inputResamplers_[c].process(externalInputs[c], externalFrames,
+                                                    resampleBuffer_.data());
+        inputBuffers_[c].write(resampleBuffer_.data(), frames);
+      }
+      else
+      {
+        inputBuffers_[c].write(externalInputs[c], externalFrames);
+      }
     }
   }
 
+  // when resampling, event times are in external frames. Convert them to internal
+  // frames counted from the start of the first vector we are about to run, which
+  // in general falls between two external frames. Events before that vector are
+  // moved to its start.
+  if (resampling_)
+  {
+    context->rescaleInputEventTimes(rateRatio_, vectorStartTime_);
+  }
+
   // run vector-size process until we have externalFrames of output
   int startOffset{0};
   while (outputBuffers_[0].getReadAvailable() < externalFrames)
@@ -73,10 +140,27 @@ void SignalProcessBuffer::process(const float** externalInputs, float** external
     // write one vector to each output buffer
     for (int c = 0; c < nOutputs; c++)
     {
-      outputBuffers_[c].write(context->outputs[c]);
+      if (resampling_)
+      {
+        size_t frames = outputResamplers_[c].process(context->outputs[c].getConstBuffer(),
+                                                     kFloatsPerDSPVector, resampleBuffer_.data());
+        outputBuffers_[c].write(resampleBuffer_.data(), frames);
+      }
+      else
+      {
+        outputBuffers_[c].write(context->outputs[c]);
+      }
     }
   }
 
+  // carry the start of the next vector over to the next call. The vectors run
+  // ahead of the external frames to fill the output buffers, so this is in
+  // general more than one external frame into the next buffer.
+  if (resampling_)
+  {
+    vectorStartTime_ += startOffset / rateRatio_ - externalFrames;
+  }
+
   // read from outputBuffers to external outputs
   for (int c = 0; c < nOutputs; c++)
   {
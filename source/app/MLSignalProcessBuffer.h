@@ -7,13 +7,15 @@
 #include "MLAudioContext.h"
 #include "MLDSPBuffer.h"
 #include "MLDSPOps.h"
+#include "MLDSPResample.h"
 
 using namespace ml;
 namespace ml
 {
 // SignalProcessBuffer: utility class to serve a main loop with varying
 // arbitrary chunk sizes, buffer inputs and outputs, and compute DSP in
-// DSPVector-sized chunks.
+// DSPVector-sized chunks. Optionally, the process function can run at its own
+// internal sample rate, with the inputs and outputs resampled.
 
 using SignalProcessFn = void (*)(AudioContext*, void*);
 
@@ -26,10 +28,30 @@ class SignalProcessBuffer final
   // max chunk size for outside I/O
   size_t maxFrames_;
 
+  // optional resampling between the external and internal sample rates
+  bool resampling_{false};
+  std::vector<Resampler> inputResamplers_;
+  std::vector<Resampler> outputResamplers_;
+  std::vector<float> resampleBuffer_;
+
+  // internal frames per external frame, and the external frame, counted from
+  // the start of the next buffer passed to process(), where the next internal
+  // vector starts.
+  double rateRatio_{1.};
+  double vectorStartTime_{0.};
+
  public:
   SignalProcessBuffer(size_t inputs, size_t outputs, size_t maxFrames);
   ~SignalProcessBuffer();
 
+  // Run the process function at internalRate while the external I/O runs at
+  // externalRate. The AudioContext given to process() should be set to the
+  // internal rate. If the rates are equal, no resampling is done. When
+  // resampling, the times of input events, which are in external frames, are
+  // converted to internal frames. This allocates memory, so call it before
+  // processing starts.
+  void setSampleRates(double externalRate, double internalRate);
+
   void process(const float** inputs, float** outputs, int nFrames, AudioContext* ctx,
                SignalProcessFn processFn, void* pState);
 };
@@ -12,7 +12,6 @@ SignalProcessor::PublishedSignal::PublishedSignal(int maxFrames, int maxVoices,
                                                   int octavesDown)
     : channels_(channels), maxFrames_(maxFrames), octavesDown_(octavesDown)
 {
-  voiceRotateBuffer.resize(maxFrames * channels);
   buffer_.resize(maxFrames * channels * maxVoices);
 }
 
@@ -27,7 +27,6 @@ class SignalProcessor
   // calculation to outside code like displays.
   struct PublishedSignal
   {
-    std::vector<float> voiceRotateBuffer;
     DSPBuffer buffer_;
     size_t maxFrames_{0};
     size_t channels_{0};
@@ -56,30 +55,52 @@ class SignalProcessor
     //
     // the voice param is not used currently but we can transmit the voice number in the future if needed.
     //
+    // the frames are rotated directly into the DSPBuffer's regions, without an intermediate copy.
+    //
     template <size_t CHANNELS>
-    inline void writeQuick(DSPVectorArray<CHANNELS> inputVector, size_t frames, size_t voice)
+    inline void writeQuick(const DSPVectorArray<CHANNELS>& inputVector, size_t frames, size_t voice)
     {
-      // on every (1<<octavesDown_)th frame, rotate and write to DSPBuffer
-      int framesWritten = 0;
-      for(int f=0; f<frames; ++f)
+      // every (1<<octavesDown_)th frame is written.
+      const size_t period = size_t(1) << octavesDown_;
+      const size_t ctr = (size_t)downsampleCtr_;
+      const size_t framesToWrite = (ctr + frames) / period;
+      const int nextCtr = (int)((ctr + frames) % period);
+      if(!framesToWrite)
+      {
+        downsampleCtr_ = nextCtr;
+        return;
+      }
+      
+      // if the reader has fallen behind, drop the oldest frames to make room, as write() does.
+      const size_t samples = framesToWrite*CHANNELS;
+      const size_t space = buffer_.getWriteAvailable();
+      if(space < samples)
       {
-        downsampleCtr_++;
-        if(downsampleCtr_ >= (1 << octavesDown_))
+        buffer_.discard(samples - space);
+      }
+      
+      DSPBuffer::DataRegions dr = buffer_.reserveWrite(samples);
+      if(!dr.p1) return;
+      
+      // rotate the frames into the regions.
+      float* pDest = dr.p1;
+      size_t remaining = dr.size1;
+      for(size_t f = period - 1 - ctr; f < frames; f += period)
+      {
+        for(size_t j=0; j<CHANNELS; ++j)
         {
-          // write accumulated frame.
-          for(int j=0; j<CHANNELS; ++j)
+          *pDest++ = inputVector.constRow(j)[f];
+          if(!--remaining)
           {
-            voiceRotateBuffer[framesWritten*CHANNELS + j] = inputVector.row(j)[f];
+            pDest = dr.p2;
+            remaining = dr.size2;
           }
-          framesWritten++;
-          downsampleCtr_ = 0;
         }
       }
+      buffer_.commitWrite(samples);
       
-      if(framesWritten)
-      {
-        buffer_.write(voiceRotateBuffer.data(), framesWritten*CHANNELS);
-      }
+      // advance the counter only once the frames are written.
+      downsampleCtr_ = nextCtr;
     }
     
     // write a single frame of signal with multiple contiguous channels